@@ -13,6 +13,154 @@
 # include <math.h>
 # include <float.h>
 # include <stdbool.h>
+# include <stdint.h>
+# include <stdarg.h>
+# include <time.h>
+# include <stddef.h>
+# include <limits.h>
+# include <errno.h>
+# ifndef _WIN32
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <dirent.h>
+#  include <utime.h>
+# endif
+# ifdef _WIN32
+#  include <windows.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/utime.h>
+# endif
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+// Contadores de hardware por fase: solo Linux y solo con las trazas activas
+# if defined(DELAUNAY_CONTADORES_HW) && defined(DELAUNAY_TRAZAS) && defined(__linux__)
+#  define CONTADORES_HW
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+# endif
+# include "delaunay.h"
+
+/* Constantes                                                                 */
+// A partir de este tamaño la sección de vértices se lee en paralelo
+# define TAMANO_MINIMO_PARALELO (1 << 20)
+// Y a partir de este número de puntos se ordenan en paralelo
+# define PUNTOS_MINIMOS_ORDEN_PARALELO (1 << 16)
+
+// Ordenamiento radix de puntos: dígitos de 11 bits, seis pasadas por coordenada
+# define BITS_DIGITO_RADIX 11
+# define CUBETAS_RADIX (1 << BITS_DIGITO_RADIX)
+
+// Elección automática del motor (-A): tamaño de la muestra y umbrales
+# define MUESTRAS_PERFIL 4096
+# define DENSIDAD_SEGMENTOS_ALTA 0.5   // Segmentos por vértice
+# define OCUPACION_CURVAS 0.25         // Fracción de celdas ocupadas
+# define RECORRIDO_ORDENADO 4.0        // Espaciados medios entre consecutivos
+
+// Refinamiento de calidad: por encima de este ángulo mínimo (grados) no hay
+// garantía de que termine, tampoco en triangle.c
+# define ANGULO_MINIMO_TERMINACION 34.0
+
+// Formato binario de mallas (.bmesh)
+# define BMESH_MAGIA "DLNBMESH"
+# define BMESH_VERSION 1
+# define BMESH_ALINEACION 64
+# define BMESH_MAX_SECCIONES 16
+
+// Escritura de archivos de texto
+# define TAMANO_BUFFER_SALIDA (1 << 20)
+# define MAX_LONGITUD_FILA 256    // Cota de una fila de .node/.ele
+# define DIGITOS_SALIDA 17        // "%.17g": las coordenadas se releen sin pérdida
+
+// Línea de comandos
+# define ANGULO_MINIMO_DEFECTO 20.0   // Grados, igual que triangle.c con -q
+
+// Los códigos de salida (SALIDA_*) y los niveles de detalle (NIVEL_*) están
+// en delaunay.h
+
+// Caché de resultados (-k y OpcionesDelaunay.directorioCache)
+# define VERSION_CACHE 2              // Cambiarla invalida los resultados guardados
+# define DIRECTORIO_CACHE_DEFECTO "delaunay.cache"   // Si no hay $DELAUNAY_CACHE
+# define MEGABYTES_CACHE_DEFECTO 1024.0
+
+// Longitud del último mensaje de error que guarda cada contexto
+# define TAMANO_MENSAJE_ERROR 256
+
+// Almacenamiento local a cada hilo para el estado de trazas
+# if defined(_MSC_VER)
+#  define LOCAL_HILO __declspec(thread)
+# elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define LOCAL_HILO _Thread_local
+# else
+#  define LOCAL_HILO __thread
+# endif
+
+// Nivel máximo compilado: los mensajes por encima desaparecen del binario.
+// Los mensajes por elemento (cada triángulo, punto o recursión) están en
+// NIVEL_DEPURACION y solo existen al compilar con -DNIVEL_TRAZA_COMPILADO=5
+# ifndef NIVEL_TRAZA_COMPILADO
+#  define NIVEL_TRAZA_COMPILADO NIVEL_DETALLADO
+# endif
+
+// Filtro doble: la primera comparación es constante y el compilador elimina
+// la llamada (y la evaluación de los argumentos) de los niveles excluidos.
+// Los errores se registran también en silencio si hay un contexto que los
+// guarde (mensajeError).
+# define TRAZA(nivel, ...)                                                    \
+    do {                                                                     \
+        if ((nivel) <= NIVEL_TRAZA_COMPILADO &&                              \
+            ((nivel) <= nivelDetalle ||                                      \
+             ((nivel) == NIVEL_ERROR && mensajeError != NULL))) {            \
+            registrarTraza((nivel), __VA_ARGS__);                            \
+        }                                                                    \
+    } while (0)
+
+# define TRAZA_ERROR(...) TRAZA(NIVEL_ERROR, __VA_ARGS__)
+# define TRAZA_AVISO(...) TRAZA(NIVEL_AVISO, __VA_ARGS__)
+# define TRAZA_INFO(...) TRAZA(NIVEL_NORMAL, __VA_ARGS__)
+# define TRAZA_DETALLE(...) TRAZA(NIVEL_DETALLADO, __VA_ARGS__)
+# define TRAZA_DEPURACION(...) TRAZA(NIVEL_DEPURACION, __VA_ARGS__)
+
+// Contadores y tramos (fases cronometradas). Sin -DDELAUNAY_TRAZAS se
+// expanden a nada: ni memoria, ni llamadas, ni lecturas del reloj.
+// Con -DDELAUNAY_CONTADORES_HW (además de -DDELAUNAY_TRAZAS, en Linux) cada
+// tramo mide también ciclos, instrucciones, fallos de L1d y LLC y fallos de
+// predicción de saltos con perf_event_open.
+# ifdef DELAUNAY_TRAZAS
+#  define TRAZA_CONTAR(contador, n) (contadoresTraza[(contador)] += (n))
+#  define TRAMO_INICIO(fase) iniciarTramo(fase)
+#  define TRAMO_FIN(fase) terminarTramo(fase)
+# else
+#  define TRAZA_CONTAR(contador, n) ((void)0)
+#  define TRAMO_INICIO(fase) ((void)0)
+#  define TRAMO_FIN(fase) ((void)0)
+# endif
+
+// Contadores de operaciones: siempre disponibles (un incremento en memoria
+// local al hilo). -DDELAUNAY_SIN_CONTADORES los elimina por completo.
+# ifndef DELAUNAY_SIN_CONTADORES
+#  define CONTAR_OPERACION(campo, n) (contadoresOperacion.campo += (n))
+#  define MAXIMO_OPERACION(campo, v)                                          \
+    do {                                                                     \
+        if ((v) > contadoresOperacion.campo) contadoresOperacion.campo = (v); \
+    } while (0)
+# else
+#  define CONTAR_OPERACION(campo, n) ((void)0)
+#  define MAXIMO_OPERACION(campo, v) ((void)0)
+# endif
+
+// Cotas de error relativo de los predicados en doble precisión (Shewchuk):
+// por debajo de ellas el signo calculado no es confiable
+# define COTA_ERROR_ORIENTACION (3.0 + 16.0 * DBL_EPSILON) * (DBL_EPSILON / 2.0)
+# define COTA_ERROR_CIRCUNFERENCIA (10.0 + 96.0 * DBL_EPSILON) * (DBL_EPSILON / 2.0)
+
+// Espacio para el JSON de los contadores de operaciones
+# define TAMANO_JSON_CONTADORES 2048
 
 /*********                    Estructuras de Datos                   **********/
 /**                                                                          **/
@@ -46,6 +194,8 @@ struct Triangulacion {
     int numPuntos;                 // Numero de puntos
     int maxPuntos;                 // Capacidad máxima de puntos
     int numPuntosRegion1;          // Numero de puntos en la región 1
+    int *permutacion;              // Posición original de cada punto tras ordenarlos (o NULL)
+    int numPermutacion;            // Puntos que cubre la permutación; los Steiner van después
     // Función para agregar nuevos puntos
     void (*agregarPunto)(struct Triangulacion*, struct Punto*);
     struct Borde **bordes;
@@ -97,6 +247,134 @@ struct EntradaPoly {
     // Regiones
     int numRegiones;
     struct Region *regiones;
+
+    int primerNumero;   // Numeración del archivo (0 o 1)
+};
+
+// Archivo de entrada proyectado en memoria (mmap) o leído completo
+struct ArchivoMapeado {
+    const char *datos;
+    size_t longitud;
+    bool proyectado;    // true si proviene de mmap, false si de malloc
+};
+
+// Opciones de una ejecución (switches compatibles con triangle.c)
+struct OpcionesMalla {
+    const char *archivoEntrada;
+    bool leerPoly;          // -p
+    bool refinar;           // -r
+    bool calidad;           // -q
+    double anguloMinimo;    // Grados
+    bool restringirArea;    // -a
+    double areaMaxima;      // <= 0: áreas por región del .poly
+    bool conforme;          // -D
+    bool eliminarRepetidos; // -d
+    double toleranciaRepetidos; // -d<tol>; 0 solo coordenadas idénticas
+    int posicionSteiner;    // -t, STEINER_*
+    int algoritmo;          // -i / -F / -A, ALGORITMO_*
+    int hilos;              // -j, 0 = valor por defecto de OpenMP
+    int nivelDetalle;       // -V / -Q
+    bool escribirNode;      // -N lo desactiva
+    bool escribirEle;       // -E lo desactiva
+    bool escribirVecinos;   // -n
+    bool escribirBMesh;     // -b
+    bool escribirContadores;// -K: <base>.contadores.json
+    bool usarCache;         // -k
+    double megabytesCache;  // -k<MB>
+    bool numerarIteracion;  // Nombres de salida <base>.<iteración>.*
+    bool ayuda;             // -h
+};
+
+// Clave de un resultado en la caché: hash de 128 bits de la entrada y las
+// opciones
+struct ClaveCache {
+    uint64_t h[2];
+};
+
+// Quién consume el resultado guardado: los marcadores de vértice difieren
+enum DestinoCache {
+    DESTINO_CACHE_LINEA_COMANDOS,
+    DESTINO_CACHE_LIBRERIA
+};
+
+// Búfer de escritura: se entrega al archivo en bloques de TAMANO_BUFFER_SALIDA
+struct BufferSalida {
+    FILE *archivo;
+    char *datos;
+    size_t usado;
+    size_t capacidad;
+    size_t escrito;     // Bytes ya entregados al archivo
+    bool error;
+};
+
+// Cursor de lectura sobre los bytes del archivo
+struct Escaner {
+    const char *p;
+    const char *fin;
+};
+
+// Tipos de sección del formato .bmesh
+enum TipoSeccionBMesh {
+    BMESH_PUNTOS = 1,                // double[2 * numPuntos]: x, y
+    BMESH_MARCADORES_PUNTOS = 2,     // int32[numPuntos]
+    BMESH_ATRIBUTOS_PUNTOS = 3,      // double[numPuntos * numAtributosPunto]
+    BMESH_TRIANGULOS = 4,            // int32[3 * numTriangulos], base-0
+    BMESH_VECINOS = 5,               // int32[3 * numTriangulos], -1 sin vecino
+    BMESH_ATRIBUTOS_TRIANGULOS = 6,  // double[numTriangulos * numAtributosTriangulo]
+    BMESH_SEGMENTOS = 7,             // int32[2 * numSegmentos], base-0
+    BMESH_MARCADORES_SEGMENTOS = 8,  // int32[numSegmentos]
+    BMESH_AGUJEROS = 9,              // double[2 * numAgujeros]
+    BMESH_REGIONES = 10              // double[4 * numRegiones]: x, y, atributo, área
+};
+
+// Cabecera de 128 bytes al inicio del archivo .bmesh
+struct CabeceraBMesh {
+    char magia[8];
+    uint32_t version;
+    uint32_t numSecciones;
+    uint64_t tamanoArchivo;
+    uint64_t numPuntos;
+    uint64_t numTriangulos;
+    uint64_t numSegmentos;
+    uint64_t numAgujeros;
+    uint64_t numRegiones;
+    uint32_t numAtributosPunto;
+    uint32_t numAtributosTriangulo;
+    uint8_t reservado[56];
+};
+
+// Entrada de la tabla de secciones (sigue a la cabecera)
+struct EntradaSeccionBMesh {
+    uint32_t tipo;
+    uint32_t tamanoElemento;
+    uint64_t desplazamiento;  // Múltiplo de BMESH_ALINEACION
+    uint64_t longitud;        // En bytes
+};
+
+// Malla en arreglos planos. Al abrir un .bmesh los arreglos apuntan al
+// archivo proyectado; al construirla en memoria son propios.
+struct MallaBinaria {
+    int numPuntos;
+    int numTriangulos;
+    int numSegmentos;
+    int numAgujeros;
+    int numRegiones;
+    int numAtributosPunto;
+    int numAtributosTriangulo;
+
+    double *puntos;
+    int32_t *marcadoresPuntos;
+    double *atributosPuntos;
+    int32_t *triangulos;
+    int32_t *vecinos;
+    double *atributosTriangulos;
+    int32_t *segmentos;
+    int32_t *marcadoresSegmentos;
+    double *agujeros;
+    double *regiones;
+
+    struct ArchivoMapeado mapa;  // Proyección del archivo (solo lectura)
+    void *copiaLocal;            // Copia corregida en hosts big-endian
 };
 
 struct Region {
@@ -111,15 +389,144 @@ struct Segmento {
 };
 
 
+// Fases del proceso medidas por los tramos de traza
+enum FaseTraza {
+    FASE_LECTURA,
+    FASE_ORDENAMIENTO,
+    FASE_TRIANGULACION,
+    FASE_RESTRICCIONES,
+    FASE_VECINOS,
+    FASE_REFINAMIENTO,
+    FASE_ESCRITURA,
+    NUM_FASES
+};
+
+// Contadores de eventos que antes se imprimían uno por uno
+enum ContadorTraza {
+    CONTADOR_RECURSIONES,
+    CONTADOR_COMBINACIONES,
+    CONTADOR_TRIANGULOS_AGREGADOS,
+    CONTADOR_TRIANGULOS_DEGENERADOS,
+    CONTADOR_TRIANGULOS_DUPLICADOS,
+    CONTADOR_PUNTOS_AGREGADOS,
+    CONTADOR_PUNTOS_STEINER,
+    CONTADOR_SEGMENTOS,
+    NUM_CONTADORES
+};
+
+// Contadores de operaciones del algoritmo. Los predicados no tienen aún un
+// camino exacto: las llamadas "inciertas" son las que caen dentro de la cota
+// de error y lo necesitarían.
+struct ContadoresOperacion {
+    long long orientaciones;
+    long long orientacionesInciertas;
+    long long circunferencias;            // Pruebas de circunferencia vacía
+    long long circunferenciasInciertas;
+    long long intercambios;               // Intercambios de diagonal (flips)
+    long long recorridos;                 // Ubicaciones de un punto
+    long long triangulosRecorridos;       // Triángulos visitados en total
+    long long maxRecorrido;               // Visitados en la peor ubicación
+    long long cavidades;                  // Inserciones que reemplazan triángulos
+    long long triangulosCavidad;
+    long long maxCavidad;
+    long long steinerAceptados;
+    long long steinerFueraDeLimites;      // Rechazados por estaDentroDeLimites
+    long long steinerCercanos;            // Rechazados por hayPuntoCercano
+    long long steinerSinEspacio;          // Descartados por maxPuntos
+    long long steinerFueraDeCentro;       // Fuera de centro en lugar del circuncentro
+    long long subsegmentosVerificados;    // Delaunay conforme (-D)
+    long long subsegmentosDivididos;
+    long long verticesRepetidos;          // Eliminados antes de triangular
+    long long asignacionesArena;          // obtenerDelPool
+    long long asignacionesArenaFallidas;
+    long long asignacionesMonton;         // malloc de triángulos, bordes y puntos
+    long long aciertosCache;              // Resultados tomados de la caché
+    long long fallosCache;
+};
+
+// Contadores de hardware (perf_event_open) que se miden en cada tramo
+enum ContadorHW {
+    HW_CICLOS,
+    HW_INSTRUCCIONES,
+    HW_FALLOS_L1D,
+    HW_FALLOS_LLC,
+    HW_FALLOS_SALTO,
+    NUM_CONTADORES_HW
+};
+
+
+/*********                    Variables Globales                     **********/
+/**                                                                          **/
+
+// El estado de las trazas es local a cada hilo para que la librería pueda
+// mallar en varios hilos a la vez sin compartir nada
+
+// Nivel de detalle de los mensajes en tiempo de ejecución
+LOCAL_HILO int nivelDetalle = NIVEL_NORMAL;
+
+// Si no es NULL, el primer error se copia aquí (TAMANO_MENSAJE_ERROR bytes)
+LOCAL_HILO char *mensajeError = NULL;
+
+// Contadores de operaciones del hilo; mallarEntrada los pone en cero
+LOCAL_HILO struct ContadoresOperacion contadoresOperacion;
+
+# ifdef DELAUNAY_TRAZAS
+LOCAL_HILO long long contadoresTraza[NUM_CONTADORES];
+LOCAL_HILO double tiempoFases[NUM_FASES];      // Segundos acumulados por fase
+LOCAL_HILO double inicioFases[NUM_FASES];
+LOCAL_HILO int llamadasFases[NUM_FASES];
+# endif
+
+# ifdef CONTADORES_HW
+// Un descriptor por contador y por hilo (-1 si no está disponible)
+LOCAL_HILO int descriptoresHW[NUM_CONTADORES_HW];
+LOCAL_HILO bool contadoresHWAbiertos = false;
+LOCAL_HILO long long valoresHW[NUM_FASES][NUM_CONTADORES_HW];   // Acumulados
+LOCAL_HILO long long inicioHW[NUM_FASES][NUM_CONTADORES_HW];
+# endif
+
+
 /*********                    Prototipos de Funciones                **********/
 /**                                                                          **/
-static int leerLineaNoVacia(FILE* archivo, char* linea, int maxLen);
-static int leerSegmentos(FILE* archivo, struct EntradaPoly* entrada);
-static int leerAgujeros(FILE* archivo, struct EntradaPoly* entrada);
-static int leerRegiones(FILE* archivo, struct EntradaPoly* entrada);
+void registrarTraza(int nivel, const char *formato, ...);
+double tiempoActual(void);
+void iniciarTramo(enum FaseTraza fase);
+void terminarTramo(enum FaseTraza fase);
+void cerrarContadoresHW(void);
+void reiniciarContadoresOperacion(void);
+int formatearContadoresJSON(const struct ContadoresOperacion *c, char *destino, size_t tamano);
+int guardarContadoresJSON(const struct ContadoresOperacion *c, const char *nombreArchivo);
+void imprimirResumenTrazas(void);
+void reiniciarTrazas(void);
+static int mapearArchivo(const char *nombreArchivo, struct ArchivoMapeado *mapa);
+static void liberarArchivoMapeado(struct ArchivoMapeado *mapa);
+static int escanearEntero(struct Escaner *esc, int *valor);
+static int escanearReal(struct Escaner *esc, double *valor);
+static int leerSeccionVertices(struct Escaner *esc, struct EntradaPoly *entrada);
+static int leerSegmentos(struct Escaner *esc, struct EntradaPoly *entrada);
+static int leerAgujeros(struct Escaner *esc, struct EntradaPoly *entrada);
+static int leerRegiones(struct Escaner *esc, struct EntradaPoly *entrada);
+struct EntradaPoly* leerArchivoNode(const char *nombreArchivo);
 struct EntradaPoly* leerArchivoPoly(const char *nombreArchivo);
-void guardarArchivoNode(struct Triangulacion* tr, const char* nombreArchivo);
-void guardarArchivoEle(struct Triangulacion *tr, const char *nombreArchivo);
+int guardarArchivoNode(const struct MallaBinaria *malla, const char *nombreArchivo);
+int guardarArchivoEle(const struct MallaBinaria *malla, const char *nombreArchivo);
+int guardarArchivoNeigh(const struct MallaBinaria *malla, const char *nombreArchivo);
+void claveCache(const struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                int destino, struct ClaveCache *clave);
+int buscarEnCache(const char *directorio, const struct ClaveCache *clave,
+                  struct MallaBinaria *malla);
+int guardarEnCache(const char *directorio, uint64_t tamanoMaximo, const struct ClaveCache *clave,
+                   const struct MallaBinaria *malla);
+int guardarArchivoBMesh(const struct MallaBinaria *malla, const char *nombreArchivo);
+int escribirBMesh(const struct MallaBinaria *malla, FILE *archivo);
+uint64_t tamanoBMesh(const struct MallaBinaria *malla);
+int abrirArchivoBMesh(const char *nombreArchivo, struct MallaBinaria *malla);
+void cerrarArchivoBMesh(struct MallaBinaria *malla);
+void liberarMallaBinaria(struct MallaBinaria *malla);
+int mallaDesdeTriangulacion(struct Triangulacion *tr, struct EntradaPoly *entrada,
+                            struct MallaBinaria *malla);
+int convertirTextoABMesh(const char *base, const char *archivoBMesh);
+int convertirBMeshATexto(const char *archivoBMesh, const char *base);
 struct PoolMemoria* inicializarPoolMemoria(int capacidadMaxima, int tamañoElemento);
 void* reservarMemoria(struct PoolMemoria* pool);
 void liberarMemoria(struct PoolMemoria* pool, void* elemento);
@@ -169,6 +576,7 @@ struct Punto* encontrarCandidatoDerecha(struct Triangulacion *tr, struct Borde *
 bool puntoEnCircunferencia(struct Punto *p1, struct Punto *p2, struct Punto *p3, struct Punto *punto);
 double calcularAngulo(struct Punto *p1, struct Punto *p2, struct Punto *p3);
 int compararPuntosX(const void *a, const void *b);
+bool ordenarPuntos(struct Punto *puntos, int n, int *permutacion);
 void crearSegmento(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2);
 struct Triangulacion* triangulacionDelaunay(struct Punto* puntos, int numPuntos, int numPuntosRegion1);
 struct ColaRefinamiento* inicializarColaRefinamiento(int capacidad);
@@ -176,7 +584,10 @@ void agregarPuntoATriangulacion(struct Triangulacion *tr, struct Punto *p);
 void agregarTrianguloACola(struct ColaRefinamiento *cola, struct Triangulo *t);
 struct Triangulo* extraerTriangulo(struct ColaRefinamiento *cola);
 bool dentroLimites(struct Punto *p, struct Triangulacion *tr);
-void refinarMalla(struct Triangulacion *tr, double anguloMinimo, double areaMaxima);
+void refinarMalla(struct Triangulacion *tr, double anguloMinimo, double areaMaxima, int posicionSteiner);
+double constanteFueraCentro(int posicionSteiner, double anguloMinimo);
+bool ubicarPuntoSteiner(struct Punto *a, struct Punto *b, struct Punto *c, double constante,
+                        double *x, double *y);
 void liberarColaRefinamiento(struct ColaRefinamiento *cola);
 struct Punto* calcularCircuncentro(struct Triangulo *t);
 bool estaDentroDeLimites(struct Triangulacion *tr, struct Punto *p);
@@ -191,1746 +602,6305 @@ void combinarTriangulacionesOptimizado(struct Triangulacion *tr, int inicio, int
 bool existeTriangulo(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2, struct Punto *p3);
 void menu(void);
 void info(void);
+void uso(void);
+void opcionesPorDefecto(struct OpcionesMalla *op);
+int analizarArgumentos(int argc, char **argv, struct OpcionesMalla *op);
+int ejecutarMallado(const struct OpcionesMalla *op);
+int modoInteractivo(void);
+int mallarEntrada(struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                  struct Triangulacion **resultado);
+int eliminarVerticesRepetidos(struct EntradaPoly *entrada, double tolerancia);
+int reconstruirTriangulacion(struct EntradaPoly *entrada, const struct MallaBinaria *elementos,
+                             struct Triangulacion **resultado);
+void refinarIncremental(struct Triangulacion *tr, double anguloMinimo, double areaMaxima,
+                        int posicionSteiner, bool conforme);
+int refinarMallaExistente(struct EntradaPoly *entrada, const struct MallaBinaria *elementos,
+                          const struct OpcionesDelaunay *op, struct Triangulacion **resultado);
+int conformarYRefinar(struct Triangulacion *tr, int puntosEntrada, double anguloMinimo, double areaMaxima,
+                      int posicionSteiner, bool conforme);
+int mallarConforme(struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                   struct Triangulacion **resultado);
+void triangular(struct Triangulacion *tr);
+void insertarSegmentoRestriccion(struct Triangulacion *tr, struct Segmento *seg);
+void imprimirEstadisticas(struct Triangulacion *tr);
+int verificarTriangulacion(struct Triangulacion *tr);
 
 /*********                         Funciones                         **********/
 /**                                                                          **/
 
 
-/* Funciones de lectura y de gestión de archivos                              */
+/* Funciones de traza                                                         */
 
-static int leerLineaNoVacia(FILE* archivo, char* linea, int maxLen) {
-    while (fgets(linea, maxLen, archivo)) {
-        // Saltar comentarios y líneas vacías
-        if (linea[0] != '#' && linea[0] != '\n' && linea[0] != '\0') {
-            return 1;
+static const char *nombresFases[NUM_FASES] = {
+    "lectura", "ordenamiento", "triangulacion", "restricciones",
+    "vecinos", "refinamiento", "escritura"
+};
+
+static const char *nombresContadores[NUM_CONTADORES] = {
+    "recursiones", "combinaciones", "triangulos_agregados",
+    "triangulos_degenerados", "triangulos_duplicados", "puntos_agregados",
+    "puntos_steiner", "segmentos"
+};
+
+// Destino de todas las trazas: errores y avisos a stderr, el resto a stdout
+void registrarTraza(int nivel, const char *formato, ...) {
+    if (nivel == NIVEL_ERROR && mensajeError != NULL && mensajeError[0] == '\0') {
+        va_list copia;
+        va_start(copia, formato);
+        vsnprintf(mensajeError, TAMANO_MENSAJE_ERROR, formato, copia);
+        va_end(copia);
+
+        // Sin el salto de línea final
+        size_t longitud = strlen(mensajeError);
+        if (longitud > 0 && mensajeError[longitud - 1] == '\n') {
+            mensajeError[longitud - 1] = '\0';
         }
     }
-    return 0;
-}
+    if (nivel > nivelDetalle) return;
 
-static int leerSegmentos(FILE* archivo, struct EntradaPoly* entrada) {
-    char linea[256];
-    
-    // Leer cabecera de segmentos
-    if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-        return 0;
+    FILE *destino = (nivel <= NIVEL_AVISO) ? stderr : stdout;
+    if (nivel == NIVEL_ERROR) {
+        fputs("[ERROR] ", destino);
+    } else if (nivel == NIVEL_AVISO) {
+        fputs("[AVISO] ", destino);
     }
 
-    int numMarcadores;
-    if (sscanf(linea, "%d %d", &entrada->numSegmentos, &numMarcadores) != 2) {
-        return 0;
-    }
+    va_list argumentos;
+    va_start(argumentos, formato);
+    vfprintf(destino, formato, argumentos);
+    va_end(argumentos);
+}
 
-    if (entrada->numSegmentos > 0) {
-        entrada->segmentos = malloc(entrada->numSegmentos * sizeof(struct Segmento));
-        if (numMarcadores) {
-            entrada->marcadoresSegmentos = malloc(entrada->numSegmentos * sizeof(int));
-        }
+// Reloj monótono en segundos
+double tiempoActual(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frecuencia, contador;
+    QueryPerformanceFrequency(&frecuencia);
+    QueryPerformanceCounter(&contador);
+    return (double)contador.QuadPart / (double)frecuencia.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
 
-        for (int i = 0; i < entrada->numSegmentos; i++) {
-            if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-                return 0;
-            }
+#ifdef CONTADORES_HW
+static const char *nombresContadoresHW[NUM_CONTADORES_HW] = {
+    "ciclos", "instrucciones", "fallos_l1d", "fallos_llc", "fallos_salto"
+};
 
-            int indice;
-            if (numMarcadores) {
-                if (sscanf(linea, "%d %d %d %d", &indice, 
-                          &entrada->segmentos[i].v1, 
-                          &entrada->segmentos[i].v2,
-                          &entrada->segmentos[i].marcador) != 4) {
-                    return 0;
-                }
-            } else {
-                if (sscanf(linea, "%d %d %d", &indice, 
-                          &entrada->segmentos[i].v1, 
-                          &entrada->segmentos[i].v2) != 3) {
-                    return 0;
-                }
-                entrada->segmentos[i].marcador = 0;
-            }
-        }
+// Abre los contadores del hilo actual (solo espacio de usuario). Cada uno se
+// abre por separado: si el núcleo o el procesador no ofrece alguno, los
+// demás siguen funcionando.
+static void abrirContadoresHW(void) {
+    static const struct { uint32_t tipo; uint64_t config; } eventos[NUM_CONTADORES_HW] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+    };
+
+    contadoresHWAbiertos = true;
+    int disponibles = 0;
+    for (int i = 0; i < NUM_CONTADORES_HW; i++) {
+        struct perf_event_attr atributos;
+        memset(&atributos, 0, sizeof(atributos));
+        atributos.size = sizeof(atributos);
+        atributos.type = eventos[i].tipo;
+        atributos.config = eventos[i].config;
+        atributos.exclude_kernel = 1;
+        atributos.exclude_hv = 1;
+
+        descriptoresHW[i] = (int)syscall(SYS_perf_event_open, &atributos, 0, -1, -1, 0);
+        if (descriptoresHW[i] >= 0) disponibles++;
+    }
+    if (disponibles < NUM_CONTADORES_HW) {
+        TRAZA_AVISO("perf_event_open: %d de %d contadores disponibles (%s); "
+                    "revise /proc/sys/kernel/perf_event_paranoid\n",
+                    disponibles, NUM_CONTADORES_HW, strerror(errno));
     }
-    return 1;
 }
 
-static int leerAgujeros(FILE* archivo, struct EntradaPoly* entrada) {
-    char linea[256];
-    
-    if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
+static long long leerContadorHW(int i) {
+    long long valor;
+    if (descriptoresHW[i] < 0 || read(descriptoresHW[i], &valor, sizeof(valor)) != sizeof(valor)) {
         return 0;
     }
+    return valor;
+}
+#endif
+
+void iniciarTramo(enum FaseTraza fase) {
+#ifdef DELAUNAY_TRAZAS
+#ifdef CONTADORES_HW
+    if (!contadoresHWAbiertos) abrirContadoresHW();
+    for (int i = 0; i < NUM_CONTADORES_HW; i++) inicioHW[fase][i] = leerContadorHW(i);
+#endif
+    inicioFases[fase] = tiempoActual();
+#else
+    (void)fase;
+#endif
+}
 
-    if (sscanf(linea, "%d", &entrada->numAgujeros) != 1) {
-        return 0;
+void terminarTramo(enum FaseTraza fase) {
+#ifdef DELAUNAY_TRAZAS
+    tiempoFases[fase] += tiempoActual() - inicioFases[fase];
+    llamadasFases[fase]++;
+#ifdef CONTADORES_HW
+    for (int i = 0; i < NUM_CONTADORES_HW; i++) {
+        valoresHW[fase][i] += leerContadorHW(i) - inicioHW[fase][i];
     }
+#endif
+#else
+    (void)fase;
+#endif
+}
 
-    if (entrada->numAgujeros > 0) {
-        entrada->agujeros = malloc(entrada->numAgujeros * sizeof(struct Punto));
-        
-        for (int i = 0; i < entrada->numAgujeros; i++) {
-            if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-                return 0;
-            }
+// Cierra los contadores de hardware del hilo actual
+void cerrarContadoresHW(void) {
+#ifdef CONTADORES_HW
+    if (!contadoresHWAbiertos) return;
+    for (int i = 0; i < NUM_CONTADORES_HW; i++) {
+        if (descriptoresHW[i] >= 0) close(descriptoresHW[i]);
+        descriptoresHW[i] = -1;
+    }
+    contadoresHWAbiertos = false;
+#endif
+}
 
-            int indice;
-            if (sscanf(linea, "%d %lf %lf", &indice, 
-                      &entrada->agujeros[i].x, 
-                      &entrada->agujeros[i].y) != 3) {
-                return 0;
-            }
-            entrada->agujeros[i].indice = indice;
+// Resumen de tramos y contadores (solo en binarios con -DDELAUNAY_TRAZAS)
+void imprimirResumenTrazas(void) {
+#ifdef DELAUNAY_TRAZAS
+    TRAZA_INFO("\n%-16s %8s %12s\n", "fase", "llamadas", "segundos");
+    for (int i = 0; i < NUM_FASES; i++) {
+        if (llamadasFases[i] > 0) {
+            TRAZA_INFO("%-16s %8d %12.6f\n", nombresFases[i], llamadasFases[i], tiempoFases[i]);
         }
     }
-    return 1;
+    for (int i = 0; i < NUM_CONTADORES; i++) {
+        if (contadoresTraza[i] > 0) {
+            TRAZA_INFO("%-24s %lld\n", nombresContadores[i], contadoresTraza[i]);
+        }
+    }
+#ifdef CONTADORES_HW
+    // Tabla por fase; "n/d" si el contador no se pudo abrir
+    TRAZA_INFO("\n%-16s", "fase");
+    for (int j = 0; j < NUM_CONTADORES_HW; j++) TRAZA_INFO(" %15s", nombresContadoresHW[j]);
+    TRAZA_INFO(" %6s\n", "IPC");
+    for (int i = 0; i < NUM_FASES; i++) {
+        if (llamadasFases[i] == 0) continue;
+        TRAZA_INFO("%-16s", nombresFases[i]);
+        for (int j = 0; j < NUM_CONTADORES_HW; j++) {
+            if (descriptoresHW[j] >= 0) TRAZA_INFO(" %15lld", valoresHW[i][j]);
+            else TRAZA_INFO(" %15s", "n/d");
+        }
+        if (descriptoresHW[HW_CICLOS] >= 0 && descriptoresHW[HW_INSTRUCCIONES] >= 0 &&
+            valoresHW[i][HW_CICLOS] > 0) {
+            TRAZA_INFO(" %6.2f\n", (double)valoresHW[i][HW_INSTRUCCIONES] / valoresHW[i][HW_CICLOS]);
+        } else {
+            TRAZA_INFO(" %6s\n", "n/d");
+        }
+    }
+#endif
+#else
+    (void)nombresFases;
+    (void)nombresContadores;
+#endif
 }
 
-static int leerRegiones(FILE* archivo, struct EntradaPoly* entrada) {
-    char linea[256];
-    
-    if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-        return 0;
-    }
+// Pone en cero tramos y contadores del hilo actual (entre mediciones)
+void reiniciarTrazas(void) {
+#ifdef DELAUNAY_TRAZAS
+    memset(contadoresTraza, 0, sizeof(contadoresTraza));
+    memset(tiempoFases, 0, sizeof(tiempoFases));
+    memset(inicioFases, 0, sizeof(inicioFases));
+    memset(llamadasFases, 0, sizeof(llamadasFases));
+#endif
+#ifdef CONTADORES_HW
+    memset(valoresHW, 0, sizeof(valoresHW));
+#endif
+    reiniciarContadoresOperacion();
+}
 
-    if (sscanf(linea, "%d", &entrada->numRegiones) != 1) {
-        return 0;
-    }
 
-    if (entrada->numRegiones > 0) {
-        entrada->regiones = malloc(entrada->numRegiones * sizeof(struct Region));
-        
-        for (int i = 0; i < entrada->numRegiones; i++) {
-            if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-                return 0;
-            }
+/* Contadores de operaciones                                                  */
+
+static const struct {
+    const char *nombre;
+    size_t desplazamiento;
+} camposContadores[] = {
+    { "orientaciones",               offsetof(struct ContadoresOperacion, orientaciones) },
+    { "orientaciones_inciertas",     offsetof(struct ContadoresOperacion, orientacionesInciertas) },
+    { "circunferencias",             offsetof(struct ContadoresOperacion, circunferencias) },
+    { "circunferencias_inciertas",   offsetof(struct ContadoresOperacion, circunferenciasInciertas) },
+    { "intercambios",                offsetof(struct ContadoresOperacion, intercambios) },
+    { "recorridos",                  offsetof(struct ContadoresOperacion, recorridos) },
+    { "triangulos_recorridos",       offsetof(struct ContadoresOperacion, triangulosRecorridos) },
+    { "max_recorrido",               offsetof(struct ContadoresOperacion, maxRecorrido) },
+    { "cavidades",                   offsetof(struct ContadoresOperacion, cavidades) },
+    { "triangulos_cavidad",          offsetof(struct ContadoresOperacion, triangulosCavidad) },
+    { "max_cavidad",                 offsetof(struct ContadoresOperacion, maxCavidad) },
+    { "steiner_aceptados",           offsetof(struct ContadoresOperacion, steinerAceptados) },
+    { "steiner_fuera_de_limites",    offsetof(struct ContadoresOperacion, steinerFueraDeLimites) },
+    { "steiner_cercanos",            offsetof(struct ContadoresOperacion, steinerCercanos) },
+    { "steiner_sin_espacio",         offsetof(struct ContadoresOperacion, steinerSinEspacio) },
+    { "steiner_fuera_de_centro",     offsetof(struct ContadoresOperacion, steinerFueraDeCentro) },
+    { "subsegmentos_verificados",    offsetof(struct ContadoresOperacion, subsegmentosVerificados) },
+    { "subsegmentos_divididos",      offsetof(struct ContadoresOperacion, subsegmentosDivididos) },
+    { "vertices_repetidos",          offsetof(struct ContadoresOperacion, verticesRepetidos) },
+    { "asignaciones_arena",          offsetof(struct ContadoresOperacion, asignacionesArena) },
+    { "asignaciones_arena_fallidas", offsetof(struct ContadoresOperacion, asignacionesArenaFallidas) },
+    { "asignaciones_monton",         offsetof(struct ContadoresOperacion, asignacionesMonton) },
+    { "aciertos_cache",              offsetof(struct ContadoresOperacion, aciertosCache) },
+    { "fallos_cache",                offsetof(struct ContadoresOperacion, fallosCache) }
+};
 
-            int indice;
-            if (sscanf(linea, "%d %lf %lf %d %lf", &indice, 
-                      &entrada->regiones[i].x, 
-                      &entrada->regiones[i].y,
-                      &entrada->regiones[i].atributo,
-                      &entrada->regiones[i].areaMaxima) != 5) {
-                return 0;
-            }
+void reiniciarContadoresOperacion(void) {
+    memset(&contadoresOperacion, 0, sizeof(contadoresOperacion));
+}
+
+// Escribe los contadores como un objeto JSON de una línea. Devuelve la
+// longitud (como snprintf); si no cupo, el texto queda truncado.
+int formatearContadoresJSON(const struct ContadoresOperacion *c, char *destino, size_t tamano) {
+    size_t usado = 0;
+    int numCampos = (int)(sizeof(camposContadores) / sizeof(camposContadores[0]));
+    for (int i = 0; i <= numCampos; i++) {
+        char campo[96];
+        int longitud;
+        if (i == numCampos) {
+            longitud = snprintf(campo, sizeof(campo), "}");
+        } else {
+            long long valor = *(const long long *)((const char *)c + camposContadores[i].desplazamiento);
+            longitud = snprintf(campo, sizeof(campo), "%s\"%s\": %lld",
+                                i == 0 ? "{" : ", ", camposContadores[i].nombre, valor);
         }
+        if (usado + longitud < tamano) memcpy(destino + usado, campo, longitud + 1);
+        usado += longitud;
     }
-    return 1;
+    return (int)usado;
 }
 
-struct EntradaPoly* leerArchivoPoly(const char *nombreArchivo) {
-    FILE *archivo = fopen(nombreArchivo, "r");
+int guardarContadoresJSON(const struct ContadoresOperacion *c, const char *nombreArchivo) {
+    char json[TAMANO_JSON_CONTADORES];
+    formatearContadoresJSON(c, json, sizeof(json));
+
+    FILE *archivo = fopen(nombreArchivo, "w");
     if (!archivo) {
-        printf("[ERROR] No se pudo abrir el archivo %s\n", nombreArchivo);
-        return NULL;
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombreArchivo);
+        return 0;
     }
-
-    struct EntradaPoly *entrada = (struct EntradaPoly*)malloc(sizeof(struct EntradaPoly));
-    if (!entrada) {
-        printf("[ERROR] No se pudo asignar memoria para la estructura de entrada\n");
-        fclose(archivo);
-        return NULL;
+    fprintf(archivo, "%s\n", json);
+    int correcto = !ferror(archivo);
+    if (fclose(archivo) != 0 || !correcto) {
+        TRAZA_ERROR("No se pudo escribir el archivo %s\n", nombreArchivo);
+        return 0;
     }
+    return 1;
+}
 
-    // Inicializar con valores por defecto
-    memset(entrada, 0, sizeof(struct EntradaPoly));
 
-    char linea[256];
-    int dim; // Añadimos la variable dim aquí
 
-    // Leer sección de vértices
-    if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-        printf("[ERROR] Archivo vacío o mal formateado\n");
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+/* Funciones de lectura y de gestión de archivos                              */
+
+// Proyecta el archivo completo en memoria. En POSIX se usa mmap; en Windows
+// (o si mmap falla) se lee el archivo entero a un bloque de memoria.
+static int mapearArchivo(const char *nombreArchivo, struct ArchivoMapeado *mapa) {
+    memset(mapa, 0, sizeof(struct ArchivoMapeado));
+
+#ifndef _WIN32
+    int descriptor = open(nombreArchivo, O_RDONLY);
+    if (descriptor < 0) {
+        return 0;
     }
 
-    // Procesar primera línea: número de vértices, dimensión, atributos, marcadores
-    if (sscanf(linea, "%d %d %d %d", &entrada->numVertices, &dim, 
-               &entrada->numAtributos, &entrada->numMarcadores) != 4) {
-        printf("[ERROR] Error al leer la cabecera de vértices\n");
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        return 0;
     }
 
-    // Verificar dimensión
-    if (dim != 2) {
-        printf("[ERROR] Solo se soportan archivos 2D (dimensión = %d)\n", dim);
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+    mapa->longitud = (size_t)info.st_size;
+    if (mapa->longitud == 0) {
+        close(descriptor);
+        mapa->datos = "";
+        return 1;
     }
 
-    // Asignar memoria para vértices y sus atributos
-    entrada->vertices = malloc(entrada->numVertices * sizeof(struct Punto));
-    if (entrada->numAtributos > 0) {
-        entrada->atributos = malloc(entrada->numVertices * entrada->numAtributos * sizeof(double));
+    void *datos = mmap(NULL, mapa->longitud, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (datos != MAP_FAILED) {
+        // La lectura es secuencial por bloques: pedir lectura anticipada al kernel
+        madvise(datos, mapa->longitud, MADV_SEQUENTIAL | MADV_WILLNEED);
+        mapa->datos = datos;
+        mapa->proyectado = true;
+        return 1;
     }
-    if (entrada->numMarcadores > 0) {
-        entrada->marcadores = malloc(entrada->numVertices * sizeof(int));
+#endif
+
+    FILE *archivo = fopen(nombreArchivo, "rb");
+    if (!archivo) {
+        return 0;
     }
 
-    // Leer los vértices
-    for (int i = 0; i < entrada->numVertices; i++) {
-        if (!leerLineaNoVacia(archivo, linea, sizeof(linea))) {
-            printf("[ERROR] Error al leer vértice %d\n", i);
-            liberarEntradaPoly(entrada);
-            fclose(archivo);
-            return NULL;
-        }
+    fseek(archivo, 0, SEEK_END);
+    long longitud = ftell(archivo);
+    fseek(archivo, 0, SEEK_SET);
+    if (longitud < 0) {
+        fclose(archivo);
+        return 0;
+    }
 
-        int indice;
-        double x, y;
-        if (sscanf(linea, "%d %lf %lf", &indice, &x, &y) != 3) {
-            printf("[ERROR] Formato inválido para vértice %d\n", i);
-            liberarEntradaPoly(entrada);
-            fclose(archivo);
-            return NULL;
-        }
+    char *bloque = malloc((size_t)longitud + 1);
+    if (!bloque) {
+        fclose(archivo);
+        return 0;
+    }
 
-        entrada->vertices[i].x = x;
-        entrada->vertices[i].y = y;
-        entrada->vertices[i].indice = indice - 1; // Convertir a base-0
+    mapa->longitud = fread(bloque, 1, (size_t)longitud, archivo);
+    bloque[mapa->longitud] = '\0';
+    fclose(archivo);
 
-        // Leer atributos si existen
-        char *token = strtok(linea, " \t");
-        for (int j = 0; j < 3; j++) token = strtok(NULL, " \t"); // Saltar índice y coordenadas
-        for (int j = 0; j < entrada->numAtributos; j++) {
-            token = strtok(NULL, " \t");
-            if (token) {
-                entrada->atributos[i * entrada->numAtributos + j] = atof(token);
-            }
-        }
+    mapa->datos = bloque;
+    mapa->proyectado = false;
+    return 1;
+}
 
-        // Leer marcador si existe
-        if (entrada->numMarcadores > 0) {
-            token = strtok(NULL, " \t");
-            if (token) {
-                entrada->marcadores[i] = atoi(token);
-            }
-        }
+static void liberarArchivoMapeado(struct ArchivoMapeado *mapa) {
+    if (mapa->longitud == 0) {
+        return;
     }
-
-    // Leer segmentos
-    if (!leerSegmentos(archivo, entrada)) {
-        printf("[ERROR] Error al leer segmentos\n");
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+#ifndef _WIN32
+    if (mapa->proyectado) {
+        munmap((void*)mapa->datos, mapa->longitud);
+        return;
     }
+#endif
+    free((void*)mapa->datos);
+}
 
-    // Leer agujeros
-    if (!leerAgujeros(archivo, entrada)) {
-        printf("[ERROR] Error al leer agujeros\n");
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+static inline bool esBlanco(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+// Salta espacios dentro de la línea actual (no avanza de línea)
+static inline void saltarBlancos(struct Escaner *esc) {
+    while (esc->p < esc->fin && esBlanco(*esc->p)) {
+        esc->p++;
     }
+}
 
-    // Leer regiones
-    if (!leerRegiones(archivo, entrada)) {
-        printf("[ERROR] Error al leer regiones\n");
-        liberarEntradaPoly(entrada);
-        fclose(archivo);
-        return NULL;
+// Verdadero si no quedan campos en la línea actual (fin de línea o comentario)
+static inline bool finDeRegistro(struct Escaner *esc) {
+    saltarBlancos(esc);
+    return esc->p >= esc->fin || *esc->p == '\n' || *esc->p == '#';
+}
+
+// Avanza hasta el inicio de la siguiente línea
+static inline void saltarLinea(struct Escaner *esc) {
+    const char *salto = memchr(esc->p, '\n', (size_t)(esc->fin - esc->p));
+    esc->p = salto ? salto + 1 : esc->fin;
+}
+
+// Avanza hasta el siguiente registro, saltando líneas vacías y comentarios.
+// Devuelve 0 si se llegó al final del archivo.
+static int siguienteRegistro(struct Escaner *esc) {
+    while (esc->p < esc->fin) {
+        saltarBlancos(esc);
+        if (esc->p >= esc->fin) break;
+        if (*esc->p != '\n' && *esc->p != '#') {
+            return 1;
+        }
+        saltarLinea(esc);
     }
+    return 0;
+}
 
-    fclose(archivo);
-    return entrada;
+static inline bool esDelimitador(struct Escaner *esc) {
+    return esc->p >= esc->fin || esBlanco(*esc->p) || *esc->p == '\n' || *esc->p == '#';
 }
 
-void guardarArchivoNode(struct Triangulacion* tr, const char* nombreArchivo) {
-    FILE* archivo = fopen(nombreArchivo, "w");
-    if (!archivo) {
-        printf("[ERROR] No se pudo crear el archivo %s\n", nombreArchivo);
-        return;
+// Lee un entero del registro actual directamente de los bytes del archivo
+static int escanearEntero(struct Escaner *esc, int *valor) {
+    if (finDeRegistro(esc)) return 0;
+
+    const char *p = esc->p;
+    bool negativo = false;
+    if (*p == '-' || *p == '+') {
+        negativo = (*p == '-');
+        p++;
     }
 
-    // Escribir encabezado
-    fprintf(archivo, "%d 2 0 1\n", tr->numPuntos);
-    
-    // Guardar los puntos con sus coordenadas originales
-    for(int i = 0; i < tr->numPuntos; i++) {
-        int region;
-        // Los primeros n1 puntos son de la región 1, el resto de la región 2
-        if (i < tr->numPuntosRegion1) {
-            region = 1;
-        } else {
-            region = 2;
+    long long acumulado = 0;
+    const char *inicioDigitos = p;
+    while (p < esc->fin && *p >= '0' && *p <= '9') {
+        if (acumulado < INT_MAX) {
+            acumulado = acumulado * 10 + (*p - '0');
         }
-        
-        fprintf(archivo, "%d %.6f %.6f %d\n", 
-                i + 1,                // índice del punto
-                tr->puntos[i].x,     // coordenada x
-                tr->puntos[i].y,     // coordenada y
-                region);             // región (1 o 2)
+        p++;
     }
+    if (p == inicioDigitos || acumulado > INT_MAX) return 0;
 
-    fprintf(archivo, "# Generated by Delaunay Triangulation\n");
-    fclose(archivo);
+    esc->p = p;
+    if (!esDelimitador(esc)) return 0;
+
+    *valor = negativo ? -(int)acumulado : (int)acumulado;
+    return 1;
 }
 
-void guardarArchivoEle(struct Triangulacion *tr, const char *nombreArchivo) {
-    printf("Iniciando guardarArchivoEle...\n");
-    
-    if (tr == NULL) {
-        printf("Error: tr es NULL\n");
-        return;
+// Potencias de diez representables exactamente en double
+static const double potenciasDiezExactas[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Lee un real del registro actual. La mantisa se acumula en un entero de 64
+// bits; si tiene a lo sumo 15 dígitos y el exponente decimal cabe en la tabla
+// de potencias exactas, una sola multiplicación o división da el resultado
+// correctamente redondeado. Los casos restantes recurren a strtod.
+static int escanearReal(struct Escaner *esc, double *valor) {
+    if (finDeRegistro(esc)) return 0;
+
+    const char *inicio = esc->p;
+    const char *p = inicio;
+    bool negativo = false;
+    if (*p == '-' || *p == '+') {
+        negativo = (*p == '-');
+        p++;
     }
 
-    printf("Número de triángulos en tr: %d\n", tr->numTriangulos);
-    
-    FILE *archivo = fopen(nombreArchivo, "w");
-    if (archivo == NULL) {
-        printf("Error: No se puede crear el archivo %s. errno: %d\n", nombreArchivo, errno);
-        return;
+    uint64_t mantisa = 0;
+    int digitos = 0;
+    int exponente = 0;
+    bool hayDigitos = false;
+    bool truncado = false;
+
+    while (p < esc->fin && *p >= '0' && *p <= '9') {
+        hayDigitos = true;
+        if (digitos < 19) {
+            mantisa = mantisa * 10 + (uint64_t)(*p - '0');
+            if (mantisa != 0) digitos++;
+        } else {
+            exponente++;
+            truncado = true;
+        }
+        p++;
     }
 
-    // Contar solo triángulos válidos y verificar índices
-    int triangulos_validos = 0;
-    int i;
-    for (i = 0; i < tr->numTriangulos; i++) {
-        if (!tr->triangulos[i].esTrianguloSuper) {
-            // Verificar que los índices sean válidos
-            if (tr->triangulos[i].vertices[0]->indice >= 0 && 
-                tr->triangulos[i].vertices[0]->indice < tr->numPuntos &&
-                tr->triangulos[i].vertices[1]->indice >= 0 && 
-                tr->triangulos[i].vertices[1]->indice < tr->numPuntos &&
-                tr->triangulos[i].vertices[2]->indice >= 0 && 
-                tr->triangulos[i].vertices[2]->indice < tr->numPuntos) {
-                triangulos_validos++;
+    if (p < esc->fin && *p == '.') {
+        p++;
+        while (p < esc->fin && *p >= '0' && *p <= '9') {
+            hayDigitos = true;
+            if (digitos < 19) {
+                mantisa = mantisa * 10 + (uint64_t)(*p - '0');
+                if (mantisa != 0) digitos++;
+                exponente--;
             } else {
-                printf("Triángulo %d ignorado por índices inválidos: %d %d %d\n",
-                    i,
-                    tr->triangulos[i].vertices[0]->indice,
-                    tr->triangulos[i].vertices[1]->indice,
-                    tr->triangulos[i].vertices[2]->indice);
+                truncado = true;
             }
+            p++;
         }
     }
-    
-    printf("Número de triángulos válidos: %d\n", triangulos_validos);
-    fprintf(archivo, "%d  3  0\n", triangulos_validos);
-    
-    int indice = 1;
-    for (i = 0; i < tr->numTriangulos; i++) {
-        if (!tr->triangulos[i].esTrianguloSuper) {
-            // Solo escribir triángulos con índices válidos
-            if (tr->triangulos[i].vertices[0]->indice >= 0 && 
-                tr->triangulos[i].vertices[0]->indice < tr->numPuntos &&
-                tr->triangulos[i].vertices[1]->indice >= 0 && 
-                tr->triangulos[i].vertices[1]->indice < tr->numPuntos &&
-                tr->triangulos[i].vertices[2]->indice >= 0 && 
-                tr->triangulos[i].vertices[2]->indice < tr->numPuntos) {
-                
-                fprintf(archivo, "%d  %d  %d  %d\n",
-                        indice++,
-                        tr->triangulos[i].vertices[0]->indice + 1,  // Convertir a base-1 para MATLAB
-                        tr->triangulos[i].vertices[1]->indice + 1,
-                        tr->triangulos[i].vertices[2]->indice + 1);
-                
-                printf("Escribiendo triángulo %d: (%d, %d, %d)\n", 
-                       indice - 1,
-                       tr->triangulos[i].vertices[0]->indice + 1,
-                       tr->triangulos[i].vertices[1]->indice + 1,
-                       tr->triangulos[i].vertices[2]->indice + 1);
+
+    if (!hayDigitos) return 0;
+
+    if (p < esc->fin && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool expNegativo = false;
+        if (q < esc->fin && (*q == '-' || *q == '+')) {
+            expNegativo = (*q == '-');
+            q++;
+        }
+        if (q < esc->fin && *q >= '0' && *q <= '9') {
+            int exp = 0;
+            while (q < esc->fin && *q >= '0' && *q <= '9') {
+                if (exp < 100000) exp = exp * 10 + (*q - '0');
+                q++;
             }
+            exponente += expNegativo ? -exp : exp;
+            p = q;
         }
     }
 
-    fprintf(archivo, "# Generated by Delaunay Triangulation\n");
-    fclose(archivo);
-    printf("Archivo .ele guardado exitosamente.\n");
-}
+    esc->p = p;
+    if (!esDelimitador(esc)) return 0;
 
+    if (!truncado && digitos <= 15 && exponente >= -22 && exponente <= 22) {
+        double resultado = (double)mantisa;
+        if (exponente < 0) {
+            resultado /= potenciasDiezExactas[-exponente];
+        } else {
+            resultado *= potenciasDiezExactas[exponente];
+        }
+        *valor = negativo ? -resultado : resultado;
+        return 1;
+    }
 
-/* Funciones de Gestión de Memoria                                                */
+    // Camino lento: copiar el token (el archivo proyectado no termina en '\0')
+    char token[128];
+    size_t longitud = (size_t)(p - inicio);
+    if (longitud >= sizeof(token)) return 0;
+    memcpy(token, inicio, longitud);
+    token[longitud] = '\0';
+    *valor = strtod(token, NULL);
+    return 1;
+}
 
-struct PoolMemoria* inicializarPool(int capacidadMaxima, int tamañoElemento) {
-    struct PoolMemoria* pool = (struct PoolMemoria*)malloc(sizeof(struct PoolMemoria));
-    if (!pool) {
-        printf("[ERROR] No se pudo crear el pool de memoria\n");
-        return NULL;
+// Cuenta los registros (líneas no vacías y sin comentario) en [inicio, fin)
+static int contarRegistros(const char *inicio, const char *fin) {
+    struct Escaner esc = { inicio, fin };
+    int cuenta = 0;
+    while (siguienteRegistro(&esc)) {
+        cuenta++;
+        saltarLinea(&esc);
     }
+    return cuenta;
+}
 
-    pool->elementos = (void**)malloc(capacidadMaxima * sizeof(void*));
-    if (!pool->elementos) {
-        printf("[ERROR] No se pudo asignar memoria para los elementos del pool\n");
-        free(pool);
-        return NULL;
+// Lee el registro de un vértice: índice, x, y, atributos y marcador. Los
+// atributos y el marcador ausentes se toman como cero, igual que triangle.c.
+static int leerRegistroVertice(struct Escaner *esc, struct EntradaPoly *entrada, int i) {
+    int numero;
+    double x, y;
+    if (!escanearEntero(esc, &numero) ||
+        !escanearReal(esc, &x) ||
+        !escanearReal(esc, &y)) {
+        return 0;
     }
 
-    pool->elementoActual = malloc(capacidadMaxima * tamañoElemento);
-    if (!pool->elementoActual) {
-        printf("[ERROR] No se pudo asignar el bloque de memoria principal\n");
-        free(pool->elementos);
-        free(pool);
-        return NULL;
+    entrada->vertices[i].x = x;
+    entrada->vertices[i].y = y;
+    entrada->vertices[i].indice = numero - entrada->primerNumero; // Convertir a base-0
+
+    for (int j = 0; j < entrada->numAtributos; j++) {
+        double atributo = 0.0;
+        if (!finDeRegistro(esc) && !escanearReal(esc, &atributo)) {
+            return 0;
+        }
+        entrada->atributos[i * entrada->numAtributos + j] = atributo;
     }
 
-    pool->capacidadMaxima = capacidadMaxima;
-    pool->elementosLibres = capacidadMaxima;
-    pool->tamañoElemento = tamañoElemento;
-
-    // Inicializar la lista de elementos libres
-    for (int i = 0; i < capacidadMaxima; i++) {
-        pool->elementos[i] = (char*)pool->elementoActual + (i * tamañoElemento);
+    if (entrada->numMarcadores > 0) {
+        int marcador = 0;
+        if (!finDeRegistro(esc) && !escanearEntero(esc, &marcador)) {
+            return 0;
+        }
+        entrada->marcadores[i] = marcador;
     }
 
-    return pool;
+    saltarLinea(esc);
+    return 1;
 }
 
-void* obtenerDelPool(struct PoolMemoria* pool) {
-    if (!pool || pool->elementosLibres <= 0) {
-        return NULL;
+// Fragmento de la sección de vértices asignado a un hilo
+struct FragmentoVertices {
+    const char *inicio;
+    const char *fin;
+    int primerRegistro;
+    int numRegistros;
+    int errorEnRegistro;   // -1 si no hubo error
+    const char *finLectura;
+};
+
+// Lee la sección de vértices que comienza en esc->p. El texto restante se
+// divide en fragmentos alineados a inicio de línea; cada hilo cuenta sus
+// registros, una suma prefija asigna a cada fragmento su primer índice y
+// después todos los fragmentos se leen en paralelo.
+static int leerSeccionVertices(struct Escaner *esc, struct EntradaPoly *entrada) {
+    const int n = entrada->numVertices;
+    if (n <= 0) return 1;
+
+    entrada->vertices = malloc((size_t)n * sizeof(struct Punto));
+    if (entrada->numAtributos > 0) {
+        entrada->atributos = malloc((size_t)n * entrada->numAtributos * sizeof(double));
+    }
+    if (entrada->numMarcadores > 0) {
+        entrada->marcadores = malloc((size_t)n * sizeof(int));
+    }
+    if (!entrada->vertices ||
+        (entrada->numAtributos > 0 && !entrada->atributos) ||
+        (entrada->numMarcadores > 0 && !entrada->marcadores)) {
+        TRAZA_ERROR("No se pudo asignar memoria para %d vértices\n", n);
+        return 0;
     }
 
-    void* elemento = pool->elementos[--pool->elementosLibres];
-    memset(elemento, 0, pool->tamañoElemento);
-    return elemento;
-}
+    // La numeración del archivo (base 0 o 1) la fija el primer vértice
+    struct Escaner primero = *esc;
+    if (!siguienteRegistro(&primero) || !escanearEntero(&primero, &entrada->primerNumero)) {
+        TRAZA_ERROR("Formato inválido para vértice 0\n");
+        return 0;
+    }
 
-void devolverAlPool(struct PoolMemoria* pool, void* elemento) {
-    if (!pool || !elemento || pool->elementosLibres >= pool->capacidadMaxima) {
-        return;
+    size_t restante = (size_t)(esc->fin - esc->p);
+    int numFragmentos = 1;
+#ifdef _OPENMP
+    if (restante >= TAMANO_MINIMO_PARALELO) {
+        numFragmentos = 4 * omp_get_max_threads();
     }
+#endif
 
-    pool->elementos[pool->elementosLibres++] = elemento;
-}
+    struct FragmentoVertices *fragmentos = calloc((size_t)numFragmentos, sizeof(struct FragmentoVertices));
+    if (!fragmentos) return 0;
 
-void liberarPool(struct PoolMemoria* pool) {
-    if (pool) {
-        free(pool->elementoActual);
-        free(pool->elementos);
-        free(pool);
+    // Cortes alineados al inicio de la línea siguiente
+    const char *corte = esc->p;
+    for (int k = 0; k < numFragmentos; k++) {
+        fragmentos[k].inicio = corte;
+        if (k == numFragmentos - 1) {
+            corte = esc->fin;
+        } else {
+            struct Escaner aux = { esc->p + (restante / numFragmentos) * (k + 1), esc->fin };
+            if (aux.p < corte) aux.p = corte;
+            if (aux.p > esc->p && aux.p[-1] != '\n') saltarLinea(&aux);
+            corte = aux.p;
+        }
+        fragmentos[k].fin = corte;
+        fragmentos[k].errorEnRegistro = -1;
     }
-}
 
-void liberarEntradaPoly(struct EntradaPoly* entrada) {
-    if (entrada) {
-        free(entrada->vertices);
-        free(entrada->atributos);
-        free(entrada->marcadores);
-        free(entrada->segmentos);
-        free(entrada->marcadoresSegmentos);
-        free(entrada->agujeros);
-        free(entrada->regiones);
-        free(entrada);
+    // Paso 1: contar registros por fragmento
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int k = 0; k < numFragmentos; k++) {
+        fragmentos[k].numRegistros = contarRegistros(fragmentos[k].inicio, fragmentos[k].fin);
     }
-}
 
+    int acumulado = 0;
+    for (int k = 0; k < numFragmentos; k++) {
+        fragmentos[k].primerRegistro = acumulado;
+        acumulado += fragmentos[k].numRegistros;
+    }
+    if (acumulado < n) {
+        TRAZA_ERROR("Error al leer vértice %d\n", acumulado);
+        free(fragmentos);
+        return 0;
+    }
 
-/* Funciones de Operaciones Aritméticas                                           */
+    // Paso 2: leer los vértices de cada fragmento en su posición final
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int k = 0; k < numFragmentos; k++) {
+        struct FragmentoVertices *f = &fragmentos[k];
+        if (f->primerRegistro >= n) continue;
+
+        struct Escaner local = { f->inicio, f->fin };
+        int ultimo = f->primerRegistro + f->numRegistros;
+        if (ultimo > n) ultimo = n;
+
+        for (int i = f->primerRegistro; i < ultimo; i++) {
+            siguienteRegistro(&local);
+            if (!leerRegistroVertice(&local, entrada, i)) {
+                f->errorEnRegistro = i;
+                break;
+            }
+        }
+        f->finLectura = local.p;
+    }
 
-// Función para calcular el área de un triángulo usando determinantes
-double areaTriangulo(struct Punto *a, struct Punto *b, struct Punto *c) {
-    return fabs((b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y)) / 2.0;
+    int resultado = 1;
+    for (int k = 0; k < numFragmentos; k++) {
+        struct FragmentoVertices *f = &fragmentos[k];
+        if (f->errorEnRegistro >= 0) {
+            TRAZA_ERROR("Formato inválido para vértice %d\n", f->errorEnRegistro);
+            resultado = 0;
+            break;
+        }
+        // El fragmento que contiene el último vértice marca el fin de la sección
+        if (f->primerRegistro < n && f->primerRegistro + f->numRegistros >= n) {
+            esc->p = f->finLectura;
+        }
+    }
+
+    free(fragmentos);
+    return resultado;
 }
 
-void intercambiarDiagonal(struct Triangulacion *tr, struct Triangulo *t1, struct Triangulo *t2) {
-    // Implementación básica de intercambio de diagonal
-    struct Punto *p1 = NULL, *p2 = NULL, *p3 = NULL, *p4 = NULL;
-    
-    // Encontrar los cuatro puntos del cuadrilátero
-    for(int i = 0; i < 3; i++) {
-        if(!tieneVertice(t2, t1->vertices[i])) p1 = t1->vertices[i];
-        if(!tieneVertice(t1, t2->vertices[i])) p3 = t2->vertices[i];
+// Lee la cabecera "<#vértices> <dimensión> <#atributos> <#marcadores>"
+static int leerCabeceraVertices(struct Escaner *esc, struct EntradaPoly *entrada) {
+    int dim;
+    if (!siguienteRegistro(esc) ||
+        !escanearEntero(esc, &entrada->numVertices) ||
+        !escanearEntero(esc, &dim)) {
+        TRAZA_ERROR("Error al leer la cabecera de vértices\n");
+        return 0;
     }
-    
-    // Encontrar los puntos compartidos
-    for(int i = 0; i < 3; i++) {
-        if(t1->vertices[i] != p1) {
-            if(p2 == NULL) p2 = t1->vertices[i];
-            else p4 = t1->vertices[i];
-        }
+
+    // Atributos y marcadores son opcionales en el formato de triangle.c
+    if (!finDeRegistro(esc) && !escanearEntero(esc, &entrada->numAtributos)) {
+        TRAZA_ERROR("Error al leer la cabecera de vértices\n");
+        return 0;
     }
-    
-    // Crear nuevos triángulos
-    *t1 = *crearTriangulo(p1, p3, p2);
-    *t2 = *crearTriangulo(p1, p3, p4);
-}
+    if (!finDeRegistro(esc) && !escanearEntero(esc, &entrada->numMarcadores)) {
+        TRAZA_ERROR("Error al leer la cabecera de vértices\n");
+        return 0;
+    }
+    saltarLinea(esc);
 
-// Función para calcular el determinante de una matriz 3x3
-double determinante3x3(double matriz[3][3]) {
-    return matriz[0][0] * (matriz[1][1] * matriz[2][2] - matriz[1][2] * matriz[2][1])
-         - matriz[0][1] * (matriz[1][0] * matriz[2][2] - matriz[1][2] * matriz[2][0])
-         + matriz[0][2] * (matriz[1][0] * matriz[2][1] - matriz[1][1] * matriz[2][0]);
+    // Verificar dimensión
+    if (dim != 2) {
+        TRAZA_ERROR("Solo se soportan archivos 2D (dimensión = %d)\n", dim);
+        return 0;
+    }
+    if (entrada->numVertices < 0 || entrada->numAtributos < 0) {
+        TRAZA_ERROR("Error al leer la cabecera de vértices\n");
+        return 0;
+    }
+    return 1;
 }
 
-struct Punto* calcularCircuncentro(struct Triangulo *t) {
-    struct Punto *p1 = t->vertices[0];
-    struct Punto *p2 = t->vertices[1];
-    struct Punto *p3 = t->vertices[2];
-    
-    double d = 2 * (p1->x * (p2->y - p3->y) + 
-                    p2->x * (p3->y - p1->y) + 
-                    p3->x * (p1->y - p2->y));
-    
-    if (fabs(d) < 1e-10) return NULL;  // Triángulo degenerado
-    
-    struct Punto *c = malloc(sizeof(struct Punto));
-    if (!c) return NULL;
-    
-    c->x = ((p1->x*p1->x + p1->y*p1->y) * (p2->y - p3->y) +
-            (p2->x*p2->x + p2->y*p2->y) * (p3->y - p1->y) +
-            (p3->x*p3->x + p3->y*p3->y) * (p1->y - p2->y)) / d;
-            
-    c->y = ((p1->x*p1->x + p1->y*p1->y) * (p3->x - p2->x) +
-            (p2->x*p2->x + p2->y*p2->y) * (p1->x - p3->x) +
-            (p3->x*p3->x + p3->y*p3->y) * (p2->x - p1->x)) / d;
-            
-    return c;
-}
+static int leerSegmentos(struct Escaner *esc, struct EntradaPoly *entrada) {
+    int numMarcadores = 0;
 
-double calcularAreaTriangulo(struct Triangulo *t) {
-    if (t == NULL) return 0.0;
+    // Leer cabecera de segmentos
+    if (!siguienteRegistro(esc) || !escanearEntero(esc, &entrada->numSegmentos)) {
+        return 0;
+    }
+    if (!finDeRegistro(esc) && !escanearEntero(esc, &numMarcadores)) {
+        return 0;
+    }
+    saltarLinea(esc);
 
-    struct Punto *p1 = t->vertices[0];
-    struct Punto *p2 = t->vertices[1];
-    struct Punto *p3 = t->vertices[2];
+    if (entrada->numSegmentos < 0) return 0;
+    if (entrada->numSegmentos == 0) return 1;
 
-    // Fórmula del área usando determinante
-    double area = fabs((p1->x * (p2->y - p3->y) + 
-                       p2->x * (p3->y - p1->y) + 
-                       p3->x * (p1->y - p2->y)) / 2.0);
+    entrada->segmentos = malloc((size_t)entrada->numSegmentos * sizeof(struct Segmento));
+    if (!entrada->segmentos) return 0;
+    if (numMarcadores) {
+        entrada->marcadoresSegmentos = malloc((size_t)entrada->numSegmentos * sizeof(int));
+        if (!entrada->marcadoresSegmentos) return 0;
+    }
 
-    return area;
-}
+    for (int i = 0; i < entrada->numSegmentos; i++) {
+        int indice;
+        struct Segmento *s = &entrada->segmentos[i];
+        if (!siguienteRegistro(esc) ||
+            !escanearEntero(esc, &indice) ||
+            !escanearEntero(esc, &s->v1) ||
+            !escanearEntero(esc, &s->v2)) {
+            return 0;
+        }
 
-double calcularAngulo(struct Punto *p1, struct Punto *p2, struct Punto *p3) {
-    double dx1 = p2->x - p1->x;
-    double dy1 = p2->y - p1->y;
-    double dx2 = p3->x - p1->x;
-    double dy2 = p3->y - p1->y;
-    
-    // Calcular el ángulo usando el producto punto
-    double dot = dx1*dx2 + dy1*dy2;
-    double len1 = sqrt(dx1*dx1 + dy1*dy1);
-    double len2 = sqrt(dx2*dx2 + dy2*dy2);
-    
-    if(len1 == 0 || len2 == 0) return -1;
-    
-    double cosAngulo = dot/(len1*len2);
-    if(cosAngulo > 1) cosAngulo = 1;
-    if(cosAngulo < -1) cosAngulo = -1;
-    
-    return acos(cosAngulo);
-}
+        // Extremos en base-0, con la misma numeración que los vértices
+        s->v1 -= entrada->primerNumero;
+        s->v2 -= entrada->primerNumero;
 
-double distanciaEntrePuntos(struct Punto *p1, struct Punto *p2) {
-    return sqrt(pow(p2->x - p1->x, 2) + pow(p2->y - p1->y, 2));
+        s->marcador = 0;
+        if (numMarcadores && !finDeRegistro(esc) && !escanearEntero(esc, &s->marcador)) {
+            return 0;
+        }
+        if (numMarcadores) {
+            entrada->marcadoresSegmentos[i] = s->marcador;
+        }
+        saltarLinea(esc);
+    }
+    return 1;
 }
 
+static int leerAgujeros(struct Escaner *esc, struct EntradaPoly *entrada) {
+    if (!siguienteRegistro(esc) || !escanearEntero(esc, &entrada->numAgujeros)) {
+        return 0;
+    }
+    saltarLinea(esc);
 
-/* Funciones de verificación y comparación                                        */
+    if (entrada->numAgujeros < 0) return 0;
+    if (entrada->numAgujeros == 0) return 1;
 
-// Función para comparar puntos (primero por x, luego por y)
-int compararPuntos(const void *a, const void *b) {
-    struct Punto *p1 = (struct Punto *)a;
-    struct Punto *p2 = (struct Punto *)b;
-    
-    if (p1->x != p2->x) {
-        return (p1->x > p2->x) ? 1 : -1;
+    entrada->agujeros = malloc((size_t)entrada->numAgujeros * sizeof(struct Punto));
+    if (!entrada->agujeros) return 0;
+
+    for (int i = 0; i < entrada->numAgujeros; i++) {
+        int indice;
+        if (!siguienteRegistro(esc) ||
+            !escanearEntero(esc, &indice) ||
+            !escanearReal(esc, &entrada->agujeros[i].x) ||
+            !escanearReal(esc, &entrada->agujeros[i].y)) {
+            return 0;
+        }
+        entrada->agujeros[i].indice = indice;
+        saltarLinea(esc);
     }
-    return (p1->y > p2->y) ? 1 : -1;
+    return 1;
 }
 
-// Función para verificar si un punto está dentro de un triángulo usando áreas
-bool puntoEnTriangulo(struct Triangulo *t, struct Punto *p) {
-    // Cálculo de áreas usando determinantes
-    double area = areaTriangulo(t->vertices[0], t->vertices[1], t->vertices[2]);
-    double area1 = areaTriangulo(p, t->vertices[1], t->vertices[2]);
-    double area2 = areaTriangulo(t->vertices[0], p, t->vertices[2]);
-    double area3 = areaTriangulo(t->vertices[0], t->vertices[1], p);
+static int leerRegiones(struct Escaner *esc, struct EntradaPoly *entrada) {
+    if (!siguienteRegistro(esc) || !escanearEntero(esc, &entrada->numRegiones)) {
+        return 0;
+    }
+    saltarLinea(esc);
 
-    // Usar tolerancia para comparaciones de punto flotante
-    const double EPSILON = 1e-10;
-    double total = area1 + area2 + area3;
-    
-    return fabs(area - total) < EPSILON;
-}
+    if (entrada->numRegiones < 0) return 0;
+    if (entrada->numRegiones == 0) return 1;
 
-// Función para verificar si un triángulo tiene vértices artificiales
-int tieneVerticeArtificial(struct Triangulo *t) {
-    return t->vertices[0]->indice < 0 || 
-           t->vertices[1]->indice < 0 || 
-           t->vertices[2]->indice < 0;
-}
+    entrada->regiones = malloc((size_t)entrada->numRegiones * sizeof(struct Region));
+    if (!entrada->regiones) return 0;
 
-// Función auxiliar para verificar si un triángulo tiene un vértice
-int tieneVertice(struct Triangulo *t, struct Punto *p) {
-    if(t == NULL || p == NULL) return 0;
-    
-    return (t->vertices[0] == p || 
-            t->vertices[1] == p || 
-            t->vertices[2] == p);
-}
+    for (int i = 0; i < entrada->numRegiones; i++) {
+        int indice;
+        struct Region *r = &entrada->regiones[i];
+        if (!siguienteRegistro(esc) ||
+            !escanearEntero(esc, &indice) ||
+            !escanearReal(esc, &r->x) ||
+            !escanearReal(esc, &r->y)) {
+            return 0;
+        }
 
-// Función para verificar si un punto está dentro del círculo circunscrito
-int puntoEnCircunscrito(struct Triangulo *t, struct Punto *p) {
-    struct Punto *a = t->vertices[0];
-    struct Punto *b = t->vertices[1];
-    struct Punto *c = t->vertices[2];
-    
-    // Matriz para el test del círculo circunscrito
-    double matriz[3][3] = {
-        {a->x - p->x, a->y - p->y, (a->x - p->x) * (a->x - p->x) + (a->y - p->y) * (a->y - p->y)},
-        {b->x - p->x, b->y - p->y, (b->x - p->x) * (b->x - p->x) + (b->y - p->y) * (b->y - p->y)},
-        {c->x - p->x, c->y - p->y, (c->x - p->x) * (c->x - p->x) + (c->y - p->y) * (c->y - p->y)}
-    };
-    
-    // El signo del determinante indica si el punto está dentro o fuera
-    double det = determinante3x3(matriz);
-    
-    // Usamos una pequeña tolerancia para manejar errores de punto flotante
-    double tolerancia = 1e-10;
-    
-    // Si el determinante es positivo, el punto está dentro del círculo
-    return det > tolerancia;
+        // Atributo y área máxima son opcionales
+        double atributo = 0.0;
+        r->areaMaxima = -1.0;
+        if (!finDeRegistro(esc) && !escanearReal(esc, &atributo)) return 0;
+        if (!finDeRegistro(esc) && !escanearReal(esc, &r->areaMaxima)) return 0;
+        r->atributo = (int)atributo;
+        saltarLinea(esc);
+    }
+    return 1;
 }
 
-bool necesitaRefinamiento(struct Triangulo *t, double anguloMinimo, double areaMaxima) {
-    // Verificar área
-    double area = calcularAreaTriangulo(t);
-    if (area > areaMaxima) return true;
-    
-    // Verificar ángulos
-    double angulos[3];
-    calcularAngulos(t, angulos);
-    
-    for (int i = 0; i < 3; i++) {
-        if (angulos[i] < anguloMinimo) return true;
+// Lee un archivo .node (solo la sección de vértices)
+struct EntradaPoly* leerArchivoNode(const char *nombreArchivo) {
+    struct ArchivoMapeado mapa;
+    if (!mapearArchivo(nombreArchivo, &mapa)) {
+        TRAZA_ERROR("No se pudo abrir el archivo %s\n", nombreArchivo);
+        return NULL;
     }
-    
-    return false;
-}
 
-void calcularAngulos(struct Triangulo *t, double *angulos) {
-    for (int i = 0; i < 3; i++) {
-        struct Punto *p1 = t->vertices[i];
-        struct Punto *p2 = t->vertices[(i+1)%3];
-        struct Punto *p3 = t->vertices[(i+2)%3];
-        
-        double dx1 = p2->x - p1->x;
-        double dy1 = p2->y - p1->y;
-        double dx2 = p3->x - p1->x;
-        double dy2 = p3->y - p1->y;
-        
-        angulos[i] = fabs(atan2(dx1*dy2 - dy1*dx2, dx1*dx2 + dy1*dy2));
+    struct EntradaPoly *entrada = calloc(1, sizeof(struct EntradaPoly));
+    if (!entrada) {
+        TRAZA_ERROR("No se pudo asignar memoria para la estructura de entrada\n");
+        liberarArchivoMapeado(&mapa);
+        return NULL;
+    }
+
+    struct Escaner esc = { mapa.datos, mapa.datos + mapa.longitud };
+    if (!leerCabeceraVertices(&esc, entrada) || !leerSeccionVertices(&esc, entrada)) {
+        liberarEntradaPoly(entrada);
+        liberarArchivoMapeado(&mapa);
+        return NULL;
     }
+
+    liberarArchivoMapeado(&mapa);
+    return entrada;
 }
 
-bool esPuntoCercaDelBorde(struct Punto *p, struct Triangulacion *tr) {
-    const double DIST_MIN_BORDE = 0.05;
-    const int NUM_VECINOS = 2; // Reducimos a 2 para ser más selectivos
-    int puntos_cercanos = 0;
-    
-    // Primero verificar si está muy lejos verticalmente
-    double ymin = tr->puntos[0].y;
-    double ymax = tr->puntos[0].y;
-    for(int i = 1; i < tr->numPuntos; i++) {
-        if(tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
-        if(tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+struct EntradaPoly* leerArchivoPoly(const char *nombreArchivo) {
+    struct ArchivoMapeado mapa;
+    if (!mapearArchivo(nombreArchivo, &mapa)) {
+        TRAZA_ERROR("No se pudo abrir el archivo %s\n", nombreArchivo);
+        return NULL;
     }
-    
-    if(p->y < ymin - 0.1 || p->y > ymax + 0.1) {
-        return true;  // Rechazar puntos muy alejados verticalmente
+
+    struct EntradaPoly *entrada = (struct EntradaPoly*)malloc(sizeof(struct EntradaPoly));
+    if (!entrada) {
+        TRAZA_ERROR("No se pudo asignar memoria para la estructura de entrada\n");
+        liberarArchivoMapeado(&mapa);
+        return NULL;
     }
-    
-    // Verificar puntos cercanos
-    for(int i = 0; i < tr->numPuntos; i++) {
-        if(distanciaEntrePuntos(&tr->puntos[i], p) < DIST_MIN_BORDE) {
-            puntos_cercanos++;
-            if(puntos_cercanos >= NUM_VECINOS) {
-                return true;
+
+    // Inicializar con valores por defecto
+    memset(entrada, 0, sizeof(struct EntradaPoly));
+
+    struct Escaner esc = { mapa.datos, mapa.datos + mapa.longitud };
+
+    // Leer sección de vértices
+    if (!leerCabeceraVertices(&esc, entrada) || !leerSeccionVertices(&esc, entrada)) {
+        liberarEntradaPoly(entrada);
+        liberarArchivoMapeado(&mapa);
+        return NULL;
+    }
+
+    // Con cero vértices en el .poly, triangle.c los toma del .node homónimo
+    if (entrada->numVertices == 0) {
+        char archivoNode[FILENAME_MAX];
+        size_t longitud = strlen(nombreArchivo);
+        if (longitud > 5 && strcmp(nombreArchivo + longitud - 5, ".poly") == 0 &&
+            longitud < sizeof(archivoNode)) {
+            memcpy(archivoNode, nombreArchivo, longitud - 5);
+            strcpy(archivoNode + longitud - 5, ".node");
+
+            struct EntradaPoly *nodos = leerArchivoNode(archivoNode);
+            if (!nodos) {
+                liberarEntradaPoly(entrada);
+                liberarArchivoMapeado(&mapa);
+                return NULL;
             }
+            entrada->numVertices = nodos->numVertices;
+            entrada->numAtributos = nodos->numAtributos;
+            entrada->numMarcadores = nodos->numMarcadores;
+            entrada->primerNumero = nodos->primerNumero;
+            entrada->vertices = nodos->vertices;
+            entrada->atributos = nodos->atributos;
+            entrada->marcadores = nodos->marcadores;
+            nodos->vertices = NULL;
+            nodos->atributos = NULL;
+            nodos->marcadores = NULL;
+            liberarEntradaPoly(nodos);
         }
     }
-    return false;
-}
 
-struct Punto* calcularPuntoInterseccion(struct Triangulo *t1, struct Triangulo *t2,
-                                       struct Punto *p1, struct Punto *p2) {
-    // Crear punto para almacenar la intersección
-    struct Punto *interseccion = malloc(sizeof(struct Punto));
-    if (!interseccion) return NULL;
+    // Leer segmentos
+    if (!leerSegmentos(&esc, entrada)) {
+        TRAZA_ERROR("Error al leer segmentos\n");
+        liberarEntradaPoly(entrada);
+        liberarArchivoMapeado(&mapa);
+        return NULL;
+    }
 
-    // Obtener los segmentos del triángulo que podrían intersectar
-    for (int i = 0; i < 3; i++) {
-        struct Punto *a = t1->vertices[i];
-        struct Punto *b = t1->vertices[(i+1)%3];
-        
-        // Verificar si este segmento intersecta con el segmento restricción
-        double x, y;
-        if (encontrarInterseccion(p1->x, p1->y, p2->x, p2->y,
-                                 a->x, a->y, b->x, b->y,
-                                 &x, &y)) {
-            // Verificar que el punto no sea uno de los extremos
-            if (!esPuntoExtremo(x, y, p1, p2) && 
-                !esPuntoExtremo(x, y, a, b)) {
-                interseccion->x = x;
-                interseccion->y = y;
-                interseccion->indice = -1; // Punto temporal
-                return interseccion;
-            }
-        }
+    // Leer agujeros (opcional al final del archivo)
+    struct Escaner resto = esc;
+    if (siguienteRegistro(&resto) && !leerAgujeros(&esc, entrada)) {
+        TRAZA_ERROR("Error al leer agujeros\n");
+        liberarEntradaPoly(entrada);
+        liberarArchivoMapeado(&mapa);
+        return NULL;
     }
-    
-    free(interseccion);
-    return NULL;
-}
 
-// Función auxiliar para encontrar la intersección entre dos segmentos
-bool encontrarInterseccion(double x1, double y1, double x2, double y2,
-                          double x3, double y3, double x4, double y4,
-                          double *x, double *y) {
-    // Calcular denominador
-    double denom = (y4-y3)*(x2-x1) - (x4-x3)*(y2-y1);
-    if (fabs(denom) < 1e-10) return false; // Segmentos paralelos
+    // Leer regiones (opcional al final del archivo)
+    resto = esc;
+    if (siguienteRegistro(&resto) && !leerRegiones(&esc, entrada)) {
+        TRAZA_ERROR("Error al leer regiones\n");
+        liberarEntradaPoly(entrada);
+        liberarArchivoMapeado(&mapa);
+        return NULL;
+    }
 
-    // Calcular parámetros de intersección
-    double ua = ((x4-x3)*(y1-y3) - (y4-y3)*(x1-x3)) / denom;
-    double ub = ((x2-x1)*(y1-y3) - (y2-y1)*(x1-x3)) / denom;
+    liberarArchivoMapeado(&mapa);
+    return entrada;
+}
 
-    // Verificar si la intersección está dentro de ambos segmentos
-    if (ua >= 0 && ua <= 1 && ub >= 0 && ub <= 1) {
-        *x = x1 + ua*(x2-x1);
-        *y = y1 + ua*(y2-y1);
-        return true;
+/* Escritura con búfer de archivos de texto                                   */
+
+static int abrirBufferSalida(struct BufferSalida *b, const char *nombreArchivo) {
+    memset(b, 0, sizeof(struct BufferSalida));
+    b->archivo = fopen(nombreArchivo, "wb");
+    if (!b->archivo) {
+        return 0;
     }
+    // Sin búfer de stdio: cada bloque lleno se entrega en una sola escritura
+    setvbuf(b->archivo, NULL, _IONBF, 0);
 
-    return false;
+    b->capacidad = TAMANO_BUFFER_SALIDA;
+    b->datos = malloc(b->capacidad);
+    if (!b->datos) {
+        fclose(b->archivo);
+        return 0;
+    }
+    return 1;
 }
 
-// Función auxiliar para verificar si un punto es extremo de un segmento
-bool esPuntoExtremo(double x, double y, struct Punto *p1, struct Punto *p2) {
-    const double EPSILON = 1e-10;
-    return (fabs(x - p1->x) < EPSILON && fabs(y - p1->y) < EPSILON) ||
-           (fabs(x - p2->x) < EPSILON && fabs(y - p2->y) < EPSILON);
+static void vaciarBufferSalida(struct BufferSalida *b) {
+    if (b->usado > 0) {
+        if (fwrite(b->datos, 1, b->usado, b->archivo) != b->usado) {
+            b->error = true;
+        }
+        b->escrito += b->usado;
+        b->usado = 0;
+    }
 }
 
-bool esDelaunay(struct Punto *candidatoIzq, struct Punto *candidatoDer, struct Borde *base) {
-    if (!candidatoIzq) return true;   // Si no hay candidato izquierdo, usar derecho
-    if (!candidatoDer) return false;  // Si no hay candidato derecho, usar izquierdo
-    
-    // Verificar el criterio del círculo vacío
-    return !puntoEnCircunferencia(candidatoIzq, base->p1, base->p2, candidatoDer);
+// Garantiza espacio para n bytes y devuelve dónde escribirlos
+static inline char* reservarBufferSalida(struct BufferSalida *b, size_t n) {
+    if (b->usado + n > b->capacidad) {
+        vaciarBufferSalida(b);
+    }
+    return b->datos + b->usado;
 }
 
-double orientacion(struct Punto *p1, struct Punto *p2, struct Punto *p3) {
-    return (p2->x - p1->x) * (p3->y - p1->y) - 
-           (p3->x - p1->x) * (p2->y - p1->y);
+static int cerrarBufferSalida(struct BufferSalida *b) {
+    vaciarBufferSalida(b);
+    bool correcto = !b->error;
+    if (fclose(b->archivo) != 0) correcto = false;
+    free(b->datos);
+    return correcto;
 }
 
-bool puntoEnCircunferencia(struct Punto *p1, struct Punto *p2, 
-                          struct Punto *p3, struct Punto *punto) {
-    double ax = p2->x - p1->x;
-    double ay = p2->y - p1->y;
-    double bx = p3->x - p1->x;
-    double by = p3->y - p1->y;
-    
-    double c = ax * ax + ay * ay;
-    double d = bx * bx + by * by;
-    double e = ax * by - ay * bx;
-    
-    if (e == 0) return false;  // Puntos colineales
-    
-    double px = punto->x - p1->x;
-    double py = punto->y - p1->y;
-    
-    double det = (px * px + py * py) * (ax * by - ay * bx) -
-                (c * (px * by - py * bx) + d * (py * ax - px * ay));
-                
-    return det > 0;
+static const char paresDigitos[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Escribe un entero sin signo en decimal y devuelve el final
+static inline char* formatearNatural(char *p, uint64_t v) {
+    char tmp[20];
+    char *q = tmp + sizeof(tmp);
+    while (v >= 100) {
+        unsigned d = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--q = paresDigitos[d + 1];
+        *--q = paresDigitos[d];
+    }
+    if (v >= 10) {
+        unsigned d = (unsigned)v * 2;
+        *--q = paresDigitos[d + 1];
+        *--q = paresDigitos[d];
+    } else {
+        *--q = (char)('0' + v);
+    }
+    size_t n = (size_t)(tmp + sizeof(tmp) - q);
+    memcpy(p, q, n);
+    return p + n;
 }
 
+static inline char* formatearEntero(char *p, long long v) {
+    if (v < 0) {
+        *p++ = '-';
+        return formatearNatural(p, (uint64_t)0 - (uint64_t)v);
+    }
+    return formatearNatural(p, (uint64_t)v);
+}
 
-/* Funciones auxiliares                                                        */
+// Escribe un real con DIGITOS_SALIDA cifras significativas, con el mismo
+// resultado que "%.17g", para que la malla escrita se relea bit a bit. Si el
+// valor escalado a 17 cifras enteras se obtiene con una potencia de diez
+// exacta (1e-4 <= |v| < 1e17), el producto y su error exacto (fma) dan las
+// cifras correctamente redondeadas; el resto recurre a snprintf.
+static inline char* formatearReal(char *p, double v) {
+    double a = fabs(v);
+    if (a == 0.0) {
+        if (signbit(v)) *p++ = '-';
+        *p++ = '0';
+        return p;
+    }
+    if (!(a >= 1e-4 && a < 1e17)) {  // También descarta NaN e infinitos
+        char texto[32];
+        int n = snprintf(texto, sizeof(texto), "%.*g", DIGITOS_SALIDA, v);
+        if (n < 0) n = 0;
+        if (n >= (int)sizeof(texto)) n = (int)sizeof(texto) - 1;
+        memcpy(p, texto, (size_t)n);
+        return p + n;
+    }
 
-bool necesitaIntercambio(struct Triangulo *t1, struct Triangulo *t2) {
-    // Implementación del criterio de Delaunay
-    struct Punto *p4 = NULL;
-    for(int i = 0; i < 3; i++) {
-        if(!tieneVertice(t1, t2->vertices[i])) {
-            p4 = t2->vertices[i];
+    // Exponente decimal: la estimación se corrige con las cifras redondeadas,
+    // que también absorben el acarreo de 99...9 a 100...0
+    int exponente = (int)floor(log10(a));
+    if (exponente < -4) exponente = -4;
+    if (exponente > DIGITOS_SALIDA - 1) exponente = DIGITOS_SALIDA - 1;
+    uint64_t r;
+    for (;;) {
+        double escala = potenciasDiezExactas[DIGITOS_SALIDA - 1 - exponente];
+        double escalado = a * escala;                 // >= 2^53: entero
+        double error = fma(a, escala, -escalado);     // Exacto, |error| <= 8
+        double piso = floor(error);
+        double fraccion = error - piso;
+        r = (uint64_t)escalado + (uint64_t)(int64_t)piso;
+        if (fraccion > 0.5 || (fraccion == 0.5 && (r & 1))) r++;
+        if (r >= 100000000000000000ULL && exponente < DIGITOS_SALIDA - 1) {
+            exponente++;
+        } else if (r < 10000000000000000ULL && exponente > -4) {
+            exponente--;
+        } else {
             break;
         }
     }
-    return puntoEnCircunscrito(t1, p4);
-}
 
-// Función para encontrar el índice del vértice opuesto a un borde en un triángulo
-int encontrarBorde(struct Triangulo *t, struct Punto *p1, struct Punto *p2) {
-    int i;
-    for(i = 0; i < 3; i++) {
-        if((t->vertices[i] == p1 && t->vertices[(i+1)%3] == p2) ||
-           (t->vertices[i] == p2 && t->vertices[(i+1)%3] == p1)) {
-            return i;
+    // Notación fija de "%g": punto tras exponente + 1 cifras, ceros finales fuera
+    char cifras[DIGITOS_SALIDA];
+    for (int i = DIGITOS_SALIDA - 1; i >= 0; i--) {
+        cifras[i] = (char)('0' + r % 10);
+        r /= 10;
+    }
+    int ultima = DIGITOS_SALIDA;
+    while (ultima > 0 && cifras[ultima - 1] == '0') ultima--;
+
+    if (signbit(v)) *p++ = '-';
+    if (exponente >= 0) {
+        memcpy(p, cifras, (size_t)exponente + 1);
+        p += exponente + 1;
+        if (ultima > exponente + 1) {
+            *p++ = '.';
+            memcpy(p, cifras + exponente + 1, (size_t)(ultima - exponente - 1));
+            p += ultima - exponente - 1;
         }
+    } else {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > exponente; i--) *p++ = '0';
+        memcpy(p, cifras, (size_t)ultima);
+        p += ultima;
     }
-    return -1;  // No se encontró el borde
+    return p;
 }
 
-// Función para actualizar las relaciones de vecindad
-void actualizarVecinos(struct Triangulacion *tr) {
-    int i, j, k;
-    
-    // Primero, limpiamos todas las relaciones de vecindad
-    for(i = 0; i < tr->numTriangulos; i++) {
-        tr->triangulos[i].vecinos[0] = NULL;
-        tr->triangulos[i].vecinos[1] = NULL;
-        tr->triangulos[i].vecinos[2] = NULL;
+static inline char* copiarTexto(char *p, const char *texto) {
+    size_t n = strlen(texto);
+    memcpy(p, texto, n);
+    return p + n;
+}
+
+int guardarArchivoNode(const struct MallaBinaria *malla, const char *nombreArchivo) {
+    struct BufferSalida b;
+    if (!abrirBufferSalida(&b, nombreArchivo)) {
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombreArchivo);
+        return 0;
     }
-    
-    // Luego, buscamos los vecinos para cada triángulo
-    for(i = 0; i < tr->numTriangulos; i++) {
-        for(j = i + 1; j < tr->numTriangulos; j++) {
-            // Para cada par de triángulos, verificamos si comparten un borde
-            for(k = 0; k < 3; k++) {
-                struct Punto *p1 = tr->triangulos[i].vertices[k];
-                struct Punto *p2 = tr->triangulos[i].vertices[(k+1)%3];
-                
-                // Buscar este borde en el otro triángulo
-                int bordeComun = encontrarBorde(&tr->triangulos[j], p1, p2);
-                if(bordeComun != -1) {
-                    // Los triángulos son vecinos
-                    tr->triangulos[i].vecinos[k] = &tr->triangulos[j];
-                    tr->triangulos[j].vecinos[bordeComun] = &tr->triangulos[i];
-                }
-            }
+
+    // Escribir encabezado
+    char *p = reservarBufferSalida(&b, 64);
+    p = formatearEntero(p, malla->numPuntos);
+    p = copiarTexto(p, malla->marcadoresPuntos ? " 2 0 1\n" : " 2 0 0\n");
+    b.usado = (size_t)(p - b.datos);
+
+    // Guardar los puntos con sus coordenadas originales
+    for (int i = 0; i < malla->numPuntos; i++) {
+        p = reservarBufferSalida(&b, MAX_LONGITUD_FILA);
+        p = formatearEntero(p, i + 1);                                  // índice del punto
+        *p++ = ' ';
+        p = formatearReal(p, malla->puntos[2 * i]);       // coordenada x
+        *p++ = ' ';
+        p = formatearReal(p, malla->puntos[2 * i + 1]);   // coordenada y
+        if (malla->marcadoresPuntos) {
+            *p++ = ' ';
+            p = formatearEntero(p, malla->marcadoresPuntos[i]);         // región (1 o 2)
         }
+        *p++ = '\n';
+        b.usado = (size_t)(p - b.datos);
     }
-}
 
-void agregarTrianguloACola(struct ColaRefinamiento *cola, struct Triangulo *t) {
-    if(cola->numTriangulos < cola->capacidad) {
-        cola->triangulos[cola->numTriangulos++] = t;
+    p = reservarBufferSalida(&b, 64);
+    p = copiarTexto(p, "# Generated by Delaunay Triangulation\n");
+    b.usado = (size_t)(p - b.datos);
+
+    if (!cerrarBufferSalida(&b)) {
+        TRAZA_ERROR("Error al escribir el archivo %s\n", nombreArchivo);
+        return 0;
     }
+    return 1;
 }
 
-struct Triangulo* extraerTriangulo(struct ColaRefinamiento *cola) {
-    if(cola->numTriangulos > 0) {
-        return cola->triangulos[--cola->numTriangulos];
+int guardarArchivoEle(const struct MallaBinaria *malla, const char *nombreArchivo) {
+    struct BufferSalida b;
+    if (!abrirBufferSalida(&b, nombreArchivo)) {
+        TRAZA_ERROR("No se puede crear el archivo %s. errno: %d\n", nombreArchivo, errno);
+        return 0;
     }
-    return NULL;
-}
 
-bool dentroLimites(struct Punto *p, struct Triangulacion *tr) {
-    // Encontrar los límites del dominio original
-    double xmin = tr->puntos[0].x;
-    double xmax = tr->puntos[0].x;
-    double ymin = tr->puntos[0].y;
-    double ymax = tr->puntos[0].y;
-    
-    for(int i = 1; i < tr->numPuntos; i++) {
-        if(tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
-        if(tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
-        if(tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
-        if(tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+    char *p = reservarBufferSalida(&b, 64);
+    p = formatearEntero(p, malla->numTriangulos);
+    p = copiarTexto(p, "  3  0\n");
+    b.usado = (size_t)(p - b.datos);
+
+    // Los vértices usan la misma numeración que el .node
+    for (int i = 0; i < malla->numTriangulos; i++) {
+        const int32_t *t = &malla->triangulos[3 * i];
+        p = reservarBufferSalida(&b, MAX_LONGITUD_FILA);
+        p = formatearEntero(p, i + 1);
+        p = copiarTexto(p, "  ");
+        p = formatearEntero(p, t[0] + 1);  // Convertir a base-1 para MATLAB
+        p = copiarTexto(p, "  ");
+        p = formatearEntero(p, t[1] + 1);
+        p = copiarTexto(p, "  ");
+        p = formatearEntero(p, t[2] + 1);
+        *p++ = '\n';
+        b.usado = (size_t)(p - b.datos);
     }
-    
-    // Margen más estricto
-    const double margen = 0.05;
-    
-    // Verificación más estricta de los límites
-    bool dentroX = p->x > xmin + margen && p->x < xmax - margen;
-    bool dentroY = p->y > ymin + margen && p->y < ymax - margen;
-    
-    // Verificación adicional para puntos muy alejados
-    bool noMuyLejos = fabs(p->y - ymin) < 0.2 && fabs(p->y - ymax) < 0.2;
-    
-    return dentroX && dentroY && noMuyLejos;
-}
 
-struct ListaTriangulos* encontrarTriangulosIntersectados(struct Triangulacion *tr, 
-                                                        struct Punto *p1, 
-                                                        struct Punto *p2) {
-    // Inicializar lista de triángulos
+    p = reservarBufferSalida(&b, 64);
+    p = copiarTexto(p, "# Generated by Delaunay Triangulation\n");
+    b.usado = (size_t)(p - b.datos);
+
+    if (!cerrarBufferSalida(&b)) {
+        TRAZA_ERROR("No se pudo escribir el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+
+    TRAZA_INFO("Archivo .ele guardado: %d triángulos\n", malla->numTriangulos);
+    return 1;
+}
+
+
+// Escribe los vecinos de cada triángulo con la misma numeración que el .ele
+// (-1 en los bordes)
+int guardarArchivoNeigh(const struct MallaBinaria *malla, const char *nombreArchivo) {
+    if (!malla->vecinos && malla->numTriangulos > 0) {
+        TRAZA_ERROR("La malla no tiene vecinos para %s\n", nombreArchivo);
+        return 0;
+    }
+
+    struct BufferSalida b;
+    if (!abrirBufferSalida(&b, nombreArchivo)) {
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+
+    char *p = reservarBufferSalida(&b, 64);
+    p = formatearEntero(p, malla->numTriangulos);
+    p = copiarTexto(p, "  3\n");
+    b.usado = (size_t)(p - b.datos);
+
+    for (int i = 0; i < malla->numTriangulos; i++) {
+        p = reservarBufferSalida(&b, MAX_LONGITUD_FILA);
+        p = formatearEntero(p, i + 1);
+        for (int k = 0; k < 3; k++) {
+            int vecino = malla->vecinos[3 * i + k];
+            p = copiarTexto(p, "  ");
+            p = formatearEntero(p, vecino < 0 ? -1 : vecino + 1);
+        }
+        *p++ = '\n';
+        b.usado = (size_t)(p - b.datos);
+    }
+
+    if (!cerrarBufferSalida(&b)) {
+        TRAZA_ERROR("No se pudo escribir el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+    return 1;
+}
+
+
+/* Formato binario de mallas (.bmesh)                                         */
+
+// Disposición del archivo (todos los valores en little-endian):
+//   [0, 128)    Cabecera con magia, versión, tamaño total y conteos
+//   [128, ...)  Tabla de secciones: tipo, tamaño de elemento, desplazamiento
+//               y longitud en bytes de cada sección
+//   [...]       Secciones, cada una alineada a 64 bytes
+// Como mmap entrega memoria alineada a página, cada sección puede usarse
+// directamente como arreglo sin copiarla.
+
+static inline bool esHostBigEndian(void) {
+    const uint16_t prueba = 1;
+    return *(const uint8_t*)&prueba == 0;
+}
+
+// Invierte el orden de bytes de cada elemento del arreglo
+static void intercambiarBytes(void *datos, size_t numElementos, size_t tamano) {
+    uint8_t *p = datos;
+    for (size_t i = 0; i < numElementos; i++, p += tamano) {
+        for (size_t j = 0; j < tamano / 2; j++) {
+            uint8_t aux = p[j];
+            p[j] = p[tamano - 1 - j];
+            p[tamano - 1 - j] = aux;
+        }
+    }
+}
+
+static inline uint64_t alinearBMesh(uint64_t desplazamiento) {
+    return (desplazamiento + BMESH_ALINEACION - 1) & ~(uint64_t)(BMESH_ALINEACION - 1);
+}
+
+// Disposición de una malla en el archivo: secciones no vacías, tabla con
+// desplazamientos alineados y tamaño total
+struct DisposicionBMesh {
+    struct {
+        uint32_t tipo;
+        uint32_t tamanoElemento;
+        const void *datos;
+        uint64_t numElementos;
+    } secciones[BMESH_MAX_SECCIONES];
+    struct EntradaSeccionBMesh tabla[BMESH_MAX_SECCIONES];
+    int numSecciones;
+    uint64_t tamano;
+};
+
+static void calcularDisposicionBMesh(const struct MallaBinaria *malla, struct DisposicionBMesh *d) {
+    d->numSecciones = 0;
+
+#define AGREGAR_SECCION(t, tam, ptr, n)                                     \
+    if ((ptr) != NULL && (n) > 0) {                                         \
+        d->secciones[d->numSecciones].tipo = (t);                           \
+        d->secciones[d->numSecciones].tamanoElemento = (tam);               \
+        d->secciones[d->numSecciones].datos = (ptr);                        \
+        d->secciones[d->numSecciones].numElementos = (uint64_t)(n);         \
+        d->numSecciones++;                                                  \
+    }
+
+    AGREGAR_SECCION(BMESH_PUNTOS, 8, malla->puntos, 2 * malla->numPuntos);
+    AGREGAR_SECCION(BMESH_MARCADORES_PUNTOS, 4, malla->marcadoresPuntos, malla->numPuntos);
+    AGREGAR_SECCION(BMESH_ATRIBUTOS_PUNTOS, 8, malla->atributosPuntos,
+                    malla->numPuntos * malla->numAtributosPunto);
+    AGREGAR_SECCION(BMESH_TRIANGULOS, 4, malla->triangulos, 3 * malla->numTriangulos);
+    AGREGAR_SECCION(BMESH_VECINOS, 4, malla->vecinos, 3 * malla->numTriangulos);
+    AGREGAR_SECCION(BMESH_ATRIBUTOS_TRIANGULOS, 8, malla->atributosTriangulos,
+                    malla->numTriangulos * malla->numAtributosTriangulo);
+    AGREGAR_SECCION(BMESH_SEGMENTOS, 4, malla->segmentos, 2 * malla->numSegmentos);
+    AGREGAR_SECCION(BMESH_MARCADORES_SEGMENTOS, 4, malla->marcadoresSegmentos, malla->numSegmentos);
+    AGREGAR_SECCION(BMESH_AGUJEROS, 8, malla->agujeros, 2 * malla->numAgujeros);
+    AGREGAR_SECCION(BMESH_REGIONES, 8, malla->regiones, 4 * malla->numRegiones);
+#undef AGREGAR_SECCION
+
+    // Calcular desplazamientos
+    uint64_t desplazamiento = alinearBMesh(sizeof(struct CabeceraBMesh) +
+                                           d->numSecciones * sizeof(struct EntradaSeccionBMesh));
+    for (int i = 0; i < d->numSecciones; i++) {
+        d->tabla[i].tipo = d->secciones[i].tipo;
+        d->tabla[i].tamanoElemento = d->secciones[i].tamanoElemento;
+        d->tabla[i].desplazamiento = desplazamiento;
+        d->tabla[i].longitud = d->secciones[i].numElementos * d->secciones[i].tamanoElemento;
+        desplazamiento = alinearBMesh(desplazamiento + d->tabla[i].longitud);
+    }
+    d->tamano = desplazamiento;
+}
+
+// Tamaño en bytes que ocupará la malla en formato .bmesh
+uint64_t tamanoBMesh(const struct MallaBinaria *malla) {
+    struct DisposicionBMesh d;
+    calcularDisposicionBMesh(malla, &d);
+    return d.tamano;
+}
+
+// Escribe una malla en formato .bmesh en un flujo abierto (archivo, socket
+// o memoria). Las secciones vacías se omiten.
+int escribirBMesh(const struct MallaBinaria *malla, FILE *archivo) {
+    struct DisposicionBMesh d;
+    calcularDisposicionBMesh(malla, &d);
+    int numSecciones = d.numSecciones;
+
+    struct CabeceraBMesh cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, BMESH_MAGIA, sizeof(cabecera.magia));
+    cabecera.version = BMESH_VERSION;
+    cabecera.numSecciones = (uint32_t)numSecciones;
+    cabecera.tamanoArchivo = d.tamano;
+    cabecera.numPuntos = (uint64_t)malla->numPuntos;
+    cabecera.numTriangulos = (uint64_t)malla->numTriangulos;
+    cabecera.numSegmentos = (uint64_t)malla->numSegmentos;
+    cabecera.numAgujeros = (uint64_t)malla->numAgujeros;
+    cabecera.numRegiones = (uint64_t)malla->numRegiones;
+    cabecera.numAtributosPunto = (uint32_t)malla->numAtributosPunto;
+    cabecera.numAtributosTriangulo = (uint32_t)malla->numAtributosTriangulo;
+
+    // La cabecera y la tabla se escriben siempre en little-endian
+    bool bigEndian = esHostBigEndian();
+    struct EntradaSeccionBMesh tablaArchivo[BMESH_MAX_SECCIONES];
+    memcpy(tablaArchivo, d.tabla, sizeof(d.tabla));
+    if (bigEndian) {
+        intercambiarBytes(&cabecera.version, 2, 4);
+        intercambiarBytes(&cabecera.tamanoArchivo, 6, 8);
+        intercambiarBytes(&cabecera.numAtributosPunto, 2, 4);
+        for (int i = 0; i < numSecciones; i++) {
+            intercambiarBytes(&tablaArchivo[i].tipo, 2, 4);
+            intercambiarBytes(&tablaArchivo[i].desplazamiento, 2, 8);
+        }
+    }
+
+    static const char relleno[BMESH_ALINEACION] = { 0 };
+    bool correcto = fwrite(&cabecera, sizeof(cabecera), 1, archivo) == 1;
+    if (numSecciones > 0) {
+        correcto = correcto &&
+                   fwrite(tablaArchivo, sizeof(struct EntradaSeccionBMesh), numSecciones, archivo) ==
+                   (size_t)numSecciones;
+    }
+    uint64_t posicion = sizeof(cabecera) + numSecciones * sizeof(struct EntradaSeccionBMesh);
+
+    for (int i = 0; i < numSecciones && correcto; i++) {
+        uint64_t longitud = d.tabla[i].longitud;
+        fwrite(relleno, 1, (size_t)(d.tabla[i].desplazamiento - posicion), archivo);
+
+        if (bigEndian) {
+            void *copia = malloc((size_t)longitud);
+            if (!copia) {
+                correcto = false;
+                break;
+            }
+            memcpy(copia, d.secciones[i].datos, (size_t)longitud);
+            intercambiarBytes(copia, (size_t)d.secciones[i].numElementos, d.secciones[i].tamanoElemento);
+            correcto = fwrite(copia, 1, (size_t)longitud, archivo) == longitud;
+            free(copia);
+        } else {
+            correcto = fwrite(d.secciones[i].datos, 1, (size_t)longitud, archivo) == longitud;
+        }
+        posicion = d.tabla[i].desplazamiento + longitud;
+    }
+    fwrite(relleno, 1, (size_t)(d.tamano - posicion), archivo);
+
+    return correcto && !ferror(archivo);
+}
+
+int guardarArchivoBMesh(const struct MallaBinaria *malla, const char *nombreArchivo) {
+    FILE *archivo = fopen(nombreArchivo, "wb");
+    if (!archivo) {
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+
+    int correcto = escribirBMesh(malla, archivo);
+    if (fclose(archivo) != 0 || !correcto) {
+        TRAZA_ERROR("Error al escribir el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+    return 1;
+}
+
+// Abre un archivo .bmesh. En hosts little-endian los arreglos de la malla
+// apuntan directamente al archivo proyectado (solo lectura, sin copias).
+int abrirArchivoBMesh(const char *nombreArchivo, struct MallaBinaria *malla) {
+    memset(malla, 0, sizeof(struct MallaBinaria));
+
+    if (!mapearArchivo(nombreArchivo, &malla->mapa)) {
+        TRAZA_ERROR("No se pudo abrir el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+
+    const uint8_t *base = (const uint8_t*)malla->mapa.datos;
+    uint64_t longitudArchivo = malla->mapa.longitud;
+
+    if (esHostBigEndian() && longitudArchivo > 0) {
+        // Copia privada que se corrige sección por sección
+        uint8_t *copia = malloc((size_t)longitudArchivo);
+        if (!copia) {
+            cerrarArchivoBMesh(malla);
+            return 0;
+        }
+        memcpy(copia, base, (size_t)longitudArchivo);
+        malla->copiaLocal = copia;
+        base = copia;
+    }
+
+    struct CabeceraBMesh cabecera;
+    if (longitudArchivo < sizeof(cabecera)) {
+        TRAZA_ERROR("%s no es un archivo .bmesh válido\n", nombreArchivo);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+    memcpy(&cabecera, base, sizeof(cabecera));
+    if (malla->copiaLocal) {
+        intercambiarBytes(&cabecera.version, 2, 4);
+        intercambiarBytes(&cabecera.tamanoArchivo, 6, 8);
+        intercambiarBytes(&cabecera.numAtributosPunto, 2, 4);
+    }
+
+    if (memcmp(cabecera.magia, BMESH_MAGIA, sizeof(cabecera.magia)) != 0) {
+        TRAZA_ERROR("%s no es un archivo .bmesh válido\n", nombreArchivo);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+    if (cabecera.version > BMESH_VERSION) {
+        TRAZA_ERROR("Versión de .bmesh no soportada: %u\n", cabecera.version);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+    if (cabecera.tamanoArchivo > longitudArchivo ||
+        cabecera.numSecciones > BMESH_MAX_SECCIONES ||
+        cabecera.numPuntos > INT32_MAX || cabecera.numTriangulos > INT32_MAX ||
+        cabecera.numSegmentos > INT32_MAX || cabecera.numAgujeros > INT32_MAX ||
+        cabecera.numRegiones > INT32_MAX) {
+        TRAZA_ERROR("Archivo .bmesh truncado o corrupto: %s\n", nombreArchivo);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+
+    malla->numPuntos = (int)cabecera.numPuntos;
+    malla->numTriangulos = (int)cabecera.numTriangulos;
+    malla->numSegmentos = (int)cabecera.numSegmentos;
+    malla->numAgujeros = (int)cabecera.numAgujeros;
+    malla->numRegiones = (int)cabecera.numRegiones;
+    malla->numAtributosPunto = (int)cabecera.numAtributosPunto;
+    malla->numAtributosTriangulo = (int)cabecera.numAtributosTriangulo;
+
+    const struct EntradaSeccionBMesh *tablaArchivo =
+        (const struct EntradaSeccionBMesh*)(base + sizeof(cabecera));
+    if (sizeof(cabecera) + cabecera.numSecciones * sizeof(struct EntradaSeccionBMesh) > longitudArchivo) {
+        TRAZA_ERROR("Archivo .bmesh truncado o corrupto: %s\n", nombreArchivo);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < cabecera.numSecciones; i++) {
+        struct EntradaSeccionBMesh s = tablaArchivo[i];
+        if (malla->copiaLocal) {
+            intercambiarBytes(&s.tipo, 2, 4);
+            intercambiarBytes(&s.desplazamiento, 2, 8);
+        }
+
+        if (s.desplazamiento % BMESH_ALINEACION != 0 ||
+            s.desplazamiento > longitudArchivo ||
+            s.longitud > longitudArchivo - s.desplazamiento ||
+            (s.tamanoElemento != 4 && s.tamanoElemento != 8) ||
+            s.longitud % s.tamanoElemento != 0) {
+            TRAZA_ERROR("Sección %u inválida en %s\n", i, nombreArchivo);
+            cerrarArchivoBMesh(malla);
+            return 0;
+        }
+
+        uint8_t *datos = (uint8_t*)base + s.desplazamiento;
+        uint64_t numElementos = s.longitud / s.tamanoElemento;
+        if (malla->copiaLocal) {
+            intercambiarBytes(datos, (size_t)numElementos, s.tamanoElemento);
+        }
+
+        // Longitud esperada de cada sección conocida; las desconocidas se ignoran
+        uint64_t esperado = 0;
+        switch (s.tipo) {
+        case BMESH_PUNTOS:
+            malla->puntos = (double*)datos;
+            esperado = 2 * cabecera.numPuntos;
+            break;
+        case BMESH_MARCADORES_PUNTOS:
+            malla->marcadoresPuntos = (int32_t*)datos;
+            esperado = cabecera.numPuntos;
+            break;
+        case BMESH_ATRIBUTOS_PUNTOS:
+            malla->atributosPuntos = (double*)datos;
+            esperado = cabecera.numPuntos * cabecera.numAtributosPunto;
+            break;
+        case BMESH_TRIANGULOS:
+            malla->triangulos = (int32_t*)datos;
+            esperado = 3 * cabecera.numTriangulos;
+            break;
+        case BMESH_VECINOS:
+            malla->vecinos = (int32_t*)datos;
+            esperado = 3 * cabecera.numTriangulos;
+            break;
+        case BMESH_ATRIBUTOS_TRIANGULOS:
+            malla->atributosTriangulos = (double*)datos;
+            esperado = cabecera.numTriangulos * cabecera.numAtributosTriangulo;
+            break;
+        case BMESH_SEGMENTOS:
+            malla->segmentos = (int32_t*)datos;
+            esperado = 2 * cabecera.numSegmentos;
+            break;
+        case BMESH_MARCADORES_SEGMENTOS:
+            malla->marcadoresSegmentos = (int32_t*)datos;
+            esperado = cabecera.numSegmentos;
+            break;
+        case BMESH_AGUJEROS:
+            malla->agujeros = (double*)datos;
+            esperado = 2 * cabecera.numAgujeros;
+            break;
+        case BMESH_REGIONES:
+            malla->regiones = (double*)datos;
+            esperado = 4 * cabecera.numRegiones;
+            break;
+        default:
+            continue;
+        }
+
+        if (numElementos != esperado) {
+            TRAZA_ERROR("Sección %u de %s no coincide con la cabecera\n", i, nombreArchivo);
+            cerrarArchivoBMesh(malla);
+            return 0;
+        }
+    }
+
+    // Las secciones vacías se omiten, pero un conteo distinto de cero en la
+    // cabecera exige la suya: sin ella los arreglos quedarían en NULL
+    if ((cabecera.numPuntos > 0 && !malla->puntos) ||
+        (cabecera.numTriangulos > 0 && !malla->triangulos) ||
+        (cabecera.numSegmentos > 0 && !malla->segmentos) ||
+        (cabecera.numAgujeros > 0 && !malla->agujeros) ||
+        (cabecera.numRegiones > 0 && !malla->regiones) ||
+        (cabecera.numPuntos * cabecera.numAtributosPunto > 0 && !malla->atributosPuntos) ||
+        (cabecera.numTriangulos * cabecera.numAtributosTriangulo > 0 && !malla->atributosTriangulos)) {
+        TRAZA_ERROR("Archivo .bmesh truncado o corrupto: %s\n", nombreArchivo);
+        cerrarArchivoBMesh(malla);
+        return 0;
+    }
+
+    // Los índices deben caer dentro del arreglo de puntos (o de triángulos,
+    // para los vecinos; -1 en el borde)
+    if (malla->triangulos) {
+        for (int i = 0; i < 3 * malla->numTriangulos; i++) {
+            if (malla->triangulos[i] < 0 || malla->triangulos[i] >= malla->numPuntos) {
+                TRAZA_ERROR("Triángulo %d con vértice fuera de rango en %s\n", i / 3, nombreArchivo);
+                cerrarArchivoBMesh(malla);
+                return 0;
+            }
+        }
+    }
+    if (malla->vecinos) {
+        for (int i = 0; i < 3 * malla->numTriangulos; i++) {
+            if (malla->vecinos[i] < -1 || malla->vecinos[i] >= malla->numTriangulos) {
+                TRAZA_ERROR("Triángulo %d con vecino fuera de rango en %s\n", i / 3, nombreArchivo);
+                cerrarArchivoBMesh(malla);
+                return 0;
+            }
+        }
+    }
+    if (malla->segmentos) {
+        for (int i = 0; i < 2 * malla->numSegmentos; i++) {
+            if (malla->segmentos[i] < 0 || malla->segmentos[i] >= malla->numPuntos) {
+                TRAZA_ERROR("Segmento %d con vértice fuera de rango en %s\n", i / 2, nombreArchivo);
+                cerrarArchivoBMesh(malla);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void cerrarArchivoBMesh(struct MallaBinaria *malla) {
+    if (!malla) return;
+    liberarArchivoMapeado(&malla->mapa);
+    free(malla->copiaLocal);
+    memset(malla, 0, sizeof(struct MallaBinaria));
+}
+
+// Libera los arreglos de una malla construida en memoria (no proyectada)
+void liberarMallaBinaria(struct MallaBinaria *malla) {
+    if (!malla) return;
+    free(malla->puntos);
+    free(malla->marcadoresPuntos);
+    free(malla->atributosPuntos);
+    free(malla->triangulos);
+    free(malla->vecinos);
+    free(malla->atributosTriangulos);
+    free(malla->segmentos);
+    free(malla->marcadoresSegmentos);
+    free(malla->agujeros);
+    free(malla->regiones);
+    memset(malla, 0, sizeof(struct MallaBinaria));
+}
+
+// Posición de un vértice dentro de tr->puntos, o -1 si no pertenece al arreglo
+// (por ejemplo, los vértices del super-triángulo)
+static inline int posicionPunto(struct Triangulacion *tr, struct Punto *p) {
+    uintptr_t inicio = (uintptr_t)tr->puntos;
+    uintptr_t direccion = (uintptr_t)p;
+    if (direccion < inicio) return -1;
+    uintptr_t posicion = (direccion - inicio) / sizeof(struct Punto);
+    return posicion < (uintptr_t)tr->numPuntos ? (int)posicion : -1;
+}
+
+// Número de salida de cada punto de tr->puntos: los de la entrada recuperan
+// su posición original a través de la permutación del ordenamiento y los
+// Steiner, agregados después, conservan la suya. Sin permutación (mallas que
+// no se ordenaron) es la identidad.
+static int *numeracionSalida(struct Triangulacion *tr) {
+    int *numero = malloc(((size_t)tr->numPuntos + 1) * sizeof(int));
+    if (!numero) return NULL;
+    int n = tr->permutacion ? tr->numPermutacion : 0;
+    if (n > tr->numPuntos) n = tr->numPuntos;
+    for (int i = 0; i < n; i++) numero[i] = tr->permutacion[i];
+    for (int i = n; i < tr->numPuntos; i++) numero[i] = i;
+    return numero;
+}
+
+// Construye los arreglos planos de una triangulación, de los que se escriben
+// todas las salidas. Los vértices se numeran en el orden de la entrada, con
+// los Steiner al final (numeracionSalida); los segmentos, agujeros y regiones
+// se toman de la entrada si se proporciona.
+int mallaDesdeTriangulacion(struct Triangulacion *tr, struct EntradaPoly *entrada,
+                            struct MallaBinaria *malla) {
+    memset(malla, 0, sizeof(struct MallaBinaria));
+
+    malla->numPuntos = tr->numPuntos;
+    malla->puntos = malloc((size_t)tr->numPuntos * 2 * sizeof(double));
+    malla->marcadoresPuntos = malloc((size_t)tr->numPuntos * sizeof(int32_t));
+    int *nuevoIndice = malloc(((size_t)tr->numTriangulos + 1) * sizeof(int));
+    int *numero = numeracionSalida(tr);
+    if (!malla->puntos || !malla->marcadoresPuntos || !nuevoIndice || !numero) {
+        free(nuevoIndice);
+        free(numero);
+        liberarMallaBinaria(malla);
+        return 0;
+    }
+
+    for (int i = 0; i < tr->numPuntos; i++) {
+        int j = numero[i];
+        malla->puntos[2 * j] = tr->puntos[i].x;
+        malla->puntos[2 * j + 1] = tr->puntos[i].y;
+        malla->marcadoresPuntos[j] = (j < tr->numPuntosRegion1) ? 1 : 2;
+    }
+
+    // Renumerar los triángulos válidos
+    int numValidos = 0;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        nuevoIndice[i] = -1;
+        if (t->esTrianguloSuper) continue;
+        if (posicionPunto(tr, t->vertices[0]) < 0 ||
+            posicionPunto(tr, t->vertices[1]) < 0 ||
+            posicionPunto(tr, t->vertices[2]) < 0) {
+            continue;
+        }
+        nuevoIndice[i] = numValidos++;
+    }
+
+    malla->numTriangulos = numValidos;
+    malla->triangulos = malloc((size_t)numValidos * 3 * sizeof(int32_t) + 1);
+    malla->vecinos = malloc((size_t)numValidos * 3 * sizeof(int32_t) + 1);
+    if (!malla->triangulos || !malla->vecinos) {
+        free(nuevoIndice);
+        free(numero);
+        liberarMallaBinaria(malla);
+        return 0;
+    }
+
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        int j = nuevoIndice[i];
+        if (j < 0) continue;
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            malla->triangulos[3 * j + k] = numero[posicionPunto(tr, t->vertices[k])];
+
+            int vecino = -1;
+            if (t->vecinos[k] != NULL) {
+                ptrdiff_t v = t->vecinos[k] - tr->triangulos;
+                if (v >= 0 && v < tr->numTriangulos) vecino = nuevoIndice[v];
+            }
+            malla->vecinos[3 * j + k] = vecino;
+        }
+    }
+    free(nuevoIndice);
+
+    if (entrada) {
+        // Los segmentos usan la numeración original: traducir a números de
+        // salida. Los puntos Steiner se numeran después de la entrada, y los
+        // subsegmentos de -r y -D pueden terminar en ellos.
+        int limite = entrada->numVertices > tr->numPuntos ? entrada->numVertices : tr->numPuntos;
+        int *posicion = malloc(((size_t)limite + 1) * sizeof(int));
+        if (!posicion) {
+            free(numero);
+            liberarMallaBinaria(malla);
+            return 0;
+        }
+        for (int i = 0; i < limite; i++) posicion[i] = -1;
+        for (int i = 0; i < tr->numPuntos; i++) {
+            int original = tr->puntos[i].indice;
+            if (original >= 0 && original < limite && posicion[original] < 0) {
+                posicion[original] = numero[i];
+            }
+        }
+
+        if (entrada->numSegmentos > 0) {
+            malla->segmentos = malloc((size_t)entrada->numSegmentos * 2 * sizeof(int32_t));
+            malla->marcadoresSegmentos = malloc((size_t)entrada->numSegmentos * sizeof(int32_t));
+            if (malla->segmentos && malla->marcadoresSegmentos) {
+                int s = 0;
+                for (int i = 0; i < entrada->numSegmentos; i++) {
+                    int v1 = entrada->segmentos[i].v1;
+                    int v2 = entrada->segmentos[i].v2;
+                    if (v1 < 0 || v1 >= limite || posicion[v1] < 0 ||
+                        v2 < 0 || v2 >= limite || posicion[v2] < 0) {
+                        continue;
+                    }
+                    malla->segmentos[2 * s] = posicion[v1];
+                    malla->segmentos[2 * s + 1] = posicion[v2];
+                    malla->marcadoresSegmentos[s] = entrada->segmentos[i].marcador;
+                    s++;
+                }
+                malla->numSegmentos = s;
+            }
+        }
+        free(posicion);
+
+        if (entrada->numAgujeros > 0) {
+            malla->agujeros = malloc((size_t)entrada->numAgujeros * 2 * sizeof(double));
+            if (malla->agujeros) {
+                malla->numAgujeros = entrada->numAgujeros;
+                for (int i = 0; i < entrada->numAgujeros; i++) {
+                    malla->agujeros[2 * i] = entrada->agujeros[i].x;
+                    malla->agujeros[2 * i + 1] = entrada->agujeros[i].y;
+                }
+            }
+        }
+
+        if (entrada->numRegiones > 0) {
+            malla->regiones = malloc((size_t)entrada->numRegiones * 4 * sizeof(double));
+            if (malla->regiones) {
+                malla->numRegiones = entrada->numRegiones;
+                for (int i = 0; i < entrada->numRegiones; i++) {
+                    malla->regiones[4 * i] = entrada->regiones[i].x;
+                    malla->regiones[4 * i + 1] = entrada->regiones[i].y;
+                    malla->regiones[4 * i + 2] = entrada->regiones[i].atributo;
+                    malla->regiones[4 * i + 3] = entrada->regiones[i].areaMaxima;
+                }
+            }
+        }
+    }
+
+    free(numero);
+    return 1;
+}
+
+// Lee un archivo .ele de triangle.c: índices en base-0 según primerNumero
+static int leerArchivoEle(const char *nombreArchivo, int primerNumero, struct MallaBinaria *malla) {
+    struct ArchivoMapeado mapa;
+    if (!mapearArchivo(nombreArchivo, &mapa)) {
+        TRAZA_ERROR("No se pudo abrir el archivo %s\n", nombreArchivo);
+        return 0;
+    }
+
+    struct Escaner esc = { mapa.datos, mapa.datos + mapa.longitud };
+    int numTriangulos, nodosPorTriangulo = 3, numAtributos = 0;
+    if (!siguienteRegistro(&esc) ||
+        !escanearEntero(&esc, &numTriangulos) ||
+        (!finDeRegistro(&esc) && !escanearEntero(&esc, &nodosPorTriangulo)) ||
+        (!finDeRegistro(&esc) && !escanearEntero(&esc, &numAtributos)) ||
+        numTriangulos < 0 || nodosPorTriangulo < 3 || numAtributos < 0) {
+        TRAZA_ERROR("Cabecera inválida en %s\n", nombreArchivo);
+        liberarArchivoMapeado(&mapa);
+        return 0;
+    }
+    saltarLinea(&esc);
+
+    malla->numTriangulos = numTriangulos;
+    malla->numAtributosTriangulo = numAtributos;
+    malla->triangulos = malloc((size_t)numTriangulos * 3 * sizeof(int32_t) + 1);
+    if (numAtributos > 0) {
+        malla->atributosTriangulos = malloc((size_t)numTriangulos * numAtributos * sizeof(double));
+    }
+    if (!malla->triangulos || (numAtributos > 0 && !malla->atributosTriangulos)) {
+        liberarArchivoMapeado(&mapa);
+        return 0;
+    }
+
+    for (int i = 0; i < numTriangulos; i++) {
+        int numero, v, correcto = siguienteRegistro(&esc) && escanearEntero(&esc, &numero);
+        for (int k = 0; correcto && k < nodosPorTriangulo; k++) {
+            correcto = escanearEntero(&esc, &v);
+            if (k < 3) malla->triangulos[3 * i + k] = v - primerNumero;
+        }
+        for (int k = 0; correcto && k < numAtributos; k++) {
+            double atributo = 0.0;
+            correcto = finDeRegistro(&esc) || escanearReal(&esc, &atributo);
+            malla->atributosTriangulos[i * numAtributos + k] = atributo;
+        }
+        if (!correcto) {
+            TRAZA_ERROR("Formato inválido para triángulo %d en %s\n", i, nombreArchivo);
+            liberarArchivoMapeado(&mapa);
+            return 0;
+        }
+        saltarLinea(&esc);
+    }
+
+    liberarArchivoMapeado(&mapa);
+    return 1;
+}
+
+// Lee un archivo .neigh de triangle.c (opcional)
+static int leerArchivoNeigh(const char *nombreArchivo, int primerNumero, struct MallaBinaria *malla) {
+    struct ArchivoMapeado mapa;
+    if (!mapearArchivo(nombreArchivo, &mapa)) {
+        return 0;
+    }
+
+    struct Escaner esc = { mapa.datos, mapa.datos + mapa.longitud };
+    int numTriangulos;
+    if (!siguienteRegistro(&esc) || !escanearEntero(&esc, &numTriangulos) ||
+        numTriangulos != malla->numTriangulos) {
+        liberarArchivoMapeado(&mapa);
+        return 0;
+    }
+    saltarLinea(&esc);
+
+    malla->vecinos = malloc((size_t)numTriangulos * 3 * sizeof(int32_t) + 1);
+    if (!malla->vecinos) {
+        liberarArchivoMapeado(&mapa);
+        return 0;
+    }
+
+    for (int i = 0; i < numTriangulos; i++) {
+        int numero, v, correcto = siguienteRegistro(&esc) && escanearEntero(&esc, &numero);
+        for (int k = 0; correcto && k < 3; k++) {
+            correcto = escanearEntero(&esc, &v);
+            malla->vecinos[3 * i + k] = (v < 0) ? -1 : v - primerNumero;
+        }
+        if (!correcto) {
+            free(malla->vecinos);
+            malla->vecinos = NULL;
+            liberarArchivoMapeado(&mapa);
+            return 0;
+        }
+        saltarLinea(&esc);
+    }
+
+    liberarArchivoMapeado(&mapa);
+    return 1;
+}
+
+// Convierte <base>.node, <base>.ele y, si existen, <base>.neigh y <base>.poly
+// al archivo binario indicado
+int convertirTextoABMesh(const char *base, const char *archivoBMesh) {
+    char nombre[FILENAME_MAX];
+    struct MallaBinaria malla;
+    memset(&malla, 0, sizeof(malla));
+
+    snprintf(nombre, sizeof(nombre), "%s.node", base);
+    struct EntradaPoly *nodos = leerArchivoNode(nombre);
+    if (!nodos) return 0;
+
+    malla.numPuntos = nodos->numVertices;
+    malla.numAtributosPunto = nodos->numAtributos;
+    malla.puntos = malloc((size_t)nodos->numVertices * 2 * sizeof(double) + 1);
+    if (!malla.puntos) {
+        liberarEntradaPoly(nodos);
+        return 0;
+    }
+    for (int i = 0; i < nodos->numVertices; i++) {
+        malla.puntos[2 * i] = nodos->vertices[i].x;
+        malla.puntos[2 * i + 1] = nodos->vertices[i].y;
+    }
+    if (nodos->numAtributos > 0) {
+        malla.atributosPuntos = nodos->atributos;
+        nodos->atributos = NULL;
+    }
+    if (nodos->numMarcadores > 0) {
+        malla.marcadoresPuntos = (int32_t*)nodos->marcadores;
+        nodos->marcadores = NULL;
+    }
+    int primerNumero = nodos->primerNumero;
+    liberarEntradaPoly(nodos);
+
+    snprintf(nombre, sizeof(nombre), "%s.ele", base);
+    if (!leerArchivoEle(nombre, primerNumero, &malla)) {
+        liberarMallaBinaria(&malla);
+        return 0;
+    }
+
+    snprintf(nombre, sizeof(nombre), "%s.neigh", base);
+    leerArchivoNeigh(nombre, primerNumero, &malla);
+
+    snprintf(nombre, sizeof(nombre), "%s.poly", base);
+    FILE *prueba = fopen(nombre, "r");
+    if (prueba) {
+        fclose(prueba);
+        struct EntradaPoly *poly = leerArchivoPoly(nombre);
+        if (poly) {
+            if (poly->numSegmentos > 0) {
+                malla.segmentos = malloc((size_t)poly->numSegmentos * 2 * sizeof(int32_t));
+                malla.marcadoresSegmentos = malloc((size_t)poly->numSegmentos * sizeof(int32_t));
+                if (malla.segmentos && malla.marcadoresSegmentos) {
+                    malla.numSegmentos = poly->numSegmentos;
+                    for (int i = 0; i < poly->numSegmentos; i++) {
+                        malla.segmentos[2 * i] = poly->segmentos[i].v1;
+                        malla.segmentos[2 * i + 1] = poly->segmentos[i].v2;
+                        malla.marcadoresSegmentos[i] = poly->segmentos[i].marcador;
+                    }
+                }
+            }
+            if (poly->numAgujeros > 0) {
+                malla.agujeros = malloc((size_t)poly->numAgujeros * 2 * sizeof(double));
+                if (malla.agujeros) {
+                    malla.numAgujeros = poly->numAgujeros;
+                    for (int i = 0; i < poly->numAgujeros; i++) {
+                        malla.agujeros[2 * i] = poly->agujeros[i].x;
+                        malla.agujeros[2 * i + 1] = poly->agujeros[i].y;
+                    }
+                }
+            }
+            if (poly->numRegiones > 0) {
+                malla.regiones = malloc((size_t)poly->numRegiones * 4 * sizeof(double));
+                if (malla.regiones) {
+                    malla.numRegiones = poly->numRegiones;
+                    for (int i = 0; i < poly->numRegiones; i++) {
+                        malla.regiones[4 * i] = poly->regiones[i].x;
+                        malla.regiones[4 * i + 1] = poly->regiones[i].y;
+                        malla.regiones[4 * i + 2] = poly->regiones[i].atributo;
+                        malla.regiones[4 * i + 3] = poly->regiones[i].areaMaxima;
+                    }
+                }
+            }
+            liberarEntradaPoly(poly);
+        }
+    }
+
+    int resultado = guardarArchivoBMesh(&malla, archivoBMesh);
+    liberarMallaBinaria(&malla);
+    return resultado;
+}
+
+// Convierte un archivo .bmesh a <base>.node, <base>.ele y, según las
+// secciones presentes, <base>.neigh y <base>.poly (numeración base-1)
+int convertirBMeshATexto(const char *archivoBMesh, const char *base) {
+    struct MallaBinaria malla;
+    if (!abrirArchivoBMesh(archivoBMesh, &malla)) return 0;
+
+    char nombre[FILENAME_MAX];
+    FILE *archivo;
+
+    snprintf(nombre, sizeof(nombre), "%s.node", base);
+    if (!(archivo = fopen(nombre, "w"))) {
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombre);
+        cerrarArchivoBMesh(&malla);
+        return 0;
+    }
+    fprintf(archivo, "%d 2 %d %d\n", malla.numPuntos, malla.numAtributosPunto,
+            malla.marcadoresPuntos ? 1 : 0);
+    for (int i = 0; i < malla.numPuntos; i++) {
+        // %.17g conserva el valor exacto del double
+        fprintf(archivo, "%d %.17g %.17g", i + 1, malla.puntos[2 * i], malla.puntos[2 * i + 1]);
+        for (int j = 0; j < malla.numAtributosPunto; j++) {
+            fprintf(archivo, " %.17g", malla.atributosPuntos[i * malla.numAtributosPunto + j]);
+        }
+        if (malla.marcadoresPuntos) fprintf(archivo, " %d", malla.marcadoresPuntos[i]);
+        fprintf(archivo, "\n");
+    }
+    fclose(archivo);
+
+    snprintf(nombre, sizeof(nombre), "%s.ele", base);
+    if (!(archivo = fopen(nombre, "w"))) {
+        TRAZA_ERROR("No se pudo crear el archivo %s\n", nombre);
+        cerrarArchivoBMesh(&malla);
+        return 0;
+    }
+    fprintf(archivo, "%d  3  %d\n", malla.numTriangulos, malla.numAtributosTriangulo);
+    for (int i = 0; i < malla.numTriangulos; i++) {
+        fprintf(archivo, "%d  %d  %d  %d", i + 1, malla.triangulos[3 * i] + 1,
+                malla.triangulos[3 * i + 1] + 1, malla.triangulos[3 * i + 2] + 1);
+        for (int j = 0; j < malla.numAtributosTriangulo; j++) {
+            fprintf(archivo, "  %.17g", malla.atributosTriangulos[i * malla.numAtributosTriangulo + j]);
+        }
+        fprintf(archivo, "\n");
+    }
+    fclose(archivo);
+
+    if (malla.vecinos) {
+        snprintf(nombre, sizeof(nombre), "%s.neigh", base);
+        if ((archivo = fopen(nombre, "w"))) {
+            fprintf(archivo, "%d  3\n", malla.numTriangulos);
+            for (int i = 0; i < malla.numTriangulos; i++) {
+                fprintf(archivo, "%d  %d  %d  %d\n", i + 1,
+                        malla.vecinos[3 * i] < 0 ? -1 : malla.vecinos[3 * i] + 1,
+                        malla.vecinos[3 * i + 1] < 0 ? -1 : malla.vecinos[3 * i + 1] + 1,
+                        malla.vecinos[3 * i + 2] < 0 ? -1 : malla.vecinos[3 * i + 2] + 1);
+            }
+            fclose(archivo);
+        }
+    }
+
+    if (malla.segmentos || malla.agujeros || malla.regiones) {
+        snprintf(nombre, sizeof(nombre), "%s.poly", base);
+        if ((archivo = fopen(nombre, "w"))) {
+            // Los vértices están en el .node
+            fprintf(archivo, "0 2 0 1\n");
+            fprintf(archivo, "%d 1\n", malla.segmentos ? malla.numSegmentos : 0);
+            for (int i = 0; malla.segmentos && i < malla.numSegmentos; i++) {
+                fprintf(archivo, "%d %d %d %d\n", i + 1, malla.segmentos[2 * i] + 1,
+                        malla.segmentos[2 * i + 1] + 1,
+                        malla.marcadoresSegmentos ? malla.marcadoresSegmentos[i] : 0);
+            }
+            fprintf(archivo, "%d\n", malla.agujeros ? malla.numAgujeros : 0);
+            for (int i = 0; malla.agujeros && i < malla.numAgujeros; i++) {
+                fprintf(archivo, "%d %.17g %.17g\n", i + 1, malla.agujeros[2 * i], malla.agujeros[2 * i + 1]);
+            }
+            fprintf(archivo, "%d\n", malla.regiones ? malla.numRegiones : 0);
+            for (int i = 0; malla.regiones && i < malla.numRegiones; i++) {
+                fprintf(archivo, "%d %.17g %.17g %.17g %.17g\n", i + 1,
+                        malla.regiones[4 * i], malla.regiones[4 * i + 1],
+                        malla.regiones[4 * i + 2], malla.regiones[4 * i + 3]);
+            }
+            fclose(archivo);
+        }
+    }
+
+    cerrarArchivoBMesh(&malla);
+    return 1;
+}
+
+
+/* Caché de resultados                                                        */
+
+// Cada resultado se guarda como <directorio>/<clave>.bmesh, donde la clave es
+// un hash de 128 bits de la entrada canónica (los valores leídos, no el texto
+// del archivo) y de las opciones que afectan la malla. Un acierto proyecta el
+// archivo con mmap; la fecha de modificación hace de marca de último uso para
+// expulsar los resultados más antiguos cuando el directorio supera el límite.
+
+// Primos de mezcla de 64 bits (los de xxHash64)
+# define HASH_PRIMO_1 0x9E3779B185EBCA87ULL
+# define HASH_PRIMO_2 0xC2B2AE3D27D4EB4FULL
+# define HASH_PRIMO_3 0x165667B19E3779F9ULL
+
+struct EstadoHash {
+    uint64_t a, b;
+    uint64_t palabras;
+};
+
+static inline uint64_t rotarIzquierda64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t mezclarFinal64(uint64_t x) {
+    x ^= x >> 33;
+    x *= HASH_PRIMO_2;
+    x ^= x >> 29;
+    x *= HASH_PRIMO_3;
+    x ^= x >> 32;
+    return x;
+}
+
+static inline void agregarPalabraHash(struct EstadoHash *h, uint64_t w) {
+    h->a = rotarIzquierda64(h->a + w * HASH_PRIMO_2, 31) * HASH_PRIMO_1;
+    h->b = rotarIzquierda64(h->b ^ (w * HASH_PRIMO_1), 27) * HASH_PRIMO_2 + HASH_PRIMO_3;
+    h->palabras++;
+}
+
+static inline void agregarEnteroHash(struct EstadoHash *h, long long v) {
+    agregarPalabraHash(h, (uint64_t)v);
+}
+
+// -0.0 y 0.0 producen el mismo resultado y por lo tanto la misma clave
+static inline void agregarRealHash(struct EstadoHash *h, double v) {
+    uint64_t w;
+    if (v == 0.0) v = 0.0;
+    memcpy(&w, &v, sizeof(w));
+    agregarPalabraHash(h, w);
+}
+
+void claveCache(const struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                int destino, struct ClaveCache *clave) {
+    struct EstadoHash h = { HASH_PRIMO_1, HASH_PRIMO_2, 0 };
+
+    agregarEnteroHash(&h, VERSION_CACHE);
+    agregarEnteroHash(&h, BMESH_VERSION);
+    agregarEnteroHash(&h, destino);
+
+    // Opciones que cambian la malla (no los hilos ni el nivel de detalle)
+    agregarRealHash(&h, op->anguloMinimo > 0.0 ? op->anguloMinimo : 0.0);
+    agregarRealHash(&h, op->areaMaxima > 0.0 ? op->areaMaxima : 0.0);
+    agregarEnteroHash(&h, op->usarAreasRegion != 0);
+    agregarEnteroHash(&h, op->conforme != 0);
+    agregarEnteroHash(&h, op->posicionSteiner);
+    agregarEnteroHash(&h, op->algoritmo);
+    agregarRealHash(&h, op->eliminarRepetidos ? fmax(op->toleranciaRepetidos, 0.0) : -1.0);
+
+    agregarEnteroHash(&h, entrada->numVertices);
+    for (int i = 0; i < entrada->numVertices; i++) {
+        agregarRealHash(&h, entrada->vertices[i].x);
+        agregarRealHash(&h, entrada->vertices[i].y);
+    }
+    agregarEnteroHash(&h, entrada->marcadores != NULL);
+    for (int i = 0; entrada->marcadores && i < entrada->numVertices; i++) {
+        agregarEnteroHash(&h, entrada->marcadores[i]);
+    }
+    agregarEnteroHash(&h, entrada->numSegmentos);
+    for (int i = 0; i < entrada->numSegmentos; i++) {
+        agregarEnteroHash(&h, entrada->segmentos[i].v1);
+        agregarEnteroHash(&h, entrada->segmentos[i].v2);
+        agregarEnteroHash(&h, entrada->segmentos[i].marcador);
+    }
+    agregarEnteroHash(&h, entrada->numAgujeros);
+    for (int i = 0; i < entrada->numAgujeros; i++) {
+        agregarRealHash(&h, entrada->agujeros[i].x);
+        agregarRealHash(&h, entrada->agujeros[i].y);
+    }
+    agregarEnteroHash(&h, entrada->numRegiones);
+    for (int i = 0; i < entrada->numRegiones; i++) {
+        agregarRealHash(&h, entrada->regiones[i].x);
+        agregarRealHash(&h, entrada->regiones[i].y);
+        agregarEnteroHash(&h, entrada->regiones[i].atributo);
+        agregarRealHash(&h, entrada->regiones[i].areaMaxima);
+    }
+
+    clave->h[0] = mezclarFinal64(h.a ^ h.palabras);
+    clave->h[1] = mezclarFinal64(h.b + h.palabras * HASH_PRIMO_3);
+}
+
+static void nombreArchivoCache(const char *directorio, const struct ClaveCache *clave,
+                               const char *sufijo, char *nombre, size_t tamano) {
+    snprintf(nombre, tamano, "%s/%016llx%016llx%s", directorio,
+             (unsigned long long)clave->h[0], (unsigned long long)clave->h[1], sufijo);
+}
+
+static void crearDirectorioCache(const char *directorio) {
+#ifdef _WIN32
+    CreateDirectoryA(directorio, NULL);
+#else
+    mkdir(directorio, 0777);
+#endif
+}
+
+// Proyecta el resultado guardado. Con acierto la malla apunta al archivo y se
+// cierra con cerrarArchivoBMesh. Una entrada que no se puede abrir o a la que
+// le falta alguna sección de las que escribe mallaDesdeTriangulacion cuenta
+// como fallo: se borra y el llamador la vuelve a calcular y guardar.
+int buscarEnCache(const char *directorio, const struct ClaveCache *clave,
+                  struct MallaBinaria *malla) {
+    char nombre[FILENAME_MAX];
+    nombreArchivoCache(directorio, clave, ".bmesh", nombre, sizeof(nombre));
+
+    // Un archivo ausente es un fallo normal: no debe quedar como error
+    FILE *prueba = fopen(nombre, "rb");
+    if (!prueba) {
+        return 0;
+    }
+    fclose(prueba);
+
+    // El error de apertura no es del llamador, que recalcula la malla: basta
+    // con el aviso de abajo
+    char *errorAnterior = mensajeError;
+    int nivelAnterior = nivelDetalle;
+    mensajeError = NULL;
+    nivelDetalle = NIVEL_SILENCIOSO;
+    bool abierto = abrirArchivoBMesh(nombre, malla);
+    mensajeError = errorAnterior;
+    nivelDetalle = nivelAnterior;
+    bool completo = abierto &&
+        (malla->numPuntos == 0 || (malla->puntos && malla->marcadoresPuntos)) &&
+        (malla->numTriangulos == 0 || (malla->triangulos && malla->vecinos)) &&
+        (malla->numSegmentos == 0 || (malla->segmentos && malla->marcadoresSegmentos));
+    if (!completo) {
+        TRAZA_AVISO("Resultado en caché dañado, se descarta: %s\n", nombre);
+        if (abierto) cerrarArchivoBMesh(malla);
+        remove(nombre);
+        return 0;
+    }
+
+    // Marcar el uso para la expulsión por antigüedad
+    utime(nombre, NULL);
+    TRAZA_DETALLE("Resultado tomado de la caché: %s\n", nombre);
+    return 1;
+}
+
+struct ArchivoCache {
+    char nombre[FILENAME_MAX];
+    uint64_t tamano;
+    time_t ultimoUso;
+};
+
+static int compararArchivosCache(const void *a, const void *b) {
+    const struct ArchivoCache *x = a, *y = b;
+    return (x->ultimoUso > y->ultimoUso) - (x->ultimoUso < y->ultimoUso);
+}
+
+// Agrega un resultado del directorio a la lista (solo los .bmesh de la caché)
+static int agregarArchivoCache(struct ArchivoCache **lista, int *num, int *capacidad,
+                               const char *directorio, const char *nombre) {
+    size_t longitud = strlen(nombre);
+    if (longitud != 32 + 6 || strcmp(nombre + 32, ".bmesh") != 0) return 1;
+
+    struct ArchivoCache archivo;
+    snprintf(archivo.nombre, sizeof(archivo.nombre), "%s/%s", directorio, nombre);
+    struct stat info;
+    if (stat(archivo.nombre, &info) != 0) return 1;
+    archivo.tamano = (uint64_t)info.st_size;
+    archivo.ultimoUso = info.st_mtime;
+
+    if (*num == *capacidad) {
+        int nueva = *capacidad > 0 ? 2 * *capacidad : 64;
+        struct ArchivoCache *p = realloc(*lista, (size_t)nueva * sizeof(struct ArchivoCache));
+        if (!p) return 0;
+        *lista = p;
+        *capacidad = nueva;
+    }
+    (*lista)[(*num)++] = archivo;
+    return 1;
+}
+
+// Borra los resultados usados hace más tiempo hasta que el directorio quepa
+// en tamanoMaximo bytes
+static void recortarCache(const char *directorio, uint64_t tamanoMaximo) {
+    struct ArchivoCache *lista = NULL;
+    int num = 0, capacidad = 0;
+    bool correcto = true;
+
+#ifdef _WIN32
+    char patron[FILENAME_MAX];
+    snprintf(patron, sizeof(patron), "%s/*.bmesh", directorio);
+    WIN32_FIND_DATAA datos;
+    HANDLE busqueda = FindFirstFileA(patron, &datos);
+    if (busqueda == INVALID_HANDLE_VALUE) return;
+    do {
+        correcto = agregarArchivoCache(&lista, &num, &capacidad, directorio, datos.cFileName);
+    } while (correcto && FindNextFileA(busqueda, &datos));
+    FindClose(busqueda);
+#else
+    DIR *dir = opendir(directorio);
+    if (!dir) return;
+    struct dirent *d;
+    while (correcto && (d = readdir(dir)) != NULL) {
+        correcto = agregarArchivoCache(&lista, &num, &capacidad, directorio, d->d_name);
+    }
+    closedir(dir);
+#endif
+
+    uint64_t total = 0;
+    for (int i = 0; i < num; i++) total += lista[i].tamano;
+    if (correcto && total > tamanoMaximo) {
+        qsort(lista, (size_t)num, sizeof(struct ArchivoCache), compararArchivosCache);
+        for (int i = 0; i < num && total > tamanoMaximo; i++) {
+            if (remove(lista[i].nombre) == 0) {
+                total -= lista[i].tamano;
+                TRAZA_DETALLE("Expulsado de la caché: %s\n", lista[i].nombre);
+            }
+        }
+    }
+    free(lista);
+}
+
+// Guarda un resultado. Se escribe en un archivo temporal y se renombra, así
+// otros procesos nunca proyectan un resultado a medias.
+int guardarEnCache(const char *directorio, uint64_t tamanoMaximo, const struct ClaveCache *clave,
+                   const struct MallaBinaria *malla) {
+    if (tamanoBMesh(malla) > tamanoMaximo) return 0;
+    crearDirectorioCache(directorio);
+
+    char nombre[FILENAME_MAX], temporal[FILENAME_MAX + 32];
+    nombreArchivoCache(directorio, clave, ".bmesh", nombre, sizeof(nombre));
+    static LOCAL_HILO int secuencia = 0;
+    char sufijo[48];
+#ifdef _WIN32
+    snprintf(sufijo, sizeof(sufijo), ".%lu.%lu.%d.tmp", (unsigned long)GetCurrentProcessId(),
+             (unsigned long)GetCurrentThreadId(), secuencia++);
+#else
+    snprintf(sufijo, sizeof(sufijo), ".%ld.%p.%d.tmp", (long)getpid(), (void *)&sufijo, secuencia++);
+#endif
+    nombreArchivoCache(directorio, clave, sufijo, temporal, sizeof(temporal));
+
+    FILE *archivo = fopen(temporal, "wb");
+    if (!archivo) {
+        TRAZA_AVISO("No se pudo escribir en la caché %s\n", directorio);
+        return 0;
+    }
+    int correcto = escribirBMesh(malla, archivo);
+    correcto = fclose(archivo) == 0 && correcto;
+#ifdef _WIN32
+    correcto = correcto && MoveFileExA(temporal, nombre, MOVEFILE_REPLACE_EXISTING);
+#else
+    correcto = correcto && rename(temporal, nombre) == 0;
+#endif
+    if (!correcto) {
+        remove(temporal);
+        TRAZA_AVISO("No se pudo guardar el resultado en la caché %s\n", directorio);
+        return 0;
+    }
+
+    recortarCache(directorio, tamanoMaximo);
+    return 1;
+}
+
+
+/* Funciones de Gestión de Memoria                                                */
+
+struct PoolMemoria* inicializarPool(int capacidadMaxima, int tamañoElemento) {
+    struct PoolMemoria* pool = (struct PoolMemoria*)malloc(sizeof(struct PoolMemoria));
+    if (!pool) {
+        TRAZA_ERROR("No se pudo crear el pool de memoria\n");
+        return NULL;
+    }
+
+    pool->elementos = (void**)malloc(capacidadMaxima * sizeof(void*));
+    if (!pool->elementos) {
+        TRAZA_ERROR("No se pudo asignar memoria para los elementos del pool\n");
+        free(pool);
+        return NULL;
+    }
+
+    pool->elementoActual = malloc(capacidadMaxima * tamañoElemento);
+    if (!pool->elementoActual) {
+        TRAZA_ERROR("No se pudo asignar el bloque de memoria principal\n");
+        free(pool->elementos);
+        free(pool);
+        return NULL;
+    }
+
+    pool->capacidadMaxima = capacidadMaxima;
+    pool->elementosLibres = capacidadMaxima;
+    pool->tamañoElemento = tamañoElemento;
+
+    // Inicializar la lista de elementos libres
+    for (int i = 0; i < capacidadMaxima; i++) {
+        pool->elementos[i] = (char*)pool->elementoActual + (i * tamañoElemento);
+    }
+
+    return pool;
+}
+
+void* obtenerDelPool(struct PoolMemoria* pool) {
+    if (!pool || pool->elementosLibres <= 0) {
+        CONTAR_OPERACION(asignacionesArenaFallidas, 1);
+        return NULL;
+    }
+
+    CONTAR_OPERACION(asignacionesArena, 1);
+    void* elemento = pool->elementos[--pool->elementosLibres];
+    memset(elemento, 0, pool->tamañoElemento);
+    return elemento;
+}
+
+void devolverAlPool(struct PoolMemoria* pool, void* elemento) {
+    if (!pool || !elemento || pool->elementosLibres >= pool->capacidadMaxima) {
+        return;
+    }
+
+    pool->elementos[pool->elementosLibres++] = elemento;
+}
+
+void liberarPool(struct PoolMemoria* pool) {
+    if (pool) {
+        free(pool->elementoActual);
+        free(pool->elementos);
+        free(pool);
+    }
+}
+
+void liberarEntradaPoly(struct EntradaPoly* entrada) {
+    if (entrada) {
+        free(entrada->vertices);
+        free(entrada->atributos);
+        free(entrada->marcadores);
+        free(entrada->segmentos);
+        free(entrada->marcadoresSegmentos);
+        free(entrada->agujeros);
+        free(entrada->regiones);
+        free(entrada);
+    }
+}
+
+
+/* Funciones de Operaciones Aritméticas                                           */
+
+// Función para calcular el área de un triángulo usando determinantes
+double areaTriangulo(struct Punto *a, struct Punto *b, struct Punto *c) {
+    return fabs((b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y)) / 2.0;
+}
+
+void intercambiarDiagonal(struct Triangulacion *tr, struct Triangulo *t1, struct Triangulo *t2) {
+    (void)tr;
+    // Implementación básica de intercambio de diagonal
+    struct Punto *p1 = NULL, *p2 = NULL, *p3 = NULL, *p4 = NULL;
+    
+    // Encontrar los cuatro puntos del cuadrilátero
+    for(int i = 0; i < 3; i++) {
+        if(!tieneVertice(t2, t1->vertices[i])) p1 = t1->vertices[i];
+        if(!tieneVertice(t1, t2->vertices[i])) p3 = t2->vertices[i];
+    }
+    
+    // Encontrar los puntos compartidos
+    for(int i = 0; i < 3; i++) {
+        if(t1->vertices[i] != p1) {
+            if(p2 == NULL) p2 = t1->vertices[i];
+            else p4 = t1->vertices[i];
+        }
+    }
+    
+    // Crear nuevos triángulos
+    struct Triangulo *n1 = crearTriangulo(p1, p3, p2);
+    struct Triangulo *n2 = crearTriangulo(p1, p3, p4);
+    if (n1 && n2) {
+        *t1 = *n1;
+        *t2 = *n2;
+        CONTAR_OPERACION(intercambios, 1);
+    }
+    free(n1);
+    free(n2);
+}
+
+// Función para calcular el determinante de una matriz 3x3
+double determinante3x3(double matriz[3][3]) {
+    return matriz[0][0] * (matriz[1][1] * matriz[2][2] - matriz[1][2] * matriz[2][1])
+         - matriz[0][1] * (matriz[1][0] * matriz[2][2] - matriz[1][2] * matriz[2][0])
+         + matriz[0][2] * (matriz[1][0] * matriz[2][1] - matriz[1][1] * matriz[2][0]);
+}
+
+struct Punto* calcularCircuncentro(struct Triangulo *t) {
+    struct Punto *p1 = t->vertices[0];
+    struct Punto *p2 = t->vertices[1];
+    struct Punto *p3 = t->vertices[2];
+    
+    double d = 2 * (p1->x * (p2->y - p3->y) + 
+                    p2->x * (p3->y - p1->y) + 
+                    p3->x * (p1->y - p2->y));
+    
+    if (fabs(d) < 1e-10) return NULL;  // Triángulo degenerado
+    
+    struct Punto *c = malloc(sizeof(struct Punto));
+    if (!c) return NULL;
+    CONTAR_OPERACION(asignacionesMonton, 1);
+    
+    c->x = ((p1->x*p1->x + p1->y*p1->y) * (p2->y - p3->y) +
+            (p2->x*p2->x + p2->y*p2->y) * (p3->y - p1->y) +
+            (p3->x*p3->x + p3->y*p3->y) * (p1->y - p2->y)) / d;
+            
+    c->y = ((p1->x*p1->x + p1->y*p1->y) * (p3->x - p2->x) +
+            (p2->x*p2->x + p2->y*p2->y) * (p1->x - p3->x) +
+            (p3->x*p3->x + p3->y*p3->y) * (p2->x - p1->x)) / d;
+            
+    return c;
+}
+
+// Distancia del punto fuera de centro a la arista más corta, en múltiplos de
+// su longitud, para un ángulo mínimo en radianes. Con cot(θ/2) / 2 (Üngör) el
+// punto forma con esa arista un triángulo cuyo ángulo menor es justo θ;
+// triangle.c usa 0.475 en lugar de 0.5 para quedar con margen.
+double constanteFueraCentro(int posicionSteiner, double anguloMinimo) {
+    if (posicionSteiner == STEINER_CIRCUNCENTRO || anguloMinimo <= 0.0) return 0.0;
+    double coseno = cos(anguloMinimo);
+    if (coseno >= 1.0) return 0.0;
+    double factor = posicionSteiner == STEINER_FUERA_CENTRO ? 0.5 : 0.475;
+    return factor * sqrt((1.0 + coseno) / (1.0 - coseno));
+}
+
+// Punto Steiner para el triángulo (a, b, c): el circuncentro o, si la
+// constante es positiva y queda más cerca de la arista más corta, el punto
+// fuera de centro sobre su mediatriz (como findcircumcenter de triangle.c).
+// Evita las cascadas de los circuncentros lejanos de los triángulos delgados.
+bool ubicarPuntoSteiner(struct Punto *a, struct Punto *b, struct Punto *c, double constante,
+                        double *x, double *y) {
+    // Circuncentro relativo a a para no perder precisión con coordenadas grandes
+    double bx = b->x - a->x, by = b->y - a->y;
+    double cx = c->x - a->x, cy = c->y - a->y;
+    double d = 2.0 * (bx * cy - by * cx);
+    if (d == 0.0) return false;
+    double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+    *x = a->x + (cy * b2 - by * c2) / d;
+    *y = a->y + (bx * c2 - cx * b2) / d;
+    if (!isfinite(*x) || !isfinite(*y)) return false;
+    if (constante <= 0.0) return true;
+
+    // Arista más corta (p, q) y vértice opuesto r
+    struct Punto *v[3] = { a, b, c };
+    int k = 0;
+    double minimo = DBL_MAX;
+    for (int i = 0; i < 3; i++) {
+        double dx = v[(i + 1) % 3]->x - v[i]->x, dy = v[(i + 1) % 3]->y - v[i]->y;
+        if (dx * dx + dy * dy < minimo) {
+            minimo = dx * dx + dy * dy;
+            k = i;
+        }
+    }
+    struct Punto *p = v[k], *q = v[(k + 1) % 3], *r = v[(k + 2) % 3];
+    double ex = q->x - p->x, ey = q->y - p->y;
+    double nx = -ey, ny = ex;   // Normal hacia r, de la misma longitud que la arista
+    if (nx * (r->x - p->x) + ny * (r->y - p->y) < 0.0) {
+        nx = -nx;
+        ny = -ny;
+    }
+    double fx = 0.5 * ex + constante * nx, fy = 0.5 * ey + constante * ny;
+    double ox = *x - p->x, oy = *y - p->y;
+    if (fx * fx + fy * fy < ox * ox + oy * oy) {
+        *x = p->x + fx;
+        *y = p->y + fy;
+        CONTAR_OPERACION(steinerFueraDeCentro, 1);
+    }
+    return true;
+}
+
+double calcularAreaTriangulo(struct Triangulo *t) {
+    if (t == NULL) return 0.0;
+
+    struct Punto *p1 = t->vertices[0];
+    struct Punto *p2 = t->vertices[1];
+    struct Punto *p3 = t->vertices[2];
+
+    // Fórmula del área usando determinante
+    double area = fabs((p1->x * (p2->y - p3->y) + 
+                       p2->x * (p3->y - p1->y) + 
+                       p3->x * (p1->y - p2->y)) / 2.0);
+
+    return area;
+}
+
+double calcularAngulo(struct Punto *p1, struct Punto *p2, struct Punto *p3) {
+    double dx1 = p2->x - p1->x;
+    double dy1 = p2->y - p1->y;
+    double dx2 = p3->x - p1->x;
+    double dy2 = p3->y - p1->y;
+    
+    // Calcular el ángulo usando el producto punto
+    double dot = dx1*dx2 + dy1*dy2;
+    double len1 = sqrt(dx1*dx1 + dy1*dy1);
+    double len2 = sqrt(dx2*dx2 + dy2*dy2);
+    
+    if(len1 == 0 || len2 == 0) return -1;
+    
+    double cosAngulo = dot/(len1*len2);
+    if(cosAngulo > 1) cosAngulo = 1;
+    if(cosAngulo < -1) cosAngulo = -1;
+    
+    return acos(cosAngulo);
+}
+
+double distanciaEntrePuntos(struct Punto *p1, struct Punto *p2) {
+    return sqrt(pow(p2->x - p1->x, 2) + pow(p2->y - p1->y, 2));
+}
+
+
+/* Funciones de verificación y comparación                                        */
+
+// Función para comparar puntos (primero por x, luego por y)
+int compararPuntos(const void *a, const void *b) {
+    struct Punto *p1 = (struct Punto *)a;
+    struct Punto *p2 = (struct Punto *)b;
+    
+    if (p1->x != p2->x) {
+        return (p1->x > p2->x) ? 1 : -1;
+    }
+    return (p1->y > p2->y) ? 1 : -1;
+}
+
+// Función para verificar si un punto está dentro de un triángulo usando áreas
+bool puntoEnTriangulo(struct Triangulo *t, struct Punto *p) {
+    // Cálculo de áreas usando determinantes
+    double area = areaTriangulo(t->vertices[0], t->vertices[1], t->vertices[2]);
+    double area1 = areaTriangulo(p, t->vertices[1], t->vertices[2]);
+    double area2 = areaTriangulo(t->vertices[0], p, t->vertices[2]);
+    double area3 = areaTriangulo(t->vertices[0], t->vertices[1], p);
+
+    // Usar tolerancia para comparaciones de punto flotante
+    const double EPSILON = 1e-10;
+    double total = area1 + area2 + area3;
+    
+    return fabs(area - total) < EPSILON;
+}
+
+// Función para verificar si un triángulo tiene vértices artificiales
+int tieneVerticeArtificial(struct Triangulo *t) {
+    return t->vertices[0]->indice < 0 || 
+           t->vertices[1]->indice < 0 || 
+           t->vertices[2]->indice < 0;
+}
+
+// Función auxiliar para verificar si un triángulo tiene un vértice
+int tieneVertice(struct Triangulo *t, struct Punto *p) {
+    if(t == NULL || p == NULL) return 0;
+    
+    return (t->vertices[0] == p || 
+            t->vertices[1] == p || 
+            t->vertices[2] == p);
+}
+
+// Función para verificar si un punto está dentro del círculo circunscrito
+int puntoEnCircunscrito(struct Triangulo *t, struct Punto *p) {
+    struct Punto *a = t->vertices[0];
+    struct Punto *b = t->vertices[1];
+    struct Punto *c = t->vertices[2];
+    
+    // Matriz para el test del círculo circunscrito
+    double matriz[3][3] = {
+        {a->x - p->x, a->y - p->y, (a->x - p->x) * (a->x - p->x) + (a->y - p->y) * (a->y - p->y)},
+        {b->x - p->x, b->y - p->y, (b->x - p->x) * (b->x - p->x) + (b->y - p->y) * (b->y - p->y)},
+        {c->x - p->x, c->y - p->y, (c->x - p->x) * (c->x - p->x) + (c->y - p->y) * (c->y - p->y)}
+    };
+    
+    // El signo del determinante indica si el punto está dentro o fuera
+    double det = determinante3x3(matriz);
+
+    CONTAR_OPERACION(circunferencias, 1);
+    double permanente = matriz[0][2] * fabs(matriz[1][0] * matriz[2][1] - matriz[1][1] * matriz[2][0])
+                      + matriz[1][2] * fabs(matriz[2][0] * matriz[0][1] - matriz[2][1] * matriz[0][0])
+                      + matriz[2][2] * fabs(matriz[0][0] * matriz[1][1] - matriz[0][1] * matriz[1][0]);
+    if (fabs(det) <= COTA_ERROR_CIRCUNFERENCIA * permanente) {
+        CONTAR_OPERACION(circunferenciasInciertas, 1);
+    }
+    
+    // Usamos una pequeña tolerancia para manejar errores de punto flotante
+    double tolerancia = 1e-10;
+    
+    // Si el determinante es positivo, el punto está dentro del círculo
+    return det > tolerancia;
+}
+
+bool necesitaRefinamiento(struct Triangulo *t, double anguloMinimo, double areaMaxima) {
+    // Verificar área
+    double area = calcularAreaTriangulo(t);
+    if (area > areaMaxima) return true;
+    
+    // Verificar ángulos
+    double angulos[3];
+    calcularAngulos(t, angulos);
+    
+    for (int i = 0; i < 3; i++) {
+        if (angulos[i] < anguloMinimo) return true;
+    }
+    
+    return false;
+}
+
+void calcularAngulos(struct Triangulo *t, double *angulos) {
+    for (int i = 0; i < 3; i++) {
+        struct Punto *p1 = t->vertices[i];
+        struct Punto *p2 = t->vertices[(i+1)%3];
+        struct Punto *p3 = t->vertices[(i+2)%3];
+        
+        double dx1 = p2->x - p1->x;
+        double dy1 = p2->y - p1->y;
+        double dx2 = p3->x - p1->x;
+        double dy2 = p3->y - p1->y;
+        
+        angulos[i] = fabs(atan2(dx1*dy2 - dy1*dx2, dx1*dx2 + dy1*dy2));
+    }
+}
+
+bool esPuntoCercaDelBorde(struct Punto *p, struct Triangulacion *tr) {
+    const double DIST_MIN_BORDE = 0.05;
+    const int NUM_VECINOS = 2; // Reducimos a 2 para ser más selectivos
+    int puntos_cercanos = 0;
+    
+    // Primero verificar si está muy lejos verticalmente
+    double ymin = tr->puntos[0].y;
+    double ymax = tr->puntos[0].y;
+    for(int i = 1; i < tr->numPuntos; i++) {
+        if(tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
+        if(tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+    }
+    
+    if(p->y < ymin - 0.1 || p->y > ymax + 0.1) {
+        return true;  // Rechazar puntos muy alejados verticalmente
+    }
+    
+    // Verificar puntos cercanos
+    for(int i = 0; i < tr->numPuntos; i++) {
+        if(distanciaEntrePuntos(&tr->puntos[i], p) < DIST_MIN_BORDE) {
+            puntos_cercanos++;
+            if(puntos_cercanos >= NUM_VECINOS) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+struct Punto* calcularPuntoInterseccion(struct Triangulo *t1, struct Triangulo *t2,
+                                       struct Punto *p1, struct Punto *p2) {
+    (void)t2;
+    // Crear punto para almacenar la intersección
+    struct Punto *interseccion = malloc(sizeof(struct Punto));
+    if (!interseccion) return NULL;
+
+    // Obtener los segmentos del triángulo que podrían intersectar
+    for (int i = 0; i < 3; i++) {
+        struct Punto *a = t1->vertices[i];
+        struct Punto *b = t1->vertices[(i+1)%3];
+        
+        // Verificar si este segmento intersecta con el segmento restricción
+        double x, y;
+        if (encontrarInterseccion(p1->x, p1->y, p2->x, p2->y,
+                                 a->x, a->y, b->x, b->y,
+                                 &x, &y)) {
+            // Verificar que el punto no sea uno de los extremos
+            if (!esPuntoExtremo(x, y, p1, p2) && 
+                !esPuntoExtremo(x, y, a, b)) {
+                interseccion->x = x;
+                interseccion->y = y;
+                interseccion->indice = -1; // Punto temporal
+                return interseccion;
+            }
+        }
+    }
+    
+    free(interseccion);
+    return NULL;
+}
+
+// Función auxiliar para encontrar la intersección entre dos segmentos
+bool encontrarInterseccion(double x1, double y1, double x2, double y2,
+                          double x3, double y3, double x4, double y4,
+                          double *x, double *y) {
+    // Calcular denominador
+    double denom = (y4-y3)*(x2-x1) - (x4-x3)*(y2-y1);
+    if (fabs(denom) < 1e-10) return false; // Segmentos paralelos
+
+    // Calcular parámetros de intersección
+    double ua = ((x4-x3)*(y1-y3) - (y4-y3)*(x1-x3)) / denom;
+    double ub = ((x2-x1)*(y1-y3) - (y2-y1)*(x1-x3)) / denom;
+
+    // Verificar si la intersección está dentro de ambos segmentos
+    if (ua >= 0 && ua <= 1 && ub >= 0 && ub <= 1) {
+        *x = x1 + ua*(x2-x1);
+        *y = y1 + ua*(y2-y1);
+        return true;
+    }
+
+    return false;
+}
+
+// Función auxiliar para verificar si un punto es extremo de un segmento
+bool esPuntoExtremo(double x, double y, struct Punto *p1, struct Punto *p2) {
+    const double EPSILON = 1e-10;
+    return (fabs(x - p1->x) < EPSILON && fabs(y - p1->y) < EPSILON) ||
+           (fabs(x - p2->x) < EPSILON && fabs(y - p2->y) < EPSILON);
+}
+
+bool esDelaunay(struct Punto *candidatoIzq, struct Punto *candidatoDer, struct Borde *base) {
+    if (!candidatoIzq) return true;   // Si no hay candidato izquierdo, usar derecho
+    if (!candidatoDer) return false;  // Si no hay candidato derecho, usar izquierdo
+    
+    // Verificar el criterio del círculo vacío
+    return !puntoEnCircunferencia(candidatoIzq, base->p1, base->p2, candidatoDer);
+}
+
+double orientacion(struct Punto *p1, struct Punto *p2, struct Punto *p3) {
+    double izquierda = (p2->x - p1->x) * (p3->y - p1->y);
+    double derecha = (p3->x - p1->x) * (p2->y - p1->y);
+    double det = izquierda - derecha;
+
+    CONTAR_OPERACION(orientaciones, 1);
+    if (fabs(det) <= COTA_ERROR_ORIENTACION * (fabs(izquierda) + fabs(derecha))) {
+        CONTAR_OPERACION(orientacionesInciertas, 1);
+    }
+    return det;
+}
+
+bool puntoEnCircunferencia(struct Punto *p1, struct Punto *p2, 
+                          struct Punto *p3, struct Punto *punto) {
+    double ax = p2->x - p1->x;
+    double ay = p2->y - p1->y;
+    double bx = p3->x - p1->x;
+    double by = p3->y - p1->y;
+    
+    double c = ax * ax + ay * ay;
+    double d = bx * bx + by * by;
+    double e = ax * by - ay * bx;
+    
+    if (e == 0) return false;  // Puntos colineales
+    
+    double px = punto->x - p1->x;
+    double py = punto->y - p1->y;
+    
+    double det = (px * px + py * py) * (ax * by - ay * bx) -
+                (c * (px * by - py * bx) + d * (py * ax - px * ay));
+
+    CONTAR_OPERACION(circunferencias, 1);
+    double permanente = (px * px + py * py) * (fabs(ax * by) + fabs(ay * bx)) +
+                        c * (fabs(px * by) + fabs(py * bx)) + d * (fabs(py * ax) + fabs(px * ay));
+    if (fabs(det) <= COTA_ERROR_CIRCUNFERENCIA * permanente) {
+        CONTAR_OPERACION(circunferenciasInciertas, 1);
+    }
+                
+    return det > 0;
+}
+
+
+/* Funciones auxiliares                                                        */
+
+bool necesitaIntercambio(struct Triangulo *t1, struct Triangulo *t2) {
+    // Implementación del criterio de Delaunay
+    struct Punto *p4 = NULL;
+    for(int i = 0; i < 3; i++) {
+        if(!tieneVertice(t1, t2->vertices[i])) {
+            p4 = t2->vertices[i];
+            break;
+        }
+    }
+    return puntoEnCircunscrito(t1, p4);
+}
+
+// Función para encontrar el índice del vértice opuesto a un borde en un triángulo
+int encontrarBorde(struct Triangulo *t, struct Punto *p1, struct Punto *p2) {
+    int i;
+    for(i = 0; i < 3; i++) {
+        if((t->vertices[i] == p1 && t->vertices[(i+1)%3] == p2) ||
+           (t->vertices[i] == p2 && t->vertices[(i+1)%3] == p1)) {
+            return i;
+        }
+    }
+    return -1;  // No se encontró el borde
+}
+
+// Función para actualizar las relaciones de vecindad
+void actualizarVecinos(struct Triangulacion *tr) {
+    int i, j, k;
+    
+    // Primero, limpiamos todas las relaciones de vecindad
+    for(i = 0; i < tr->numTriangulos; i++) {
+        tr->triangulos[i].vecinos[0] = NULL;
+        tr->triangulos[i].vecinos[1] = NULL;
+        tr->triangulos[i].vecinos[2] = NULL;
+    }
+    
+    // Luego, buscamos los vecinos para cada triángulo
+    for(i = 0; i < tr->numTriangulos; i++) {
+        for(j = i + 1; j < tr->numTriangulos; j++) {
+            // Para cada par de triángulos, verificamos si comparten un borde
+            for(k = 0; k < 3; k++) {
+                struct Punto *p1 = tr->triangulos[i].vertices[k];
+                struct Punto *p2 = tr->triangulos[i].vertices[(k+1)%3];
+                
+                // Buscar este borde en el otro triángulo
+                int bordeComun = encontrarBorde(&tr->triangulos[j], p1, p2);
+                if(bordeComun != -1) {
+                    // Los triángulos son vecinos
+                    tr->triangulos[i].vecinos[k] = &tr->triangulos[j];
+                    tr->triangulos[j].vecinos[bordeComun] = &tr->triangulos[i];
+                }
+            }
+        }
+    }
+}
+
+void agregarTrianguloACola(struct ColaRefinamiento *cola, struct Triangulo *t) {
+    if(cola->numTriangulos < cola->capacidad) {
+        cola->triangulos[cola->numTriangulos++] = t;
+    }
+}
+
+struct Triangulo* extraerTriangulo(struct ColaRefinamiento *cola) {
+    if(cola->numTriangulos > 0) {
+        return cola->triangulos[--cola->numTriangulos];
+    }
+    return NULL;
+}
+
+bool dentroLimites(struct Punto *p, struct Triangulacion *tr) {
+    // Encontrar los límites del dominio original
+    double xmin = tr->puntos[0].x;
+    double xmax = tr->puntos[0].x;
+    double ymin = tr->puntos[0].y;
+    double ymax = tr->puntos[0].y;
+    
+    for(int i = 1; i < tr->numPuntos; i++) {
+        if(tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
+        if(tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
+        if(tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
+        if(tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+    }
+    
+    // Margen más estricto
+    const double margen = 0.05;
+    
+    // Verificación más estricta de los límites
+    bool dentroX = p->x > xmin + margen && p->x < xmax - margen;
+    bool dentroY = p->y > ymin + margen && p->y < ymax - margen;
+    
+    // Verificación adicional para puntos muy alejados
+    bool noMuyLejos = fabs(p->y - ymin) < 0.2 && fabs(p->y - ymax) < 0.2;
+    
+    return dentroX && dentroY && noMuyLejos;
+}
+
+struct ListaTriangulos* encontrarTriangulosIntersectados(struct Triangulacion *tr, 
+                                                        struct Punto *p1, 
+                                                        struct Punto *p2) {
+    // Inicializar lista de triángulos
     struct ListaTriangulos *lista = malloc(sizeof(struct ListaTriangulos));
     if (!lista) return NULL;
     
-    lista->capacidad = 10;  // Capacidad inicial
-    lista->numTriangulos = 0;
-    lista->triangulos = malloc(lista->capacidad * sizeof(struct Triangulo*));
-    if (!lista->triangulos) {
-        free(lista);
-        return NULL;
+    lista->capacidad = 10;  // Capacidad inicial
+    lista->numTriangulos = 0;
+    lista->triangulos = malloc(lista->capacidad * sizeof(struct Triangulo*));
+    if (!lista->triangulos) {
+        free(lista);
+        return NULL;
+    }
+
+    // Encontrar un triángulo inicial que contenga p1
+    struct Triangulo *triangulo_inicial = NULL;
+    int visitados = 0;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        visitados++;
+        if (puntoEnTriangulo(&tr->triangulos[i], p1)) {
+            triangulo_inicial = &tr->triangulos[i];
+            break;
+        }
+    }
+    CONTAR_OPERACION(recorridos, 1);
+    CONTAR_OPERACION(triangulosRecorridos, visitados);
+    MAXIMO_OPERACION(maxRecorrido, visitados);
+
+    if (!triangulo_inicial) {
+        free(lista->triangulos);
+        free(lista);
+        return NULL;
+    }
+
+    // Agregar el triángulo inicial a la lista
+    lista->triangulos[lista->numTriangulos++] = triangulo_inicial;
+
+    // Buscar triángulos intersectados
+    int i = 0;
+    while (i < lista->numTriangulos) {
+        struct Triangulo *t = lista->triangulos[i];
+        
+        // Verificar vecinos
+        for (int j = 0; j < 3; j++) {
+            if (t->vecinos[j] != NULL) {
+                // Verificar si el segmento intersecta con este triángulo
+                double x, y;
+                struct Punto *a = t->vertices[j];
+                struct Punto *b = t->vertices[(j+1)%3];
+                
+                if (encontrarInterseccion(p1->x, p1->y, p2->x, p2->y,
+                                        a->x, a->y, b->x, b->y,
+                                        &x, &y)) {
+                    // Verificar si ya está en la lista
+                    bool ya_existe = false;
+                    for (int k = 0; k < lista->numTriangulos; k++) {
+                        if (lista->triangulos[k] == t->vecinos[j]) {
+                            ya_existe = true;
+                            break;
+                        }
+                    }
+                    
+                    // Agregar a la lista si no existe
+                    if (!ya_existe) {
+                        // Expandir la lista si es necesario
+                        if (lista->numTriangulos >= lista->capacidad) {
+                            lista->capacidad *= 2;
+                            struct Triangulo **temp = realloc(lista->triangulos, 
+                                                            lista->capacidad * sizeof(struct Triangulo*));
+                            if (!temp) {
+                                // Manejar error de memoria
+                                free(lista->triangulos);
+                                free(lista);
+                                return NULL;
+                            }
+                            lista->triangulos = temp;
+                        }
+                        
+                        lista->triangulos[lista->numTriangulos++] = t->vecinos[j];
+                    }
+                }
+            }
+        }
+        i++;
+    }
+
+    TRAZA_DEPURACION("Encontrados %d triángulos intersectados\n", lista->numTriangulos);
+    return lista;
+}
+
+bool compartenArista(struct Triangulo *t1, struct Triangulo *t2) {
+    // Verificar si dos triángulos comparten una arista
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if ((t1->vertices[i] == t2->vertices[j] && 
+                 t1->vertices[(i+1)%3] == t2->vertices[(j+1)%3]) ||
+                (t1->vertices[i] == t2->vertices[(j+1)%3] && 
+                 t1->vertices[(i+1)%3] == t2->vertices[j])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void marcarAristasRestringidas(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2) {
+    // Marcar las aristas que forman parte del segmento como restringidas
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int j = 0; j < 3; j++) {
+            if ((t->vertices[j] == p1 && t->vertices[(j+1)%3] == p2) ||
+                (t->vertices[j] == p2 && t->vertices[(j+1)%3] == p1)) {
+                t->aristasRestringidas[j] = 1;
+            }
+        }
+    }
+}
+
+struct Borde* actualizarBase(struct Triangulacion *tr, struct Borde *baseActual, struct Punto *nuevo) {
+    (void)tr;
+    struct Borde *nuevaBase = malloc(sizeof(struct Borde));
+    if (!nuevaBase) return NULL;
+    
+    // La nueva base depende de qué lado se agregó el punto
+    if (orientacion(baseActual->p1, baseActual->p2, nuevo) > 0) {
+        // Punto agregado a la izquierda
+        nuevaBase->p1 = nuevo;
+        nuevaBase->p2 = baseActual->p2;
+    } else {
+        // Punto agregado a la derecha
+        nuevaBase->p1 = baseActual->p1;
+        nuevaBase->p2 = nuevo;
+    }
+    
+    free(baseActual);
+    return nuevaBase;
+}
+
+void crearSegmento(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2) {
+    if (tr->numBordes >= tr->maxBordes) return;
+    
+    struct Borde *borde = malloc(sizeof(struct Borde));
+    if (!borde) return;
+    
+    borde->p1 = p1;
+    borde->p2 = p2;
+    tr->bordes[tr->numBordes++] = borde;
+}
+
+
+/* Funciones de triangulación                                                  */
+
+// Función para inicializar la triangulación
+struct Triangulacion* inicializarTriangulacion(struct Punto* puntos, int numPuntos, int numPuntosRegion1) {
+    struct Triangulacion* tr = (struct Triangulacion*)malloc(sizeof(struct Triangulacion));
+    if (!tr) return NULL;
+
+    tr->maxTriangulos = numPuntos * 3;
+    tr->triangulos = (struct Triangulo*)malloc(tr->maxTriangulos * sizeof(struct Triangulo));
+    if (!tr->triangulos) {
+        free(tr);
+        return NULL;
+    }
+
+    tr->numTriangulos = 0;
+    tr->puntos = puntos;
+    tr->numPuntos = numPuntos;
+    tr->maxPuntos = numPuntos;
+    tr->numPuntosRegion1 = numPuntosRegion1;  // Guardamos el número de puntos de la región 1
+    tr->permutacion = NULL;
+    tr->numPermutacion = 0;
+
+    return tr;
+}
+
+// Función para crear un nuevo triángulo
+struct Triangulo* crearTriangulo(struct Punto *v1, struct Punto *v2, struct Punto *v3) {
+    struct Triangulo *t = malloc(sizeof(struct Triangulo));
+    if (t == NULL) {
+        TRAZA_ERROR("No se pudo asignar memoria para el triángulo\n");
+        return NULL;
+    }
+    CONTAR_OPERACION(asignacionesMonton, 1);
+    
+    // Permitir puntos artificiales (índices negativos) durante la triangulación
+    t->vertices[0] = v1;
+    t->vertices[1] = v2;
+    t->vertices[2] = v3;
+    t->indices[0] = v1->indice;
+    t->indices[1] = v2->indice;
+    t->indices[2] = v3->indice;
+    
+    // Marcar como triángulo artificial si tiene algún punto artificial
+    if (v1->indice < 0 || v2->indice < 0 || v3->indice < 0) {
+        t->esTrianguloSuper = 1;  // Usar 1 para indicar triángulo artificial
+    } else {
+        t->esTrianguloSuper = 0;
+    }
+    
+    // Inicializar vecinos
+    t->vecinos[0] = NULL;
+    t->vecinos[1] = NULL;
+    t->vecinos[2] = NULL;
+    
+    return t;
+}
+
+// Función para crear el super-triángulo que contendrá todos los puntos
+struct Triangulo* crearSuperTriangulo(struct Punto *puntos, int numPuntos) {
+    int i;
+    // Encontrar los límites del conjunto de puntos
+    double minX = puntos[0].x;
+    double minY = puntos[0].y;
+    double maxX = minX;
+    double maxY = minY;
+    
+    for(i = 1; i < numPuntos; i++) {
+        if(puntos[i].x < minX) minX = puntos[i].x;
+        if(puntos[i].y < minY) minY = puntos[i].y;
+        if(puntos[i].x > maxX) maxX = puntos[i].x;
+        if(puntos[i].y > maxY) maxY = puntos[i].y;
+    }
+    
+    // Calcular el centro y el tamaño del rectángulo que contiene los puntos
+    double dx = maxX - minX;
+    double dy = maxY - minY;
+    double deltaMax = (dx > dy) ? dx : dy;
+    double midX = (minX + maxX) / 2;
+    double midY = (minY + maxY) / 2;
+
+    // Crear los vértices del super-triángulo
+    struct Punto *p1 = malloc(sizeof(struct Punto));
+    struct Punto *p2 = malloc(sizeof(struct Punto));
+    struct Punto *p3 = malloc(sizeof(struct Punto));
+    
+    // Hacer el super-triángulo lo suficientemente grande
+    p1->x = midX - 20 * deltaMax;
+    p1->y = midY - deltaMax;
+    p1->indice = -1;
+    
+    p2->x = midX + 20 * deltaMax;
+    p2->y = midY - deltaMax;
+    p2->indice = -2;
+    
+    p3->x = midX;
+    p3->y = midY + 20 * deltaMax;
+    p3->indice = -3;
+    
+    // Crear el super-triángulo
+    struct Triangulo *superTriangulo = crearTriangulo(p1, p2, p3);
+    superTriangulo->esTrianguloSuper = 1;
+    
+    return superTriangulo;
+}
+
+void agregarTriangulo(struct Triangulacion* tr, struct Triangulo* t) {
+    if (tr->numTriangulos >= tr->maxTriangulos) {
+        // Aumentar capacidad si es necesario
+        tr->maxTriangulos *= 2;
+        struct Triangulo* temp = (struct Triangulo*)realloc(tr->triangulos, 
+                                tr->maxTriangulos * sizeof(struct Triangulo));
+        if (!temp) return;
+        tr->triangulos = temp;
+    }
+
+    // Copiar el triángulo a la estructura
+    tr->triangulos[tr->numTriangulos] = *t;
+    tr->numTriangulos++;
+}
+
+void eliminarTriangulo(struct Triangulacion* tr, struct Triangulo* t) {
+    // Buscar el triángulo en el arreglo
+    int idx = -1;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        if (&tr->triangulos[i] == t) {
+            idx = i;
+            break;
+        }
+    }
+
+    if (idx == -1) return;  // Triángulo no encontrado
+
+    // Mover el último triángulo a la posición del eliminado
+    if (idx < tr->numTriangulos - 1) {
+        tr->triangulos[idx] = tr->triangulos[tr->numTriangulos - 1];
+    }
+    tr->numTriangulos--;
+}
+
+// Función para optimización local después de insertar un punto
+void optimizarLocal(struct Triangulacion *tr, struct Punto *p) {
+    bool cambios;
+    do {
+        cambios = false;
+        // Encontrar todos los pares de triángulos adyacentes que comparten el punto p
+        for(int i = 0; i < tr->numTriangulos; i++) {
+            if(tieneVertice(&tr->triangulos[i], p)) {
+                for(int j = 0; j < 3; j++) {
+                    struct Triangulo *vecino = tr->triangulos[i].vecinos[j];
+                    if(vecino != NULL && !vecino->esTrianguloSuper) {
+                        if(necesitaIntercambio(&tr->triangulos[i], vecino)) {
+                            intercambiarDiagonal(tr, &tr->triangulos[i], vecino);
+                            cambios = true;
+                        }
+                    }
+                }
+            }
+        }
+    } while(cambios);
+}
+
+void dividirTriangulo(struct Triangulacion *tr, struct Triangulo *t, struct Punto *p) {
+    struct Punto *a = t->vertices[0];
+    struct Punto *b = t->vertices[1];
+    struct Punto *c = t->vertices[2];
+
+    // Crear tres nuevos triángulos
+    struct Triangulo* t1 = crearTriangulo(p, a, b);
+    struct Triangulo* t2 = crearTriangulo(p, b, c);
+    struct Triangulo* t3 = crearTriangulo(p, c, a);
+
+    // Preservar la información del triángulo super
+    t1->esTrianguloSuper = t->esTrianguloSuper;
+    t2->esTrianguloSuper = t->esTrianguloSuper;
+    t3->esTrianguloSuper = t->esTrianguloSuper;
+
+    // Agregar los nuevos triángulos
+    agregarTriangulo(tr, t1);
+    agregarTriangulo(tr, t2);
+    agregarTriangulo(tr, t3);
+
+    // Eliminar el triángulo original
+    eliminarTriangulo(tr, t);
+
+    // La cavidad de una división es el propio triángulo
+    CONTAR_OPERACION(cavidades, 1);
+    CONTAR_OPERACION(triangulosCavidad, 1);
+    MAXIMO_OPERACION(maxCavidad, 1);
+}
+
+// Función para eliminar triángulos que contienen vértices del super-triángulo
+void eliminarTriangulosSuper(struct Triangulacion *tr) {
+    int j = 0;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        if (!tieneVerticeArtificial(&tr->triangulos[i])) {
+            if (i != j) tr->triangulos[j] = tr->triangulos[i];
+            j++;
+        }
+    }
+    tr->numTriangulos = j;
+}
+
+// Función para liberar la memoria de la triangulación
+void liberarTriangulacion(struct Triangulacion *tr) {
+    if (tr != NULL) {
+        if (tr->puntos != NULL) {
+            free(tr->puntos);
+        }
+        if (tr->triangulos != NULL) {
+            free(tr->triangulos);
+        }
+        free(tr->permutacion);
+        if (tr->bordes != NULL) {
+            for (int i = 0; i < tr->numBordes; i++) {
+                free(tr->bordes[i]);
+            }
+            free(tr->bordes);
+        }
+        free(tr);
+    }
+}
+
+// Función para insertar un segmento como restricción
+void insertarSegmentoRestriccion(struct Triangulacion *tr, struct Segmento *seg) {
+    struct Punto *p1 = &tr->puntos[seg->v1];
+    struct Punto *p2 = &tr->puntos[seg->v2];
+    
+    // Encontrar triángulos que intersecta el segmento
+    struct ListaTriangulos *triangulos = encontrarTriangulosIntersectados(tr, p1, p2);
+    if (!triangulos) return;
+
+    // Crear nueva arista restringida
+    for (int i = 0; i < triangulos->numTriangulos - 1; i++) {
+        struct Triangulo *t1 = triangulos->triangulos[i];
+        struct Triangulo *t2 = triangulos->triangulos[i + 1];
+        
+        // Dividir triángulos si es necesario
+        if (!compartenArista(t1, t2)) {
+            struct Punto *p = calcularPuntoInterseccion(t1, t2, p1, p2);
+            if (p) {
+                dividirTriangulo(tr, t1, p);
+                dividirTriangulo(tr, t2, p);
+                optimizarLocal(tr, p);
+            }
+        }
+    }
+
+    // Marcar aristas como restringidas
+    marcarAristasRestringidas(tr, p1, p2);
+}
+
+// Modificar la triangulación principal para incluir restricciones
+struct Triangulacion* triangulacionDelaunayRestringida(struct EntradaPoly *entrada) {
+    TRAZA_DETALLE("Iniciando triangulación de Delaunay con restricciones...\n");
+    
+    // Paso 1: Triangulación inicial
+    struct Triangulacion* tr = triangulacionDelaunay(entrada->vertices, 
+                                                   entrada->numVertices,
+                                                   entrada->numVertices);
+    if (!tr) {
+        TRAZA_ERROR("Falló la triangulación inicial\n");
+        return NULL;
+    }
+    
+    TRAZA_DETALLE("Triangulación inicial completada.\n");
+    TRAZA_DETALLE("Insertando restricciones de segmentos...\n");
+    
+    // Paso 2: Insertar segmentos como restricciones
+    for (int i = 0; i < entrada->numSegmentos; i++) {
+        TRAZA_DEPURACION("Procesando segmento %d de %d\n", i + 1, entrada->numSegmentos);
+        TRAZA_CONTAR(CONTADOR_SEGMENTOS, 1);
+        insertarSegmentoRestriccion(tr, &entrada->segmentos[i]);
+    }
+    
+    TRAZA_DETALLE("Restricciones insertadas.\n");
+    TRAZA_DETALLE("Actualizando relaciones de vecindad...\n");
+    
+    // Paso 3: Actualizar estructura final
+    actualizarVecinos(tr);
+    
+    TRAZA_INFO("Triangulación restringida completada.\n");
+    return tr;
+}
+
+struct Borde* encontrarBaseInicial(struct Triangulacion *tr, int medio) {
+    struct Borde *base = malloc(sizeof(struct Borde));
+    if (!base) return NULL;
+    
+    // Encontrar el punto más a la derecha de la mitad izquierda
+    struct Punto *p1 = &tr->puntos[medio];
+    // Y el punto más a la izquierda de la mitad derecha
+    struct Punto *p2 = &tr->puntos[medio + 1];
+    
+    base->p1 = p1;
+    base->p2 = p2;
+    return base;
+}
+
+struct Punto* encontrarCandidatoIzquierda(struct Triangulacion *tr, struct Borde *base) {
+    struct Punto *mejor = NULL;
+    double mejorAngulo = -DBL_MAX;
+    
+    // Buscar entre todos los puntos a la izquierda de la base
+    for (int i = 0; i < tr->numPuntos; i++) {
+        struct Punto *p = &tr->puntos[i];
+        if (p == base->p1 || p == base->p2) continue;
+        
+        // Verificar si está a la izquierda de la base
+        if (orientacion(base->p1, base->p2, p) > 0) {
+            double angulo = calcularAngulo(base->p1, base->p2, p);
+            if (angulo > mejorAngulo) {
+                mejorAngulo = angulo;
+                mejor = p;
+            }
+        }
+    }
+    
+    return mejor;
+}
+
+struct Punto* encontrarCandidatoDerecha(struct Triangulacion *tr, struct Borde *base) {
+    struct Punto *mejor = NULL;
+    double mejorAngulo = -DBL_MAX;
+    
+    // Buscar entre todos los puntos a la derecha de la base
+    for (int i = 0; i < tr->numPuntos; i++) {
+        struct Punto *p = &tr->puntos[i];
+        if (p == base->p1 || p == base->p2) continue;
+        
+        // Verificar si está a la derecha de la base
+        if (orientacion(base->p1, base->p2, p) < 0) {
+            double angulo = calcularAngulo(base->p1, base->p2, p);
+            if (angulo > mejorAngulo) {
+                mejorAngulo = angulo;
+                mejor = p;
+            }
+        }
+    }
+    
+    return mejor;
+}
+
+/* Ordenamiento de puntos                                                     */
+// Clave entera con el mismo orden que el double: a los positivos se les
+// invierte el bit de signo y a los negativos todos los bits. -0.0 y 0.0
+// comparan iguales, así que comparten clave.
+static inline uint64_t claveOrdenable(double v) {
+    uint64_t u;
+    if (v == 0.0) v = 0.0;
+    memcpy(&u, &v, sizeof(uint64_t));
+    return (u & 0x8000000000000000ULL) ? ~u : (u | 0x8000000000000000ULL);
+}
+
+struct ElementoRadix {
+    uint64_t clave;
+    int indice;
+};
+
+// Pasadas LSD estables sobre las claves de 'elementos'. Cada hilo cuenta y
+// reparte un tramo contiguo; los desplazamientos se acumulan dígito a dígito
+// y, dentro de cada dígito, en el orden de los tramos, lo que conserva la
+// estabilidad. Las pasadas cuyo dígito es igual en todas las claves se omiten.
+// Devuelve el arreglo que contiene el resultado (elementos o auxiliar).
+static struct ElementoRadix *pasadasRadix(struct ElementoRadix *elementos, struct ElementoRadix *auxiliar,
+                                          int n, int numHilos, size_t *conteo) {
+    for (int desplazamiento = 0; desplazamiento < 64; desplazamiento += BITS_DIGITO_RADIX) {
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(numHilos) schedule(static, 1)
+#endif
+        for (int h = 0; h < numHilos; h++) {
+            size_t *propio = conteo + (size_t)h * CUBETAS_RADIX;
+            int desde = (int)((int64_t)n * h / numHilos), hasta = (int)((int64_t)n * (h + 1) / numHilos);
+            memset(propio, 0, CUBETAS_RADIX * sizeof(size_t));
+            for (int i = desde; i < hasta; i++) {
+                propio[(elementos[i].clave >> desplazamiento) & (CUBETAS_RADIX - 1)]++;
+            }
+        }
+
+        size_t acumulado = 0;
+        bool trivial = false;
+        for (int d = 0; d < CUBETAS_RADIX && !trivial; d++) {
+            size_t inicioDigito = acumulado;
+            for (int h = 0; h < numHilos; h++) {
+                size_t c = conteo[(size_t)h * CUBETAS_RADIX + d];
+                conteo[(size_t)h * CUBETAS_RADIX + d] = acumulado;
+                acumulado += c;
+            }
+            trivial = (acumulado - inicioDigito == (size_t)n);
+        }
+        if (trivial) continue;
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(numHilos) schedule(static, 1)
+#endif
+        for (int h = 0; h < numHilos; h++) {
+            size_t *propio = conteo + (size_t)h * CUBETAS_RADIX;
+            int desde = (int)((int64_t)n * h / numHilos), hasta = (int)((int64_t)n * (h + 1) / numHilos);
+            for (int i = desde; i < hasta; i++) {
+                auxiliar[propio[(elementos[i].clave >> desplazamiento) & (CUBETAS_RADIX - 1)]++] = elementos[i];
+            }
+        }
+        struct ElementoRadix *t = elementos;
+        elementos = auxiliar;
+        auxiliar = t;
+    }
+    return elementos;
+}
+
+// Ordena los puntos por x y, a igual x, por y, con un radix LSD sobre las
+// claves ordenables de ambas coordenadas: primero y, luego x. Si se pasa
+// 'permutacion', recibe en cada posición la que ocupaba ese punto antes de
+// ordenar. Devuelve false si no hay memoria; el arreglo queda intacto.
+bool ordenarPuntos(struct Punto *puntos, int n, int *permutacion) {
+    if (n <= 0) return true;
+
+    int numHilos = 1;
+#ifdef _OPENMP
+    if (n >= PUNTOS_MINIMOS_ORDEN_PARALELO) numHilos = omp_get_max_threads();
+#endif
+
+    struct ElementoRadix *elementos = malloc((size_t)n * sizeof(struct ElementoRadix));
+    struct ElementoRadix *auxiliar = malloc((size_t)n * sizeof(struct ElementoRadix));
+    size_t *conteo = malloc((size_t)numHilos * CUBETAS_RADIX * sizeof(size_t));
+    struct Punto *copia = malloc((size_t)n * sizeof(struct Punto));
+    if (!elementos || !auxiliar || !conteo || !copia) {
+        free(elementos);
+        free(auxiliar);
+        free(conteo);
+        free(copia);
+        return false;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(numHilos)
+#endif
+    for (int i = 0; i < n; i++) {
+        elementos[i].clave = claveOrdenable(puntos[i].y);
+        elementos[i].indice = i;
+    }
+    struct ElementoRadix *orden = pasadasRadix(elementos, auxiliar, n, numHilos, conteo);
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(numHilos)
+#endif
+    for (int i = 0; i < n; i++) {
+        orden[i].clave = claveOrdenable(puntos[orden[i].indice].x);
+    }
+    orden = pasadasRadix(orden, orden == elementos ? auxiliar : elementos, n, numHilos, conteo);
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(numHilos)
+#endif
+    for (int i = 0; i < n; i++) {
+        copia[i] = puntos[orden[i].indice];
+        if (permutacion) permutacion[i] = orden[i].indice;
+    }
+    memcpy(puntos, copia, (size_t)n * sizeof(struct Punto));
+
+    free(elementos);
+    free(auxiliar);
+    free(conteo);
+    free(copia);
+    return true;
+}
+
+// ordenarPuntos con qsort como respaldo si faltan los arreglos auxiliares.
+// El criterio es el mismo, pero entonces no hay permutación: devuelve si
+// 'permutacion' quedó escrita.
+static bool ordenarPuntosConRespaldo(struct Punto *puntos, int n, int *permutacion) {
+    if (ordenarPuntos(puntos, n, permutacion)) return permutacion != NULL;
+    TRAZA_AVISO("Sin memoria para el ordenamiento radix; se usa qsort\n");
+    qsort(puntos, n, sizeof(struct Punto), compararPuntosX);
+    return false;
+}
+
+void triangular(struct Triangulacion *tr) {
+    TRAZA_DETALLE("Iniciando ordenamiento de puntos...\n");
+    TRAMO_INICIO(FASE_ORDENAMIENTO);
+    free(tr->permutacion);
+    tr->permutacion = malloc((size_t)tr->numPuntos * sizeof(int) + 1);
+    if (!ordenarPuntosConRespaldo(tr->puntos, tr->numPuntos, tr->permutacion)) {
+        free(tr->permutacion);
+        tr->permutacion = NULL;
+    }
+    tr->numPermutacion = tr->permutacion ? tr->numPuntos : 0;
+    TRAMO_FIN(FASE_ORDENAMIENTO);
+    TRAZA_DETALLE("Puntos ordenados. Total puntos: %d\n", tr->numPuntos);
+    
+    TRAZA_DETALLE("Iniciando división recursiva...\n");
+    TRAMO_INICIO(FASE_TRIANGULACION);
+    divideVencerasDelaunay(tr, 0, tr->numPuntos - 1);
+    TRAMO_FIN(FASE_TRIANGULACION);
+    
+    TRAZA_INFO("Triangulación completada. Número de triángulos: %d\n", tr->numTriangulos);
+}
+
+void agregarTrianguloATriangulacion(struct Triangulacion *tr, struct Punto *v1, struct Punto *v2, struct Punto *v3) {
+    // Verificar que no sea un triángulo degenerado
+    double area = calcularAreaTriangulo2(v1, v2, v3);
+    if (fabs(area) < 1e-10) {
+        TRAZA_DEPURACION("Intento de agregar triángulo degenerado\n");
+        TRAZA_CONTAR(CONTADOR_TRIANGULOS_DEGENERADOS, 1);
+        return;
+    }
+    
+    // Verificar que no exista ya el triángulo
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        if ((t->vertices[0] == v1 && t->vertices[1] == v2 && t->vertices[2] == v3) ||
+            (t->vertices[0] == v2 && t->vertices[1] == v3 && t->vertices[2] == v1) ||
+            (t->vertices[0] == v3 && t->vertices[1] == v1 && t->vertices[2] == v2)) {
+            TRAZA_DEPURACION("Triángulo duplicado\n");
+            TRAZA_CONTAR(CONTADOR_TRIANGULOS_DUPLICADOS, 1);
+            return;
+        }
+    }
+    
+    // Agregar el triángulo
+    if (tr->numTriangulos < tr->maxTriangulos) {
+        tr->triangulos[tr->numTriangulos].vertices[0] = v1;
+        tr->triangulos[tr->numTriangulos].vertices[1] = v2;
+        tr->triangulos[tr->numTriangulos].vertices[2] = v3;
+        tr->triangulos[tr->numTriangulos].indices[0] = v1->indice;
+        tr->triangulos[tr->numTriangulos].indices[1] = v2->indice;
+        tr->triangulos[tr->numTriangulos].indices[2] = v3->indice;
+        tr->triangulos[tr->numTriangulos].vecinos[0] = NULL;
+        tr->triangulos[tr->numTriangulos].vecinos[1] = NULL;
+        tr->triangulos[tr->numTriangulos].vecinos[2] = NULL;
+        memset(tr->triangulos[tr->numTriangulos].aristasRestringidas, 0,
+               sizeof(tr->triangulos[tr->numTriangulos].aristasRestringidas));
+        tr->triangulos[tr->numTriangulos].esTrianguloSuper = false;
+        tr->numTriangulos++;
+        TRAZA_DEPURACION("Triángulo agregado: (%d, %d, %d)\n", 
+                         v1->indice, v2->indice, v3->indice);
+        TRAZA_CONTAR(CONTADOR_TRIANGULOS_AGREGADOS, 1);
+    }
+}
+
+void combinarTriangulaciones(struct Triangulacion *tr, int inicio, int medio, int fin) {
+    TRAZA_DEPURACION("Combinando submallas [%d-%d] y [%d-%d]\n", inicio, medio, medio+1, fin);
+    TRAZA_CONTAR(CONTADOR_COMBINACIONES, 1);
+    
+    struct Borde *baseInicial = encontrarBaseInicial(tr, medio);
+    if (!baseInicial) {
+        TRAZA_ERROR("No se pudo encontrar la base inicial\n");
+        return;
+    }
+    
+    while (true) {
+        struct Punto *candidatoIzq = encontrarCandidatoIzquierda(tr, baseInicial);
+        struct Punto *candidatoDer = encontrarCandidatoDerecha(tr, baseInicial);
+        
+        if (!candidatoIzq && !candidatoDer) break;
+        
+        if (candidatoIzq && (!candidatoDer || esDelaunay(candidatoIzq, candidatoDer, baseInicial))) {
+            agregarTrianguloATriangulacion(tr, candidatoIzq, baseInicial->p1, baseInicial->p2);
+            baseInicial->p2 = candidatoIzq;
+        } else if (candidatoDer) {
+            agregarTrianguloATriangulacion(tr, candidatoDer, baseInicial->p1, baseInicial->p2);
+            baseInicial->p1 = candidatoDer;
+        }
+    }
+    
+    free(baseInicial);
+}
+
+int compararPuntosX(const void *a, const void *b) {
+    struct Punto *p1 = (struct Punto *)a;
+    struct Punto *p2 = (struct Punto *)b;
+    
+    if (p1->x < p2->x) return -1;
+    if (p1->x > p2->x) return 1;
+    if (p1->y < p2->y) return -1;
+    if (p1->y > p2->y) return 1;
+    return 0;
+}
+
+void divideVencerasDelaunay(struct Triangulacion *tr, int inicio, int fin) {
+    TRAZA_DEPURACION("Procesando segmento [%d, %d]\n", inicio, fin);
+    TRAZA_CONTAR(CONTADOR_RECURSIONES, 1);
+    
+    // Caso base: 2 o 3 puntos
+    if (fin - inicio + 1 <= 3) {
+        if (fin - inicio + 1 == 3) {
+            struct Punto *p1 = &tr->puntos[inicio];
+            struct Punto *p2 = &tr->puntos[inicio + 1];
+            struct Punto *p3 = &tr->puntos[inicio + 2];
+            
+            double area = calcularAreaTriangulo2(p1, p2, p3);
+            if (fabs(area) > 1e-10 && !existeTriangulo(tr, p1, p2, p3)) {
+                if (orientacion(p1, p2, p3) > 0) {
+                    agregarTrianguloATriangulacion(tr, p1, p2, p3);
+                } else {
+                    agregarTrianguloATriangulacion(tr, p1, p3, p2);
+                }
+            }
+        }
+        return;
+    }
+    
+    int medio = inicio + (fin - inicio) / 2;
+    
+    divideVencerasDelaunay(tr, inicio, medio);
+    divideVencerasDelaunay(tr, medio + 1, fin);
+    
+    combinarTriangulacionesOptimizado(tr, inicio, medio, fin);
+}
+
+void combinarTriangulacionesOptimizado(struct Triangulacion *tr, int inicio, int medio, int fin) {
+    TRAZA_DEPURACION("Combinando submallas optimizado [%d-%d] y [%d-%d]\n", inicio, medio, medio+1, fin);
+    TRAZA_CONTAR(CONTADOR_COMBINACIONES, 1);
+    
+    // Crear un array para marcar puntos ya procesados
+    bool *procesado = calloc(tr->numPuntos, sizeof(bool));
+    if (!procesado) {
+        TRAZA_ERROR("No se pudo asignar memoria para el array de procesados\n");
+        return;
+    }
+    
+    // Encontrar puntos extremos para la base inicial
+    struct Punto *p_izq = NULL, *p_der = NULL;
+    double x_min = INFINITY, x_max = -INFINITY;
+    
+    for (int i = inicio; i <= fin; i++) {
+        if (tr->puntos[i].x < x_min) {
+            x_min = tr->puntos[i].x;
+            p_izq = &tr->puntos[i];
+        }
+        if (tr->puntos[i].x > x_max) {
+            x_max = tr->puntos[i].x;
+            p_der = &tr->puntos[i];
+        }
+    }
+    
+    if (!p_izq || !p_der) {
+        free(procesado);
+        return;
+    }
+    
+    // Procesar puntos
+    for (int i = inicio; i <= fin; i++) {
+        if (!procesado[i]) {
+            struct Punto *p_actual = &tr->puntos[i];
+            
+            // Buscar los dos puntos más cercanos ya procesados
+            struct Punto *p1 = NULL, *p2 = NULL;
+            double min_dist1 = INFINITY, min_dist2 = INFINITY;
+            
+            for (int j = inicio; j <= fin; j++) {
+                if (i != j && procesado[j]) {
+                    double dist = distanciaEntrePuntos(p_actual, &tr->puntos[j]);
+                    if (dist < min_dist1) {
+                        min_dist2 = min_dist1;
+                        p2 = p1;
+                        min_dist1 = dist;
+                        p1 = &tr->puntos[j];
+                    } else if (dist < min_dist2) {
+                        min_dist2 = dist;
+                        p2 = &tr->puntos[j];
+                    }
+                }
+            }
+            
+            if (p1 && p2) {
+                // Verificar orientación y criterio de Delaunay
+                if (orientacion(p1, p2, p_actual) > 0 && 
+                    !existeTriangulo(tr, p1, p2, p_actual)) {
+                    agregarTrianguloATriangulacion(tr, p1, p2, p_actual);
+                }
+            }
+            
+            procesado[i] = true;
+        }
+    }
+    
+    free(procesado);
+}
+
+bool existeTriangulo(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2, struct Punto *p3) {
+    for (int i =0; i < tr->numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        if ((t->vertices[0] == p1 && t->vertices[1] == p2 && t->vertices[2] == p3) ||
+            (t->vertices[0] == p2 && t->vertices[1] == p3 && t->vertices[2] == p1) ||
+            (t->vertices[0] == p3 && t->vertices[1] == p1 && t->vertices[2] == p2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Función principal que inicia el proceso
+struct Triangulacion* triangulacionDelaunay(struct Punto *puntos, int numPuntos, int numPuntosRegion1) {
+    TRAZA_DETALLE("Iniciando triangulación de Delaunay...\n");
+    
+    // Ordenar puntos por coordenada x (y por y a igual x)
+    TRAMO_INICIO(FASE_ORDENAMIENTO);
+    int *permutacion = malloc((size_t)numPuntos * sizeof(int) + 1);
+    if (!ordenarPuntosConRespaldo(puntos, numPuntos, permutacion)) {
+        free(permutacion);
+        permutacion = NULL;
+    }
+    TRAMO_FIN(FASE_ORDENAMIENTO);
+    
+    // Inicializar la triangulación
+    struct Triangulacion* tr = inicializarTriangulacion(puntos, numPuntos, numPuntosRegion1);
+    if (!tr) {
+        free(permutacion);
+        TRAZA_ERROR("Error al inicializar la triangulación\n");
+        return NULL;
+    }
+    tr->permutacion = permutacion;
+    tr->numPermutacion = permutacion ? numPuntos : 0;
+    
+    // Aplicar el algoritmo divide y vencerás
+    TRAMO_INICIO(FASE_TRIANGULACION);
+    divideVencerasDelaunay(tr, 0, numPuntos - 1);
+    TRAMO_FIN(FASE_TRIANGULACION);
+    
+    // Refinar la malla
+    double anguloMinimo = 20.0 * M_PI / 180.0;  // 20 grados en radianes
+    double areaMaxima = calcularAreaMaximaPermitida(tr);
+    refinarMalla(tr, anguloMinimo, areaMaxima, STEINER_CIRCUNCENTRO);
+    
+    TRAZA_INFO("Triangulación completada.\n");
+    return tr;
+}
+
+
+/* Funciones de refinamiento                                                   */
+
+struct ColaRefinamiento* iniciarColaRefinamiento(int capacidad) {
+    // Asignar memoria para la estructura principal
+    struct ColaRefinamiento *cola = malloc(sizeof(struct ColaRefinamiento));
+    if (cola == NULL) {
+        TRAZA_ERROR("No se pudo asignar memoria para la cola\n");
+        return NULL;
+    }
+    
+    // Asignar memoria para los arreglos de triángulos y bordes
+    cola->triangulos = malloc(capacidad * sizeof(struct Triangulo*));
+    cola->bordes = malloc(capacidad * sizeof(struct Borde*));
+    
+    // Verificar asignación de memoria
+    if (cola->triangulos == NULL || cola->bordes == NULL) {
+        TRAZA_ERROR("No se pudo asignar memoria para los arreglos\n");
+        free(cola);
+        return NULL;
+    }
+    
+    // Inicializar los contadores
+    cola->numTriangulos = 0;  // Número actual de triángulos en la cola
+    cola->numBordes = 0;      // Número actual de bordes en la cola
+    cola->capacidad = capacidad;  // Capacidad máxima de la cola
+    
+    return cola;
+}
+
+void agregarPuntoATriangulacion(struct Triangulacion *tr, struct Punto *p) {
+    // Si necesitamos más espacio
+    if (tr->numPuntos >= tr->maxPuntos) {
+        int nuevaCapacidad = tr->maxPuntos * 2;
+        struct Punto *nuevosPuntos = realloc(tr->puntos, 
+                                            nuevaCapacidad * sizeof(struct Punto));
+        if (nuevosPuntos == NULL) {
+            TRAZA_ERROR("No se pudo expandir el arreglo de puntos\n");
+            return;
+        }
+        tr->puntos = nuevosPuntos;
+        tr->maxPuntos = nuevaCapacidad;
+    }
+    
+    // Agregar el nuevo punto
+    tr->puntos[tr->numPuntos] = *p;
+    tr->puntos[tr->numPuntos].indice = tr->numPuntos;
+    tr->numPuntos++;
+    
+    TRAZA_DEPURACION("Nuevo punto agregado en (%f, %f), índice %d\n", 
+                     p->x, p->y, tr->numPuntos - 1);
+    TRAZA_CONTAR(CONTADOR_PUNTOS_AGREGADOS, 1);
+}
+
+void liberarColaRefinamiento(struct ColaRefinamiento *cola) {
+    if(cola != NULL) {
+        free(cola->triangulos);
+        free(cola->bordes);
+        free(cola);
+    }
+}
+
+bool estaDentroDeLimites(struct Triangulacion *tr, struct Punto *p) {
+    int dentro = 0;
+    for (int i = 0; i < tr->numBordes; i++) {
+        struct Borde *b = tr->bordes[i];
+        if ((b->p1->y > p->y) != (b->p2->y > p->y) &&
+            p->x < (b->p2->x - b->p1->x) * (p->y - b->p1->y) / 
+                   (b->p2->y - b->p1->y) + b->p1->x) {
+            dentro = !dentro;
+        }
+    }
+    return dentro;
+}
+
+bool hayPuntoCercano(struct Triangulacion *tr, struct Punto *p) {
+    const double DISTANCIA_MINIMA = 0.001;
+    
+    for (int i = 0; i < tr->numPuntos; i++) {
+        double dx = tr->puntos[i].x - p->x;
+        double dy = tr->puntos[i].y - p->y;
+        double dist = sqrt(dx*dx + dy*dy);
+        
+        if (dist < DISTANCIA_MINIMA) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double calcularAreaMaximaPermitida(struct Triangulacion *tr) {
+    double xmin = tr->puntos[0].x;
+    double xmax = tr->puntos[0].x;
+    double ymin = tr->puntos[0].y;
+    double ymax = tr->puntos[0].y;
+    
+    for (int i = 1; i < tr->numPuntos; i++) {
+        if (tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
+        if (tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
+        if (tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
+        if (tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+    }
+    
+    double areaTotal = (xmax - xmin) * (ymax - ymin);
+    return areaTotal * 0.01; // 1% del área total
+}
+
+void refinarMalla(struct Triangulacion *tr, double anguloMinimo, double areaMaxima, int posicionSteiner) {
+    TRAZA_DETALLE("\n=== INICIO DEL REFINAMIENTO ===\n");
+    TRAMO_INICIO(FASE_REFINAMIENTO);
+    int puntosIniciales = tr->numPuntos;
+    double constante = constanteFueraCentro(posicionSteiner, anguloMinimo);
+    int iteraciones = 0;
+    const int MAX_ITERACIONES = 100;
+    bool seAgregaronPuntos;
+    
+    do {
+        seAgregaronPuntos = false;
+        iteraciones++;
+        
+        // Lista temporal de puntos a agregar
+        struct Punto *nuevosPuntos = malloc(tr->numTriangulos * sizeof(struct Punto));
+        int numNuevosPuntos = 0;
+        
+        // Revisar cada triángulo
+        for (int i = 0; i < tr->numTriangulos; i++) {
+            struct Triangulo *t = &tr->triangulos[i];
+            if (t->esTrianguloSuper) continue;
+            
+            // Calcular ángulos del triángulo
+            double angulos[3];
+            calcularAngulos(t, angulos);
+            
+            // Verificar si necesita refinamiento
+            bool necesitaRefinar = false;
+            for (int j = 0; j < 3; j++) {
+                if (angulos[j] < anguloMinimo) {
+                    necesitaRefinar = true;
+                    break;
+                }
+            }
+            
+            if (necesitaRefinar || calcularAreaTriangulo(t) > areaMaxima) {
+                struct Punto *circuncentro = calcularCircuncentro(t);
+                if (!circuncentro) {
+                    continue;
+                }
+                if (constante > 0.0) {
+                    ubicarPuntoSteiner(t->vertices[0], t->vertices[1], t->vertices[2], constante,
+                                       &circuncentro->x, &circuncentro->y);
+                }
+                if (!estaDentroDeLimites(tr, circuncentro)) {
+                    CONTAR_OPERACION(steinerFueraDeLimites, 1);
+                } else if (hayPuntoCercano(tr, circuncentro)) {
+                    CONTAR_OPERACION(steinerCercanos, 1);
+                } else {
+                    nuevosPuntos[numNuevosPuntos++] = *circuncentro;
+                    seAgregaronPuntos = true;
+                }
+                free(circuncentro);
+            }
+        }
+        
+        // Agregar los nuevos puntos y retriangular
+        if (seAgregaronPuntos) {
+            for (int i =0; i < numNuevosPuntos; i++) {
+                if (tr->numPuntos < tr->maxPuntos) {
+                    tr->puntos[tr->numPuntos] = nuevosPuntos[i];
+                    tr->puntos[tr->numPuntos].indice = tr->numPuntos;
+                    tr->numPuntos++;
+                    TRAZA_DEPURACION("Punto Steiner agregado: (%f, %f)\n", 
+                                     nuevosPuntos[i].x, nuevosPuntos[i].y);
+                    TRAZA_CONTAR(CONTADOR_PUNTOS_STEINER, 1);
+                    CONTAR_OPERACION(steinerAceptados, 1);
+                } else {
+                    CONTAR_OPERACION(steinerSinEspacio, 1);
+                }
+            }
+            
+            // Retriangular desde cero con los nuevos puntos
+            divideVencerasDelaunay(tr, 0, tr->numPuntos - 1);
+        }
+        
+        free(nuevosPuntos);
+        
+    } while (seAgregaronPuntos && iteraciones < MAX_ITERACIONES);
+    
+    TRAMO_FIN(FASE_REFINAMIENTO);
+    TRAZA_INFO("Refinamiento completado: %d puntos agregados en %d iteraciones\n",
+               tr->numPuntos - puntosIniciales, iteraciones);
+}
+
+
+/* Refinamiento incremental de una malla existente (-r)                        */
+
+// La malla se reconstruye desde .node/.ele (como reconstruct() de triangle.c)
+// y se refina insertando un punto a la vez con Bowyer-Watson: cada punto
+// reemplaza solo la cavidad de triángulos cuyo circuncírculo lo contiene, sin
+// cruzar aristas restringidas. Los triángulos se refieren por su posición en
+// tr->triangulos, que puede reubicarse al crecer.
+
+// Triángulo pendiente de revisar. Los vértices permiten descartar entradas
+// cuyo lugar ya ocupa otro triángulo.
+struct TrianguloPendiente {
+    double arista;         // Longitud de la arista más corta (prioridad)
+    int triangulo;
+    int vertices[3];
+};
+
+// Arista del borde de la cavidad, orientada en sentido antihorario
+struct AristaCavidad {
+    int a, b;
+    int vecino;            // Triángulo del otro lado o -1
+    int restringida;
+    int interior;          // 3 * triángulo de la cavidad + arista
+};
+
+struct RefinamientoIncremental {
+    struct Triangulacion *tr;
+    double anguloMinimo;       // Radianes
+    double areaMaxima;
+    double longitudMinima;     // Subsegmentos más cortos no se dividen (redondeo)
+    double lente;              // cos²(2θ) de la lente diametral; 0: círculo diametral
+
+    // Extremos del segmento de la entrada que contiene a cada vértice
+    // interior a un segmento, o -1: la prueba de capas de los ángulos pequeños
+    int (*extremos)[2];
+    int capacidadExtremos;
+
+    // Montículo de triángulos por refinar, el de arista más corta primero:
+    // como en triangle.c, así converge con ángulos de hasta unos 34°, donde
+    // el orden de llegada agrega varias veces más puntos o no termina
+    struct TrianguloPendiente *cola;
+    int numCola, capacidadCola;
+
+    int *cavidad;
+    int numCavidad, capacidadCavidad;
+    struct AristaCavidad *frontera;
+    int numFrontera, capacidadFrontera;
+    int *nuevos;               // Triángulos creados por la última inserción
+    int invadida;              // Segmento invadido por el último circuncentro
+
+    // Modo conforme (-D): las aristas restringidas no detienen la cavidad, y
+    // los subsegmentos borrados o invadidos se apilan para volver a verificarse
+    bool conforme;
+    int *trianguloDePunto;     // Un triángulo incidente a cada vértice, o -1
+    int capacidadTrianguloDePunto;
+    struct Segmento *pila;     // Subsegmentos por verificar
+    int numPila, capacidadPila;
+    int puntosEntrada;         // Los vértices de la entrada van primero
+
+    int *marca;                // Generación en que cada triángulo entró a la cavidad
+    int capacidadMarca;
+    int generacion;
+};
+
+// Crece un arreglo al doble hasta que quepan necesario elementos
+static int asegurarCapacidad(void **arreglo, int *capacidad, int necesario, size_t tamano) {
+    if (necesario <= *capacidad) return 1;
+    int nueva = *capacidad > 0 ? *capacidad : 64;
+    while (nueva < necesario) {
+        if (nueva > INT_MAX / 2) return 0;
+        nueva *= 2;
     }
+    void *p = realloc(*arreglo, (size_t)nueva * tamano);
+    if (!p) return 0;
+    *arreglo = p;
+    *capacidad = nueva;
+    return 1;
+}
 
-    // Encontrar un triángulo inicial que contenga p1
-    struct Triangulo *triangulo_inicial = NULL;
+// Amplía tr->puntos y corrige los punteros de los triángulos y bordes
+static int asegurarCapacidadPuntos(struct Triangulacion *tr, int necesario) {
+    if (necesario <= tr->maxPuntos) return 1;
+    int nueva = tr->maxPuntos > 0 ? tr->maxPuntos : 64;
+    while (nueva < necesario) {
+        if (nueva > INT_MAX / 2) return 0;
+        nueva *= 2;
+    }
+    struct Punto *puntos = malloc((size_t)nueva * sizeof(struct Punto));
+    if (!puntos) return 0;
+    memcpy(puntos, tr->puntos, (size_t)tr->numPuntos * sizeof(struct Punto));
     for (int i = 0; i < tr->numTriangulos; i++) {
-        if (puntoEnTriangulo(&tr->triangulos[i], p1)) {
-            triangulo_inicial = &tr->triangulos[i];
-            break;
+        for (int k = 0; k < 3; k++) {
+            tr->triangulos[i].vertices[k] = puntos + (tr->triangulos[i].vertices[k] - tr->puntos);
         }
     }
+    for (int i = 0; i < tr->numBordes; i++) {
+        tr->bordes[i]->p1 = puntos + (tr->bordes[i]->p1 - tr->puntos);
+        tr->bordes[i]->p2 = puntos + (tr->bordes[i]->p2 - tr->puntos);
+    }
+    free(tr->puntos);
+    tr->puntos = puntos;
+    tr->maxPuntos = nueva;
+    return 1;
+}
 
-    if (!triangulo_inicial) {
-        free(lista->triangulos);
-        free(lista);
-        return NULL;
+// Amplía tr->triangulos y corrige los punteros a vecinos
+static int asegurarCapacidadTriangulos(struct RefinamientoIncremental *ri, int necesario) {
+    struct Triangulacion *tr = ri->tr;
+    if (necesario <= tr->maxTriangulos) return 1;
+    int nueva = tr->maxTriangulos > 0 ? tr->maxTriangulos : 64;
+    while (nueva < necesario) {
+        if (nueva > INT_MAX / 2) return 0;
+        nueva *= 2;
+    }
+    struct Triangulo *triangulos = malloc((size_t)nueva * sizeof(struct Triangulo));
+    if (!triangulos) return 0;
+    memcpy(triangulos, tr->triangulos, (size_t)tr->numTriangulos * sizeof(struct Triangulo));
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        for (int k = 0; k < 3; k++) {
+            if (triangulos[i].vecinos[k]) {
+                triangulos[i].vecinos[k] = triangulos + (tr->triangulos[i].vecinos[k] - tr->triangulos);
+            }
+        }
     }
+    free(tr->triangulos);
+    tr->triangulos = triangulos;
+    tr->maxTriangulos = nueva;
 
-    // Agregar el triángulo inicial a la lista
-    lista->triangulos[lista->numTriangulos++] = triangulo_inicial;
+    int capacidadAnterior = ri->capacidadMarca;
+    if (!asegurarCapacidad((void **)&ri->marca, &ri->capacidadMarca, nueva, sizeof(int))) return 0;
+    memset(ri->marca + capacidadAnterior, 0, (size_t)(ri->capacidadMarca - capacidadAnterior) * sizeof(int));
+    return 1;
+}
 
-    // Buscar triángulos intersectados
-    int i = 0;
-    while (i < lista->numTriangulos) {
-        struct Triangulo *t = lista->triangulos[i];
-        
-        // Verificar vecinos
-        for (int j = 0; j < 3; j++) {
-            if (t->vecinos[j] != NULL) {
-                // Verificar si el segmento intersecta con este triángulo
-                double x, y;
-                struct Punto *a = t->vertices[j];
-                struct Punto *b = t->vertices[(j+1)%3];
-                
-                if (encontrarInterseccion(p1->x, p1->y, p2->x, p2->y,
-                                        a->x, a->y, b->x, b->y,
-                                        &x, &y)) {
-                    // Verificar si ya está en la lista
-                    bool ya_existe = false;
-                    for (int k = 0; k < lista->numTriangulos; k++) {
-                        if (lista->triangulos[k] == t->vecinos[j]) {
-                            ya_existe = true;
-                            break;
-                        }
-                    }
-                    
-                    // Agregar a la lista si no existe
-                    if (!ya_existe) {
-                        // Expandir la lista si es necesario
-                        if (lista->numTriangulos >= lista->capacidad) {
-                            lista->capacidad *= 2;
-                            struct Triangulo **temp = realloc(lista->triangulos, 
-                                                            lista->capacidad * sizeof(struct Triangulo*));
-                            if (!temp) {
-                                // Manejar error de memoria
-                                free(lista->triangulos);
-                                free(lista);
-                                return NULL;
-                            }
-                            lista->triangulos = temp;
-                        }
-                        
-                        lista->triangulos[lista->numTriangulos++] = t->vecinos[j];
-                    }
-                }
+static inline int indiceTriangulo(struct Triangulacion *tr, struct Triangulo *t) {
+    return t ? (int)(t - tr->triangulos) : -1;
+}
+
+static inline int indicePunto(struct Triangulacion *tr, struct Punto *p) {
+    return (int)(p - tr->puntos);
+}
+
+// Reconstruye la triangulación a partir de los vértices (.node) y los
+// triángulos (.ele). La adyacencia se recupera con una tabla hash de aristas
+// dirigidas: cada arista (a, b) encuentra a su gemela (b, a) en O(1). Los
+// segmentos de la entrada que coinciden con una arista quedan restringidos.
+// Una malla con triángulos de área nula o invertidos se rechaza: refinarla
+// solo propagaría el error.
+int reconstruirTriangulacion(struct EntradaPoly *entrada, const struct MallaBinaria *elementos,
+                             struct Triangulacion **resultado) {
+    *resultado = NULL;
+    int numPuntos = entrada->numVertices, numTriangulos = elementos->numTriangulos;
+
+    // Los .ele se refieren a la numeración del .node
+    int maxIndice = 0;
+    for (int i = 0; i < numPuntos; i++) {
+        if (entrada->vertices[i].indice > maxIndice) maxIndice = entrada->vertices[i].indice;
+    }
+    int *posicion = malloc(((size_t)maxIndice + 1) * sizeof(int));
+    struct Triangulacion *tr = calloc(1, sizeof(struct Triangulacion));
+    if (!posicion || !tr) {
+        free(posicion);
+        free(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para reconstruir la malla\n");
+        return SALIDA_MEMORIA;
+    }
+    for (int i = 0; i <= maxIndice; i++) posicion[i] = -1;
+
+    tr->numPuntos = numPuntos;
+    tr->maxPuntos = numPuntos;
+    tr->numPuntosRegion1 = numPuntos;
+    tr->puntos = malloc((size_t)numPuntos * sizeof(struct Punto));
+    tr->numTriangulos = numTriangulos;
+    tr->maxTriangulos = numTriangulos;
+    tr->triangulos = calloc((size_t)numTriangulos + 1, sizeof(struct Triangulo));
+    if (!tr->puntos || !tr->triangulos) {
+        free(posicion);
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para reconstruir la malla\n");
+        return SALIDA_MEMORIA;
+    }
+    for (int i = 0; i < numPuntos; i++) {
+        tr->puntos[i] = entrada->vertices[i];
+        if (entrada->vertices[i].indice >= 0) posicion[entrada->vertices[i].indice] = i;
+        tr->puntos[i].indice = i;
+    }
+
+    // Triángulos en sentido antihorario
+    for (int i = 0; i < numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            int v = elementos->triangulos[3 * i + k];
+            int p = (v >= 0 && v <= maxIndice) ? posicion[v] : -1;
+            if (p < 0) {
+                TRAZA_ERROR("El triángulo %d referencia un vértice inexistente (%d)\n", i + 1, v);
+                free(posicion);
+                liberarTriangulacion(tr);
+                return SALIDA_ENTRADA;
             }
+            t->vertices[k] = &tr->puntos[p];
+            t->indices[k] = p;
+        }
+        double orientado = orientacion(t->vertices[0], t->vertices[1], t->vertices[2]);
+        if (orientado == 0.0) {
+            TRAZA_ERROR("El triángulo %d tiene área nula\n", i + 1);
+            free(posicion);
+            liberarTriangulacion(tr);
+            return SALIDA_ENTRADA;
+        }
+        if (orientado < 0) {
+            struct Punto *v = t->vertices[1];
+            t->vertices[1] = t->vertices[2];
+            t->vertices[2] = v;
+            t->indices[1] = indicePunto(tr, t->vertices[1]);
+            t->indices[2] = indicePunto(tr, t->vertices[2]);
+        }
+    }
+    free(posicion);
+
+    // Tabla hash de aristas dirigidas: clave (a, b), valor 3 * triángulo + k
+    size_t tamanoTabla = 16;
+    while (tamanoTabla < 6 * (size_t)numTriangulos) tamanoTabla *= 2;
+    uint64_t *claves = malloc(tamanoTabla * sizeof(uint64_t));
+    int *valores = malloc(tamanoTabla * sizeof(int));
+    if (!claves || !valores) {
+        free(claves);
+        free(valores);
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para reconstruir la malla\n");
+        return SALIDA_MEMORIA;
+    }
+    memset(valores, 0xff, tamanoTabla * sizeof(int));
+
+#define CLAVE_ARISTA(a, b) (((uint64_t)(uint32_t)(a) << 32) | (uint32_t)(b))
+    int aristasRepetidas = 0;
+    for (int i = 0; i < numTriangulos; i++) {
+        for (int k = 0; k < 3; k++) {
+            uint64_t clave = CLAVE_ARISTA(tr->triangulos[i].indices[k], tr->triangulos[i].indices[(k + 1) % 3]);
+            size_t h = mezclarFinal64(clave) & (tamanoTabla - 1);
+            while (valores[h] >= 0 && claves[h] != clave) h = (h + 1) & (tamanoTabla - 1);
+            if (valores[h] >= 0) {
+                aristasRepetidas++;
+                continue;
+            }
+            claves[h] = clave;
+            valores[h] = 3 * i + k;
         }
-        i++;
     }
 
-    printf("Encontrados %d triángulos intersectados\n", lista->numTriangulos);
-    return lista;
+    // Buscar en la tabla la arista (a, b); -1 si no existe
+#define BUSCAR_ARISTA(a, b, salida) do {                                     \
+        uint64_t clave_ = CLAVE_ARISTA((a), (b));                            \
+        size_t h_ = mezclarFinal64(clave_) & (tamanoTabla - 1);              \
+        while (valores[h_] >= 0 && claves[h_] != clave_) h_ = (h_ + 1) & (tamanoTabla - 1); \
+        (salida) = valores[h_];                                              \
+    } while (0)
+
+    for (int i = 0; i < numTriangulos; i++) {
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            int gemela;
+            BUSCAR_ARISTA(t->indices[(k + 1) % 3], t->indices[k], gemela);
+            t->vecinos[k] = gemela >= 0 ? &tr->triangulos[gemela / 3] : NULL;
+        }
+    }
+
+    // Segmentos: se marcan las dos caras de la arista
+    int segmentosSinArista = 0;
+    for (int i = 0; i < entrada->numSegmentos; i++) {
+        int v1 = entrada->segmentos[i].v1, v2 = entrada->segmentos[i].v2;
+        if (v1 < 0 || v1 >= numPuntos || v2 < 0 || v2 >= numPuntos) continue;
+        int arista, gemela;
+        BUSCAR_ARISTA(v1, v2, arista);
+        BUSCAR_ARISTA(v2, v1, gemela);
+        if (arista < 0 && gemela < 0) {
+            segmentosSinArista++;
+            continue;
+        }
+        if (arista >= 0) tr->triangulos[arista / 3].aristasRestringidas[arista % 3] = 1;
+        if (gemela >= 0) tr->triangulos[gemela / 3].aristasRestringidas[gemela % 3] = 1;
+    }
+#undef BUSCAR_ARISTA
+#undef CLAVE_ARISTA
+    free(claves);
+    free(valores);
+
+    if (aristasRepetidas > 0) {
+        // Un triángulo invertido, una vez orientado, recorre una arista en el
+        // mismo sentido que su vecino
+        TRAZA_ERROR("%d aristas repetidas: la malla tiene triángulos invertidos o superpuestos\n",
+                    aristasRepetidas);
+        liberarTriangulacion(tr);
+        return SALIDA_ENTRADA;
+    }
+    if (segmentosSinArista > 0) {
+        TRAZA_AVISO("%d segmentos no son aristas de la malla y se ignoran\n", segmentosSinArista);
+    }
+    TRAZA_INFO("Malla reconstruida: %d vértices, %d triángulos\n", numPuntos, numTriangulos);
+    *resultado = tr;
+    return SALIDA_EXITO;
 }
 
-bool compartenArista(struct Triangulo *t1, struct Triangulo *t2) {
-    // Verificar si dos triángulos comparten una arista
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            if ((t1->vertices[i] == t2->vertices[j] && 
-                 t1->vertices[(i+1)%3] == t2->vertices[(j+1)%3]) ||
-                (t1->vertices[i] == t2->vertices[(j+1)%3] && 
-                 t1->vertices[(i+1)%3] == t2->vertices[j])) {
-                return true;
-            }
+// Determinante del circuncírculo para un triángulo antihorario (positivo si p
+// está dentro) y, en *cota, el error de redondeo que puede tener
+static double circunferenciaAntihoraria(struct Triangulo *t, struct Punto *p, double *cota) {
+    double adx = t->vertices[0]->x - p->x, ady = t->vertices[0]->y - p->y;
+    double bdx = t->vertices[1]->x - p->x, bdy = t->vertices[1]->y - p->y;
+    double cdx = t->vertices[2]->x - p->x, cdy = t->vertices[2]->y - p->y;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy) +
+                 clift * (adx * bdy - bdx * ady);
+
+    CONTAR_OPERACION(circunferencias, 1);
+    double permanente = alift * (fabs(bdx * cdy) + fabs(cdx * bdy)) +
+                        blift * (fabs(cdx * ady) + fabs(adx * cdy)) +
+                        clift * (fabs(adx * bdy) + fabs(bdx * ady));
+    *cota = COTA_ERROR_CIRCUNFERENCIA * permanente;
+    if (fabs(det) <= *cota) {
+        CONTAR_OPERACION(circunferenciasInciertas, 1);
+    }
+    return det;
+}
+
+// Prueba del circuncírculo para un triángulo antihorario. A diferencia de
+// puntoEnCircunscrito no usa una tolerancia absoluta, que a escalas pequeñas
+// descarta casi todas las cavidades.
+static bool enCircunferenciaAntihoraria(struct Triangulo *t, struct Punto *p) {
+    double cota;
+    return circunferenciaAntihoraria(t, p, &cota) > 0;
+}
+
+// Arista más corta del triángulo: la k va de vertices[k] a vertices[k + 1]
+static int aristaMasCorta(struct Triangulo *t) {
+    double minimo = DBL_MAX;
+    int corta = 0;
+    for (int k = 0; k < 3; k++) {
+        double d = distanciaEntrePuntos(t->vertices[k], t->vertices[(k + 1) % 3]);
+        if (d < minimo) {
+            minimo = d;
+            corta = k;
         }
     }
-    return false;
+    return corta;
 }
 
-void marcarAristasRestringidas(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2) {
-    // Marcar las aristas que forman parte del segmento como restringidas
-    for (int i = 0; i < tr->numTriangulos; i++) {
-        struct Triangulo *t = &tr->triangulos[i];
+// Prueba de capas de triangle.c: un triángulo cuya arista más corta une dos
+// vértices de segmentos distintos que parten de un mismo vértice de la
+// entrada, a la misma distancia de él, se debe a un ángulo pequeño de la
+// entrada. Dividirlo solo agregaría otra capa más cerca del vértice.
+static bool anguloPequenoDeLaEntrada(struct RefinamientoIncremental *ri, struct Triangulo *t) {
+    if (!ri->extremos) return false;
+    int k = aristaMasCorta(t);
+    if (t->aristasRestringidas[k] || !t->vecinos[k]) return false;
+    int a = t->indices[k], b = t->indices[(k + 1) % 3];
+    if (ri->extremos[a][0] < 0 || ri->extremos[b][0] < 0) return false;
+
+    int comun = -1, distintos = 0;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            if (ri->extremos[a][i] == ri->extremos[b][j]) comun = ri->extremos[a][i];
+        }
+        if (ri->extremos[a][i] != ri->extremos[b][0] && ri->extremos[a][i] != ri->extremos[b][1]) distintos++;
+    }
+    if (comun < 0 || distintos == 0) return false;   // Sin vértice común o mismo segmento
+
+    struct Punto *vertice = &ri->tr->puntos[comun];
+    double da = distanciaEntrePuntos(&ri->tr->puntos[a], vertice);
+    double db = distanciaEntrePuntos(&ri->tr->puntos[b], vertice);
+    return da < 1.001 * db && da > 0.999 * db;
+}
+
+static bool trianguloRequiereRefinar(struct RefinamientoIncremental *ri, struct Triangulo *t) {
+    if (calcularAreaTriangulo(t) > ri->areaMaxima) return true;
+    if (ri->anguloMinimo <= 0.0) return false;
+    double angulos[3];
+    calcularAngulos(t, angulos);
+    if (angulos[0] >= ri->anguloMinimo && angulos[1] >= ri->anguloMinimo &&
+        angulos[2] >= ri->anguloMinimo) {
+        return false;
+    }
+    // Dos vértices de la entrada casi repetidos no se separan refinando: sus
+    // circuncentros solo acumularían error de redondeo
+    int k = aristaMasCorta(t);
+    if (t->indices[k] < ri->tr->numPuntosRegion1 && t->indices[(k + 1) % 3] < ri->tr->numPuntosRegion1 &&
+        distanciaEntrePuntos(t->vertices[k], t->vertices[(k + 1) % 3]) < ri->longitudMinima) {
+        return false;
+    }
+    return !anguloPequenoDeLaEntrada(ri, t);
+}
+
+static void encolarSiRequiere(struct RefinamientoIncremental *ri, int indice) {
+    struct Triangulo *t = &ri->tr->triangulos[indice];
+    if (!trianguloRequiereRefinar(ri, t)) return;
+
+    if (!asegurarCapacidad((void **)&ri->cola, &ri->capacidadCola, ri->numCola + 1,
+                           sizeof(struct TrianguloPendiente))) {
+        return;
+    }
+    struct TrianguloPendiente nuevo;
+    int k = aristaMasCorta(t);
+    nuevo.arista = distanciaEntrePuntos(t->vertices[k], t->vertices[(k + 1) % 3]);
+    nuevo.triangulo = indice;
+    for (int j = 0; j < 3; j++) nuevo.vertices[j] = t->indices[j];
+
+    // Subir en el montículo
+    int i = ri->numCola++;
+    while (i > 0 && ri->cola[(i - 1) / 2].arista > nuevo.arista) {
+        ri->cola[i] = ri->cola[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    ri->cola[i] = nuevo;
+}
+
+static struct TrianguloPendiente desencolarPendiente(struct RefinamientoIncremental *ri) {
+    struct TrianguloPendiente primero = ri->cola[0];
+    struct TrianguloPendiente ultimo = ri->cola[--ri->numCola];
+
+    // Bajar el último desde la raíz
+    int i = 0;
+    for (;;) {
+        int hijo = 2 * i + 1;
+        if (hijo >= ri->numCola) break;
+        if (hijo + 1 < ri->numCola && ri->cola[hijo + 1].arista < ri->cola[hijo].arista) hijo++;
+        if (ri->cola[hijo].arista >= ultimo.arista) break;
+        ri->cola[i] = ri->cola[hijo];
+        i = hijo;
+    }
+    if (ri->numCola > 0) ri->cola[i] = ultimo;
+    return primero;
+}
+
+// Camina desde el triángulo inicio hacia (x, y). Devuelve el triángulo que lo
+// contiene, o -1 si el camino cruza una arista restringida o sale de la malla;
+// en ese caso *bloqueo = 3 * triángulo + arista.
+static int ubicarPunto(struct RefinamientoIncremental *ri, int inicio, double x, double y, int *bloqueo) {
+    struct Triangulacion *tr = ri->tr;
+    struct Punto p = { x, y, -1 };
+    int actual = inicio, pasos = 0;
+    *bloqueo = -1;
+
+    CONTAR_OPERACION(recorridos, 1);
+    bool encontrado = false;
+    while (pasos++ <= tr->numTriangulos) {
+        struct Triangulo *t = &tr->triangulos[actual];
+        int salida = -1;
+        // Empezar por una arista distinta en cada paso evita ciclos
         for (int j = 0; j < 3; j++) {
-            if ((t->vertices[j] == p1 && t->vertices[(j+1)%3] == p2) ||
-                (t->vertices[j] == p2 && t->vertices[(j+1)%3] == p1)) {
-                t->aristasRestringidas[j] = 1;
+            int k = (j + pasos) % 3;
+            if (orientacion(t->vertices[k], t->vertices[(k + 1) % 3], &p) < 0) {
+                salida = k;
+                break;
             }
         }
+        if (salida < 0) {
+            encontrado = true;
+            break;
+        }
+        if (!t->vecinos[salida] || (t->aristasRestringidas[salida] && !ri->conforme)) {
+            *bloqueo = 3 * actual + salida;
+            actual = -1;
+            break;
+        }
+        actual = indiceTriangulo(tr, t->vecinos[salida]);
     }
+    CONTAR_OPERACION(triangulosRecorridos, pasos);
+    MAXIMO_OPERACION(maxRecorrido, pasos);
+    return encontrado ? actual : -1;
 }
 
-struct Borde* actualizarBase(struct Triangulacion *tr, struct Borde *baseActual, struct Punto *nuevo) {
-    struct Borde *nuevaBase = malloc(sizeof(struct Borde));
-    if (!nuevaBase) return NULL;
-    
-    // La nueva base depende de qué lado se agregó el punto
-    if (orientacion(baseActual->p1, baseActual->p2, nuevo) > 0) {
-        // Punto agregado a la izquierda
-        nuevaBase->p1 = nuevo;
-        nuevaBase->p2 = baseActual->p2;
-    } else {
-        // Punto agregado a la derecha
-        nuevaBase->p1 = baseActual->p1;
-        nuevaBase->p2 = nuevo;
+static void apilarSubsegmento(struct RefinamientoIncremental *ri, int a, int b) {
+    if (!asegurarCapacidad((void **)&ri->pila, &ri->capacidadPila, ri->numPila + 1,
+                           sizeof(struct Segmento))) {
+        return;
     }
-    
-    free(baseActual);
-    return nuevaBase;
+    ri->pila[ri->numPila].v1 = a;
+    ri->pila[ri->numPila].v2 = b;
+    ri->pila[ri->numPila].marcador = 0;
+    ri->numPila++;
 }
 
-void crearSegmento(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2) {
-    if (tr->numBordes >= tr->maxBordes) return;
-    
-    struct Borde *borde = malloc(sizeof(struct Borde));
-    if (!borde) return;
-    
-    borde->p1 = p1;
-    borde->p2 = p2;
-    tr->bordes[tr->numBordes++] = borde;
+// Constante de la lente diametral para un ángulo mínimo en radianes, como
+// en triangle.c: (2 cos²θ - 1)². Sin ángulo mínimo o en modo conforme (-D),
+// 0: los segmentos se protegen con el círculo diametral.
+static double lenteDiametral(double anguloMinimo, bool conforme) {
+    if (conforme || anguloMinimo <= 0.0) return 0.0;
+    double coseno = cos(anguloMinimo);
+    double c = 2.0 * coseno * coseno - 1.0;
+    return c * c;
 }
 
+// El punto (x, y) invade el subsegmento (a, b) si lo ve con un ángulo obtuso
+// (círculo diametral) o, con ri->lente, de al menos 180° - 2θ: la lente
+// diametral de triangle.c, que con -q evita dividir segmentos por puntos que
+// no formarían un triángulo de mala calidad con ellos
+static bool invadeSubsegmento(const struct RefinamientoIncremental *ri, const struct Punto *a,
+                              const struct Punto *b, double x, double y) {
+    double ax = a->x - x, ay = a->y - y, bx = b->x - x, by = b->y - y;
+    double producto = ax * bx + ay * by;
+    if (producto >= 0.0) return false;
+    return producto * producto >= ri->lente * (ax * ax + ay * ay) * (bx * bx + by * by);
+}
 
-/* Funciones de triangulación                                                  */
+// Inserta el vértice indice (ya guardado en tr->puntos) en la cavidad que
+// parte de inicio. Si a y b son >= 0, el punto divide la arista (a, b): los
+// triángulos de ambos lados entran a la cavidad y las dos mitades heredan la
+// restricción. Devuelve 1, 0 si la cavidad no es válida (punto repetido o
+// degenerado) o -1 si el punto invade el círculo diametral de un segmento de
+// la frontera, que queda en ri->invadida como 3 * triángulo + arista.
+static int insertarVerticeCavidad(struct RefinamientoIncremental *ri, int indice, int inicio,
+                                  int a, int b) {
+    struct Triangulacion *tr = ri->tr;
+    struct Punto *p = &tr->puntos[indice];
+    double x = p->x, y = p->y;
+
+    // Cavidad: triángulos alcanzables cuyo circuncírculo contiene al punto
+    ri->generacion++;
+    ri->numCavidad = 0;
+    ri->numFrontera = 0;
+    bool divideArista = a >= 0;
+    if (!asegurarCapacidad((void **)&ri->cavidad, &ri->capacidadCavidad, 2, sizeof(int))) return 0;
+    ri->cavidad[ri->numCavidad++] = inicio;
+    ri->marca[inicio] = ri->generacion;
+    if (divideArista) {
+        struct Triangulo *t = &tr->triangulos[inicio];
+        for (int k = 0; k < 3; k++) {
+            int u = t->indices[k], v = t->indices[(k + 1) % 3];
+            if ((u == a && v == b) || (u == b && v == a)) {
+                if (t->vecinos[k]) {
+                    int otro = indiceTriangulo(tr, t->vecinos[k]);
+                    ri->cavidad[ri->numCavidad++] = otro;
+                    ri->marca[otro] = ri->generacion;
+                }
+            }
+        }
+    }
 
-// Función para inicializar la triangulación
-struct Triangulacion* inicializarTriangulacion(struct Punto* puntos, int numPuntos, int numPuntosRegion1) {
-    struct Triangulacion* tr = (struct Triangulacion*)malloc(sizeof(struct Triangulacion));
-    if (!tr) return NULL;
+    for (int i = 0; i < ri->numCavidad; i++) {
+        struct Triangulo *t = &tr->triangulos[ri->cavidad[i]];
+        for (int k = 0; k < 3; k++) {
+            int u = t->indices[k], v = t->indices[(k + 1) % 3];
+            bool esDividida = divideArista && ((u == a && v == b) || (u == b && v == a));
+            struct Triangulo *vecino = t->vecinos[k];
+            int iv = indiceTriangulo(tr, vecino);
+
+            if (vecino && ri->marca[iv] == ri->generacion) continue;   // Interior
+            if (esDividida) continue;   // Arista de borde que se divide: queda abierta
+            if (vecino && (ri->conforme || !t->aristasRestringidas[k]) &&
+                enCircunferenciaAntihoraria(vecino, p)) {
+                if (!asegurarCapacidad((void **)&ri->cavidad, &ri->capacidadCavidad,
+                                       ri->numCavidad + 1, sizeof(int))) {
+                    return 0;
+                }
+                ri->cavidad[ri->numCavidad++] = iv;
+                ri->marca[iv] = ri->generacion;
+                t = &tr->triangulos[ri->cavidad[i]];
+                continue;
+            }
+            if (!asegurarCapacidad((void **)&ri->frontera, &ri->capacidadFrontera,
+                                   ri->numFrontera + 1, sizeof(struct AristaCavidad))) {
+                return 0;
+            }
+            struct AristaCavidad *f = &ri->frontera[ri->numFrontera++];
+            f->a = u;
+            f->b = v;
+            f->vecino = iv;
+            f->restringida = t->aristasRestringidas[k];
+            f->interior = 3 * ri->cavidad[i] + k;
+        }
+    }
 
-    tr->maxTriangulos = numPuntos * 3;
-    tr->triangulos = (struct Triangulo*)malloc(tr->maxTriangulos * sizeof(struct Triangulo));
-    if (!tr->triangulos) {
-        free(tr);
-        return NULL;
+    // Un vecino de la frontera pudo entrar a la cavidad después: descartar
+    // esas aristas, que ya son interiores. Si era un segmento, el punto no lo
+    // ve desde la cavidad y no se inserta (salvo en modo conforme, donde el
+    // segmento se pierde y se vuelve a encolar).
+    int n = 0;
+    for (int i = 0; i < ri->numFrontera; i++) {
+        struct AristaCavidad *f = &ri->frontera[i];
+        if (f->vecino >= 0 && ri->marca[f->vecino] == ri->generacion) {
+            if (f->restringida && !ri->conforme) return 0;
+            continue;
+        }
+        ri->frontera[n++] = *f;
+    }
+    ri->numFrontera = n;
+
+    // Un circuncentro no se inserta si invade un segmento: se divide el
+    // segmento en su lugar (Ruppert)
+    if (!divideArista && !ri->conforme) {
+        for (int i = 0; i < ri->numFrontera; i++) {
+            struct AristaCavidad *f = &ri->frontera[i];
+            if (!f->restringida && f->vecino >= 0) continue;
+            if (invadeSubsegmento(ri, &tr->puntos[f->a], &tr->puntos[f->b], x, y)) {
+                ri->invadida = f->interior;
+                return -1;
+            }
+        }
     }
 
-    tr->numTriangulos = 0;
-    tr->puntos = puntos;
-    tr->numPuntos = numPuntos;
-    tr->maxPuntos = numPuntos;
-    tr->numPuntosRegion1 = numPuntosRegion1;  // Guardamos el número de puntos de la región 1
+    // La cavidad debe ser estrellada respecto del punto
+    for (int i = 0; i < ri->numFrontera; i++) {
+        if (orientacion(&tr->puntos[ri->frontera[i].a], &tr->puntos[ri->frontera[i].b], p) <= 0) {
+            return 0;
+        }
+    }
 
-    return tr;
-}
+    int numNuevos = ri->numFrontera;
+    if (!asegurarCapacidadTriangulos(ri, tr->numTriangulos + numNuevos - ri->numCavidad) ||
+        !asegurarCapacidad((void **)&ri->cavidad, &ri->capacidadCavidad, numNuevos, sizeof(int))) {
+        CONTAR_OPERACION(steinerSinEspacio, 1);
+        return 0;
+    }
+    p = &tr->puntos[indice];
+
+    // Con subsegmentos en seguimiento, los que la cavidad borra o el punto
+    // invade vuelven a la pila para verificarse
+    if (ri->trianguloDePunto) {
+        for (int i = 0; i < ri->numCavidad; i++) {
+            struct Triangulo *t = &tr->triangulos[ri->cavidad[i]];
+            for (int k = 0; k < 3; k++) {
+                int u = t->indices[k], v = t->indices[(k + 1) % 3];
+                int iv = indiceTriangulo(tr, t->vecinos[k]);
+                if (!t->aristasRestringidas[k] || iv < ri->cavidad[i]) continue;
+                if (ri->marca[iv] != ri->generacion) continue;
+                if (divideArista && ((u == a && v == b) || (u == b && v == a))) continue;
+                apilarSubsegmento(ri, u, v);
+            }
+        }
+        for (int i = 0; i < ri->numFrontera; i++) {
+            struct AristaCavidad *f = &ri->frontera[i];
+            if (f->restringida && invadeSubsegmento(ri, &tr->puntos[f->a], &tr->puntos[f->b], x, y)) {
+                apilarSubsegmento(ri, f->a, f->b);
+            }
+        }
+    }
 
-// Función para crear un nuevo triángulo
-struct Triangulo* crearTriangulo(struct Punto *v1, struct Punto *v2, struct Punto *v3) {
-    struct Triangulo *t = malloc(sizeof(struct Triangulo));
-    if (t == NULL) {
-        printf("Error: No se pudo asignar memoria para el triángulo\n");
-        return NULL;
+    CONTAR_OPERACION(cavidades, 1);
+    CONTAR_OPERACION(triangulosCavidad, ri->numCavidad);
+    MAXIMO_OPERACION(maxCavidad, ri->numCavidad);
+
+    // Los nuevos triángulos ocupan los lugares de la cavidad y luego el final
+    for (int i = ri->numCavidad; i < numNuevos; i++) ri->cavidad[i] = tr->numTriangulos++;
+    ri->nuevos = ri->cavidad;
+    for (int i = 0; i < numNuevos; i++) {
+        struct AristaCavidad *f = &ri->frontera[i];
+        struct Triangulo *t = &tr->triangulos[ri->cavidad[i]];
+        memset(t, 0, sizeof(struct Triangulo));
+        t->vertices[0] = &tr->puntos[f->a];
+        t->vertices[1] = &tr->puntos[f->b];
+        t->vertices[2] = p;
+        t->indices[0] = f->a;
+        t->indices[1] = f->b;
+        t->indices[2] = indice;
+        t->aristasRestringidas[0] = f->restringida;
+        if (f->vecino >= 0) {
+            struct Triangulo *v = &tr->triangulos[f->vecino];
+            t->vecinos[0] = v;
+            for (int k = 0; k < 3; k++) {
+                if (v->indices[k] == f->b && v->indices[(k + 1) % 3] == f->a) v->vecinos[k] = t;
+            }
+        }
+        if (ri->trianguloDePunto) {
+            ri->trianguloDePunto[f->a] = ri->cavidad[i];
+            ri->trianguloDePunto[f->b] = ri->cavidad[i];
+            ri->trianguloDePunto[indice] = ri->cavidad[i];
+        }
     }
-    
-    // Permitir puntos artificiales (índices negativos) durante la triangulación
-    t->vertices[0] = v1;
-    t->vertices[1] = v2;
-    t->vertices[2] = v3;
-    t->indices[0] = v1->indice;
-    t->indices[1] = v2->indice;
-    t->indices[2] = v3->indice;
-    
-    // Marcar como triángulo artificial si tiene algún punto artificial
-    if (v1->indice < 0 || v2->indice < 0 || v3->indice < 0) {
-        t->esTrianguloSuper = 1;  // Usar 1 para indicar triángulo artificial
-    } else {
-        t->esTrianguloSuper = 0;
+
+    // Vecinos entre los nuevos: (b, p) de uno es (p, a) del que empieza en b
+    for (int i = 0; i < numNuevos; i++) {
+        struct Triangulo *t = &tr->triangulos[ri->cavidad[i]];
+        for (int j = 0; j < numNuevos; j++) {
+            struct Triangulo *u = &tr->triangulos[ri->cavidad[j]];
+            if (u->indices[0] == t->indices[1]) {
+                t->vecinos[1] = u;
+                u->vecinos[2] = t;
+                break;
+            }
+        }
+        // Las mitades de una arista dividida siguen siendo segmentos
+        if (divideArista) {
+            if (t->indices[1] == a || t->indices[1] == b) t->aristasRestringidas[1] = 1;
+            if (t->indices[0] == a || t->indices[0] == b) t->aristasRestringidas[2] = 1;
+        }
     }
-    
-    // Inicializar vecinos
-    t->vecinos[0] = NULL;
-    t->vecinos[1] = NULL;
-    t->vecinos[2] = NULL;
-    
-    return t;
+    ri->numCavidad = numNuevos;
+    return 1;
 }
 
-// Función para crear el super-triángulo que contendrá todos los puntos
-struct Triangulo* crearSuperTriangulo(struct Punto *puntos, int numPuntos) {
-    int i;
-    // Encontrar los límites del conjunto de puntos
-    double minX = puntos[0].x;
-    double minY = puntos[0].y;
-    double maxX = minX;
-    double maxY = minY;
-    
-    for(i = 1; i < numPuntos; i++) {
-        if(puntos[i].x < minX) minX = puntos[i].x;
-        if(puntos[i].y < minY) minY = puntos[i].y;
-        if(puntos[i].x > maxX) maxX = puntos[i].x;
-        if(puntos[i].y > maxY) maxY = puntos[i].y;
+// Agrega el punto (x, y) al final de tr->puntos y lo inserta como
+// insertarVerticeCavidad. Devuelve el índice del punto, -1 si la cavidad no
+// es válida o -2 si invade un segmento (ri->invadida).
+static int insertarPuntoCavidad(struct RefinamientoIncremental *ri, double x, double y,
+                                int inicio, int a, int b) {
+    struct Triangulacion *tr = ri->tr;
+    if (!asegurarCapacidadPuntos(tr, tr->numPuntos + 1) ||
+        (ri->trianguloDePunto &&
+         !asegurarCapacidad((void **)&ri->trianguloDePunto, &ri->capacidadTrianguloDePunto,
+                            tr->numPuntos + 1, sizeof(int))) ||
+        (ri->extremos &&
+         !asegurarCapacidad((void **)&ri->extremos, &ri->capacidadExtremos,
+                            tr->numPuntos + 1, sizeof(*ri->extremos)))) {
+        CONTAR_OPERACION(steinerSinEspacio, 1);
+        return -1;
     }
-    
-    // Calcular el centro y el tamaño del rectángulo que contiene los puntos
-    double dx = maxX - minX;
-    double dy = maxY - minY;
-    double deltaMax = (dx > dy) ? dx : dy;
-    double midX = (minX + maxX) / 2;
-    double midY = (minY + maxY) / 2;
-
-    // Crear los vértices del super-triángulo
-    struct Punto *p1 = malloc(sizeof(struct Punto));
-    struct Punto *p2 = malloc(sizeof(struct Punto));
-    struct Punto *p3 = malloc(sizeof(struct Punto));
-    
-    // Hacer el super-triángulo lo suficientemente grande
-    p1->x = midX - 20 * deltaMax;
-    p1->y = midY - deltaMax;
-    p1->indice = -1;
-    
-    p2->x = midX + 20 * deltaMax;
-    p2->y = midY - deltaMax;
-    p2->indice = -2;
-    
-    p3->x = midX;
-    p3->y = midY + 20 * deltaMax;
-    p3->indice = -3;
-    
-    // Crear el super-triángulo
-    struct Triangulo *superTriangulo = crearTriangulo(p1, p2, p3);
-    superTriangulo->esTrianguloSuper = 1;
-    
-    return superTriangulo;
+    int indice = tr->numPuntos;
+    if (ri->extremos) ri->extremos[indice][0] = ri->extremos[indice][1] = -1;
+    tr->puntos[indice].x = x;
+    tr->puntos[indice].y = y;
+    tr->puntos[indice].indice = indice;
+
+    int resultado = insertarVerticeCavidad(ri, indice, inicio, a, b);
+    if (resultado <= 0) return resultado - 1;
+    tr->numPuntos++;
+    CONTAR_OPERACION(steinerAceptados, 1);
+    TRAZA_CONTAR(CONTADOR_PUNTOS_STEINER, 1);
+    return indice;
 }
 
-void agregarTriangulo(struct Triangulacion* tr, struct Triangulo* t) {
-    if (tr->numTriangulos >= tr->maxTriangulos) {
-        // Aumentar capacidad si es necesario
-        tr->maxTriangulos *= 2;
-        struct Triangulo* temp = (struct Triangulo*)realloc(tr->triangulos, 
-                                tr->maxTriangulos * sizeof(struct Triangulo));
-        if (!temp) return;
-        tr->triangulos = temp;
+static int iniciarRefinamientoIncremental(struct RefinamientoIncremental *ri, struct Triangulacion *tr) {
+    memset(ri, 0, sizeof(struct RefinamientoIncremental));
+    ri->tr = tr;
+
+    // Longitud mínima relativa al tamaño del dominio: por debajo, el punto
+    // medio de un subsegmento apenas se distingue de sus extremos
+    double xmin = DBL_MAX, xmax = -DBL_MAX, ymin = DBL_MAX, ymax = -DBL_MAX;
+    for (int i = 0; i < tr->numPuntos; i++) {
+        if (tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
+        if (tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
+        if (tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
+        if (tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
     }
+    ri->longitudMinima = 1e-9 * hypot(xmax - xmin, ymax - ymin);
 
-    // Copiar el triángulo a la estructura
-    tr->triangulos[tr->numTriangulos] = *t;
-    tr->numTriangulos++;
+    if (!asegurarCapacidad((void **)&ri->marca, &ri->capacidadMarca, tr->maxTriangulos + 1, sizeof(int))) {
+        return 0;
+    }
+    memset(ri->marca, 0, (size_t)ri->capacidadMarca * sizeof(int));
+    return 1;
 }
 
-void eliminarTriangulo(struct Triangulacion* tr, struct Triangulo* t) {
-    // Buscar el triángulo en el arreglo
-    int idx = -1;
+static void liberarRefinamientoIncremental(struct RefinamientoIncremental *ri) {
+    free(ri->cola);
+    free(ri->cavidad);
+    free(ri->frontera);
+    free(ri->marca);
+    free(ri->trianguloDePunto);
+    free(ri->pila);
+    free(ri->extremos);
+}
+
+// Etiqueta cada vértice interior a un segmento (un punto Steiner con
+// exactamente dos aristas restringidas o de borde, alineadas) con los
+// extremos del segmento, que se encuentran recorriendo la cadena de
+// subsegmentos en ambos sentidos. Los vértices de la entrada siempre son
+// extremos, como en puntoDivision. Devuelve 0 si falta memoria.
+static int etiquetarVerticesSegmento(struct RefinamientoIncremental *ri) {
+    struct Triangulacion *tr = ri->tr;
+    int n = tr->numPuntos;
+    int (*contiguos)[2] = malloc(((size_t)n + 1) * sizeof(*contiguos));
+    int *grado = calloc((size_t)n + 1, sizeof(int));
+    if (!contiguos || !grado ||
+        !asegurarCapacidad((void **)&ri->extremos, &ri->capacidadExtremos, n + 1, sizeof(*ri->extremos))) {
+        free(contiguos);
+        free(grado);
+        return 0;
+    }
     for (int i = 0; i < tr->numTriangulos; i++) {
-        if (&tr->triangulos[i] == t) {
-            idx = i;
-            break;
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            if (!t->aristasRestringidas[k] && t->vecinos[k]) continue;
+            if (t->vecinos[k] && t->vecinos[k] < t) continue;
+            int a = t->indices[k], b = t->indices[(k + 1) % 3];
+            if (grado[a] < 2) contiguos[a][grado[a]] = b;
+            if (grado[b] < 2) contiguos[b][grado[b]] = a;
+            grado[a]++;
+            grado[b]++;
         }
     }
 
-    if (idx == -1) return;  // Triángulo no encontrado
+    // Interior: dos subsegmentos que siguen la misma recta
+    for (int v = 0; v < n; v++) {
+        ri->extremos[v][0] = ri->extremos[v][1] = -1;
+        if (v < tr->numPuntosRegion1 || grado[v] != 2) continue;
+        struct Punto *p = &tr->puntos[v], *a = &tr->puntos[contiguos[v][0]], *b = &tr->puntos[contiguos[v][1]];
+        double ax = a->x - p->x, ay = a->y - p->y, bx = b->x - p->x, by = b->y - p->y;
+        if (ax * bx + ay * by < 0.0 && fabs(ax * by - ay * bx) <= 1e-9 * hypot(ax, ay) * hypot(bx, by)) {
+            ri->extremos[v][0] = ri->extremos[v][1] = v;   // Pendiente de recorrer
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        if (ri->extremos[v][0] != v) continue;
+        int fin[2];
+        for (int lado = 0; lado < 2; lado++) {
+            int anterior = v, actual = contiguos[v][lado];
+            while (actual != v && ri->extremos[actual][0] >= 0) {
+                int siguiente = contiguos[actual][0] == anterior ? contiguos[actual][1] : contiguos[actual][0];
+                anterior = actual;
+                actual = siguiente;
+            }
+            fin[lado] = actual;
+        }
+        // Toda la cadena comparte la etiqueta; una cadena cerrada no tiene extremos
+        if (fin[0] == v) fin[0] = fin[1] = -1;
+        for (int lado = 0; lado < 2; lado++) {
+            int anterior = v, actual = contiguos[v][lado];
+            while (actual != v && actual != fin[lado]) {
+                int siguiente = contiguos[actual][0] == anterior ? contiguos[actual][1] : contiguos[actual][0];
+                ri->extremos[actual][0] = fin[0];
+                ri->extremos[actual][1] = fin[1];
+                anterior = actual;
+                actual = siguiente;
+            }
+        }
+        ri->extremos[v][0] = fin[0];
+        ri->extremos[v][1] = fin[1];
+    }
+    free(contiguos);
+    free(grado);
+    return 1;
+}
 
-    // Mover el último triángulo a la posición del eliminado
-    if (idx < tr->numTriangulos - 1) {
-        tr->triangulos[idx] = tr->triangulos[tr->numTriangulos - 1];
+// Un vértice agregado sobre el subsegmento (a, b) hereda el segmento de la
+// entrada al que pertenece
+static void etiquetarDivision(struct RefinamientoIncremental *ri, int indice, int a, int b) {
+    if (!ri->extremos) return;
+    if (ri->extremos[a][0] >= 0) {
+        memcpy(ri->extremos[indice], ri->extremos[a], sizeof(ri->extremos[indice]));
+    } else if (ri->extremos[b][0] >= 0) {
+        memcpy(ri->extremos[indice], ri->extremos[b], sizeof(ri->extremos[indice]));
+    } else {
+        ri->extremos[indice][0] = a;
+        ri->extremos[indice][1] = b;
     }
-    tr->numTriangulos--;
 }
 
-// Función para optimización local después de insertar un punto
-void optimizarLocal(struct Triangulacion *tr, struct Punto *p) {
-    bool cambios;
-    do {
-        cambios = false;
-        // Encontrar todos los pares de triángulos adyacentes que comparten el punto p
-        for(int i = 0; i < tr->numTriangulos; i++) {
-            if(tieneVertice(&tr->triangulos[i], p)) {
-                for(int j = 0; j < 3; j++) {
-                    struct Triangulo *vecino = tr->triangulos[i].vecinos[j];
-                    if(vecino != NULL && !vecino->esTrianguloSuper) {
-                        if(necesitaIntercambio(&tr->triangulos[i], vecino)) {
-                            intercambiarDiagonal(tr, &tr->triangulos[i], vecino);
-                            cambios = true;
-                        }
-                    }
-                }
-            }
+static void puntoDivision(struct RefinamientoIncremental *ri, int a, int b, double *x, double *y);
+
+// Refina hasta que ningún triángulo viole el ángulo mínimo ni el área
+// máxima. Un circuncentro que cae del otro lado de un segmento (o fuera de la
+// malla) divide ese segmento por la mitad, como en el algoritmo de Ruppert.
+// Con ángulo mínimo y sin conforme los segmentos se protegen con lentes
+// diametrales; con conforme (-D), con sus círculos diametrales.
+void refinarIncremental(struct Triangulacion *tr, double anguloMinimo, double areaMaxima,
+                        int posicionSteiner, bool conforme) {
+    TRAZA_DETALLE("\n=== INICIO DEL REFINAMIENTO INCREMENTAL ===\n");
+    TRAMO_INICIO(FASE_REFINAMIENTO);
+
+    struct RefinamientoIncremental ri;
+    int puntosIniciales = tr->numPuntos;
+    if (!iniciarRefinamientoIncremental(&ri, tr)) {
+        liberarRefinamientoIncremental(&ri);
+        TRAZA_ERROR("No se pudo asignar memoria para el refinamiento\n");
+        TRAMO_FIN(FASE_REFINAMIENTO);
+        return;
+    }
+    ri.anguloMinimo = anguloMinimo;
+    ri.areaMaxima = areaMaxima;
+    ri.lente = lenteDiametral(anguloMinimo, conforme);
+    double constante = constanteFueraCentro(posicionSteiner, anguloMinimo);
+    if (anguloMinimo > 0.0 && !etiquetarVerticesSegmento(&ri)) {
+        liberarRefinamientoIncremental(&ri);
+        TRAZA_ERROR("No se pudo asignar memoria para el refinamiento\n");
+        TRAMO_FIN(FASE_REFINAMIENTO);
+        return;
+    }
+
+    for (int i = 0; i < tr->numTriangulos; i++) encolarSiRequiere(&ri, i);
+
+    while (ri.numCola > 0) {
+        struct TrianguloPendiente pendiente = desencolarPendiente(&ri);
+        struct Triangulo *t = &tr->triangulos[pendiente.triangulo];
+        if (t->indices[0] != pendiente.vertices[0] || t->indices[1] != pendiente.vertices[1] ||
+            t->indices[2] != pendiente.vertices[2]) {
+            continue;   // Ya fue reemplazado
         }
-    } while(cambios);
-}
 
-void dividirTriangulo(struct Triangulacion *tr, struct Triangulo *t, struct Punto *p) {
-    struct Punto *a = t->vertices[0];
-    struct Punto *b = t->vertices[1];
-    struct Punto *c = t->vertices[2];
+        double x, y;
+        if (!ubicarPuntoSteiner(t->vertices[0], t->vertices[1], t->vertices[2], constante, &x, &y)) continue;
+
+        int bloqueo;
+        int contenedor = ubicarPunto(&ri, pendiente.triangulo, x, y, &bloqueo);
+        int insertado;
+        if (contenedor >= 0) {
+            insertado = insertarPuntoCavidad(&ri, x, y, contenedor, -1, -1);
+            if (insertado == -2) {
+                bloqueo = ri.invadida;   // Dividir el segmento invadido
+            } else if (insertado < 0) {
+                CONTAR_OPERACION(steinerCercanos, 1);
+            }
+        }
+        if (contenedor < 0 && bloqueo < 0) {
+            continue;   // El camino no terminó (malla inconsistente)
+        }
+        if (contenedor < 0 || insertado == -2) {
+            // Dividir el segmento que separa o que invade el circuncentro
+            CONTAR_OPERACION(steinerFueraDeLimites, 1);
+            struct Triangulo *tb = &tr->triangulos[bloqueo / 3];
+            int k = bloqueo % 3;
+            struct Punto *pa = tb->vertices[k], *pb = tb->vertices[(k + 1) % 3];
+            if (distanciaEntrePuntos(pa, pb) < 2.0 * ri.longitudMinima) continue;
+            int a = tb->indices[k], b = tb->indices[(k + 1) % 3];
+            puntoDivision(&ri, a, b, &x, &y);
+            insertado = insertarPuntoCavidad(&ri, x, y, bloqueo / 3, a, b);
+            if (insertado >= 0) {
+                etiquetarDivision(&ri, insertado, a, b);
+                encolarSiRequiere(&ri, pendiente.triangulo);   // Si sobrevivió, reintentar
+            }
+        }
+        if (insertado < 0) continue;
 
-    // Crear tres nuevos triángulos
-    struct Triangulo* t1 = crearTriangulo(p, a, b);
-    struct Triangulo* t2 = crearTriangulo(p, b, c);
-    struct Triangulo* t3 = crearTriangulo(p, c, a);
+        for (int i = 0; i < ri.numCavidad; i++) encolarSiRequiere(&ri, ri.nuevos[i]);
+    }
 
-    // Preservar la información del triángulo super
-    t1->esTrianguloSuper = t->esTrianguloSuper;
-    t2->esTrianguloSuper = t->esTrianguloSuper;
-    t3->esTrianguloSuper = t->esTrianguloSuper;
+    liberarRefinamientoIncremental(&ri);
 
-    // Agregar los nuevos triángulos
-    agregarTriangulo(tr, t1);
-    agregarTriangulo(tr, t2);
-    agregarTriangulo(tr, t3);
+    TRAMO_FIN(FASE_REFINAMIENTO);
+    TRAZA_INFO("Refinamiento incremental: %d puntos agregados\n", tr->numPuntos - puntosIniciales);
+}
 
-    // Eliminar el triángulo original
-    eliminarTriangulo(tr, t);
+static void avisarAnguloMinimo(const struct OpcionesDelaunay *op) {
+    if (op->anguloMinimo > ANGULO_MINIMO_TERMINACION) {
+        TRAZA_AVISO("Con un ángulo mínimo mayor que %g° el refinamiento puede no terminar\n",
+                    ANGULO_MINIMO_TERMINACION);
+    }
 }
 
-// Función para eliminar triángulos que contienen vértices del super-triángulo
-void eliminarTriangulosSuper(struct Triangulacion *tr) {
-    int j = 0;
+// Reemplaza los segmentos de la entrada por las aristas restringidas y las del
+// borde de la malla (los segmentos ya divididos), numerados por posición
+static int subsegmentosDeTriangulacion(struct Triangulacion *tr, struct EntradaPoly *entrada) {
+    int num = 0, capacidad = 0;
+    struct Segmento *segmentos = NULL;
     for (int i = 0; i < tr->numTriangulos; i++) {
-        if (!tieneVerticeArtificial(&tr->triangulos[i])) {
-            if (i != j) tr->triangulos[j] = tr->triangulos[i];
-            j++;
+        struct Triangulo *t = &tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            if (!t->aristasRestringidas[k] && t->vecinos[k]) continue;
+            // Cada arista interior aparece dos veces: quedarse con una cara
+            if (t->vecinos[k] && t->vecinos[k] < t) continue;
+            if (!asegurarCapacidad((void **)&segmentos, &capacidad, num + 1, sizeof(struct Segmento))) {
+                free(segmentos);
+                return 0;
+            }
+            segmentos[num].v1 = t->indices[k];
+            segmentos[num].v2 = t->indices[(k + 1) % 3];
+            segmentos[num].marcador = t->vecinos[k] ? 0 : 1;
+            num++;
         }
     }
-    tr->numTriangulos = j;
+    free(entrada->segmentos);
+    entrada->segmentos = segmentos;
+    entrada->numSegmentos = num;
+    return 1;
 }
 
-// Función para liberar la memoria de la triangulación
-void liberarTriangulacion(struct Triangulacion *tr) {
-    if (tr != NULL) {
-        if (tr->puntos != NULL) {
-            free(tr->puntos);
-        }
-        if (tr->triangulos != NULL) {
-            free(tr->triangulos);
+// Refina una malla leída de .node/.ele (y .poly con -p) con las opciones
+// dadas. La entrada queda con los subsegmentos para la salida.
+int refinarMallaExistente(struct EntradaPoly *entrada, const struct MallaBinaria *elementos,
+                          const struct OpcionesDelaunay *op, struct Triangulacion **resultado) {
+    *resultado = NULL;
+    reiniciarContadoresOperacion();
+    avisarAnguloMinimo(op);
+
+    struct Triangulacion *tr;
+    TRAMO_INICIO(FASE_TRIANGULACION);
+    int codigo = reconstruirTriangulacion(entrada, elementos, &tr);
+    TRAMO_FIN(FASE_TRIANGULACION);
+    if (codigo != SALIDA_EXITO) return codigo;
+
+    double anguloMinimo = op->anguloMinimo > 0.0 ? op->anguloMinimo * M_PI / 180.0 : 0.0;
+    double areaMaxima = op->areaMaxima > 0.0 ? op->areaMaxima : DBL_MAX;
+    if (op->usarAreasRegion) {
+        for (int i = 0; i < entrada->numRegiones; i++) {
+            double a = entrada->regiones[i].areaMaxima;
+            if (a > 0.0 && a < areaMaxima) areaMaxima = a;
         }
-        if (tr->bordes != NULL) {
-            for (int i = 0; i < tr->numBordes; i++) {
-                free(tr->bordes[i]);
-            }
-            free(tr->bordes);
+    }
+    if (op->conforme) {
+        if (!conformarYRefinar(tr, entrada->numVertices, anguloMinimo, areaMaxima, op->posicionSteiner, true)) {
+            liberarTriangulacion(tr);
+            TRAZA_ERROR("No se pudo asignar memoria para el refinamiento\n");
+            return SALIDA_MEMORIA;
         }
-        free(tr);
+    } else if (anguloMinimo > 0.0 || areaMaxima < DBL_MAX) {
+        refinarIncremental(tr, anguloMinimo, areaMaxima, op->posicionSteiner, false);
+    }
+
+    for (int i = 0; i < tr->numPuntos; i++) tr->puntos[i].indice = i;
+    if (!subsegmentosDeTriangulacion(tr, entrada)) {
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para los segmentos\n");
+        return SALIDA_MEMORIA;
+    }
+
+    imprimirEstadisticas(tr);
+    if (verificarTriangulacion(tr) > 0) {
+        liberarTriangulacion(tr);
+        return SALIDA_TRIANGULACION;
     }
+    *resultado = tr;
+    return SALIDA_EXITO;
 }
 
-// Función para insertar un segmento como restricción
-void insertarSegmentoRestriccion(struct Triangulacion *tr, struct Segmento *seg) {
-    struct Punto *p1 = &tr->puntos[seg->v1];
-    struct Punto *p2 = &tr->puntos[seg->v2];
-    
-    // Encontrar triángulos que intersecta el segmento
-    struct ListaTriangulos *triangulos = encontrarTriangulosIntersectados(tr, p1, p2);
-    if (!triangulos) return;
+/* Delaunay conforme (-D)                                                     */
+
+// Busca la arista (a, b) girando alrededor de a desde trianguloDePunto[a], de
+// modo que el costo es el grado de a. Devuelve 3 * triángulo + k con la arista
+// k entre a y b (en cualquier sentido), o -1 si no está en la malla.
+static int buscarArista(struct RefinamientoIncremental *ri, int a, int b) {
+    struct Triangulacion *tr = ri->tr;
+    int inicio = ri->trianguloDePunto[a];
+    if (inicio < 0) return -1;
+
+    // Primero en un sentido; si se llega al borde, en el otro
+    for (int sentido = 0; sentido < 2; sentido++) {
+        struct Triangulo *t = &tr->triangulos[inicio];
+        for (int pasos = 0; t && pasos < tr->numTriangulos; pasos++) {
+            int i = 0;
+            while (i < 3 && t->indices[i] != a) i++;
+            if (i == 3) return -1;
+            int actual = indiceTriangulo(tr, t);
+            if (t->indices[(i + 1) % 3] == b) return 3 * actual + i;
+            if (t->indices[(i + 2) % 3] == b) return 3 * actual + (i + 2) % 3;
+            t = t->vecinos[sentido == 0 ? (i + 2) % 3 : i];
+            if (t == &tr->triangulos[inicio]) return -1;   // Vuelta completa
+        }
+    }
+    return -1;
+}
 
-    // Crear nueva arista restringida
-    for (int i = 0; i < triangulos->numTriangulos - 1; i++) {
-        struct Triangulo *t1 = triangulos->triangulos[i];
-        struct Triangulo *t2 = triangulos->triangulos[i + 1];
-        
-        // Dividir triángulos si es necesario
-        if (!compartenArista(t1, t2)) {
-            struct Punto *p = calcularPuntoInterseccion(t1, t2, p1, p2);
-            if (p) {
-                dividirTriangulo(tr, t1, p);
-                dividirTriangulo(tr, t2, p);
-                optimizarLocal(tr, p);
+// Un vecino de a o de b que está sobre el segmento (a, b), o -1. Los
+// segmentos de la entrada que se superponen o pasan por un vértice se dividen
+// en ese vértice: ningún punto nuevo haría aparecer la arista completa.
+static int verticeSobreSubsegmento(struct RefinamientoIncremental *ri, int a, int b) {
+    struct Triangulacion *tr = ri->tr;
+    struct Punto *pa = &tr->puntos[a], *pb = &tr->puntos[b];
+    double dx = pb->x - pa->x, dy = pb->y - pa->y;
+    double longitud2 = dx * dx + dy * dy;
+
+    for (int extremo = 0; extremo < 2; extremo++) {
+        int centro = extremo == 0 ? a : b;
+        int inicio = ri->trianguloDePunto[centro];
+        if (inicio < 0) continue;
+        for (int sentido = 0; sentido < 2; sentido++) {
+            struct Triangulo *t = &tr->triangulos[inicio];
+            for (int pasos = 0; t && pasos < tr->numTriangulos; pasos++) {
+                int i = 0;
+                while (i < 3 && t->indices[i] != centro) i++;
+                if (i == 3) break;
+                for (int m = 1; m <= 2; m++) {
+                    int c = t->indices[(i + m) % 3];
+                    if (c == a || c == b) continue;
+                    struct Punto *pc = &tr->puntos[c];
+                    double izquierda = dx * (pc->y - pa->y), derecha = dy * (pc->x - pa->x);
+                    if (fabs(izquierda - derecha) > COTA_ERROR_ORIENTACION * (fabs(izquierda) + fabs(derecha))) {
+                        continue;
+                    }
+                    double proyeccion = (pc->x - pa->x) * dx + (pc->y - pa->y) * dy;
+                    if (proyeccion > 0.0 && proyeccion < longitud2) return c;
+                }
+                t = t->vecinos[sentido == 0 ? (i + 2) % 3 : i];
+                if (t == &tr->triangulos[inicio]) break;
             }
         }
     }
-
-    // Marcar aristas como restringidas
-    marcarAristasRestringidas(tr, p1, p2);
+    return -1;
 }
 
-// Modificar la triangulación principal para incluir restricciones
-struct Triangulacion* triangulacionDelaunayRestringida(struct EntradaPoly *entrada) {
-    printf("Iniciando triangulación de Delaunay con restricciones...\n");
-    
-    // Paso 1: Triangulación inicial
-    struct Triangulacion* tr = triangulacionDelaunay(entrada->vertices, 
-                                                   entrada->numVertices,
-                                                   entrada->numVertices);
-    if (!tr) {
-        printf("[ERROR] Falló la triangulación inicial\n");
-        return NULL;
-    }
-    
-    printf("Triangulación inicial completada.\n");
-    printf("Insertando restricciones de segmentos...\n");
-    
-    // Paso 2: Insertar segmentos como restricciones
-    for (int i = 0; i < entrada->numSegmentos; i++) {
-        printf("Procesando segmento %d de %d\n", i + 1, entrada->numSegmentos);
-        insertarSegmentoRestriccion(tr, &entrada->segmentos[i]);
+// En una triangulación de Delaunay, si algún vértice cae dentro del círculo
+// diametral de una arista, también cae alguno de los dos vértices opuestos:
+// basta con revisar esos dos (triangle.c hace lo mismo con las lentes)
+static bool subsegmentoInvadido(struct RefinamientoIncremental *ri, int arista) {
+    struct Triangulo *t = &ri->tr->triangulos[arista / 3];
+    int k = arista % 3;
+    struct Punto *a = t->vertices[k], *b = t->vertices[(k + 1) % 3];
+    struct Triangulo *lados[2] = { t, t->vecinos[k] };
+    for (int l = 0; l < 2; l++) {
+        if (!lados[l]) continue;
+        for (int m = 0; m < 3; m++) {
+            struct Punto *c = lados[l]->vertices[m];
+            if (c == a || c == b) continue;
+            if (invadeSubsegmento(ri, a, b, c->x, c->y)) return true;
+        }
     }
-    
-    printf("Restricciones insertadas.\n");
-    printf("Actualizando relaciones de vecindad...\n");
-    
-    // Paso 3: Actualizar estructura final
-    actualizarVecinos(tr);
-    
-    printf("Triangulación restringida completada.\n");
-    return tr;
+    return false;
 }
 
-struct Borde* encontrarBaseInicial(struct Triangulacion *tr, int medio) {
-    struct Borde *base = malloc(sizeof(struct Borde));
-    if (!base) return NULL;
-    
-    // Encontrar el punto más a la derecha de la mitad izquierda
-    struct Punto *p1 = &tr->puntos[medio];
-    // Y el punto más a la izquierda de la mitad derecha
-    struct Punto *p2 = &tr->puntos[medio + 1];
-    
-    base->p1 = p1;
-    base->p2 = p2;
-    return base;
+static void marcarSubsegmento(struct Triangulacion *tr, int arista) {
+    struct Triangulo *t = &tr->triangulos[arista / 3];
+    int k = arista % 3;
+    t->aristasRestringidas[k] = 1;
+    struct Triangulo *v = t->vecinos[k];
+    if (!v) return;
+    for (int m = 0; m < 3; m++) {
+        if (v->vecinos[m] == t) v->aristasRestringidas[m] = 1;
+    }
 }
 
-struct Punto* encontrarCandidatoIzquierda(struct Triangulacion *tr, struct Borde *base) {
-    struct Punto *mejor = NULL;
-    double mejorAngulo = -DBL_MAX;
-    
-    // Buscar entre todos los puntos a la izquierda de la base
-    for (int i = 0; i < tr->numPuntos; i++) {
-        struct Punto *p = &tr->puntos[i];
-        if (p == base->p1 || p == base->p2) continue;
-        
-        // Verificar si está a la izquierda de la base
-        if (orientacion(base->p1, base->p2, p) > 0) {
-            double angulo = calcularAngulo(base->p1, base->p2, p);
-            if (angulo > mejorAngulo) {
-                mejorAngulo = angulo;
-                mejor = p;
-            }
+// Punto donde se divide (a, b): el punto medio o, si sólo un extremo es un
+// vértice de la entrada, la capa concéntrica (potencia de dos) más cercana a
+// la mitad medida desde ese extremo. Así dos segmentos que forman un ángulo
+// pequeño se dividen a las mismas distancias y no se invaden sin fin. Con
+// las etiquetas de segmento, los extremos de la entrada son los vértices que
+// no son interiores a un segmento.
+static void puntoDivision(struct RefinamientoIncremental *ri, int a, int b, double *x, double *y) {
+    struct Punto *pa = &ri->tr->puntos[a], *pb = &ri->tr->puntos[b];
+    bool entradaA = ri->extremos ? ri->extremos[a][0] < 0 : a < ri->puntosEntrada;
+    bool entradaB = ri->extremos ? ri->extremos[b][0] < 0 : b < ri->puntosEntrada;
+    double t = 0.5;
+    if (entradaA != entradaB) {
+        if (entradaB) {
+            struct Punto *c = pa;
+            pa = pb;
+            pb = c;
         }
+        double longitud = distanciaEntrePuntos(pa, pb);
+        double capa = 1.0;
+        while (longitud > 3.0 * capa) capa *= 2.0;
+        while (longitud < 1.5 * capa) capa *= 0.5;
+        t = capa / longitud;
     }
-    
-    return mejor;
+    *x = pa->x + t * (pb->x - pa->x);
+    *y = pa->y + t * (pb->y - pa->y);
 }
 
-struct Punto* encontrarCandidatoDerecha(struct Triangulacion *tr, struct Borde *base) {
-    struct Punto *mejor = NULL;
-    double mejorAngulo = -DBL_MAX;
-    
-    // Buscar entre todos los puntos a la derecha de la base
-    for (int i = 0; i < tr->numPuntos; i++) {
-        struct Punto *p = &tr->puntos[i];
-        if (p == base->p1 || p == base->p2) continue;
-        
-        // Verificar si está a la derecha de la base
-        if (orientacion(base->p1, base->p2, p) < 0) {
-            double angulo = calcularAngulo(base->p1, base->p2, p);
-            if (angulo > mejorAngulo) {
-                mejorAngulo = angulo;
-                mejor = p;
-            }
-        }
+// Un triángulo incidente a cada vértice, para ubicar aristas sin recorrer la
+// malla entera
+static int indexarVertices(struct RefinamientoIncremental *ri) {
+    struct Triangulacion *tr = ri->tr;
+    if (!asegurarCapacidad((void **)&ri->trianguloDePunto, &ri->capacidadTrianguloDePunto,
+                           tr->maxPuntos > tr->numPuntos ? tr->maxPuntos : tr->numPuntos + 1,
+                           sizeof(int))) {
+        return 0;
     }
-    
-    return mejor;
+    for (int i = 0; i < tr->numPuntos; i++) ri->trianguloDePunto[i] = -1;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        for (int k = 0; k < 3; k++) ri->trianguloDePunto[tr->triangulos[i].indices[k]] = i;
+    }
+    return 1;
 }
 
-void triangular(struct Triangulacion *tr) {
-    printf("Iniciando ordenamiento de puntos...\n");
-    qsort(tr->puntos, tr->numPuntos, sizeof(struct Punto), compararPuntosX);
-    printf("Puntos ordenados. Total puntos: %d\n", tr->numPuntos);
-    
-    printf("Iniciando división recursiva...\n");
-    divideVencerasDelaunay(tr, 0, tr->numPuntos - 1);
-    
-    printf("Triangulación completada. Número de triángulos: %d\n", tr->numTriangulos);
+// Vacía la pila de subsegmentos: los que ya son aristas sin invadir se marcan
+// como restringidos y los que faltan o están invadidos se dividen, apilando
+// sus mitades. Cada inserción apila a su vez los subsegmentos que borra o
+// invade, así que la verificación se limita a la zona que cambió.
+static int dividirSubsegmentos(struct RefinamientoIncremental *ri) {
+    struct Triangulacion *tr = ri->tr;
+    int divisiones = 0;
+
+    while (ri->numPila > 0) {
+        struct Segmento s = ri->pila[--ri->numPila];
+        int a = s.v1, b = s.v2;
+        if (a == b || ri->trianguloDePunto[a] < 0 || ri->trianguloDePunto[b] < 0) continue;
+
+        CONTAR_OPERACION(subsegmentosVerificados, 1);
+        int arista = buscarArista(ri, a, b);
+        if (arista >= 0 && !subsegmentoInvadido(ri, arista)) {
+            marcarSubsegmento(tr, arista);
+            continue;
+        }
+        int intermedio = verticeSobreSubsegmento(ri, a, b);
+        if (intermedio >= 0) {
+            apilarSubsegmento(ri, a, intermedio);
+            apilarSubsegmento(ri, intermedio, b);
+            continue;
+        }
+        if (distanciaEntrePuntos(&tr->puntos[a], &tr->puntos[b]) < 2.0 * ri->longitudMinima) {
+            if (arista >= 0) marcarSubsegmento(tr, arista);
+            continue;
+        }
+
+        double x, y;
+        puntoDivision(ri, a, b, &x, &y);
+        // Si la arista existe, el punto está sobre ella; si no, se camina
+        // desde a (sólo en modo conforme, donde los segmentos no bloquean)
+        int bloqueo;
+        int contenedor = arista >= 0 ? arista / 3 : ubicarPunto(ri, ri->trianguloDePunto[a], x, y, &bloqueo);
+        int indice = contenedor >= 0 ? insertarPuntoCavidad(ri, x, y, contenedor, a, b) : -1;
+        if (indice < 0) {
+            // Punto repetido o cruce de segmentos: se deja como está
+            CONTAR_OPERACION(steinerCercanos, 1);
+            if (arista >= 0) marcarSubsegmento(tr, arista);
+            continue;
+        }
+        divisiones++;
+        etiquetarDivision(ri, indice, a, b);
+        CONTAR_OPERACION(subsegmentosDivididos, 1);
+        apilarSubsegmento(ri, a, indice);
+        apilarSubsegmento(ri, indice, b);
+    }
+    return divisiones;
 }
 
-void agregarTrianguloATriangulacion(struct Triangulacion *tr, struct Punto *v1, struct Punto *v2, struct Punto *v3) {
-    // Verificar que no sea un triángulo degenerado
-    double area = calcularAreaTriangulo2(v1, v2, v3);
-    if (fabs(area) < 1e-10) {
-        printf("Advertencia: Intento de agregar triángulo degenerado\n");
-        return;
+// Apila todos los subsegmentos de la malla (aristas restringidas y de borde)
+// y divide los invadidos. Devuelve el número de divisiones o -1 sin memoria.
+static int conformarSubsegmentos(struct Triangulacion *tr, int puntosEntrada, double lente) {
+    struct RefinamientoIncremental ri;
+    if (!iniciarRefinamientoIncremental(&ri, tr) || !indexarVertices(&ri)) {
+        liberarRefinamientoIncremental(&ri);
+        return -1;
+    }
+    ri.puntosEntrada = puntosEntrada;
+    ri.lente = lente;
+    if (lente > 0.0 && !etiquetarVerticesSegmento(&ri)) {
+        liberarRefinamientoIncremental(&ri);
+        return -1;
     }
-    
-    // Verificar que no exista ya el triángulo
     for (int i = 0; i < tr->numTriangulos; i++) {
         struct Triangulo *t = &tr->triangulos[i];
-        if ((t->vertices[0] == v1 && t->vertices[1] == v2 && t->vertices[2] == v3) ||
-            (t->vertices[0] == v2 && t->vertices[1] == v3 && t->vertices[2] == v1) ||
-            (t->vertices[0] == v3 && t->vertices[1] == v1 && t->vertices[2] == v2)) {
-            printf("Advertencia: Triángulo duplicado\n");
-            return;
+        for (int k = 0; k < 3; k++) {
+            if (!t->aristasRestringidas[k] && t->vecinos[k]) continue;
+            if (t->vecinos[k] && t->vecinos[k] < t) continue;
+            apilarSubsegmento(&ri, t->indices[k], t->indices[(k + 1) % 3]);
         }
     }
-    
-    // Agregar el triángulo
-    if (tr->numTriangulos < tr->maxTriangulos) {
-        tr->triangulos[tr->numTriangulos].vertices[0] = v1;
-        tr->triangulos[tr->numTriangulos].vertices[1] = v2;
-        tr->triangulos[tr->numTriangulos].vertices[2] = v3;
-        tr->triangulos[tr->numTriangulos].esTrianguloSuper = false;
-        tr->numTriangulos++;
-        printf("Triángulo agregado: (%d, %d, %d)\n", 
-               v1->indice, v2->indice, v3->indice);
-    }
+    int divisiones = dividirSubsegmentos(&ri);
+    liberarRefinamientoIncremental(&ri);
+    return divisiones;
 }
 
-void combinarTriangulaciones(struct Triangulacion *tr, int inicio, int medio, int fin) {
-    printf("Combinando submallas [%d-%d] y [%d-%d]\n", inicio, medio, medio+1, fin);
-    
-    struct Borde *baseInicial = encontrarBaseInicial(tr, medio);
-    if (!baseInicial) {
-        printf("ERROR: No se pudo encontrar la base inicial\n");
-        return;
-    }
-    
-    while (true) {
-        struct Punto *candidatoIzq = encontrarCandidatoIzquierda(tr, baseInicial);
-        struct Punto *candidatoDer = encontrarCandidatoDerecha(tr, baseInicial);
-        
-        if (!candidatoIzq && !candidatoDer) break;
-        
-        if (candidatoIzq && (!candidatoDer || esDelaunay(candidatoIzq, candidatoDer, baseInicial))) {
-            agregarTrianguloATriangulacion(tr, candidatoIzq, baseInicial->p1, baseInicial->p2);
-            baseInicial->p2 = candidatoIzq;
-        } else if (candidatoDer) {
-            agregarTrianguloATriangulacion(tr, candidatoDer, baseInicial->p1, baseInicial->p2);
-            baseInicial->p1 = candidatoDer;
-        }
+// Con calidad, el refinamiento y la división de subsegmentos se alternan
+// hasta que ninguna inserción invade un subsegmento
+int conformarYRefinar(struct Triangulacion *tr, int puntosEntrada, double anguloMinimo,
+                      double areaMaxima, int posicionSteiner, bool conforme) {
+    double lente = lenteDiametral(anguloMinimo, conforme);
+    TRAMO_INICIO(FASE_RESTRICCIONES);
+    int divisiones = conformarSubsegmentos(tr, puntosEntrada, lente);
+    TRAMO_FIN(FASE_RESTRICCIONES);
+    while (divisiones >= 0 && (anguloMinimo > 0.0 || areaMaxima < DBL_MAX)) {
+        refinarIncremental(tr, anguloMinimo, areaMaxima, posicionSteiner, conforme);
+        TRAMO_INICIO(FASE_RESTRICCIONES);
+        divisiones = conformarSubsegmentos(tr, puntosEntrada, lente);
+        TRAMO_FIN(FASE_RESTRICCIONES);
+        if (divisiones == 0) break;
     }
-    
-    free(baseInicial);
+    return divisiones >= 0;
 }
 
-int compararPuntosX(const void *a, const void *b) {
-    struct Punto *p1 = (struct Punto *)a;
-    struct Punto *p2 = (struct Punto *)b;
-    
-    if (p1->x < p2->x) return -1;
-    if (p1->x > p2->x) return 1;
-    return 0;
+// Vértice de la malla en la posición del vértice v: el propio v o, si era
+// un repetido que no se insertó, aquel con sus mismas coordenadas
+static int verticeInsertado(struct RefinamientoIncremental *ri, int v) {
+    if (ri->trianguloDePunto[v] >= 0) return v;
+    struct Triangulacion *tr = ri->tr;
+    int bloqueo;
+    int t = ubicarPunto(ri, 0, tr->puntos[v].x, tr->puntos[v].y, &bloqueo);
+    for (int k = 0; t >= 0 && k < 3; k++) {
+        int w = tr->triangulos[t].indices[k];
+        if (tr->puntos[w].x == tr->puntos[v].x && tr->puntos[w].y == tr->puntos[v].y) return w;
+    }
+    return v;
 }
 
-void divideVencerasDelaunay(struct Triangulacion *tr, int inicio, int fin) {
-    printf("Procesando segmento [%d, %d]\n", inicio, fin);
-    
-    // Caso base: 2 o 3 puntos
-    if (fin - inicio + 1 <= 3) {
-        if (fin - inicio + 1 == 3) {
-            struct Punto *p1 = &tr->puntos[inicio];
-            struct Punto *p2 = &tr->puntos[inicio + 1];
-            struct Punto *p3 = &tr->puntos[inicio + 2];
-            
-            double area = calcularAreaTriangulo2(p1, p2, p3);
-            if (fabs(area) > 1e-10 && !existeTriangulo(tr, p1, p2, p3)) {
-                if (orientacion(p1, p2, p3) > 0) {
-                    agregarTrianguloATriangulacion(tr, p1, p2, p3);
-                } else {
-                    agregarTrianguloATriangulacion(tr, p1, p3, p2);
-                }
+// Sin segmentos, las aristas de la envolvente convexa (cadena monótona)
+// delimitan el dominio
+static int apilarEnvolvente(struct RefinamientoIncremental *ri, int numPuntos) {
+    struct Punto *orden = malloc((size_t)numPuntos * sizeof(struct Punto));
+    int *casco = malloc(((size_t)2 * numPuntos + 1) * sizeof(int));
+    if (!orden || !casco) {
+        free(orden);
+        free(casco);
+        return 0;
+    }
+    // Los vértices repetidos que no se insertaron no forman parte de la malla
+    int numInsertados = 0;
+    for (int i = 0; i < numPuntos; i++) {
+        if (ri->trianguloDePunto[i] < 0) continue;
+        orden[numInsertados] = ri->tr->puntos[i];
+        orden[numInsertados++].indice = i;
+    }
+    numPuntos = numInsertados;
+    ordenarPuntosConRespaldo(orden, numPuntos, NULL);
+
+    int n = 0;
+    for (int pasada = 0; pasada < 2; pasada++) {
+        int base = n;
+        for (int j = 0; j < numPuntos; j++) {
+            struct Punto *p = &orden[pasada == 0 ? j : numPuntos - 1 - j];
+            while (n >= base + 2 && orientacion(&ri->tr->puntos[casco[n - 2]],
+                                                &ri->tr->puntos[casco[n - 1]], p) <= 0) {
+                n--;
             }
+            casco[n++] = p->indice;
         }
-        return;
+        n--;   // El último punto de una cadena es el primero de la otra
     }
-    
-    int medio = inicio + (fin - inicio) / 2;
-    
-    divideVencerasDelaunay(tr, inicio, medio);
-    divideVencerasDelaunay(tr, medio + 1, fin);
-    
-    combinarTriangulacionesOptimizado(tr, inicio, medio, fin);
+    for (int i = 0; i < n; i++) apilarSubsegmento(ri, casco[i], casco[(i + 1) % n]);
+    free(orden);
+    free(casco);
+    return n >= 3;
 }
 
-void combinarTriangulacionesOptimizado(struct Triangulacion *tr, int inicio, int medio, int fin) {
-    printf("Combinando submallas optimizado [%d-%d] y [%d-%d]\n", inicio, medio, medio+1, fin);
-    
-    // Crear un array para marcar puntos ya procesados
-    bool *procesado = calloc(tr->numPuntos, sizeof(bool));
-    if (!procesado) {
-        printf("Error: No se pudo asignar memoria para el array de procesados\n");
-        return;
+// Elimina los triángulos exteriores y los de los agujeros propagándose sin
+// cruzar subsegmentos, desde los que tocan el super-triángulo y desde cada
+// agujero. Luego compacta los arreglos y quita los vértices del
+// super-triángulo (posiciones puntosEntrada a puntosEntrada + 2).
+static int recortarDominio(struct RefinamientoIncremental *ri, struct EntradaPoly *entrada) {
+    struct Triangulacion *tr = ri->tr;
+    int primerSuper = ri->puntosEntrada;
+    char *eliminado = calloc((size_t)tr->numTriangulos + 1, 1);
+    int *pila = malloc(((size_t)tr->numTriangulos + 1) * sizeof(int));
+    int *nuevo = malloc(((size_t)tr->numTriangulos + 1) * sizeof(int));
+    if (!eliminado || !pila || !nuevo) {
+        free(eliminado);
+        free(pila);
+        free(nuevo);
+        return 0;
     }
-    
-    // Encontrar puntos extremos para la base inicial
-    struct Punto *p_izq = NULL, *p_der = NULL;
-    double x_min = INFINITY, x_max = -INFINITY;
-    
-    for (int i = inicio; i <= fin; i++) {
-        if (tr->puntos[i].x < x_min) {
-            x_min = tr->puntos[i].x;
-            p_izq = &tr->puntos[i];
+
+    int numPila = 0;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        for (int k = 0; k < 3; k++) {
+            int v = tr->triangulos[i].indices[k];
+            if (v >= primerSuper && v < primerSuper + 3 && !eliminado[i]) {
+                eliminado[i] = 1;
+                pila[numPila++] = i;
+            }
         }
-        if (tr->puntos[i].x > x_max) {
-            x_max = tr->puntos[i].x;
-            p_der = &tr->puntos[i];
+    }
+    for (int h = 0; h <= entrada->numAgujeros; h++) {
+        if (h > 0) {
+            // La semilla del agujero se busca cruzando segmentos
+            int bloqueo;
+            int t = ubicarPunto(ri, 0, entrada->agujeros[h - 1].x, entrada->agujeros[h - 1].y, &bloqueo);
+            if (t < 0 || eliminado[t]) continue;
+            eliminado[t] = 1;
+            pila[numPila++] = t;
+        }
+        while (numPila > 0) {
+            struct Triangulo *t = &tr->triangulos[pila[--numPila]];
+            for (int k = 0; k < 3; k++) {
+                int v = indiceTriangulo(tr, t->vecinos[k]);
+                if (v < 0 || eliminado[v] || t->aristasRestringidas[k]) continue;
+                eliminado[v] = 1;
+                pila[numPila++] = v;
+            }
         }
     }
-    
-    if (!p_izq || !p_der) {
-        free(procesado);
-        return;
+
+    // Compactar los triángulos: cada uno se mueve a una posición menor o igual
+    int numValidos = 0;
+    for (int i = 0; i < tr->numTriangulos; i++) nuevo[i] = eliminado[i] ? -1 : numValidos++;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        if (eliminado[i]) continue;
+        struct Triangulo t = tr->triangulos[i];
+        for (int k = 0; k < 3; k++) {
+            int v = indiceTriangulo(tr, t.vecinos[k]);
+            t.vecinos[k] = (v >= 0 && !eliminado[v]) ? &tr->triangulos[nuevo[v]] : NULL;
+            if (t.indices[k] >= primerSuper + 3) t.indices[k] -= 3;
+        }
+        tr->triangulos[nuevo[i]] = t;
     }
-    
-    // Procesar puntos
-    for (int i = inicio; i <= fin; i++) {
-        if (!procesado[i]) {
-            struct Punto *p_actual = &tr->puntos[i];
-            
-            // Buscar los dos puntos más cercanos ya procesados
-            struct Punto *p1 = NULL, *p2 = NULL;
-            double min_dist1 = INFINITY, min_dist2 = INFINITY;
-            
-            for (int j = inicio; j <= fin; j++) {
-                if (i != j && procesado[j]) {
-                    double dist = distanciaEntrePuntos(p_actual, &tr->puntos[j]);
-                    if (dist < min_dist1) {
-                        min_dist2 = min_dist1;
-                        p2 = p1;
-                        min_dist1 = dist;
-                        p1 = &tr->puntos[j];
-                    } else if (dist < min_dist2) {
-                        min_dist2 = dist;
-                        p2 = &tr->puntos[j];
-                    }
-                }
-            }
-            
-            if (p1 && p2) {
-                // Verificar orientación y criterio de Delaunay
-                if (orientacion(p1, p2, p_actual) > 0 && 
-                    !existeTriangulo(tr, p1, p2, p_actual)) {
-                    agregarTrianguloATriangulacion(tr, p1, p2, p_actual);
-                }
-            }
-            
-            procesado[i] = true;
+    tr->numTriangulos = numValidos;
+
+    // Quitar los vértices del super-triángulo
+    memmove(&tr->puntos[primerSuper], &tr->puntos[primerSuper + 3],
+            (size_t)(tr->numPuntos - primerSuper - 3) * sizeof(struct Punto));
+    tr->numPuntos -= 3;
+    for (int i = 0; i < tr->numPuntos; i++) tr->puntos[i].indice = i;
+    for (int i = 0; i < tr->numTriangulos; i++) {
+        for (int k = 0; k < 3; k++) {
+            tr->triangulos[i].vertices[k] = &tr->puntos[tr->triangulos[i].indices[k]];
+        }
+    }
+
+    free(eliminado);
+    free(pila);
+    free(nuevo);
+    return 1;
+}
+
+/* Barrido                                                                    */
+// Triangulación de Delaunay por barrido (Domiter y Žalik): los vértices se
+// recorren de abajo hacia arriba y cada uno se apoya en la arista del frente
+// de avance que tiene debajo. El frente es una lista ordenada por x entre los
+// dos vértices inferiores del super-triángulo; tras cada punto se rellenan los
+// huecos y cuencas que deja y las aristas que gana cada triángulo nuevo se
+// legalizan con intercambios de Lawson. Al final el frente se vuelve cóncavo y se cierra con
+// el vértice superior del super-triángulo, así que el resultado es el mismo
+// que el de la inserción incremental.
+
+struct NodoFrente {
+    int punto;
+    int anterior, siguiente;   // Vecinos en el frente, -1 en los extremos
+    int triangulo;             // Triángulo bajo la arista hacia el siguiente
+    bool vivo;
+};
+
+struct Barrido {
+    struct Triangulacion *tr;
+    struct NodoFrente *nodos;
+    int numNodos;
+    int *nodoDePunto;          // Nodo del frente de cada vértice, o -1
+    int *cubetas;              // Algún nodo con x en cada cubeta, para ubicar puntos
+    int numCubetas;
+    double xmin, anchoCubeta;
+    int *pila;                 // Aristas (triángulo, u, v) por legalizar
+    int numPila, capacidadPila;
+};
+
+static inline int cubetaBarrido(struct Barrido *b, double x) {
+    int c = (int)((x - b->xmin) / b->anchoCubeta);
+    return c < 0 ? 0 : (c >= b->numCubetas ? b->numCubetas - 1 : c);
+}
+
+static inline struct Punto *puntoNodo(struct Barrido *b, int nodo) {
+    return &b->tr->puntos[b->nodos[nodo].punto];
+}
+
+static int nuevoNodoFrente(struct Barrido *b, int punto, int anterior, int siguiente, int triangulo) {
+    int nodo = b->numNodos++;
+    b->nodos[nodo] = (struct NodoFrente){ punto, anterior, siguiente, triangulo, true };
+    if (anterior >= 0) b->nodos[anterior].siguiente = nodo;
+    if (siguiente >= 0) b->nodos[siguiente].anterior = nodo;
+    b->nodoDePunto[punto] = nodo;
+    b->cubetas[cubetaBarrido(b, b->tr->puntos[punto].x)] = nodo;
+    return nodo;
+}
+
+static void quitarNodoFrente(struct Barrido *b, int nodo) {
+    struct NodoFrente *v = &b->nodos[nodo];
+    b->nodos[v->anterior].siguiente = v->siguiente;
+    b->nodos[v->siguiente].anterior = v->anterior;
+    b->nodoDePunto[v->punto] = -1;
+    v->vivo = false;
+    int c = cubetaBarrido(b, b->tr->puntos[v->punto].x);
+    if (b->cubetas[c] == nodo) b->cubetas[c] = v->anterior;
+}
+
+// Nodo del frente con la mayor x <= x. Se parte de la cubeta de x; los nodos
+// ya quitados conservan su vecino izquierdo, que lleva de vuelta al frente.
+static int ubicarEnFrente(struct Barrido *b, double x) {
+    int nodo = b->cubetas[cubetaBarrido(b, x)];
+    while (!b->nodos[nodo].vivo) nodo = b->nodos[nodo].anterior;
+    while (b->nodos[nodo].anterior >= 0 && puntoNodo(b, nodo)->x > x) nodo = b->nodos[nodo].anterior;
+    while (b->nodos[nodo].siguiente >= 0 && puntoNodo(b, b->nodos[nodo].siguiente)->x <= x) {
+        nodo = b->nodos[nodo].siguiente;
+    }
+    return nodo;
+}
+
+static int nuevoTrianguloBarrido(struct Barrido *b, int v0, int v1, int v2) {
+    struct Triangulacion *tr = b->tr;
+    int t = tr->numTriangulos++;
+    struct Triangulo *nuevo = &tr->triangulos[t];
+    memset(nuevo, 0, sizeof(struct Triangulo));
+    nuevo->indices[0] = v0;
+    nuevo->indices[1] = v1;
+    nuevo->indices[2] = v2;
+    for (int k = 0; k < 3; k++) nuevo->vertices[k] = &tr->puntos[nuevo->indices[k]];
+    return t;
+}
+
+// Apunta hacia t la arista (v, u) de su vecino, gemela de la arista (u, v) de t
+static void reenlazarVecino(struct Triangulacion *tr, struct Triangulo *vecino, int u, int v, int t) {
+    if (!vecino) return;
+    for (int k = 0; k < 3; k++) {
+        if (vecino->indices[k] == v && vecino->indices[(k + 1) % 3] == u) {
+            vecino->vecinos[k] = &tr->triangulos[t];
+            return;
         }
     }
-    
-    free(procesado);
 }
 
-bool existeTriangulo(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2, struct Punto *p3) {
-    for (int i =0; i < tr->numTriangulos; i++) {
-        struct Triangulo *t = &tr->triangulos[i];
-        if ((t->vertices[0] == p1 && t->vertices[1] == p2 && t->vertices[2] == p3) ||
-            (t->vertices[0] == p2 && t->vertices[1] == p3 && t->vertices[2] == p1) ||
-            (t->vertices[0] == p3 && t->vertices[1] == p1 && t->vertices[2] == p2)) {
-            return true;
+// Une la arista k de t con el triángulo vecino (-1 para ninguno) en ambos sentidos
+static void enlazarBarrido(struct Barrido *b, int t, int k, int vecino) {
+    struct Triangulacion *tr = b->tr;
+    struct Triangulo *tt = &tr->triangulos[t];
+    tt->vecinos[k] = vecino >= 0 ? &tr->triangulos[vecino] : NULL;
+    if (vecino >= 0) reenlazarVecino(tr, tt->vecinos[k], tt->indices[k], tt->indices[(k + 1) % 3], t);
+}
+
+// Las aristas sin vecino de t que pertenecen al frente quedan a cargo de t. Una
+// arista del frente (izquierda u, derecha v) aparece como v -> u en el
+// triángulo que tiene debajo.
+static void actualizarFrente(struct Barrido *b, int t) {
+    struct Triangulo *tt = &b->tr->triangulos[t];
+    for (int k = 0; k < 3; k++) {
+        if (tt->vecinos[k]) continue;
+        int nodo = b->nodoDePunto[tt->indices[(k + 1) % 3]];
+        if (nodo >= 0 && b->nodos[nodo].siguiente >= 0 &&
+            b->nodos[b->nodos[nodo].siguiente].punto == tt->indices[k]) {
+            b->nodos[nodo].triangulo = t;
         }
     }
-    return false;
 }
 
-// Función principal que inicia el proceso
-struct Triangulacion* triangulacionDelaunay(struct Punto *puntos, int numPuntos, int numPuntosRegion1) {
-    printf("Iniciando triangulación de Delaunay...\n");
-    
-    // Ordenar puntos por coordenada x
-    qsort(puntos, numPuntos, sizeof(struct Punto), compararPuntosX);
-    
-    // Inicializar la triangulación
-    struct Triangulacion* tr = inicializarTriangulacion(puntos, numPuntos, numPuntosRegion1);
-    if (!tr) {
-        printf("Error al inicializar la triangulación\n");
-        return NULL;
+static int apilarArista(struct Barrido *b, int t, int u, int v) {
+    if (!asegurarCapacidad((void **)&b->pila, &b->capacidadPila, b->numPila + 3, sizeof(int))) return 0;
+    b->pila[b->numPila++] = t;
+    b->pila[b->numPila++] = u;
+    b->pila[b->numPila++] = v;
+    return 1;
+}
+
+// Intercambios de Lawson sobre las aristas apiladas: la arista (a, c) de t se
+// voltea si el vértice del otro lado cae claramente dentro del circuncírculo de
+// t, y las cuatro aristas del cuadrilátero se revisan a su vez. Los casos
+// cocirculares dentro del error de redondeo no se voltean, así que ninguna
+// arista puede ir y volver indefinidamente.
+static int legalizarBarrido(struct Barrido *b) {
+    struct Triangulacion *tr = b->tr;
+    while (b->numPila > 0) {
+        int c = b->pila[--b->numPila];
+        int a = b->pila[--b->numPila];
+        int t = b->pila[--b->numPila];
+        struct Triangulo *tt = &tr->triangulos[t];
+        int k = 0;
+        while (k < 3 && !(tt->indices[k] == a && tt->indices[(k + 1) % 3] == c)) k++;
+        if (k == 3) continue;   // Un intercambio posterior ya la movió y la apiló de nuevo
+
+        struct Triangulo *opuesto = tt->vecinos[k];
+        if (!opuesto) continue;
+        int j = 0;
+        while (j < 3 && (opuesto->indices[j] == a || opuesto->indices[j] == c)) j++;
+        int q = opuesto->indices[j];
+        double cota;
+        if (circunferenciaAntihoraria(tt, &tr->puntos[q], &cota) <= cota) continue;
+
+        // t = (p, a, c) y su vecino (c, a, q) pasan a ser (p, a, q) y (p, q, c)
+        int n = indiceTriangulo(tr, opuesto);
+        int p = tt->indices[(k + 2) % 3];
+        int vecinoA = indiceTriangulo(tr, tt->vecinos[(k + 2) % 3]);
+        int vecinoC = indiceTriangulo(tr, tt->vecinos[(k + 1) % 3]);
+        int vecinoAQ = indiceTriangulo(tr, opuesto->vecinos[(j + 2) % 3]);
+        int vecinoQC = indiceTriangulo(tr, opuesto->vecinos[j]);
+
+        int indicesT[3] = { p, a, q }, indicesN[3] = { p, q, c };
+        for (int m = 0; m < 3; m++) {
+            tt->indices[m] = indicesT[m];
+            tt->vertices[m] = &tr->puntos[indicesT[m]];
+            opuesto->indices[m] = indicesN[m];
+            opuesto->vertices[m] = &tr->puntos[indicesN[m]];
+        }
+        enlazarBarrido(b, t, 0, vecinoA);
+        enlazarBarrido(b, t, 1, vecinoAQ);
+        enlazarBarrido(b, t, 2, n);
+        enlazarBarrido(b, n, 1, vecinoQC);
+        enlazarBarrido(b, n, 2, vecinoC);
+        CONTAR_OPERACION(intercambios, 1);
+
+        actualizarFrente(b, t);
+        actualizarFrente(b, n);
+        if (!apilarArista(b, t, p, a) || !apilarArista(b, t, a, q) ||
+            !apilarArista(b, n, q, c) || !apilarArista(b, n, c, p)) {
+            return 0;
+        }
     }
-    
-    // Aplicar el algoritmo divide y vencerás
-    divideVencerasDelaunay(tr, 0, numPuntos - 1);
-    
-    // Refinar la malla
-    double anguloMinimo = 20.0 * M_PI / 180.0;  // 20 grados en radianes
-    double areaMaxima = calcularAreaMaximaPermitida(tr);
-    refinarMalla(tr, anguloMinimo, areaMaxima);
-    
-    printf("Triangulación completada.\n");
-    return tr;
+    return 1;
 }
 
+// Cubre con un triángulo el valle del frente en el nodo v (v queda por debajo
+// de la cuerda entre sus vecinos), lo quita del frente y legaliza las dos
+// aristas que el triángulo comparte
+static int rellenarValle(struct Barrido *b, int v) {
+    int u = b->nodos[v].anterior, w = b->nodos[v].siguiente;
+    int pu = b->nodos[u].punto, pv = b->nodos[v].punto, pw = b->nodos[w].punto;
+    int t = nuevoTrianguloBarrido(b, pu, pv, pw);
+    enlazarBarrido(b, t, 0, b->nodos[u].triangulo);
+    enlazarBarrido(b, t, 1, b->nodos[v].triangulo);
+    b->nodos[u].triangulo = t;
+    quitarNodoFrente(b, v);
+    return apilarArista(b, t, pu, pv) && apilarArista(b, t, pv, pw) && legalizarBarrido(b);
+}
 
-/* Funciones de refinamiento                                                   */
+static inline bool esValle(struct Barrido *b, int v) {
+    int u = b->nodos[v].anterior, w = b->nodos[v].siguiente;
+    return u >= 0 && w >= 0 && orientacion(puntoNodo(b, u), puntoNodo(b, v), puntoNodo(b, w)) > 0.0;
+}
 
-struct ColaRefinamiento* iniciarColaRefinamiento(int capacidad) {
-    // Asignar memoria para la estructura principal
-    struct ColaRefinamiento *cola = malloc(sizeof(struct ColaRefinamiento));
-    if (cola == NULL) {
-        printf("Error: No se pudo asignar memoria para la cola\n");
-        return NULL;
+// Valle con ángulo agudo: rellenarlo no deja triángulos planos
+static inline bool esHueco(struct Barrido *b, int v) {
+    if (!esValle(b, v)) return false;
+    struct Punto *pu = puntoNodo(b, b->nodos[v].anterior), *pv = puntoNodo(b, v);
+    struct Punto *pw = puntoNodo(b, b->nodos[v].siguiente);
+    return (pu->x - pv->x) * (pw->x - pv->x) + (pu->y - pv->y) * (pw->y - pv->y) > 0.0;
+}
+
+// Rellena los valles entre los nodos izquierdo y derecho hasta que el tramo
+// del frente queda cóncavo, como la envolvente de Graham
+static int rellenarTramo(struct Barrido *b, int izquierdo, int derecho) {
+    int v = b->nodos[izquierdo].siguiente;
+    while (v != derecho && v >= 0) {
+        int u = b->nodos[v].anterior, w = b->nodos[v].siguiente;
+        if (esValle(b, v)) {
+            if (!rellenarValle(b, v)) return 0;
+            v = (u != izquierdo) ? u : w;
+        } else {
+            v = w;
+        }
     }
-    
-    // Asignar memoria para los arreglos de triángulos y bordes
-    cola->triangulos = malloc(capacidad * sizeof(struct Triangulo*));
-    cola->bordes = malloc(capacidad * sizeof(struct Borde*));
-    
-    // Verificar asignación de memoria
-    if (cola->triangulos == NULL || cola->bordes == NULL) {
-        printf("Error: No se pudo asignar memoria para los arreglos\n");
-        free(cola);
-        return NULL;
+    return 1;
+}
+
+// Cuenca del frente junto al nodo (a la derecha si sentido > 0): baja y vuelve
+// a subir. Si es más honda que ancha se rellena entera; las llanas las cubren
+// los puntos siguientes. El recorrido se corta en cuanto la cuenca no puede
+// ser honda y a las b->numCubetas aristas, para que un frente largo y llano
+// (puntos sobre una curva) no se recorra en cada evento.
+static int rellenarCuenca(struct Barrido *b, int nodo, int sentido) {
+#define VECINO_FRENTE(v) (sentido > 0 ? b->nodos[v].siguiente : b->nodos[v].anterior)
+    struct Punto *origen = puntoNodo(b, nodo);
+    int fondo = VECINO_FRENTE(nodo);
+    if (fondo < 0 || puntoNodo(b, fondo)->y >= origen->y) return 1;
+    int pasos = b->numCubetas;
+    while (VECINO_FRENTE(fondo) >= 0 && puntoNodo(b, VECINO_FRENTE(fondo))->y < puntoNodo(b, fondo)->y) {
+        fondo = VECINO_FRENTE(fondo);
+        struct Punto *f = puntoNodo(b, fondo);
+        if (fabs(f->x - origen->x) > origen->y - f->y || --pasos == 0) return 1;
     }
-    
-    // Inicializar los contadores
-    cola->numTriangulos = 0;  // Número actual de triángulos en la cola
-    cola->numBordes = 0;      // Número actual de bordes en la cola
-    cola->capacidad = capacidad;  // Capacidad máxima de la cola
-    
-    return cola;
+    double alto = origen->y - puntoNodo(b, fondo)->y;
+    int borde = fondo;
+    while (VECINO_FRENTE(borde) >= 0 && puntoNodo(b, VECINO_FRENTE(borde))->y > puntoNodo(b, borde)->y &&
+           puntoNodo(b, borde)->y < origen->y) {
+        borde = VECINO_FRENTE(borde);
+        if (fabs(puntoNodo(b, borde)->x - origen->x) > alto || --pasos == 0) return 1;
+    }
+#undef VECINO_FRENTE
+    if (borde == fondo) return 1;
+
+    alto = fmin(origen->y, puntoNodo(b, borde)->y) - puntoNodo(b, fondo)->y;
+    double ancho = fabs(puntoNodo(b, borde)->x - origen->x);
+    if (alto < ancho) return 1;
+    return sentido > 0 ? rellenarTramo(b, nodo, borde) : rellenarTramo(b, borde, nodo);
 }
 
-void agregarPuntoATriangulacion(struct Triangulacion *tr, struct Punto *p) {
-    // Si necesitamos más espacio
-    if (tr->numPuntos >= tr->maxPuntos) {
-        int nuevaCapacidad = tr->maxPuntos * 2;
-        struct Punto *nuevosPuntos = realloc(tr->puntos, 
-                                            nuevaCapacidad * sizeof(struct Punto));
-        if (nuevosPuntos == NULL) {
-            printf("Error: No se pudo expandir el arreglo de puntos\n");
-            return;
+// Triangula los puntos 0..n-1 de ri->tr por barrido dentro del super-triángulo
+// formado por los puntos n (abajo a la izquierda), n + 1 (abajo a la derecha)
+// y n + 2 (arriba). Los vértices repetidos se omiten y se cuentan en
+// *repetidos. Devuelve 0 si falta memoria.
+static int triangularBarrido(struct RefinamientoIncremental *ri, int n, int *repetidos) {
+    struct Triangulacion *tr = ri->tr;
+    struct Barrido b;
+    memset(&b, 0, sizeof(b));
+    b.tr = tr;
+    *repetidos = 0;
+
+    // Orden por y y, a igual y, por x: el radix ordena por la primera coordenada
+    struct Punto *orden = malloc((size_t)n * sizeof(struct Punto));
+    b.nodos = malloc(((size_t)n + 3) * sizeof(struct NodoFrente));
+    b.nodoDePunto = malloc(((size_t)n + 3) * sizeof(int));
+    b.numCubetas = (int)sqrt((double)n) + 1;
+    b.cubetas = malloc((size_t)b.numCubetas * sizeof(int));
+    if (!orden || !b.nodos || !b.nodoDePunto || !b.cubetas) {
+        free(orden);
+        free(b.nodos);
+        free(b.nodoDePunto);
+        free(b.cubetas);
+        return 0;
+    }
+    double xmax = -DBL_MAX;
+    b.xmin = DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        orden[i].x = tr->puntos[i].y;
+        orden[i].y = tr->puntos[i].x;
+        orden[i].indice = i;
+        if (tr->puntos[i].x < b.xmin) b.xmin = tr->puntos[i].x;
+        if (tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
+    }
+    ordenarPuntosConRespaldo(orden, n, NULL);
+    b.anchoCubeta = (xmax - b.xmin) / b.numCubetas;
+    if (!(b.anchoCubeta > 0.0)) b.anchoCubeta = 1.0;
+    for (int i = 0; i < n + 3; i++) b.nodoDePunto[i] = -1;
+
+    // Primer triángulo: la base del super-triángulo y el punto más bajo
+    int izquierdo = n, derecho = n + 1, superior = n + 2;
+    tr->numTriangulos = 0;
+    int t0 = nuevoTrianguloBarrido(&b, izquierdo, derecho, orden[0].indice);
+    int nodoIzquierdo = nuevoNodoFrente(&b, izquierdo, -1, -1, t0);
+    int nodoDerecho = nuevoNodoFrente(&b, derecho, nodoIzquierdo, -1, -1);
+    nuevoNodoFrente(&b, orden[0].indice, nodoIzquierdo, nodoDerecho, t0);
+    for (int c = 0; c < b.numCubetas; c++) b.cubetas[c] = b.nodoDePunto[orden[0].indice];
+
+    int correcto = 1;
+    for (int i = 1; i < n && correcto; i++) {
+        int p = orden[i].indice;
+        if (orden[i].x == orden[i - 1].x && orden[i].y == orden[i - 1].y) {
+            (*repetidos)++;
+            continue;
         }
-        tr->puntos = nuevosPuntos;
-        tr->maxPuntos = nuevaCapacidad;
+
+        // Evento de punto: triángulo sobre la arista del frente que está debajo
+        int a = ubicarEnFrente(&b, tr->puntos[p].x);
+        int siguiente = b.nodos[a].siguiente;
+        int t = nuevoTrianguloBarrido(&b, b.nodos[a].punto, b.nodos[siguiente].punto, p);
+        enlazarBarrido(&b, t, 0, b.nodos[a].triangulo);
+        b.nodos[a].triangulo = t;
+        int nodo = nuevoNodoFrente(&b, p, a, siguiente, t);
+        correcto = apilarArista(&b, t, b.nodos[a].punto, b.nodos[siguiente].punto) && legalizarBarrido(&b);
+
+        // Huecos agudos a ambos lados y cuencas hondas a la derecha y a la izquierda
+        while (correcto && b.nodos[nodo].siguiente >= 0 && esHueco(&b, b.nodos[nodo].siguiente)) {
+            correcto = rellenarValle(&b, b.nodos[nodo].siguiente);
+        }
+        while (correcto && b.nodos[nodo].anterior >= 0 && esHueco(&b, b.nodos[nodo].anterior)) {
+            correcto = rellenarValle(&b, b.nodos[nodo].anterior);
+        }
+        if (correcto) correcto = rellenarCuenca(&b, nodo, 1) && rellenarCuenca(&b, nodo, -1);
     }
-    
-    // Agregar el nuevo punto
-    tr->puntos[tr->numPuntos] = *p;
-    tr->puntos[tr->numPuntos].indice = tr->numPuntos;
-    tr->numPuntos++;
-    
-    printf("Nuevo punto agregado en (%f, %f), índice %d\n", 
-           p->x, p->y, tr->numPuntos - 1);
+
+    // Cierre: frente cóncavo y abanico desde el vértice superior
+    if (correcto) correcto = rellenarTramo(&b, nodoIzquierdo, nodoDerecho);
+    int anterior = -1;
+    for (int v = nodoIzquierdo; correcto && v != nodoDerecho; v = b.nodos[v].siguiente) {
+        int w = b.nodos[v].siguiente;
+        int t = nuevoTrianguloBarrido(&b, b.nodos[v].punto, b.nodos[w].punto, superior);
+        enlazarBarrido(&b, t, 0, b.nodos[v].triangulo);
+        if (anterior >= 0) enlazarBarrido(&b, t, 2, anterior);
+        b.nodos[v].triangulo = t;
+        anterior = t;
+    }
+    for (int v = nodoIzquierdo; correcto && v != nodoDerecho; v = b.nodos[v].siguiente) {
+        correcto = apilarArista(&b, b.nodos[v].triangulo, b.nodos[v].punto, b.nodos[b.nodos[v].siguiente].punto);
+    }
+    if (correcto) correcto = legalizarBarrido(&b);
+
+    free(orden);
+    free(b.nodos);
+    free(b.nodoDePunto);
+    free(b.cubetas);
+    free(b.pila);
+    return correcto;
 }
 
-void liberarColaRefinamiento(struct ColaRefinamiento *cola) {
-    if(cola != NULL) {
-        free(cola->triangulos);
-        free(cola->bordes);
-        free(cola);
+/* Triangulación restringida                                                  */
+
+// Lado de la recta (a, b) en que está c: 1 a la izquierda, -1 a la derecha y
+// 0 si el redondeo no permite distinguirlo (como verticeSobreSubsegmento)
+static int ladoDeRecta(struct Punto *a, struct Punto *b, struct Punto *c) {
+    double izquierda = (b->x - a->x) * (c->y - a->y);
+    double derecha = (b->y - a->y) * (c->x - a->x);
+    if (fabs(izquierda - derecha) <= COTA_ERROR_ORIENTACION * (fabs(izquierda) + fabs(derecha))) return 0;
+    return izquierda > derecha ? 1 : -1;
+}
+
+// Intercambia la diagonal del cuadrilátero que forman la arista k del
+// triángulo indice y su vecino: (u, v, p) y (v, u, q) pasan a ser (u, q, p) y
+// (v, p, q), con la nueva diagonal (p, q) como arista 1 de los dos
+static void intercambiarArista(struct RefinamientoIncremental *ri, int indice, int k) {
+    struct Triangulacion *tr = ri->tr;
+    struct Triangulo *t = &tr->triangulos[indice];
+    struct Triangulo *o = t->vecinos[k];
+    int j = 0;
+    while (o->vecinos[j] != t) j++;
+    int u = t->indices[k], v = t->indices[(k + 1) % 3], p = t->indices[(k + 2) % 3];
+    int q = o->indices[(j + 2) % 3];
+    struct Triangulo *vecinoVP = t->vecinos[(k + 1) % 3], *vecinoPU = t->vecinos[(k + 2) % 3];
+    struct Triangulo *vecinoUQ = o->vecinos[(j + 1) % 3], *vecinoQV = o->vecinos[(j + 2) % 3];
+    int restringidaVP = t->aristasRestringidas[(k + 1) % 3], restringidaPU = t->aristasRestringidas[(k + 2) % 3];
+    int restringidaUQ = o->aristasRestringidas[(j + 1) % 3], restringidaQV = o->aristasRestringidas[(j + 2) % 3];
+
+    int nuevosT[3] = { u, q, p }, nuevosO[3] = { v, p, q };
+    for (int m = 0; m < 3; m++) {
+        t->indices[m] = nuevosT[m];
+        t->vertices[m] = &tr->puntos[nuevosT[m]];
+        o->indices[m] = nuevosO[m];
+        o->vertices[m] = &tr->puntos[nuevosO[m]];
     }
+    t->vecinos[0] = vecinoUQ;
+    t->vecinos[1] = o;
+    t->vecinos[2] = vecinoPU;
+    o->vecinos[0] = vecinoVP;
+    o->vecinos[1] = t;
+    o->vecinos[2] = vecinoQV;
+    t->aristasRestringidas[0] = restringidaUQ;
+    t->aristasRestringidas[1] = 0;
+    t->aristasRestringidas[2] = restringidaPU;
+    o->aristasRestringidas[0] = restringidaVP;
+    o->aristasRestringidas[1] = 0;
+    o->aristasRestringidas[2] = restringidaQV;
+    int io = indiceTriangulo(tr, o);
+    reenlazarVecino(tr, vecinoUQ, u, q, indice);
+    reenlazarVecino(tr, vecinoVP, v, p, io);
+
+    ri->trianguloDePunto[u] = ri->trianguloDePunto[p] = indice;
+    ri->trianguloDePunto[v] = ri->trianguloDePunto[q] = io;
+    CONTAR_OPERACION(intercambios, 1);
 }
 
-bool estaDentroDeLimites(struct Triangulacion *tr, struct Punto *p) {
-    int dentro = 0;
-    for (int i = 0; i < tr->numBordes; i++) {
-        struct Borde *b = tr->bordes[i];
-        if ((b->p1->y > p->y) != (b->p2->y > p->y) &&
-            p->x < (b->p2->x - b->p1->x) * (p->y - b->p1->y) / 
-                   (b->p2->y - b->p1->y) + b->p1->x) {
-            dentro = !dentro;
+// Agrega la arista (a, b) a una lista de trabajo
+static int agregarArista(struct Segmento **lista, int *num, int *capacidad, int a, int b) {
+    if (!asegurarCapacidad((void **)lista, capacidad, *num + 1, sizeof(struct Segmento))) return 0;
+    (*lista)[*num].v1 = a;
+    (*lista)[*num].v2 = b;
+    (*lista)[*num].marcador = 0;
+    (*num)++;
+    return 1;
+}
+
+// Legaliza (Lawson) las aristas de la lista y las que expone cada
+// intercambio, sin atravesar aristas restringidas. Devuelve 0 si falta memoria.
+static int legalizarRestringida(struct RefinamientoIncremental *ri, struct Segmento **lista, int *num,
+                                int *capacidad) {
+    struct Triangulacion *tr = ri->tr;
+    long long limite = 16LL * tr->numTriangulos;
+    while (*num > 0 && limite-- > 0) {
+        struct Segmento s = (*lista)[--*num];
+        int e = buscarArista(ri, s.v1, s.v2);
+        if (e < 0) continue;
+        struct Triangulo *t = &tr->triangulos[e / 3];
+        struct Triangulo *o = t->vecinos[e % 3];
+        if (!o || t->aristasRestringidas[e % 3]) continue;
+        int u = t->indices[e % 3], v = t->indices[(e % 3 + 1) % 3], p = t->indices[(e % 3 + 2) % 3];
+        int j = 0;
+        while (o->vecinos[j] != t) j++;
+        int q = o->indices[(j + 2) % 3];
+        double cota;
+        if (circunferenciaAntihoraria(t, &tr->puntos[q], &cota) <= cota) continue;
+        intercambiarArista(ri, e / 3, e % 3);
+        if (!agregarArista(lista, num, capacidad, u, q) || !agregarArista(lista, num, capacidad, q, v) ||
+            !agregarArista(lista, num, capacidad, v, p) || !agregarArista(lista, num, capacidad, p, u)) {
+            return 0;
         }
     }
-    return dentro;
+    *num = 0;
+    return 1;
 }
 
-bool hayPuntoCercano(struct Triangulacion *tr, struct Punto *p) {
-    const double DISTANCIA_MINIMA = 0.001;
-    
-    for (int i = 0; i < tr->numPuntos; i++) {
-        double dx = tr->puntos[i].x - p->x;
-        double dy = tr->puntos[i].y - p->y;
-        double dist = sqrt(dx*dx + dy*dy);
-        
-        if (dist < DISTANCIA_MINIMA) {
-            return true;
+// Divide la arista restringida k del triángulo indice con un punto nuevo en
+// (x, y): los dos triángulos que la comparten pasan a ser cuatro, las mitades
+// siguen restringidas y las cuatro aristas exteriores se legalizan. Devuelve
+// el índice del punto o -1 si falta memoria.
+static int dividirAristaRestringida(struct RefinamientoIncremental *ri, int indice, int k, double x, double y,
+                                    struct Segmento **lista, int *capacidad) {
+    struct Triangulacion *tr = ri->tr;
+    if (!asegurarCapacidadPuntos(tr, tr->numPuntos + 1) ||
+        !asegurarCapacidad((void **)&ri->trianguloDePunto, &ri->capacidadTrianguloDePunto,
+                           tr->numPuntos + 1, sizeof(int)) ||
+        !asegurarCapacidadTriangulos(ri, tr->numTriangulos + 2)) {
+        return -1;
+    }
+    int m = tr->numPuntos++;
+    tr->puntos[m].x = x;
+    tr->puntos[m].y = y;
+    tr->puntos[m].indice = m;
+
+    // t = (u, v, r) y o = (v, u, s) pasan a ser (u, m, r), (m, v, r),
+    // (m, u, s) y (v, m, s)
+    struct Triangulo *t = &tr->triangulos[indice];
+    struct Triangulo *o = t->vecinos[k];
+    int io = indiceTriangulo(tr, o);
+    int j = 0;
+    while (o->vecinos[j] != t) j++;
+    int u = t->indices[k], v = t->indices[(k + 1) % 3], r = t->indices[(k + 2) % 3];
+    int s = o->indices[(j + 2) % 3];
+    struct Triangulo *vecinoVR = t->vecinos[(k + 1) % 3], *vecinoRU = t->vecinos[(k + 2) % 3];
+    struct Triangulo *vecinoUS = o->vecinos[(j + 1) % 3], *vecinoSV = o->vecinos[(j + 2) % 3];
+    int restringidaVR = t->aristasRestringidas[(k + 1) % 3], restringidaRU = t->aristasRestringidas[(k + 2) % 3];
+    int restringidaUS = o->aristasRestringidas[(j + 1) % 3], restringidaSV = o->aristasRestringidas[(j + 2) % 3];
+
+    int it2 = tr->numTriangulos++, io2 = tr->numTriangulos++;
+    int indices[4][3] = { { u, m, r }, { m, v, r }, { m, u, s }, { v, m, s } };
+    int lugar[4] = { indice, it2, io, io2 };
+    for (int n = 0; n < 4; n++) {
+        struct Triangulo *nuevo = &tr->triangulos[lugar[n]];
+        memset(nuevo, 0, sizeof(struct Triangulo));
+        for (int l = 0; l < 3; l++) {
+            nuevo->indices[l] = indices[n][l];
+            nuevo->vertices[l] = &tr->puntos[indices[n][l]];
         }
+        nuevo->aristasRestringidas[0] = 1;
     }
-    return false;
+    struct Triangulo *t1 = &tr->triangulos[indice], *t2 = &tr->triangulos[it2];
+    struct Triangulo *o1 = &tr->triangulos[io], *o2 = &tr->triangulos[io2];
+    t1->vecinos[0] = o1;
+    t1->vecinos[1] = t2;
+    t1->vecinos[2] = vecinoRU;
+    t1->aristasRestringidas[2] = restringidaRU;
+    t2->vecinos[0] = o2;
+    t2->vecinos[1] = vecinoVR;
+    t2->vecinos[2] = t1;
+    t2->aristasRestringidas[1] = restringidaVR;
+    o1->vecinos[0] = t1;
+    o1->vecinos[1] = vecinoUS;
+    o1->vecinos[2] = o2;
+    o1->aristasRestringidas[1] = restringidaUS;
+    o2->vecinos[0] = t2;
+    o2->vecinos[1] = o1;
+    o2->vecinos[2] = vecinoSV;
+    o2->aristasRestringidas[2] = restringidaSV;
+    reenlazarVecino(tr, vecinoVR, v, r, it2);
+    reenlazarVecino(tr, vecinoSV, s, v, io2);
+
+    ri->trianguloDePunto[u] = ri->trianguloDePunto[r] = indice;
+    ri->trianguloDePunto[v] = it2;
+    ri->trianguloDePunto[s] = io;
+    ri->trianguloDePunto[m] = indice;
+    CONTAR_OPERACION(subsegmentosDivididos, 1);
+    CONTAR_OPERACION(steinerAceptados, 1);
+    TRAZA_CONTAR(CONTADOR_PUNTOS_STEINER, 1);
+
+    int num = 0;
+    if (!agregarArista(lista, &num, capacidad, r, u) || !agregarArista(lista, &num, capacidad, v, r) ||
+        !agregarArista(lista, &num, capacidad, u, s) || !agregarArista(lista, &num, capacidad, s, v) ||
+        !legalizarRestringida(ri, lista, &num, capacidad)) {
+        return -1;
+    }
+    return m;
 }
 
-double calcularAreaMaximaPermitida(struct Triangulacion *tr) {
-    double xmin = tr->puntos[0].x;
-    double xmax = tr->puntos[0].x;
-    double ymin = tr->puntos[0].y;
-    double ymax = tr->puntos[0].y;
-    
-    for (int i = 1; i < tr->numPuntos; i++) {
-        if (tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
-        if (tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
-        if (tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
-        if (tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+// Triángulo alrededor de a cuyo ángulo en a contiene la dirección hacia b. Si
+// un vecino de a está sobre el segmento lo devuelve en *intermedio.
+static int anguloHacia(struct RefinamientoIncremental *ri, int a, int b, int *intermedio) {
+    struct Triangulacion *tr = ri->tr;
+    struct Punto *pa = &tr->puntos[a], *pb = &tr->puntos[b];
+    double longitud2 = (pb->x - pa->x) * (pb->x - pa->x) + (pb->y - pa->y) * (pb->y - pa->y);
+    *intermedio = -1;
+    int inicio = ri->trianguloDePunto[a];
+    struct Triangulo *t = &tr->triangulos[inicio];
+    for (int pasos = 0; t && pasos < tr->numTriangulos; pasos++) {
+        int i = 0;
+        while (i < 3 && t->indices[i] != a) i++;
+        if (i == 3) return -1;
+        for (int m = 1; m <= 2; m++) {
+            struct Punto *pc = t->vertices[(i + m) % 3];
+            double proyeccion = (pc->x - pa->x) * (pb->x - pa->x) + (pc->y - pa->y) * (pb->y - pa->y);
+            if (ladoDeRecta(pa, pb, pc) == 0 && proyeccion > 0.0 && proyeccion <= longitud2) {
+                *intermedio = t->indices[(i + m) % 3];
+                return indiceTriangulo(tr, t);
+            }
+        }
+        if (ladoDeRecta(pa, pb, t->vertices[(i + 1) % 3]) < 0 && ladoDeRecta(pa, pb, t->vertices[(i + 2) % 3]) > 0) {
+            return indiceTriangulo(tr, t);
+        }
+        t = t->vecinos[(i + 2) % 3];
+        if (t == &tr->triangulos[inicio]) break;   // Vuelta completa
     }
-    
-    double areaTotal = (xmax - xmin) * (ymax - ymin);
-    return areaTotal * 0.01; // 1% del área total
+    return -1;
 }
 
-void refinarMalla(struct Triangulacion *tr, double anguloMinimo, double areaMaxima) {
-    printf("\n=== INICIO DEL REFINAMIENTO ===\n");
-    int puntosIniciales = tr->numPuntos;
-    int iteraciones = 0;
-    const int MAX_ITERACIONES = 100;
-    bool seAgregaronPuntos;
-    
-    do {
-        seAgregaronPuntos = false;
-        iteraciones++;
-        
-        // Lista temporal de puntos a agregar
-        struct Punto *nuevosPuntos = malloc(tr->numTriangulos * sizeof(struct Punto));
-        int numNuevosPuntos = 0;
-        
-        // Revisar cada triángulo
-        for (int i = 0; i < tr->numTriangulos; i++) {
-            struct Triangulo *t = &tr->triangulos[i];
-            if (t->esTrianguloSuper) continue;
-            
-            // Calcular ángulos del triángulo
-            double angulos[3];
-            calcularAngulos(t, angulos);
-            
-            // Verificar si necesita refinamiento
-            bool necesitaRefinar = false;
-            for (int j = 0; j < 3; j++) {
-                if (angulos[j] < anguloMinimo) {
-                    necesitaRefinar = true;
+// Inserta los segmentos de la pila como aristas restringidas sin agregar
+// vértices, salvo donde dos segmentos se cruzan. Las aristas que cruza cada
+// segmento se intercambian hasta que ninguna lo cruce (Sloan) y las aristas
+// nuevas se legalizan sin atravesar restricciones (Lawson), de modo que el
+// resultado es la triangulación de Delaunay restringida, como la de -p en
+// triangle.c. Un segmento que pasa por un vértice se inserta en dos tramos; uno
+// que cruza otro segmento se divide en el punto de cruce. Devuelve 0 si falta
+// memoria.
+static int insertarSegmentosRestringidos(struct RefinamientoIncremental *ri) {
+    struct Triangulacion *tr = ri->tr;
+    struct Segmento *cruces = NULL, *nuevas = NULL;
+    int capacidadCruces = 0, capacidadNuevas = 0;
+    int perdidos = 0, correcto = 1;
+
+    while (correcto && ri->numPila > 0) {
+        struct Segmento s = ri->pila[--ri->numPila];
+        int a = s.v1, b = s.v2;
+        if (a == b || ri->trianguloDePunto[a] < 0 || ri->trianguloDePunto[b] < 0) continue;
+
+        CONTAR_OPERACION(subsegmentosVerificados, 1);
+        int arista = buscarArista(ri, a, b);
+        if (arista >= 0) {
+            marcarSubsegmento(tr, arista);
+            continue;
+        }
+
+        // Recorrido de a hacia b anotando las aristas cruzadas; derecho e
+        // izquierdo son los extremos de la arista actual a cada lado de (a, b)
+        int intermedio;
+        int t = anguloHacia(ri, a, b, &intermedio);
+        if (t < 0) {
+            perdidos++;
+            continue;
+        }
+        if (intermedio >= 0) {
+            apilarSubsegmento(ri, intermedio, b);
+            apilarSubsegmento(ri, a, intermedio);
+            continue;
+        }
+        struct Punto *pa = &tr->puntos[a], *pb = &tr->puntos[b];
+        int i = 0;
+        while (tr->triangulos[t].indices[i] != a) i++;
+        int k = (i + 1) % 3;
+        int derecho = tr->triangulos[t].indices[k], izquierdo = tr->triangulos[t].indices[(k + 1) % 3];
+        int numCruces = 0, destino = -1, cruzaSegmento = 0;
+        for (int pasos = 0; destino < 0 && pasos <= tr->numTriangulos; pasos++) {
+            struct Triangulo *actual = &tr->triangulos[t];
+            struct Triangulo *o = actual->vecinos[k];
+            if (!o) break;
+            if (actual->aristasRestringidas[k]) {
+                cruzaSegmento = 1;
+                break;
+            }
+            if (!agregarArista(&cruces, &numCruces, &capacidadCruces, derecho, izquierdo)) {
+                correcto = 0;
+                break;
+            }
+            int j = 0;
+            while (o->vecinos[j] != actual) j++;
+            int q = o->indices[(j + 2) % 3];
+            int lado = q == b ? 0 : ladoDeRecta(pa, pb, o->vertices[(j + 2) % 3]);
+            t = indiceTriangulo(tr, o);
+            if (lado == 0) {
+                destino = q;
+            } else if (lado < 0) {
+                derecho = q;
+                k = (j + 2) % 3;
+            } else {
+                izquierdo = q;
+                k = (j + 1) % 3;
+            }
+        }
+        if (!correcto) break;
+        if (cruzaSegmento) {
+            // Cruce con otro segmento: ambos se dividen en la intersección o,
+            // si por redondeo cae sobre un extremo del otro, en ese extremo
+            struct Punto *pc = &tr->puntos[derecho], *pd = &tr->puntos[izquierdo];
+            double denominador = (pb->x - pa->x) * (pd->y - pc->y) - (pb->y - pa->y) * (pd->x - pc->x);
+            double r = ((pc->x - pa->x) * (pd->y - pc->y) - (pc->y - pa->y) * (pd->x - pc->x)) / denominador;
+            struct Punto cruce = { pa->x + r * (pb->x - pa->x), pa->y + r * (pb->y - pa->y), -1 };
+            int nuevo;
+            if (distanciaEntrePuntos(&cruce, pc) <= ri->longitudMinima) {
+                nuevo = derecho;
+            } else if (distanciaEntrePuntos(&cruce, pd) <= ri->longitudMinima) {
+                nuevo = izquierdo;
+            } else {
+                nuevo = dividirAristaRestringida(ri, t, k, cruce.x, cruce.y, &nuevas, &capacidadNuevas);
+                if (nuevo < 0) {
+                    correcto = 0;
                     break;
                 }
             }
-            
-            if (necesitaRefinar || calcularAreaTriangulo(t) > areaMaxima) {
-                struct Punto *circuncentro = calcularCircuncentro(t);
-                if (circuncentro && estaDentroDeLimites(tr, circuncentro) && 
-                    !hayPuntoCercano(tr, circuncentro)) {
-                    nuevosPuntos[numNuevosPuntos++] = *circuncentro;
-                    seAgregaronPuntos = true;
-                }
-                free(circuncentro);
+            apilarSubsegmento(ri, nuevo, b);
+            apilarSubsegmento(ri, a, nuevo);
+            continue;
+        }
+        if (destino < 0) {
+            perdidos++;
+            continue;
+        }
+        if (destino != b) apilarSubsegmento(ri, destino, b);
+        struct Punto *pdestino = &tr->puntos[destino];
+
+        // Intercambios: una arista cuyo cuadrilátero no es convexo vuelve al
+        // final de la cola hasta que otro intercambio lo haga convexo
+        int numNuevas = 0;
+        long long limite = 4LL * numCruces * numCruces + 64;
+        for (int cabeza = 0; correcto && cabeza < numCruces; cabeza++) {
+            int u = cruces[cabeza].v1, v = cruces[cabeza].v2;
+            int e = buscarArista(ri, u, v);
+            if (e < 0 || --limite < 0) break;
+            struct Triangulo *tu = &tr->triangulos[e / 3];
+            struct Triangulo *o = tu->vecinos[e % 3];
+            int p = tu->indices[(e % 3 + 2) % 3];
+            int j = 0;
+            while (o->vecinos[j] != tu) j++;
+            int q = o->indices[(j + 2) % 3];
+            double ladoU = orientacion(&tr->puntos[p], &tr->puntos[q], &tr->puntos[u]);
+            double ladoV = orientacion(&tr->puntos[p], &tr->puntos[q], &tr->puntos[v]);
+            if (!((ladoU > 0 && ladoV < 0) || (ladoU < 0 && ladoV > 0))) {
+                correcto = agregarArista(&cruces, &numCruces, &capacidadCruces, u, v);
+                continue;
             }
+            intercambiarArista(ri, e / 3, e % 3);
+            bool cruza = p != a && q != a && p != destino && q != destino &&
+                         ladoDeRecta(pa, pdestino, &tr->puntos[p]) * ladoDeRecta(pa, pdestino, &tr->puntos[q]) < 0;
+            correcto = cruza ? agregarArista(&cruces, &numCruces, &capacidadCruces, p, q)
+                             : agregarArista(&nuevas, &numNuevas, &capacidadNuevas, p, q);
         }
-        
-        // Agregar los nuevos puntos y retriangular
-        if (seAgregaronPuntos) {
-            for (int i =0; i < numNuevosPuntos; i++) {
-                if (tr->numPuntos < tr->maxPuntos) {
-                    tr->puntos[tr->numPuntos++] = nuevosPuntos[i];
-                    printf("Punto Steiner agregado: (%f, %f)\n", 
-                           nuevosPuntos[i].x, nuevosPuntos[i].y);
-                }
+        if (!correcto) break;
+        arista = buscarArista(ri, a, destino);
+        if (arista < 0) {
+            perdidos++;
+            continue;
+        }
+        marcarSubsegmento(tr, arista);
+        correcto = legalizarRestringida(ri, &nuevas, &numNuevas, &capacidadNuevas);
+    }
+    free(cruces);
+    free(nuevas);
+    if (perdidos > 0) TRAZA_AVISO("%d segmentos no se pudieron recuperar\n", perdidos);
+    return correcto;
+}
+
+// Triangulación con los motores incremental y de barrido: inserta los
+// vértices en un super-triángulo y los segmentos (o la envolvente convexa)
+// como aristas restringidas, recorta el dominio y, si se pidió calidad,
+// refina sin dejar subsegmentos invadidos. Con -D, en cambio, los
+// subsegmentos que faltan o están invadidos se dividen hasta que todos son
+// aristas de Delaunay (triangulación de Delaunay conforme).
+int mallarConforme(struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                   struct Triangulacion **resultado) {
+    *resultado = NULL;
+    int n = entrada->numVertices;
+
+    struct Triangulacion *tr = calloc(1, sizeof(struct Triangulacion));
+    if (!tr) {
+        TRAZA_ERROR("No se pudo asignar memoria para la triangulación\n");
+        return SALIDA_MEMORIA;
+    }
+    tr->maxPuntos = 2 * (n + 3);
+    tr->puntos = malloc((size_t)tr->maxPuntos * sizeof(struct Punto));
+    tr->maxTriangulos = 2 * tr->maxPuntos;
+    tr->triangulos = malloc((size_t)tr->maxTriangulos * sizeof(struct Triangulo));
+    if (!tr->puntos || !tr->triangulos) {
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para la triangulación\n");
+        return SALIDA_MEMORIA;
+    }
+    for (int i = 0; i < n; i++) {
+        tr->puntos[i].x = entrada->vertices[i].x;
+        tr->puntos[i].y = entrada->vertices[i].y;
+        tr->puntos[i].indice = i;
+    }
+    tr->numPuntos = n;
+    tr->numPuntosRegion1 = n;
+
+    struct RefinamientoIncremental ri;
+    if (!iniciarRefinamientoIncremental(&ri, tr)) {
+        liberarRefinamientoIncremental(&ri);
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para la triangulación\n");
+        return SALIDA_MEMORIA;
+    }
+    // Las búsquedas cruzan segmentos: -D los divide y recortarDominio ubica
+    // los agujeros a través de ellos
+    ri.conforme = true;
+    ri.puntosEntrada = n;
+
+    // Super-triángulo con las mismas proporciones que crearSuperTriangulo
+    double xmin = DBL_MAX, xmax = -DBL_MAX, ymin = DBL_MAX, ymax = -DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        if (tr->puntos[i].x < xmin) xmin = tr->puntos[i].x;
+        if (tr->puntos[i].x > xmax) xmax = tr->puntos[i].x;
+        if (tr->puntos[i].y < ymin) ymin = tr->puntos[i].y;
+        if (tr->puntos[i].y > ymax) ymax = tr->puntos[i].y;
+    }
+    double delta = fmax(xmax - xmin, ymax - ymin);
+    double cx = 0.5 * (xmin + xmax), cy = 0.5 * (ymin + ymax);
+    struct Punto super[3] = {
+        { cx - 20.0 * delta, cy - delta, n },
+        { cx + 20.0 * delta, cy - delta, n + 1 },
+        { cx, cy + 20.0 * delta, n + 2 },
+    };
+    struct Triangulo *t0 = &tr->triangulos[0];
+    memset(t0, 0, sizeof(struct Triangulo));
+    for (int k = 0; k < 3; k++) {
+        tr->puntos[n + k] = super[k];
+        t0->vertices[k] = &tr->puntos[n + k];
+        t0->indices[k] = n + k;
+    }
+    tr->numPuntos = n + 3;
+    tr->numTriangulos = 1;
+
+    double anguloMinimo = op->anguloMinimo > 0.0 ? op->anguloMinimo * M_PI / 180.0 : 0.0;
+    double areaMaxima = op->areaMaxima > 0.0 ? op->areaMaxima : DBL_MAX;
+    if (op->usarAreasRegion) {
+        for (int i = 0; i < entrada->numRegiones; i++) {
+            double a = entrada->regiones[i].areaMaxima;
+            if (a > 0.0 && a < areaMaxima) areaMaxima = a;
+        }
+    }
+    bool refinamiento = anguloMinimo > 0.0 || areaMaxima < DBL_MAX;
+
+    int codigo = SALIDA_EXITO;
+    int repetidos = 0;
+    TRAMO_INICIO(FASE_TRIANGULACION);
+    if (op->algoritmo == ALGORITMO_BARRIDO) {
+        // Barrido: arma de una vez la triangulación del super-triángulo
+        if (!triangularBarrido(&ri, n, &repetidos) || !indexarVertices(&ri)) codigo = SALIDA_MEMORIA;
+    } else {
+        // Inserción incremental de los vértices, cada búsqueda desde el anterior
+        if (!indexarVertices(&ri)) codigo = SALIDA_MEMORIA;
+        int ultimo = 0;
+        for (int i = 0; i < n && codigo == SALIDA_EXITO; i++) {
+            int bloqueo;
+            int contenedor = ubicarPunto(&ri, ultimo, tr->puntos[i].x, tr->puntos[i].y, &bloqueo);
+            if (contenedor < 0 || insertarVerticeCavidad(&ri, i, contenedor, -1, -1) <= 0) {
+                repetidos++;
+                continue;
             }
-            
-            // Retriangular desde cero con los nuevos puntos
-            divideVencerasDelaunay(tr, 0, tr->numPuntos - 1);
+            ultimo = ri.nuevos[0];
         }
-        
-        free(nuevosPuntos);
-        
-    } while (seAgregaronPuntos && iteraciones < MAX_ITERACIONES);
-    
-    printf("Refinamiento completado: %d puntos agregados en %d iteraciones\n",
-           tr->numPuntos - puntosIniciales, iteraciones);
+    }
+    TRAMO_FIN(FASE_TRIANGULACION);
+    if (repetidos > 0) TRAZA_AVISO("%d vértices repetidos no se insertaron\n", repetidos);
+
+    // Subsegmentos iniciales: los de la entrada o la envolvente convexa. Sólo
+    // -D los divide hasta que son aristas de Delaunay; si no, se insertan como
+    // aristas restringidas y la triangulación no gana vértices.
+    TRAMO_INICIO(FASE_RESTRICCIONES);
+    if (codigo == SALIDA_EXITO) {
+        int validos = 0;
+        for (int i = 0; i < entrada->numSegmentos; i++) {
+            int v1 = entrada->segmentos[i].v1, v2 = entrada->segmentos[i].v2;
+            if (v1 < 0 || v1 >= n || v2 < 0 || v2 >= n) continue;
+            // Un extremo repetido sin insertar dejaría un hueco en el borde
+            apilarSubsegmento(&ri, verticeInsertado(&ri, v1), verticeInsertado(&ri, v2));
+            validos++;
+        }
+        if (validos == 0 && !apilarEnvolvente(&ri, n)) {
+            TRAZA_ERROR("Los vértices son colineales\n");
+            codigo = SALIDA_TRIANGULACION;
+        }
+    }
+    if (codigo == SALIDA_EXITO) {
+        if (op->conforme) {
+            dividirSubsegmentos(&ri);
+        } else if (!insertarSegmentosRestringidos(&ri)) {
+            codigo = SALIDA_MEMORIA;
+        }
+        if (codigo == SALIDA_EXITO && !recortarDominio(&ri, entrada)) codigo = SALIDA_MEMORIA;
+    }
+    TRAMO_FIN(FASE_RESTRICCIONES);
+    liberarRefinamientoIncremental(&ri);
+
+    if (codigo == SALIDA_EXITO && tr->numTriangulos == 0) {
+        TRAZA_ERROR("La triangulación no produjo triángulos\n");
+        codigo = SALIDA_TRIANGULACION;
+    }
+    if (codigo == SALIDA_EXITO && (op->conforme || refinamiento)) {
+        if (!conformarYRefinar(tr, n, anguloMinimo, areaMaxima, op->posicionSteiner, op->conforme)) {
+            codigo = SALIDA_MEMORIA;
+        }
+    }
+    if (codigo != SALIDA_EXITO) {
+        if (codigo == SALIDA_MEMORIA) TRAZA_ERROR("No se pudo asignar memoria para la triangulación\n");
+        liberarTriangulacion(tr);
+        return codigo;
+    }
+
+    for (int i = 0; i < tr->numPuntos; i++) tr->puntos[i].indice = i;
+    if (!subsegmentosDeTriangulacion(tr, entrada)) {
+        liberarTriangulacion(tr);
+        TRAZA_ERROR("No se pudo asignar memoria para los segmentos\n");
+        return SALIDA_MEMORIA;
+    }
+
+    imprimirEstadisticas(tr);
+    if (verificarTriangulacion(tr) > 0) {
+        liberarTriangulacion(tr);
+        return SALIDA_TRIANGULACION;
+    }
+    *resultado = tr;
+    return SALIDA_EXITO;
 }
 
+
+/* Estadísticas y verificación                                                */
+
 void imprimirEstadisticas(struct Triangulacion *tr) {
-    printf("\nEstadísticas de la triangulación:\n");
-    printf("Número de puntos: %d\n", tr->numPuntos);
-    printf("Número de triángulos: %d\n", tr->numTriangulos);
-    printf("Número de bordes: %d\n", tr->numBordes);
+    TRAZA_INFO("\nEstadísticas de la triangulación:\n");
+    TRAZA_INFO("Número de puntos: %d\n", tr->numPuntos);
+    TRAZA_INFO("Número de triángulos: %d\n", tr->numTriangulos);
+    TRAZA_INFO("Número de bordes: %d\n", tr->numBordes);
 }
 
-void verificarTriangulacion(struct Triangulacion *tr) {
-    printf("\nVerificando triangulación...\n");
-    int triangulos_invalidos = 0;
-    
+// Comprueba que la malla sea una triangulación válida: vértices distintos,
+// orientación antihoraria con área no nula y vecindad simétrica, con cada
+// arista compartida recorrida en sentidos opuestos por sus dos triángulos.
+// Una arista con más de dos triángulos o dos triángulos superpuestos rompen
+// esa simetría. Devuelve el número de triángulos inválidos.
+int verificarTriangulacion(struct Triangulacion *tr) {
+    TRAZA_DETALLE("\nVerificando triangulación...\n");
+    int invalidos = 0;
+
     for (int i = 0; i < tr->numTriangulos; i++) {
-        // Verificar que los vértices sean distintos
-        if ((tr->triangulos[i].vertices[0] == tr->triangulos[i].vertices[1] ||
-            tr->triangulos[i].vertices[1] == tr->triangulos[i].vertices[2] ||
-            tr->triangulos[i].vertices[2] == tr->triangulos[i].vertices[0])) {
-            triangulos_invalidos++;
+        struct Triangulo *t = &tr->triangulos[i];
+        bool valido = t->vertices[0] != t->vertices[1] && t->vertices[1] != t->vertices[2] &&
+                      t->vertices[2] != t->vertices[0] &&
+                      orientacion(t->vertices[0], t->vertices[1], t->vertices[2]) > 0.0;
+        for (int k = 0; k < 3 && valido; k++) {
+            struct Triangulo *v = t->vecinos[k];
+            if (!v) continue;
+            if (v < tr->triangulos || v >= tr->triangulos + tr->numTriangulos) {
+                valido = false;
+                break;
+            }
+            int j = 0;
+            while (j < 3 && v->vecinos[j] != t) j++;
+            valido = j < 3 && v->vertices[j] == t->vertices[(k + 1) % 3] &&
+                     v->vertices[(j + 1) % 3] == t->vertices[k];
         }
+        if (!valido) invalidos++;
     }
-    
-    printf("Triángulos inválidos encontrados: %d\n", triangulos_invalidos);
+
+    if (invalidos > 0) {
+        TRAZA_ERROR("Triangulación inválida: %d triángulos degenerados, invertidos o superpuestos\n",
+                    invalidos);
+    } else {
+        TRAZA_DETALLE("Triangulación válida\n");
+    }
+    return invalidos;
 }
 
 
 /* Funciones de interacción con el usuario                                     */
+# ifndef DELAUNAY_LIBRERIA
 void info(){
     printf("\nInformacion sobre el programa:\n");
     printf("    -p  Triangula un grafo planar de lineas (.poly file).\n");
@@ -1938,12 +6908,14 @@ void info(){
     printf("    -q  Genera una malla de calidad. Se puede especificar un angulo minimo.\n");
     printf("    -a  Aplica una restriccion de area maxima a los triangulos.\n");
     printf("    -D  Conforme a Delaunay: todos los triangulos son verdaderamente Delaunay.\n");
+    printf("    -b: Convierte una malla .node/.ele al formato binario .bmesh\n");
+    printf("    -t: Convierte un archivo .bmesh a .node/.ele\n");
     printf("    -i: Muestra esta informacion\n");
     printf("    -s: Salir del programa\n");
+    printf("\nDesde la linea de comandos: delaunay -h\n");
     printf("\nPresione Enter para continuar...");
     getchar();
     getchar();
-    system("cls");
     return;
 }
 
@@ -1957,11 +6929,14 @@ void menu(){
     printf("\n");
     printf("-p [archivo.poly]: Generar triangulacion\n");
     printf("-r: Refinar malla\n");
+    printf("-b: Convertir .node/.ele a .bmesh\n");
+    printf("-t: Convertir .bmesh a .node/.ele\n");
     printf("-i: Mostrar informacion\n");
     printf("-s: Salir\n");
     printf("==================================================\n");
     printf("Ingrese un comando: ");
 }
+# endif
 
 // Agregar estas implementaciones
 double calcularAreaTriangulo2(struct Punto *p1, struct Punto *p2, struct Punto *p3) {
@@ -1970,8 +6945,10 @@ double calcularAreaTriangulo2(struct Punto *p1, struct Punto *p2, struct Punto *
 }
 
 struct Borde* crearBorde(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2) {
+    (void)tr;
     struct Borde *borde = malloc(sizeof(struct Borde));
     if (!borde) return NULL;
+    CONTAR_OPERACION(asignacionesMonton, 1);
     
     borde->p1 = p1;
     borde->p2 = p2;
@@ -1995,128 +6972,1165 @@ void agregarBorde(struct Triangulacion *tr, struct Punto *p1, struct Punto *p2)
     }
 }
 
-int main() {
-    char comando[100];
-    char nombreArchivo[100];
-    struct Triangulacion *tr = NULL;
-    struct EntradaPoly *entrada = NULL;
-    
-    do {
-        menu();
-        scanf("%s", comando);
-        
-        if (strcmp(comando, "-p") == 0) {
-            printf("Ingrese el nombre del archivo .poly: ");
-            scanf("%s", nombreArchivo);
-            
-            // Leer archivo .poly
-            entrada = leerArchivoPoly(nombreArchivo);
-            if (!entrada) {
-                printf("[ERROR] No se pudo procesar el archivo %s\n", nombreArchivo);
-                continue;
+/* Vértices repetidos                                                         */
+
+// Elimina los vértices repetidos o a distancia <= tolerancia de otro anterior
+// (tolerancia 0: solo coordenadas idénticas). Los vértices se agrupan en una
+// rejilla de celdas de lado >= tolerancia, guardada en una tabla hash, y cada
+// uno se compara solo con los sobrevivientes de las 3x3 celdas vecinas: tiempo
+// lineal esperado. Sobrevive el primero en el orden de la entrada; los
+// segmentos se redirigen a él y se descartan los que quedan de longitud nula.
+// La entrada se compacta en su lugar y se renumera en base 0. Devuelve el
+// número de vértices eliminados o -1 si falta memoria.
+int eliminarVerticesRepetidos(struct EntradaPoly *entrada, double tolerancia) {
+    int n = entrada->numVertices;
+    if (n < 2) return 0;
+    if (tolerancia < 0.0) tolerancia = 0.0;
+
+    double xmin = DBL_MAX, xmax = -DBL_MAX, ymin = DBL_MAX, ymax = -DBL_MAX;
+    int maxIndice = 0;
+    for (int i = 0; i < n; i++) {
+        const struct Punto *p = &entrada->vertices[i];
+        if (p->x < xmin) xmin = p->x;
+        if (p->x > xmax) xmax = p->x;
+        if (p->y < ymin) ymin = p->y;
+        if (p->y > ymax) ymax = p->y;
+        if (p->indice > maxIndice) maxIndice = p->indice;
+    }
+
+    // Alrededor de un vértice por celda, pero nunca menos que la tolerancia
+    double lado = fmax(xmax - xmin, ymax - ymin) / sqrt((double)n);
+    if (lado < tolerancia) lado = tolerancia;
+    if (!(lado > 0.0)) lado = 1.0;
+    double tolerancia2 = tolerancia * tolerancia;
+
+    size_t tamanoTabla = 16;
+    while (tamanoTabla < 2 * (size_t)n) tamanoTabla *= 2;
+    uint64_t *claves = malloc(tamanoTabla * sizeof(uint64_t));
+    int *primero = malloc(tamanoTabla * sizeof(int));   // Primer sobreviviente de la celda
+    int *siguiente = malloc((size_t)n * sizeof(int));   // Siguiente en la celda; -2 si se elimina
+    int *nuevo = malloc((size_t)n * sizeof(int));       // Posición tras compactar
+    int *posicion = malloc(((size_t)maxIndice + 1) * sizeof(int));
+    if (!claves || !primero || !siguiente || !nuevo || !posicion) {
+        free(claves);
+        free(primero);
+        free(siguiente);
+        free(nuevo);
+        free(posicion);
+        return -1;
+    }
+    memset(primero, 0xff, tamanoTabla * sizeof(int));
+
+#define CLAVE_CELDA(cx, cy) (((uint64_t)(uint32_t)(cx) << 32) | (uint32_t)(cy))
+    int numSobrevivientes = 0;
+    for (int i = 0; i < n; i++) {
+        const struct Punto *p = &entrada->vertices[i];
+        int cx = (int)((p->x - xmin) / lado), cy = (int)((p->y - ymin) / lado);
+
+        int representante = -1;
+        for (int dx = -1; dx <= 1 && representante < 0; dx++) {
+            for (int dy = -1; dy <= 1 && representante < 0; dy++) {
+                uint64_t clave = CLAVE_CELDA(cx + dx, cy + dy);
+                size_t h = mezclarFinal64(clave) & (tamanoTabla - 1);
+                while (primero[h] >= 0 && claves[h] != clave) h = (h + 1) & (tamanoTabla - 1);
+                for (int j = primero[h]; j >= 0; j = siguiente[j]) {
+                    double ex = entrada->vertices[j].x - p->x, ey = entrada->vertices[j].y - p->y;
+                    if (ex * ex + ey * ey <= tolerancia2) {
+                        representante = j;
+                        break;
+                    }
+                }
             }
+        }
+        if (representante >= 0) {
+            nuevo[i] = nuevo[representante];
+            siguiente[i] = -2;
+            continue;
+        }
 
-            // Inicializar la triangulación
-            tr = malloc(sizeof(struct Triangulacion));
-            if (!tr) {
-                printf("[ERROR] No se pudo asignar memoria para la triangulación\n");
-                liberarEntradaPoly(entrada);
-                continue;
+        uint64_t clave = CLAVE_CELDA(cx, cy);
+        size_t h = mezclarFinal64(clave) & (tamanoTabla - 1);
+        while (primero[h] >= 0 && claves[h] != clave) h = (h + 1) & (tamanoTabla - 1);
+        claves[h] = clave;
+        siguiente[i] = primero[h];
+        primero[h] = i;
+        nuevo[i] = numSobrevivientes++;
+    }
+#undef CLAVE_CELDA
+
+    int eliminados = n - numSobrevivientes;
+    if (eliminados > 0) {
+        // Los segmentos usan la numeración del archivo
+        for (int i = 0; i <= maxIndice; i++) posicion[i] = -1;
+        for (int i = 0; i < n; i++) {
+            if (entrada->vertices[i].indice >= 0) posicion[entrada->vertices[i].indice] = i;
+        }
+        int s = 0;
+        for (int i = 0; i < entrada->numSegmentos; i++) {
+            struct Segmento seg = entrada->segmentos[i];
+            if (seg.v1 >= 0 && seg.v1 <= maxIndice && posicion[seg.v1] >= 0) seg.v1 = nuevo[posicion[seg.v1]];
+            if (seg.v2 >= 0 && seg.v2 <= maxIndice && posicion[seg.v2] >= 0) seg.v2 = nuevo[posicion[seg.v2]];
+            if (seg.v1 == seg.v2) continue;
+            entrada->segmentos[s] = seg;
+            if (entrada->marcadoresSegmentos) entrada->marcadoresSegmentos[s] = entrada->marcadoresSegmentos[i];
+            s++;
+        }
+        entrada->numSegmentos = s;
+
+        // Compactar vértices, atributos y marcadores; nuevo[i] <= i
+        for (int i = 0; i < n; i++) {
+            int j = nuevo[i];
+            if (siguiente[i] == -2 || j == i) continue;
+            entrada->vertices[j] = entrada->vertices[i];
+            if (entrada->marcadores) entrada->marcadores[j] = entrada->marcadores[i];
+            for (int k = 0; k < entrada->numAtributos; k++) {
+                entrada->atributos[(size_t)j * entrada->numAtributos + k] =
+                    entrada->atributos[(size_t)i * entrada->numAtributos + k];
             }
+        }
+        entrada->numVertices = numSobrevivientes;
+        for (int i = 0; i < numSobrevivientes; i++) entrada->vertices[i].indice = i;
+    }
 
-            // Configurar la triangulación
-            tr->maxPuntos = entrada->numVertices;
-            tr->numPuntos = entrada->numVertices;
-            tr->puntos = malloc(tr->maxPuntos * sizeof(struct Punto));
-            tr->maxTriangulos = 2 * tr->maxPuntos;
-            tr->triangulos = malloc(tr->maxTriangulos * sizeof(struct Triangulo));
-            tr->numTriangulos = 0;
-            tr->maxBordes = 3 * tr->maxPuntos;
-            tr->bordes = malloc(tr->maxBordes * sizeof(struct Borde*));
-            tr->numBordes = 0;
+    free(claves);
+    free(primero);
+    free(siguiente);
+    free(nuevo);
+    free(posicion);
+    return eliminados;
+}
 
-            if (!tr->puntos || !tr->triangulos || !tr->bordes) {
-                printf("[ERROR] No se pudo asignar memoria para las estructuras\n");
-                liberarTriangulacion(tr);
+/* Elección automática del motor                                              */
+
+// Perfil de la entrada, medido sobre una muestra de vértices repartida a lo
+// largo del arreglo
+struct PerfilEntrada {
+    int numVertices;
+    double aspecto;             // Lado mayor / lado menor de la caja envolvente
+    double ocupacion;           // Fracción de celdas ocupadas de una rejilla con
+                                // tantas celdas como muestras
+    double dispersion;          // Varianza / media de muestras por celda: ~1 al
+                                // azar, ~0 en retícula, >> 1 agrupados
+    double densidadSegmentos;   // Segmentos por vértice
+    double recorrido;           // Distancia media entre vértices consecutivos de
+                                // la entrada, en espaciados medios
+};
+
+static const char *nombresAlgoritmos[] = { "divide y vencerás", "incremental", "barrido" };
+
+static void perfilarEntrada(const struct EntradaPoly *entrada, struct PerfilEntrada *perfil) {
+    int n = entrada->numVertices;
+    const struct Punto *v = entrada->vertices;
+    int m = n < MUESTRAS_PERFIL ? n : MUESTRAS_PERFIL;
+    memset(perfil, 0, sizeof(*perfil));
+    perfil->numVertices = n;
+    perfil->densidadSegmentos = n > 0 ? (double)entrada->numSegmentos / n : 0.0;
+    if (m < 2) return;
+
+    double xmin = DBL_MAX, xmax = -DBL_MAX, ymin = DBL_MAX, ymax = -DBL_MAX;
+    for (int k = 0; k < m; k++) {
+        const struct Punto *p = &v[(int64_t)n * k / m];
+        xmin = fmin(xmin, p->x);
+        xmax = fmax(xmax, p->x);
+        ymin = fmin(ymin, p->y);
+        ymax = fmax(ymax, p->y);
+    }
+    double ancho = xmax - xmin, alto = ymax - ymin;
+    if (!(ancho > 0.0) || !(alto > 0.0)) {
+        perfil->aspecto = INFINITY;   // Colineales en un eje
+        return;
+    }
+    perfil->aspecto = fmax(ancho, alto) / fmin(ancho, alto);
+
+    // Rejilla con la proporción de la caja, unas m celdas
+    int columnas = (int)fmin(fmax(sqrt(m * ancho / alto), 1.0), m);
+    int filas = (int)fmin(fmax((double)m / columnas, 1.0), m);
+    int *celdas = calloc((size_t)columnas * filas, sizeof(int));
+    double espaciado = sqrt(ancho * alto / n);
+    double suma = 0.0;
+    for (int k = 0; k < m; k++) {
+        int i = (int)((int64_t)n * k / m);
+        if (celdas) {
+            int c = (int)fmin((v[i].x - xmin) / ancho * columnas, columnas - 1);
+            int f = (int)fmin((v[i].y - ymin) / alto * filas, filas - 1);
+            celdas[(size_t)f * columnas + c]++;
+        }
+        if (i + 1 < n) suma += hypot(v[i + 1].x - v[i].x, v[i + 1].y - v[i].y);
+    }
+    perfil->recorrido = suma / m / espaciado;
+    if (!celdas) return;
+
+    double media = (double)m / ((double)columnas * filas), varianza = 0.0;
+    int ocupadas = 0;
+    for (size_t c = 0; c < (size_t)columnas * filas; c++) {
+        ocupadas += celdas[c] > 0;
+        varianza += (celdas[c] - media) * (celdas[c] - media);
+    }
+    varianza /= (double)columnas * filas;
+    perfil->ocupacion = (double)ocupadas / ((double)columnas * filas);
+    perfil->dispersion = varianza / media;
+    free(celdas);
+}
+
+// Elige el motor de la triangulación inicial y, si no se fijaron, los hilos,
+// según el perfil de la entrada. Las reglas salen de bench -a sobre sus
+// generadores:
+// - Solo compiten los motores cuya malla pasa las columnas de validez de
+//   bench -c (Delaunay, sin aristas superpuestas ni segmentos perdidos): el
+//   incremental y el barrido, que recuperan los segmentos dividiéndolos.
+//   Divide y vencerás pierde segmentos y triángulos y nunca se elige.
+// - Con muchos segmentos, o con los puntos sobre curvas y en el orden en que
+//   las recorren, la inserción incremental camina poco y sus cavidades son
+//   chicas, mientras que el barrido intercambia mucho a lo largo de las
+//   curvas: el incremental gana por 2 a 5 veces.
+// - En el resto (al azar, agrupados, retículas) el barrido es de 4 a 40 veces
+//   más rápido, porque el incremental camina lejos o arrastra abanicos largos.
+// - El orden radix del barrido solo usa varios hilos desde
+//   PUNTOS_MINIMOS_ORDEN_PARALELO puntos; el incremental es secuencial.
+static void elegirAlgoritmo(const struct EntradaPoly *entrada, struct OpcionesDelaunay *op) {
+    struct PerfilEntrada perfil;
+    perfilarEntrada(entrada, &perfil);
+    TRAZA_DETALLE("Perfil de la entrada: %d vértices, aspecto %.3g, ocupación %.2f, dispersión %.2f, "
+                  "%.2f segmentos por vértice, recorrido %.3g\n",
+                  perfil.numVertices, perfil.aspecto, perfil.ocupacion, perfil.dispersion,
+                  perfil.densidadSegmentos, perfil.recorrido);
+
+    const char *motivo;
+    if (perfil.densidadSegmentos >= DENSIDAD_SEGMENTOS_ALTA) {
+        op->algoritmo = ALGORITMO_INCREMENTAL;
+        motivo = "los vértices siguen los segmentos";
+    } else if (perfil.ocupacion < OCUPACION_CURVAS && perfil.recorrido < RECORRIDO_ORDENADO) {
+        op->algoritmo = ALGORITMO_INCREMENTAL;
+        motivo = "los puntos están sobre curvas y en orden";
+    } else {
+        op->algoritmo = ALGORITMO_BARRIDO;
+        motivo = perfil.dispersion > 2.0 ? "puntos agrupados sin orden" :
+                 perfil.dispersion < 0.5 ? "puntos regulares" : "puntos repartidos al azar";
+    }
+
+    int hilos = op->hilos;
+#ifdef _OPENMP
+    if (hilos <= 0) {
+        bool paralelo = op->algoritmo != ALGORITMO_INCREMENTAL &&
+                        perfil.numVertices >= PUNTOS_MINIMOS_ORDEN_PARALELO;
+        hilos = paralelo ? omp_get_num_procs() : 1;
+        op->hilos = hilos;
+    }
+#else
+    hilos = 1;
+#endif
+    TRAZA_INFO("Algoritmo automático: %s con %d hilo%s (%s)\n", nombresAlgoritmos[op->algoritmo],
+               hilos, hilos == 1 ? "" : "s", motivo);
+}
+
+/* Núcleo del mallado                                                         */
+
+// Triangula la entrada y aplica restricciones y refinamiento. Lo usan la
+// línea de comandos y la librería; no lee ni escribe archivos.
+int mallarEntrada(struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                  struct Triangulacion **resultado) {
+    *resultado = NULL;
+    reiniciarContadoresOperacion();
+    avisarAnguloMinimo(op);
+
+    // Los vértices repetidos solo producen triángulos degenerados
+    if (op->eliminarRepetidos) {
+        int eliminados = eliminarVerticesRepetidos(entrada, op->toleranciaRepetidos);
+        if (eliminados < 0) {
+            TRAZA_ERROR("No se pudo asignar memoria para eliminar vértices repetidos\n");
+            return SALIDA_MEMORIA;
+        }
+        CONTAR_OPERACION(verticesRepetidos, eliminados);
+        if (eliminados > 0) {
+            TRAZA_INFO("Vértices repetidos eliminados: %d (quedan %d)\n", eliminados, entrada->numVertices);
+        }
+    }
+
+    if (entrada->numVertices < 3) {
+        TRAZA_ERROR("Se necesitan al menos 3 vértices (hay %d)\n", entrada->numVertices);
+        return SALIDA_ENTRADA;
+    }
+
+    // El modo automático decide sobre la entrada ya depurada
+    struct OpcionesDelaunay elegidas;
+    if (op->algoritmo == ALGORITMO_AUTOMATICO) {
+        elegidas = *op;
+        elegirAlgoritmo(entrada, &elegidas);
+        op = &elegidas;
+    }
+#ifdef _OPENMP
+    if (op->hilos > 0) omp_set_num_threads(op->hilos);
+#endif
+
+    // Los motores incremental y de barrido insertan los segmentos como aristas
+    // restringidas y sólo los dividen con -D. La calidad y el área se refinan
+    // siempre sobre esa malla (conformarYRefinar): divide y vencerás no la
+    // construye, así que con -q o -a se cambia al incremental.
+    bool refinamiento = op->anguloMinimo > 0.0 || op->areaMaxima > 0.0 || op->usarAreasRegion;
+    if (op->conforme || refinamiento || op->algoritmo != ALGORITMO_DIVIDE_Y_VENCERAS) {
+        if (refinamiento && op->algoritmo == ALGORITMO_DIVIDE_Y_VENCERAS) {
+            TRAZA_AVISO("El refinamiento usa la triangulación inicial incremental\n");
+        }
+        return mallarConforme(entrada, op, resultado);
+    }
+
+    // Inicializar la triangulación
+    struct Triangulacion *tr = calloc(1, sizeof(struct Triangulacion));
+    if (!tr) {
+        TRAZA_ERROR("No se pudo asignar memoria para la triangulación\n");
+        return SALIDA_MEMORIA;
+    }
+
+    tr->numPuntos = entrada->numVertices;
+    tr->maxPuntos = entrada->numVertices;
+    tr->numPuntosRegion1 = entrada->numVertices;
+    tr->puntos = malloc(tr->maxPuntos * sizeof(struct Punto));
+    tr->maxTriangulos = 2 * tr->maxPuntos;
+    tr->triangulos = malloc(tr->maxTriangulos * sizeof(struct Triangulo));
+    tr->maxBordes = 3 * tr->maxPuntos;
+    tr->bordes = malloc(tr->maxBordes * sizeof(struct Borde*));
+
+    if (!tr->puntos || !tr->triangulos || !tr->bordes) {
+        TRAZA_ERROR("No se pudo asignar memoria para las estructuras\n");
+        liberarTriangulacion(tr);
+        return SALIDA_MEMORIA;
+    }
+
+    // Copiar puntos de la entrada
+    for (int i = 0; i < entrada->numVertices; i++) {
+        tr->puntos[i].x = entrada->vertices[i].x;
+        tr->puntos[i].y = entrada->vertices[i].y;
+        tr->puntos[i].indice = i;
+    }
+
+    // Realizar la triangulación usando divide y vencerás
+    TRAZA_INFO("\nIniciando triangulación de Delaunay...\n");
+    triangular(tr);  // Esta función ya ordena los puntos y aplica divide y vencerás
+    if (tr->numTriangulos == 0) {
+        TRAZA_ERROR("La triangulación no produjo triángulos\n");
+        liberarTriangulacion(tr);
+        return SALIDA_TRIANGULACION;
+    }
+
+    // Agregar restricciones de bordes
+    if (entrada->numSegmentos > 0) {
+        TRAZA_INFO("\nAgregando restricciones de bordes...\n");
+        TRAMO_INICIO(FASE_RESTRICCIONES);
+        for (int i = 0; i < entrada->numSegmentos; i++) {
+            insertarSegmentoRestriccion(tr, &entrada->segmentos[i]);
+        }
+        TRAMO_FIN(FASE_RESTRICCIONES);
+        TRAZA_INFO("Restricciones de bordes completadas.\n");
+    }
+
+    // Actualizar estructura final
+    TRAMO_INICIO(FASE_VECINOS);
+    actualizarVecinos(tr);
+    TRAMO_FIN(FASE_VECINOS);
+
+    imprimirEstadisticas(tr);
+    if (verificarTriangulacion(tr) > 0) {
+        liberarTriangulacion(tr);
+        return SALIDA_TRIANGULACION;
+    }
+
+    *resultado = tr;
+    return SALIDA_EXITO;
+}
+
+
+/* Interfaz de librería (delaunay.h)                                           */
+
+struct ContextoDelaunay {
+    char ultimoError[TAMANO_MENSAJE_ERROR];
+    struct ContadoresOperacion contadores;   // De la última llamada
+    char contadoresJSON[TAMANO_JSON_CONTADORES];
+};
+
+ContextoDelaunay *delaunayCrearContexto(void) {
+    return calloc(1, sizeof(struct ContextoDelaunay));
+}
+
+void delaunayDestruirContexto(ContextoDelaunay *ctx) {
+    free(ctx);
+}
+
+void delaunayOpcionesPorDefecto(struct OpcionesDelaunay *op) {
+    memset(op, 0, sizeof(struct OpcionesDelaunay));
+    op->calcularVecinos = 1;
+    op->nivelDetalle = NIVEL_SILENCIOSO;
+    op->posicionSteiner = STEINER_TRIANGLE;
+    op->algoritmo = ALGORITMO_BARRIDO;
+}
+
+const char *delaunayUltimoError(const ContextoDelaunay *ctx) {
+    return ctx->ultimoError;
+}
+
+const char *delaunayContadoresJSON(ContextoDelaunay *ctx) {
+    formatearContadoresJSON(&ctx->contadores, ctx->contadoresJSON, sizeof(ctx->contadoresJSON));
+    return ctx->contadoresJSON;
+}
+
+void delaunayLiberarES(struct DelaunayES *es) {
+    free(es->listaPuntos);
+    free(es->listaMarcadoresPuntos);
+    free(es->listaTriangulos);
+    free(es->listaVecinos);
+    free(es->listaSegmentos);
+    free(es->listaMarcadoresSegmentos);
+    free(es->listaAgujeros);
+    free(es->listaRegiones);
+    memset(es, 0, sizeof(struct DelaunayES));
+}
+
+// Copia los arreglos del llamador a una EntradaPoly propia, validando índices
+static int entradaDesdeES(const struct DelaunayES *es, struct EntradaPoly **resultado) {
+    *resultado = NULL;
+    if (es->numPuntos < 3 || !es->listaPuntos) {
+        TRAZA_ERROR("Se necesitan al menos 3 puntos (hay %d)\n", es->numPuntos);
+        return SALIDA_ENTRADA;
+    }
+    if ((es->numSegmentos > 0 && !es->listaSegmentos) ||
+        (es->numAgujeros > 0 && !es->listaAgujeros) ||
+        (es->numRegiones > 0 && !es->listaRegiones)) {
+        TRAZA_ERROR("Hay un arreglo de entrada nulo con elementos declarados\n");
+        return SALIDA_ENTRADA;
+    }
+
+    struct EntradaPoly *entrada = calloc(1, sizeof(struct EntradaPoly));
+    if (!entrada) return SALIDA_MEMORIA;
+
+    entrada->numVertices = es->numPuntos;
+    entrada->numMarcadores = es->listaMarcadoresPuntos ? 1 : 0;
+    entrada->vertices = malloc((size_t)es->numPuntos * sizeof(struct Punto));
+    if (entrada->numMarcadores) {
+        entrada->marcadores = malloc((size_t)es->numPuntos * sizeof(int));
+    }
+    if (!entrada->vertices || (entrada->numMarcadores && !entrada->marcadores)) {
+        liberarEntradaPoly(entrada);
+        return SALIDA_MEMORIA;
+    }
+    for (int i = 0; i < es->numPuntos; i++) {
+        double x = es->listaPuntos[2 * i], y = es->listaPuntos[2 * i + 1];
+        if (!isfinite(x) || !isfinite(y)) {
+            TRAZA_ERROR("El punto %d tiene coordenadas no finitas\n", i);
+            liberarEntradaPoly(entrada);
+            return SALIDA_ENTRADA;
+        }
+        entrada->vertices[i].x = x;
+        entrada->vertices[i].y = y;
+        entrada->vertices[i].indice = i;
+        if (entrada->numMarcadores) entrada->marcadores[i] = es->listaMarcadoresPuntos[i];
+    }
+
+    if (es->numSegmentos > 0) {
+        entrada->numSegmentos = es->numSegmentos;
+        entrada->segmentos = malloc((size_t)es->numSegmentos * sizeof(struct Segmento));
+        if (!entrada->segmentos) {
+            liberarEntradaPoly(entrada);
+            return SALIDA_MEMORIA;
+        }
+        for (int i = 0; i < es->numSegmentos; i++) {
+            int v1 = es->listaSegmentos[2 * i], v2 = es->listaSegmentos[2 * i + 1];
+            if (v1 < 0 || v1 >= es->numPuntos || v2 < 0 || v2 >= es->numPuntos) {
+                TRAZA_ERROR("El segmento %d referencia un vértice inexistente\n", i);
                 liberarEntradaPoly(entrada);
-                continue;
+                return SALIDA_ENTRADA;
             }
+            entrada->segmentos[i].v1 = v1;
+            entrada->segmentos[i].v2 = v2;
+            entrada->segmentos[i].marcador =
+                es->listaMarcadoresSegmentos ? es->listaMarcadoresSegmentos[i] : 0;
+        }
+    }
+
+    if (es->numAgujeros > 0) {
+        entrada->numAgujeros = es->numAgujeros;
+        entrada->agujeros = malloc((size_t)es->numAgujeros * sizeof(struct Punto));
+        if (!entrada->agujeros) {
+            liberarEntradaPoly(entrada);
+            return SALIDA_MEMORIA;
+        }
+        for (int i = 0; i < es->numAgujeros; i++) {
+            entrada->agujeros[i].x = es->listaAgujeros[2 * i];
+            entrada->agujeros[i].y = es->listaAgujeros[2 * i + 1];
+            entrada->agujeros[i].indice = i;
+        }
+    }
+
+    if (es->numRegiones > 0) {
+        entrada->numRegiones = es->numRegiones;
+        entrada->regiones = malloc((size_t)es->numRegiones * sizeof(struct Region));
+        if (!entrada->regiones) {
+            liberarEntradaPoly(entrada);
+            return SALIDA_MEMORIA;
+        }
+        for (int i = 0; i < es->numRegiones; i++) {
+            entrada->regiones[i].x = es->listaRegiones[4 * i];
+            entrada->regiones[i].y = es->listaRegiones[4 * i + 1];
+            entrada->regiones[i].atributo = (int)es->listaRegiones[4 * i + 2];
+            entrada->regiones[i].areaMaxima = es->listaRegiones[4 * i + 3];
+        }
+    }
+
+    *resultado = entrada;
+    return SALIDA_EXITO;
+}
+
+// Copia un arreglo int32_t de la malla a uno int del llamador
+static int *copiarEnteros(const int32_t *origen, size_t n) {
+    if (!origen || n == 0) return NULL;
+    int *destino = malloc(n * sizeof(int));
+    if (destino) {
+        for (size_t i = 0; i < n; i++) destino[i] = origen[i];
+    }
+    return destino;
+}
+
+// Malla tal como la entrega la librería: la misma numeración que .node/.ele y
+// los marcadores del llamador en los vértices originales (0 en los Steiner)
+static int mallaParaLibreria(struct Triangulacion *tr, struct EntradaPoly *entrada,
+                             struct MallaBinaria *malla) {
+    if (!mallaDesdeTriangulacion(tr, entrada, malla)) {
+        TRAZA_ERROR("No se pudo asignar memoria para la salida\n");
+        return SALIDA_MEMORIA;
+    }
+    for (int i = 0; i < malla->numPuntos; i++) {
+        bool esOriginal = i < entrada->numVertices;
+        malla->marcadoresPuntos[i] = (esOriginal && entrada->marcadores) ? entrada->marcadores[i] : 0;
+    }
+    return SALIDA_EXITO;
+}
+
+// Copia una malla (propia o proyectada desde la caché) a los arreglos de salida
+static int salidaDesdeMalla(const struct MallaBinaria *malla, const struct OpcionesDelaunay *op,
+                            struct DelaunayES *salida) {
+    memset(salida, 0, sizeof(struct DelaunayES));
+    salida->numPuntos = malla->numPuntos;
+    salida->listaPuntos = malloc((size_t)malla->numPuntos * 2 * sizeof(double) + 1);
+    salida->listaMarcadoresPuntos = copiarEnteros(malla->marcadoresPuntos, (size_t)malla->numPuntos);
+    salida->numTriangulos = malla->numTriangulos;
+    salida->listaTriangulos = copiarEnteros(malla->triangulos, 3 * (size_t)malla->numTriangulos);
+    if (op->calcularVecinos) {
+        salida->listaVecinos = copiarEnteros(malla->vecinos, 3 * (size_t)malla->numTriangulos);
+    }
+    salida->numSegmentos = malla->numSegmentos;
+    salida->listaSegmentos = copiarEnteros(malla->segmentos, 2 * (size_t)malla->numSegmentos);
+    salida->listaMarcadoresSegmentos = copiarEnteros(malla->marcadoresSegmentos,
+                                                     (size_t)malla->numSegmentos);
+
+    bool faltaMemoria = !salida->listaPuntos ||
+        (malla->numPuntos > 0 && !salida->listaMarcadoresPuntos) ||
+        (malla->numTriangulos > 0 && !salida->listaTriangulos) ||
+        (op->calcularVecinos && malla->numTriangulos > 0 && !salida->listaVecinos) ||
+        (malla->numSegmentos > 0 && (!salida->listaSegmentos || !salida->listaMarcadoresSegmentos));
+    if (faltaMemoria) {
+        delaunayLiberarES(salida);
+        TRAZA_ERROR("No se pudo asignar memoria para la salida\n");
+        return SALIDA_MEMORIA;
+    }
+    if (malla->numPuntos > 0) {
+        memcpy(salida->listaPuntos, malla->puntos, (size_t)malla->numPuntos * 2 * sizeof(double));
+    }
+    return SALIDA_EXITO;
+}
+
+static uint64_t bytesCache(double megabytes) {
+    return (uint64_t)((megabytes > 0.0 ? megabytes : MEGABYTES_CACHE_DEFECTO) * 1048576.0);
+}
+
+// Triangula (o toma de la caché) y llena la salida
+static int triangularEntrada(struct EntradaPoly *entrada, const struct OpcionesDelaunay *op,
+                             struct DelaunayES *salida) {
+    struct ClaveCache clave;
+    struct MallaBinaria malla;
+    if (op->directorioCache) {
+        claveCache(entrada, op, DESTINO_CACHE_LIBRERIA, &clave);
+        if (buscarEnCache(op->directorioCache, &clave, &malla)) {
+            reiniciarContadoresOperacion();
+            CONTAR_OPERACION(aciertosCache, 1);
+            int resultado = salidaDesdeMalla(&malla, op, salida);
+            cerrarArchivoBMesh(&malla);
+            return resultado;
+        }
+    }
+
+    struct Triangulacion *tr;
+    int resultado = mallarEntrada(entrada, op, &tr);
+    if (resultado != SALIDA_EXITO) return resultado;
+    resultado = mallaParaLibreria(tr, entrada, &malla);
+    liberarTriangulacion(tr);
+    if (resultado != SALIDA_EXITO) return resultado;
+
+    if (op->directorioCache) {
+        CONTAR_OPERACION(fallosCache, 1);
+        guardarEnCache(op->directorioCache, bytesCache(op->megabytesCache), &clave, &malla);
+    }
+    resultado = salidaDesdeMalla(&malla, op, salida);
+    liberarMallaBinaria(&malla);
+    return resultado;
+}
+
+int delaunayTriangular(ContextoDelaunay *ctx, const struct OpcionesDelaunay *op,
+                       const struct DelaunayES *entradaES, struct DelaunayES *salida) {
+    // El nivel de detalle y el destino de los errores son locales al hilo:
+    // se fijan durante la llamada y se restauran al terminar
+    int nivelAnterior = nivelDetalle;
+    char *errorAnterior = mensajeError;
+    nivelDetalle = op->nivelDetalle;
+    mensajeError = ctx->ultimoError;
+    ctx->ultimoError[0] = '\0';
+
+    memset(salida, 0, sizeof(struct DelaunayES));
+
+    struct EntradaPoly *entrada;
+    int resultado = entradaDesdeES(entradaES, &entrada);
+    if (resultado == SALIDA_EXITO) {
+        resultado = triangularEntrada(entrada, op, salida);
+        liberarEntradaPoly(entrada);
+    }
+    ctx->contadores = contadoresOperacion;
+    if (resultado == SALIDA_MEMORIA && ctx->ultimoError[0] == '\0') {
+        snprintf(ctx->ultimoError, sizeof(ctx->ultimoError), "Memoria insuficiente");
+    }
+
+    nivelDetalle = nivelAnterior;
+    mensajeError = errorAnterior;
+    return resultado;
+}
 
-            // Copiar puntos del archivo .poly
-            for (int i = 0; i < entrada->numVertices; i++) {
-                tr->puntos[i].x = entrada->vertices[i].x;
-                tr->puntos[i].y = entrada->vertices[i].y;
-                tr->puntos[i].indice = i;
-            }
 
-            // Realizar la triangulación usando divide y vencerás
-            printf("\nIniciando triangulación de Delaunay...\n");
-            triangular(tr);  // Esta función ya ordena los puntos y aplica divide y vencerás
-            printf("Triangulación básica completada.\n");
+# ifndef DELAUNAY_LIBRERIA
+/* Funciones de la línea de comandos                                          */
+
+void opcionesPorDefecto(struct OpcionesMalla *op) {
+    memset(op, 0, sizeof(struct OpcionesMalla));
+    op->anguloMinimo = ANGULO_MINIMO_DEFECTO;
+    op->posicionSteiner = STEINER_TRIANGLE;
+    op->algoritmo = ALGORITMO_BARRIDO;
+    op->areaMaxima = -1.0;
+    op->hilos = 0;
+    op->nivelDetalle = NIVEL_NORMAL;
+    op->escribirNode = true;
+    op->escribirEle = true;
+    op->numerarIteracion = true;
+}
+
+// Lee el número que sigue a un switch (por ejemplo el 30 de -q30) y deja
+// el índice en el último carácter consumido
+static bool leerNumeroSwitch(const char *arg, int *j, double *valor) {
+    const char *inicio = &arg[*j + 1];
+    if (!((*inicio >= '0' && *inicio <= '9') || *inicio == '.')) {
+        return false;
+    }
+    char *fin;
+    *valor = strtod(inicio, &fin);
+    *j += (int)(fin - inicio);
+    return true;
+}
 
-            // Agregar restricciones de bordes
-            printf("\nAgregando restricciones de bordes...\n");
-            for (int i = 0; i < entrada->numSegmentos; i++) {
-                insertarSegmentoRestriccion(tr, &entrada->segmentos[i]);
+void uso(void) {
+    printf("Uso: delaunay [-prqaDdtiFAjVQNEnbKkh] archivo\n");
+    printf("    -p       Triangula un grafo planar de lineas (archivo .poly).\n");
+    printf("    -r       Refina una malla previamente generada (.node/.ele o .bmesh).\n");
+    printf("    -q<ang>  Malla de calidad con angulo minimo en grados (defecto %g;\n", ANGULO_MINIMO_DEFECTO);
+    printf("             por encima de %g puede no terminar).\n", ANGULO_MINIMO_TERMINACION);
+    printf("    -a<area> Area maxima por triangulo; sin valor usa las areas por region.\n");
+    printf("    -D       Conforme a Delaunay: divide los segmentos hasta que todos los\n");
+    printf("             triangulos son Delaunay (sin -D, Delaunay restringida).\n");
+    printf("    -d<tol>  Elimina los vertices repetidos o a distancia <= tol de otro\n");
+    printf("             (sin valor, solo coordenadas identicas).\n");
+    printf("    -t<n>    Puntos Steiner: 0 circuncentro, 1 fuera de centro (Ungor),\n");
+    printf("             2 fuera de centro de triangle.c (defecto).\n");
+    printf("    -i -F    Triangulacion inicial incremental / por barrido (defecto); los\n");
+    printf("             segmentos se insertan intercambiando aristas, como con -p.\n");
+    printf("    -A       Elige la triangulacion inicial y los hilos segun la entrada.\n");
+    printf("    -j<n>    Numero de hilos.\n");
+    printf("    -V       Mas detalle en los mensajes (repetible). -Q: silencioso.\n");
+    printf("    -N -E    No escribir el .node / el .ele.\n");
+    printf("    -n       Escribir los vecinos (.neigh).\n");
+    printf("    -b       Escribir la malla binaria (.bmesh).\n");
+    printf("    -K       Escribir los contadores de operaciones (.contadores.json).\n");
+    printf("    -k<MB>   Reusar mallas guardadas en $DELAUNAY_CACHE (defecto %s,\n", DIRECTORIO_CACHE_DEFECTO);
+    printf("             limite %g MB).\n", MEGABYTES_CACHE_DEFECTO);
+    printf("    -h       Muestra esta ayuda.\n");
+    printf("Sin argumentos se inicia el menu interactivo.\n");
+    printf("Codigos de salida: 0 exito, 1 uso, 2 entrada, 3 memoria,\n");
+    printf("                   4 triangulacion, 5 escritura, 6 no soportado.\n");
+}
+
+// Interpreta los argumentos al estilo de triangle.c: los switches pueden ir
+// juntos ("-pq30a0.5") o separados; el primer argumento sin '-' es el archivo
+int analizarArgumentos(int argc, char **argv, struct OpcionesMalla *op) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-') {
+            if (op->archivoEntrada) {
+                TRAZA_ERROR("Se indicó más de un archivo de entrada: %s\n", arg);
+                return SALIDA_USO;
             }
-            printf("Restricciones de bordes completadas.\n");
+            op->archivoEntrada = arg;
+            continue;
+        }
 
-            // Actualizar estructura final
-            actualizarVecinos(tr);
-            
-            imprimirEstadisticas(tr);
-            verificarTriangulacion(tr);
+        for (int j = 1; arg[j] != '\0'; j++) {
+            double valor;
+            switch (arg[j]) {
+            case 'p':
+                op->leerPoly = true;
+                break;
+            case 'r':
+                op->refinar = true;
+                break;
+            case 'q':
+                op->calidad = true;
+                if (leerNumeroSwitch(arg, &j, &valor)) {
+                    if (valor <= 0.0 || valor >= 60.0) {
+                        TRAZA_ERROR("Ángulo mínimo fuera de rango (0, 60): %g\n", valor);
+                        return SALIDA_USO;
+                    }
+                    op->anguloMinimo = valor;
+                }
+                break;
+            case 'a':
+                op->restringirArea = true;
+                if (leerNumeroSwitch(arg, &j, &valor)) {
+                    if (valor <= 0.0) {
+                        TRAZA_ERROR("El área máxima debe ser positiva: %g\n", valor);
+                        return SALIDA_USO;
+                    }
+                    op->areaMaxima = valor;
+                }
+                break;
+            case 'D':
+                op->conforme = true;
+                break;
+            case 'd':
+                op->eliminarRepetidos = true;
+                if (leerNumeroSwitch(arg, &j, &valor)) {
+                    if (valor < 0.0) {
+                        TRAZA_ERROR("La tolerancia de -d no puede ser negativa: %g\n", valor);
+                        return SALIDA_USO;
+                    }
+                    op->toleranciaRepetidos = valor;
+                }
+                break;
+            case 't':   // No -o: en triangle.c -o2 pide elementos de segundo orden
+                if (!leerNumeroSwitch(arg, &j, &valor) ||
+                    (valor != STEINER_CIRCUNCENTRO && valor != STEINER_FUERA_CENTRO &&
+                     valor != STEINER_TRIANGLE)) {
+                    TRAZA_ERROR("-t requiere 0 (circuncentro), 1 (Üngör) o 2 (triangle.c)\n");
+                    return SALIDA_USO;
+                }
+                op->posicionSteiner = (int)valor;
+                break;
+            case 'i':
+                op->algoritmo = ALGORITMO_INCREMENTAL;
+                break;
+            case 'F':
+                op->algoritmo = ALGORITMO_BARRIDO;
+                break;
+            case 'A':
+                op->algoritmo = ALGORITMO_AUTOMATICO;
+                break;
+            case 'j':
+                if (!leerNumeroSwitch(arg, &j, &valor) || valor < 1.0) {
+                    TRAZA_ERROR("-j requiere un número de hilos positivo\n");
+                    return SALIDA_USO;
+                }
+                op->hilos = (int)valor;
+                break;
+            case 'V':
+                if (op->nivelDetalle < NIVEL_DEPURACION) op->nivelDetalle++;
+                break;
+            case 'Q':
+                op->nivelDetalle = NIVEL_ERROR;
+                break;
+            case 'N':
+                op->escribirNode = false;
+                break;
+            case 'E':
+                op->escribirEle = false;
+                break;
+            case 'n':
+                op->escribirVecinos = true;
+                break;
+            case 'b':
+                op->escribirBMesh = true;
+                break;
+            case 'K':
+                op->escribirContadores = true;
+                break;
+            case 'k':
+                op->usarCache = true;
+                if (leerNumeroSwitch(arg, &j, &valor)) {
+                    if (valor <= 0.0) {
+                        TRAZA_ERROR("El tamaño de la caché debe ser positivo: %g MB\n", valor);
+                        return SALIDA_USO;
+                    }
+                    op->megabytesCache = valor;
+                }
+                break;
+            case 'h':
+                op->ayuda = true;
+                break;
+            default:
+                TRAZA_ERROR("Switch desconocido: -%c\n", arg[j]);
+                return SALIDA_USO;
+            }
+        }
+    }
 
-            // Generar archivos de salida
-            char nombreSalida[256];
-            strcpy(nombreSalida, nombreArchivo);
-            nombreSalida[strlen(nombreSalida) - 5] = '\0'; // Quitar '.poly'
-            
-            char archivoNode[256], archivoEle[256];
-            sprintf(archivoNode, "%s.node", nombreSalida);
-            sprintf(archivoEle, "%s.ele", nombreSalida);
-            
-            guardarArchivoNode(tr, archivoNode);
-            guardarArchivoEle(tr, archivoEle);
+    if (!op->ayuda && !op->archivoEntrada) {
+        TRAZA_ERROR("Falta el archivo de entrada\n");
+        return SALIDA_USO;
+    }
+    return SALIDA_EXITO;
+}
 
-            printf("\nArchivos generados exitosamente:\n");
-            printf("- %s\n", archivoNode);
-            printf("- %s\n", archivoEle);
+static bool terminaEn(const char *texto, const char *sufijo) {
+    size_t longitud = strlen(texto), longSufijo = strlen(sufijo);
+    return longitud > longSufijo && strcmp(texto + longitud - longSufijo, sufijo) == 0;
+}
 
-            // Liberar memoria
-            liberarTriangulacion(tr);
+// Separa el nombre de entrada en base y extensión y arma el nombre base de
+// salida. Con numeración de iteraciones (como triangle.c) "a.poly" produce
+// "a.1" y "a.1.node" (o "a.1.bmesh") refinado produce "a.2"; sin ella la
+// salida es "a".
+static void construirNombres(const struct OpcionesMalla *op, char *archivoEntrada,
+                             size_t tamEntrada, char *baseSalida, size_t tamSalida) {
+    const char *extension = op->refinar ? ".node" : (op->leerPoly ? ".poly" : ".node");
+    if (op->refinar && terminaEn(op->archivoEntrada, ".bmesh")) extension = ".bmesh";
+    char base[FILENAME_MAX];
+    snprintf(base, sizeof(base), "%s", op->archivoEntrada);
+
+    if (terminaEn(base, extension)) base[strlen(base) - strlen(extension)] = '\0';
+    snprintf(archivoEntrada, tamEntrada, "%s%s", base, extension);
+
+    if (!op->numerarIteracion) {
+        snprintf(baseSalida, tamSalida, "%s", base);
+        return;
+    }
+
+    // Número de iteración al final del nombre base ("a.1" -> 1)
+    int iteracion = 0;
+    char *punto = strrchr(base, '.');
+    if (punto && punto[1] != '\0' && strspn(punto + 1, "0123456789") == strlen(punto + 1)) {
+        iteracion = atoi(punto + 1);
+        *punto = '\0';
+    }
+    snprintf(baseSalida, tamSalida, "%s.%d", base, iteracion + 1);
+}
+
+// Lee la malla de -r desde un .bmesh, sin pasar por el texto: los vértices,
+// segmentos, agujeros y regiones forman la entrada (numerada desde 0) y los
+// triángulos se copian a elementos
+static int leerMallaBMesh(const char *nombreArchivo, struct EntradaPoly **entrada,
+                          struct MallaBinaria *elementos) {
+    struct MallaBinaria malla;
+    *entrada = NULL;
+    if (!abrirArchivoBMesh(nombreArchivo, &malla)) return 0;
+
+    struct DelaunayES es;
+    memset(&es, 0, sizeof(es));
+    es.listaPuntos = malla.puntos;
+    es.listaMarcadoresPuntos = (int *)malla.marcadoresPuntos;
+    es.numPuntos = malla.puntos ? malla.numPuntos : 0;
+    es.listaSegmentos = (int *)malla.segmentos;
+    es.listaMarcadoresSegmentos = (int *)malla.marcadoresSegmentos;
+    es.numSegmentos = malla.segmentos ? malla.numSegmentos : 0;
+    es.listaAgujeros = malla.agujeros;
+    es.numAgujeros = malla.agujeros ? malla.numAgujeros : 0;
+    es.listaRegiones = malla.regiones;
+    es.numRegiones = malla.regiones ? malla.numRegiones : 0;
+
+    int correcto = malla.triangulos && entradaDesdeES(&es, entrada) == SALIDA_EXITO;
+    if (correcto) {
+        size_t bytes = (size_t)malla.numTriangulos * 3 * sizeof(int32_t);
+        elementos->numTriangulos = malla.numTriangulos;
+        elementos->triangulos = malloc(bytes + 1);
+        correcto = elementos->triangulos != NULL;
+        if (correcto) memcpy(elementos->triangulos, malla.triangulos, bytes);
+    }
+    if (!correcto) {
+        liberarEntradaPoly(*entrada);
+        *entrada = NULL;
+    }
+    cerrarArchivoBMesh(&malla);
+    return correcto;
+}
+
+// Ejecuta el proceso completo (lectura, triangulación, restricciones,
+// refinamiento y escritura) y devuelve un código de salida
+int ejecutarMallado(const struct OpcionesMalla *op) {
+    nivelDetalle = op->nivelDetalle;
+
+    char archivoEntrada[FILENAME_MAX], base[FILENAME_MAX];
+    construirNombres(op, archivoEntrada, sizeof(archivoEntrada), base, sizeof(base));
+
+    // Con -r la entrada es una malla: a.1.node, a.1.ele y, con -p, los
+    // segmentos de a.1.poly; o bien a.1.bmesh, que ya los contiene
+    bool entradaBMesh = op->refinar && terminaEn(archivoEntrada, ".bmesh");
+    char archivoPoly[FILENAME_MAX], archivoEle[FILENAME_MAX];
+    size_t longitudBase = strlen(archivoEntrada) - strlen(entradaBMesh ? ".bmesh" : ".node");
+    snprintf(archivoPoly, sizeof(archivoPoly), "%.*s.poly", (int)longitudBase, archivoEntrada);
+    snprintf(archivoEle, sizeof(archivoEle), "%.*s.ele", (int)longitudBase, archivoEntrada);
+
+    // Leer la entrada
+    TRAMO_INICIO(FASE_LECTURA);
+    struct EntradaPoly *entrada;
+    struct MallaBinaria elementos;
+    memset(&elementos, 0, sizeof(elementos));
+    bool elementosLeidos = true;
+    if (entradaBMesh) {
+        elementosLeidos = leerMallaBMesh(archivoEntrada, &entrada, &elementos);
+    } else if (op->refinar) {
+        entrada = op->leerPoly ? leerArchivoPoly(archivoPoly) : leerArchivoNode(archivoEntrada);
+        elementosLeidos = !entrada || leerArchivoEle(archivoEle, entrada->primerNumero, &elementos);
+    } else {
+        entrada = op->leerPoly ? leerArchivoPoly(archivoEntrada) : leerArchivoNode(archivoEntrada);
+    }
+    TRAMO_FIN(FASE_LECTURA);
+    if (!entrada || !elementosLeidos) {
+        TRAZA_ERROR("No se pudo procesar el archivo %s\n",
+                    !entrada ? (op->refinar && op->leerPoly && !entradaBMesh ? archivoPoly : archivoEntrada)
+                             : archivoEle);
+        liberarEntradaPoly(entrada);
+        liberarMallaBinaria(&elementos);
+        return SALIDA_ENTRADA;
+    }
+    if (entrada->numVertices < 3) {
+        TRAZA_ERROR("Se necesitan al menos 3 vértices (%s tiene %d)\n",
+                    archivoEntrada, entrada->numVertices);
+        liberarEntradaPoly(entrada);
+        liberarMallaBinaria(&elementos);
+        return SALIDA_ENTRADA;
+    }
+
+    struct OpcionesDelaunay opMalla;
+    delaunayOpcionesPorDefecto(&opMalla);
+    opMalla.anguloMinimo = op->calidad ? op->anguloMinimo : 0.0;
+    opMalla.areaMaxima = op->restringirArea ? op->areaMaxima : 0.0;
+    opMalla.usarAreasRegion = op->restringirArea && op->areaMaxima <= 0.0;
+    opMalla.conforme = op->conforme;
+    opMalla.posicionSteiner = op->posicionSteiner;
+    opMalla.algoritmo = op->algoritmo;
+    opMalla.eliminarRepetidos = op->eliminarRepetidos && !op->refinar;
+    opMalla.toleranciaRepetidos = op->toleranciaRepetidos;
+    opMalla.hilos = op->hilos;
+    opMalla.nivelDetalle = op->nivelDetalle;
+
+    // Con -k se busca primero un resultado guardado para la misma entrada
+    // (no con -r: la clave no incluye los triángulos de la malla previa)
+    const char *directorioCache = getenv("DELAUNAY_CACHE");
+    if (!directorioCache || directorioCache[0] == '\0') directorioCache = DIRECTORIO_CACHE_DEFECTO;
+    struct ClaveCache clave;
+    struct MallaBinaria malla;
+    bool enCache = false;
+    bool usarCache = op->usarCache && !op->refinar;
+    if (usarCache) {
+        claveCache(entrada, &opMalla, DESTINO_CACHE_LINEA_COMANDOS, &clave);
+        enCache = buscarEnCache(directorioCache, &clave, &malla);
+    }
+
+    if (enCache) {
+        reiniciarContadoresOperacion();
+        CONTAR_OPERACION(aciertosCache, 1);
+        TRAZA_INFO("Malla tomada de la caché: %d vértices, %d triángulos\n",
+                   malla.numPuntos, malla.numTriangulos);
+    } else {
+        struct Triangulacion *tr;
+        int codigo = op->refinar ? refinarMallaExistente(entrada, &elementos, &opMalla, &tr)
+                                 : mallarEntrada(entrada, &opMalla, &tr);
+        liberarMallaBinaria(&elementos);
+        if (codigo != SALIDA_EXITO) {
             liberarEntradaPoly(entrada);
-            
-            printf("\nPresione Enter para continuar...");
-            getchar();
-            getchar();
+            return codigo;
+        }
+        // Todas las salidas se escriben desde los arreglos planos
+        bool correcto = mallaDesdeTriangulacion(tr, entrada, &malla);
+        liberarTriangulacion(tr);
+        if (!correcto) {
+            TRAZA_ERROR("No se pudo asignar memoria para la salida\n");
+            liberarEntradaPoly(entrada);
+            return SALIDA_MEMORIA;
+        }
+        if (usarCache) {
+            CONTAR_OPERACION(fallosCache, 1);
+            guardarEnCache(directorioCache, bytesCache(op->megabytesCache), &clave, &malla);
+        }
+    }
+
+    // Generar archivos de salida
+    int resultado = SALIDA_EXITO;
+    char nombre[FILENAME_MAX + 16];
+    TRAMO_INICIO(FASE_ESCRITURA);
+    if (op->escribirNode) {
+        snprintf(nombre, sizeof(nombre), "%s.node", base);
+        if (!guardarArchivoNode(&malla, nombre)) resultado = SALIDA_ESCRITURA;
+        else TRAZA_DETALLE("- %s\n", nombre);
+    }
+    if (op->escribirEle) {
+        snprintf(nombre, sizeof(nombre), "%s.ele", base);
+        if (!guardarArchivoEle(&malla, nombre)) resultado = SALIDA_ESCRITURA;
+        else TRAZA_DETALLE("- %s\n", nombre);
+    }
+    if (op->escribirVecinos) {
+        snprintf(nombre, sizeof(nombre), "%s.neigh", base);
+        if (!guardarArchivoNeigh(&malla, nombre)) resultado = SALIDA_ESCRITURA;
+        else TRAZA_DETALLE("- %s\n", nombre);
+    }
+    if (op->escribirBMesh) {
+        // Copia binaria sin pérdida de precisión
+        snprintf(nombre, sizeof(nombre), "%s.bmesh", base);
+        if (!guardarArchivoBMesh(&malla, nombre)) resultado = SALIDA_ESCRITURA;
+        else TRAZA_DETALLE("- %s\n", nombre);
+    }
+    TRAMO_FIN(FASE_ESCRITURA);
+    if (op->escribirContadores) {
+        snprintf(nombre, sizeof(nombre), "%s.contadores.json", base);
+        if (!guardarContadoresJSON(&contadoresOperacion, nombre)) resultado = SALIDA_ESCRITURA;
+        else TRAZA_DETALLE("- %s\n", nombre);
+    }
+    imprimirResumenTrazas();
+    cerrarContadoresHW();
+
+    // Liberar memoria
+    if (enCache) cerrarArchivoBMesh(&malla);
+    else liberarMallaBinaria(&malla);
+    liberarEntradaPoly(entrada);
+    return resultado;
+}
+
+// Espera Enter y limpia la pantalla (solo en el menú interactivo)
+static void pausarPantalla(void) {
+    printf("\nPresione Enter para continuar...");
+    getchar();
+    getchar();
+}
+
+static void limpiarPantalla(void) {
+#ifdef _WIN32
+    system("cls");
+#else
+    printf("\033[H\033[2J");
+#endif
+}
+
+int modoInteractivo(void) {
+    char comando[100];
+    char nombreArchivo[100];
+    
+    do {
+        menu();
+        if (scanf("%99s", comando) != 1) {
+            break;
+        }
+        
+        if (strcmp(comando, "-p") == 0) {
+            printf("Ingrese el nombre del archivo .poly: ");
+            if (scanf("%99s", nombreArchivo) != 1) break;
+
+            // Misma salida que antes: <base>.node, <base>.ele y <base>.bmesh
+            struct OpcionesMalla op;
+            opcionesPorDefecto(&op);
+            op.leerPoly = true;
+            op.escribirBMesh = true;
+            op.numerarIteracion = false;
+            op.nivelDetalle = nivelDetalle;
+            op.archivoEntrada = nombreArchivo;
+
+            if (ejecutarMallado(&op) == SALIDA_EXITO) {
+                printf("\nArchivos generados exitosamente.\n");
+            }
+            pausarPantalla();
         }
         else if (strcmp(comando, "-r") == 0) {
+            printf("Ingrese el nombre base de la malla (sin .node/.ele): ");
+            if (scanf("%99s", nombreArchivo) != 1) break;
+            double angulo;
+            printf("Angulo minimo en grados (0 sin restriccion): ");
+            if (scanf("%lf", &angulo) != 1) break;
+
+            // a.node + a.ele -> a.1.node + a.1.ele (a.1 -> a.2)
+            struct OpcionesMalla op;
+            opcionesPorDefecto(&op);
+            op.refinar = true;
+            op.calidad = angulo > 0.0 && angulo < 60.0;
+            if (op.calidad) op.anguloMinimo = angulo;
+            op.nivelDetalle = nivelDetalle;
+            op.archivoEntrada = nombreArchivo;
+
             printf("\nRefinando malla...\n");
-            // TODO: Implementar refinamiento
-            printf("\nPresione Enter para continuar...");
-            getchar();
-            getchar();
+            if (ejecutarMallado(&op) == SALIDA_EXITO) {
+                printf("\nArchivos generados exitosamente.\n");
+            }
+            pausarPantalla();
+        }
+        else if (strcmp(comando, "-b") == 0) {
+            printf("Ingrese el nombre base de la malla (sin .node/.ele): ");
+            if (scanf("%99s", nombreArchivo) != 1) break;
+
+            char archivoBMesh[256];
+            snprintf(archivoBMesh, sizeof(archivoBMesh), "%s.bmesh", nombreArchivo);
+            if (convertirTextoABMesh(nombreArchivo, archivoBMesh)) {
+                printf("\nArchivo generado: %s\n", archivoBMesh);
+            }
+            pausarPantalla();
+        }
+        else if (strcmp(comando, "-t") == 0) {
+            printf("Ingrese el nombre del archivo .bmesh: ");
+            if (scanf("%99s", nombreArchivo) != 1) break;
+
+            char base[256];
+            snprintf(base, sizeof(base), "%s", nombreArchivo);
+            size_t longitud = strlen(base);
+            if (longitud > 6 && strcmp(base + longitud - 6, ".bmesh") == 0) {
+                base[longitud - 6] = '\0';
+            }
+            if (convertirBMeshATexto(nombreArchivo, base)) {
+                printf("\nArchivos generados: %s.node, %s.ele\n", base, base);
+            }
+            pausarPantalla();
         }
         else if (strcmp(comando, "-i") == 0) {
             info();
         }
         else if (strcmp(comando, "-s") == 0) {
             printf("\nSaliendo del programa...\n");
-            if (tr) liberarTriangulacion(tr);
-            if (entrada) liberarEntradaPoly(entrada);
             break;
         }
         else {
             printf("\nComando no válido. Por favor, intente nuevamente.\n");
-            printf("\nPresione Enter para continuar...");
-            getchar();
-            getchar();
+            pausarPantalla();
         }
         
-        system("cls");  // Limpiar pantalla
+        limpiarPantalla();
 
     } while(1);
     
-    return 0;
-}
\ No newline at end of file
+    return SALIDA_EXITO;
+}
+
+int main(int argc, char **argv) {
+    // Sin argumentos: menú interactivo de siempre
+    if (argc < 2) {
+        return modoInteractivo();
+    }
+
+    struct OpcionesMalla op;
+    opcionesPorDefecto(&op);
+    int codigo = analizarArgumentos(argc, argv, &op);
+    if (codigo != SALIDA_EXITO) {
+        uso();
+        return codigo;
+    }
+    if (op.ayuda) {
+        uso();
+        return SALIDA_EXITO;
+    }
+
+    return ejecutarMallado(&op);
+}
+# endif /* DELAUNAY_LIBRERIA */
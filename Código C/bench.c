@@ -0,0 +1,1040 @@
+/******************************************************************************/
+/*                                                                            */
+/**********		    BANCO DE PRUEBAS DE LA TRIANGULACION		         **********/
+/*                                                                            */
+/******************************************************************************/
+
+/* Mide el tiempo de cada fase de Delaunay.c (lectura, ordenamiento,
+   triangulación, restricciones, vecinos, refinamiento y escritura) sobre
+   conjuntos de puntos sintéticos con semilla fija, y entrega los resultados
+   en CSV o JSON para comparar entre versiones.
+
+   Compilación (incluye Delaunay.c con las trazas activas):
+
+       gcc -O2 -o bench bench.c -lm
+       gcc -O2 -fopenmp -o bench bench.c -lm      (lectura en paralelo)
+
+   Uso:
+
+       bench [-g generadores] [-n tamaños] [-r repeticiones] [-s semilla]
+             [-l segundos] [-q ángulo] [-a motor] [-f csv|json] [-o archivo]
+             [-d directorio de datos] [-t directorio temporal] [-k]
+
+   Generadores: cuadrado, disco, gaussianas, circulo, reticula, decimal,
+   acapulco, puntos (estos dos últimos subdividen los segmentos de los .poly
+   del repositorio hasta llegar al tamaño pedido). reticula y decimal son
+   degeneradas: cocirculares exactas y a unos ulps de serlo.
+
+   Motores de la triangulación inicial (-a): dyv, incremental, barrido y
+   auto, el mismo que elige delaunay -A según la entrada.
+
+   Con -c se corren las mismas entradas en Delaunay.c y en triangulate() de
+   triangle.c, dentro del programa, comparando tiempo, memoria pico, número
+   de triángulos y validez (Delaunay y restricciones). Requiere compilar
+   triangle.c como librería:
+
+       gcc -O2 -c -DTRILIBRARY -DANSI_DECLARATORS -DNO_TIMER triangle.c
+       gcc -O2 -DCOMPARAR_TRIANGLE -o bench bench.c triangle.o -lm
+
+   Los predicados exactos de triangle.c usan fma() cuando el compilador la
+   declara rápida (-mfma, -march=native). Para medir la diferencia sobre las
+   entradas degeneradas, compilar triangle.o de las dos formas y comparar:
+
+       gcc -O2 -march=native -ffp-contract=off -c ... triangle.c
+       gcc -O2 -march=native -ffp-contract=off -DNO_FMA -c ... triangle.c
+       bench -c -g reticula,decimal -n 100000,1000000
+
+   Las dos llevan -ffp-contract=off: sin él, NO_FMA fusiona las operaciones
+   de Split() y deja de ser exacta, y el compilador fusiona también cálculos
+   fuera de los predicados (las coordenadas de los puntos nuevos), de modo
+   que las mallas ya no coinciden byte a byte con las de la otra versión. */
+
+# define DELAUNAY_LIBRERIA
+# ifndef DELAUNAY_TRAZAS
+#  define DELAUNAY_TRAZAS
+# endif
+# include "Delaunay.c"
+
+# ifdef COMPARAR_TRIANGLE
+#  define REAL double
+#  define VOID void
+#  ifndef ANSI_DECLARATORS
+#   define ANSI_DECLARATORS
+#  endif
+#  include "triangle.h"
+#  ifndef _WIN32
+#   include <signal.h>
+#   include <sys/resource.h>
+#   include <sys/wait.h>
+#  endif
+# endif
+
+/* Constantes                                                                 */
+# define MAX_TAMANOS 16
+# define NUM_GRUPOS_GAUSSIANOS 16
+# define TAMANOS_DEFECTO "1000,10000,100000,1000000,10000000"
+# define LIMITE_DEFECTO 60.0     // Segundos estimados por medición
+# define NUM_ALGORITMOS 4
+
+// Nombres de -a, en el orden de ALGORITMO_*
+static const char *opcionesAlgoritmo[NUM_ALGORITMOS] = { "dyv", "incremental", "barrido", "auto" };
+
+/* Estructuras de Datos                                                       */
+
+// Generador pseudoaleatorio (splitmix64): misma secuencia en toda plataforma
+struct Aleatorio {
+    uint64_t estado;
+};
+
+// Conjunto generado: puntos y, para los polígonos, sus segmentos
+struct ConjuntoPuntos {
+    double *puntos;     // x, y
+    int numPuntos;
+    int *segmentos;     // Pares base-0
+    int numSegmentos;
+    double *agujeros;   // x, y
+    int numAgujeros;
+};
+
+enum FormatoSalida {
+    FORMATO_CSV,
+    FORMATO_JSON
+};
+
+struct OpcionesBanco {
+    const char *generadores;
+    int tamanos[MAX_TAMANOS];
+    int numTamanos;
+    int repeticiones;
+    uint64_t semilla;
+    double limite;
+    double anguloMinimo;
+    int algoritmo;              // -a, ALGORITMO_*
+    enum FormatoSalida formato;
+    const char *archivoSalida;
+    const char *directorioDatos;
+    const char *directorioTemporal;
+    bool conservarArchivos;
+    bool compararTriangle;      // -c
+};
+
+typedef int (*FuncionGenerador)(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                                struct ConjuntoPuntos *conjunto);
+
+struct Generador {
+    const char *nombre;
+    FuncionGenerador generar;
+};
+
+
+/* Generadores                                                                */
+
+static uint64_t siguienteAleatorio(struct Aleatorio *azar) {
+    uint64_t z = (azar->estado += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Uniforme en [0, 1) con 53 bits
+static double aleatorioUniforme(struct Aleatorio *azar) {
+    return (double)(siguienteAleatorio(azar) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double aleatorioNormal(struct Aleatorio *azar) {
+    // Box-Muller; se descarta el segundo valor para no guardar estado
+    double u1 = aleatorioUniforme(azar), u2 = aleatorioUniforme(azar);
+    if (u1 < DBL_MIN) u1 = DBL_MIN;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static int reservarConjunto(struct ConjuntoPuntos *conjunto, int n) {
+    memset(conjunto, 0, sizeof(struct ConjuntoPuntos));
+    conjunto->puntos = malloc((size_t)n * 2 * sizeof(double));
+    conjunto->numPuntos = n;
+    return conjunto->puntos != NULL;
+}
+
+static void liberarConjunto(struct ConjuntoPuntos *conjunto) {
+    free(conjunto->puntos);
+    free(conjunto->segmentos);
+    free(conjunto->agujeros);
+    memset(conjunto, 0, sizeof(struct ConjuntoPuntos));
+}
+
+static int generarCuadrado(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                           struct ConjuntoPuntos *conjunto) {
+    (void)op;
+    if (!reservarConjunto(conjunto, n)) return 0;
+    for (int i = 0; i < n; i++) {
+        conjunto->puntos[2 * i] = aleatorioUniforme(azar);
+        conjunto->puntos[2 * i + 1] = aleatorioUniforme(azar);
+    }
+    return 1;
+}
+
+static int generarDisco(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                        struct ConjuntoPuntos *conjunto) {
+    (void)op;
+    if (!reservarConjunto(conjunto, n)) return 0;
+    for (int i = 0; i < n; i++) {
+        double r = sqrt(aleatorioUniforme(azar));
+        double t = 2.0 * M_PI * aleatorioUniforme(azar);
+        conjunto->puntos[2 * i] = r * cos(t);
+        conjunto->puntos[2 * i + 1] = r * sin(t);
+    }
+    return 1;
+}
+
+// Grupos gaussianos de dispersión distinta: densidad muy desigual
+static int generarGaussianas(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                             struct ConjuntoPuntos *conjunto) {
+    (void)op;
+    if (!reservarConjunto(conjunto, n)) return 0;
+    double centros[NUM_GRUPOS_GAUSSIANOS][3];
+    for (int g = 0; g < NUM_GRUPOS_GAUSSIANOS; g++) {
+        centros[g][0] = aleatorioUniforme(azar);
+        centros[g][1] = aleatorioUniforme(azar);
+        centros[g][2] = 0.001 + 0.05 * aleatorioUniforme(azar);
+    }
+    for (int i = 0; i < n; i++) {
+        int g = (int)(siguienteAleatorio(azar) % NUM_GRUPOS_GAUSSIANOS);
+        conjunto->puntos[2 * i] = centros[g][0] + centros[g][2] * aleatorioNormal(azar);
+        conjunto->puntos[2 * i + 1] = centros[g][1] + centros[g][2] * aleatorioNormal(azar);
+    }
+    return 1;
+}
+
+// Puntos cocirculares: el peor caso para las pruebas de circunferencia
+static int generarCirculo(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                          struct ConjuntoPuntos *conjunto) {
+    (void)op;
+    if (!reservarConjunto(conjunto, n)) return 0;
+    double desfase = 2.0 * M_PI * aleatorioUniforme(azar);
+    for (int i = 0; i < n; i++) {
+        double t = desfase + 2.0 * M_PI * i / n;
+        conjunto->puntos[2 * i] = cos(t);
+        conjunto->puntos[2 * i + 1] = sin(t);
+    }
+    return 1;
+}
+
+// Retícula entera: muchos puntos colineales y cuadriláteros cocirculares
+static int generarReticula(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                           struct ConjuntoPuntos *conjunto) {
+    (void)azar;
+    (void)op;
+    int lado = (int)ceil(sqrt((double)n));
+    if (!reservarConjunto(conjunto, n)) return 0;
+    for (int i = 0; i < n; i++) {
+        conjunto->puntos[2 * i] = (double)(i % lado);
+        conjunto->puntos[2 * i + 1] = (double)(i / lado);
+    }
+    return 1;
+}
+
+// Retícula de paso 0.1 trasladada a (1000, 1000): ni el paso ni los puntos
+// son representables, así que los redondeos dejan casi todos los
+// cuadriláteros a unos ulps de ser cocirculares. Los predicados exactos de
+// triangle.c llegan hasta sus últimas etapas en casi cada prueba
+static int generarDecimal(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                          struct ConjuntoPuntos *conjunto) {
+    (void)azar;
+    (void)op;
+    int lado = (int)ceil(sqrt((double)n));
+    if (!reservarConjunto(conjunto, n)) return 0;
+    for (int i = 0; i < n; i++) {
+        conjunto->puntos[2 * i] = 1000.0 + 0.1 * (double)(i % lado);
+        conjunto->puntos[2 * i + 1] = 1000.0 + 0.1 * (double)(i / lado);
+    }
+    return 1;
+}
+
+// Toma un .poly del repositorio y subdivide sus segmentos hasta llegar a
+// unos n vértices; los segmentos resultantes se insertan como restricciones
+static int generarDesdePoly(const char *relativo, int n, const struct OpcionesBanco *op,
+                            struct ConjuntoPuntos *conjunto) {
+    char ruta[FILENAME_MAX];
+    snprintf(ruta, sizeof(ruta), "%s/%s", op->directorioDatos, relativo);
+
+    int nivelAnterior = nivelDetalle;
+    nivelDetalle = NIVEL_SILENCIOSO;
+    struct EntradaPoly *poly = leerArchivoPoly(ruta);
+    nivelDetalle = nivelAnterior;
+    if (!poly || poly->numSegmentos == 0) {
+        TRAZA_ERROR("No se pudo leer %s (use -d para indicar el directorio)\n", ruta);
+        liberarEntradaPoly(poly);
+        return 0;
+    }
+
+    // Puntos nuevos por segmento
+    int extra = n > poly->numVertices ? n - poly->numVertices : 0;
+    int porSegmento = (extra + poly->numSegmentos - 1) / poly->numSegmentos;
+    int total = poly->numVertices + porSegmento * poly->numSegmentos;
+
+    if (!reservarConjunto(conjunto, total)) {
+        liberarEntradaPoly(poly);
+        return 0;
+    }
+    conjunto->numSegmentos = poly->numSegmentos * (porSegmento + 1);
+    conjunto->segmentos = malloc((size_t)conjunto->numSegmentos * 2 * sizeof(int));
+    if (!conjunto->segmentos) {
+        liberarConjunto(conjunto);
+        liberarEntradaPoly(poly);
+        return 0;
+    }
+
+    for (int i = 0; i < poly->numVertices; i++) {
+        conjunto->puntos[2 * i] = poly->vertices[i].x;
+        conjunto->puntos[2 * i + 1] = poly->vertices[i].y;
+    }
+
+    int siguiente = poly->numVertices;
+    int s = 0;
+    for (int i = 0; i < poly->numSegmentos; i++) {
+        int a = poly->segmentos[i].v1, b = poly->segmentos[i].v2;
+        struct Punto *pa = &poly->vertices[a], *pb = &poly->vertices[b];
+        int anterior = a;
+        for (int k = 1; k <= porSegmento; k++) {
+            double t = (double)k / (porSegmento + 1);
+            conjunto->puntos[2 * siguiente] = pa->x + t * (pb->x - pa->x);
+            conjunto->puntos[2 * siguiente + 1] = pa->y + t * (pb->y - pa->y);
+            conjunto->segmentos[2 * s] = anterior;
+            conjunto->segmentos[2 * s + 1] = siguiente;
+            s++;
+            anterior = siguiente++;
+        }
+        conjunto->segmentos[2 * s] = anterior;
+        conjunto->segmentos[2 * s + 1] = b;
+        s++;
+    }
+
+    if (poly->numAgujeros > 0) {
+        conjunto->numAgujeros = poly->numAgujeros;
+        conjunto->agujeros = malloc((size_t)poly->numAgujeros * 2 * sizeof(double));
+        if (conjunto->agujeros) {
+            for (int i = 0; i < poly->numAgujeros; i++) {
+                conjunto->agujeros[2 * i] = poly->agujeros[i].x;
+                conjunto->agujeros[2 * i + 1] = poly->agujeros[i].y;
+            }
+        } else {
+            conjunto->numAgujeros = 0;
+        }
+    }
+
+    liberarEntradaPoly(poly);
+    return 1;
+}
+
+static int generarAcapulco(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                           struct ConjuntoPuntos *conjunto) {
+    (void)azar;
+    return generarDesdePoly("acapulco/acapulco.poly", n, op, conjunto);
+}
+
+static int generarPuntosMatLab(struct Aleatorio *azar, int n, const struct OpcionesBanco *op,
+                               struct ConjuntoPuntos *conjunto) {
+    (void)azar;
+    return generarDesdePoly("MatLab/puntos.poly", n, op, conjunto);
+}
+
+static const struct Generador generadores[] = {
+    { "cuadrado",   generarCuadrado },
+    { "disco",      generarDisco },
+    { "gaussianas", generarGaussianas },
+    { "circulo",    generarCirculo },
+    { "reticula",   generarReticula },
+    { "decimal",    generarDecimal },
+    { "acapulco",   generarAcapulco },
+    { "puntos",     generarPuntosMatLab }
+};
+# define NUM_GENERADORES ((int)(sizeof(generadores) / sizeof(generadores[0])))
+
+// true si el generador está en la lista separada por comas (o no hay lista)
+static bool generadorElegido(const char *lista, const char *nombre) {
+    if (!lista) return true;
+    size_t longitud = strlen(nombre);
+    for (const char *p = lista; *p; ) {
+        const char *coma = strchr(p, ',');
+        size_t tramo = coma ? (size_t)(coma - p) : strlen(p);
+        if (tramo == longitud && strncmp(p, nombre, longitud) == 0) return true;
+        if (!coma) break;
+        p = coma + 1;
+    }
+    return false;
+}
+
+
+/* Archivos de entrada                                                        */
+
+// Escribe el conjunto como .poly (con segmentos) o .node; la lectura de
+// este archivo es la fase que se mide como "lectura"
+static int escribirConjunto(const struct ConjuntoPuntos *conjunto, const char *nombreArchivo) {
+    FILE *archivo = fopen(nombreArchivo, "w");
+    if (!archivo) return 0;
+
+    fprintf(archivo, "%d 2 0 0\n", conjunto->numPuntos);
+    for (int i = 0; i < conjunto->numPuntos; i++) {
+        fprintf(archivo, "%d %.17g %.17g\n", i + 1,
+                conjunto->puntos[2 * i], conjunto->puntos[2 * i + 1]);
+    }
+    if (conjunto->segmentos) {
+        fprintf(archivo, "%d 0\n", conjunto->numSegmentos);
+        for (int i = 0; i < conjunto->numSegmentos; i++) {
+            fprintf(archivo, "%d %d %d\n", i + 1,
+                    conjunto->segmentos[2 * i] + 1, conjunto->segmentos[2 * i + 1] + 1);
+        }
+        fprintf(archivo, "%d\n", conjunto->numAgujeros);
+        for (int i = 0; i < conjunto->numAgujeros; i++) {
+            fprintf(archivo, "%d %.17g %.17g\n", i + 1,
+                    conjunto->agujeros[2 * i], conjunto->agujeros[2 * i + 1]);
+        }
+    }
+
+    int correcto = !ferror(archivo);
+    return (fclose(archivo) == 0) && correcto;
+}
+
+
+/* Medición                                                                   */
+
+struct Medicion {
+    double fases[NUM_FASES];
+    double total;
+    int numPuntos;       // Al terminar (con puntos Steiner)
+    int numTriangulos;
+    int codigo;          // SALIDA_*
+    struct ContadoresOperacion operaciones;
+};
+
+// Una ejecución completa: leer, mallar y escribir, con los tramos de Delaunay.c
+static void medirEjecucion(const char *base, bool esPoly, const struct OpcionesBanco *op,
+                           struct Medicion *medicion) {
+    char nombre[FILENAME_MAX + 16];
+    memset(medicion, 0, sizeof(struct Medicion));
+    reiniciarTrazas();
+
+    double inicio = tiempoActual();
+
+    snprintf(nombre, sizeof(nombre), "%s%s", base, esPoly ? ".poly" : ".node");
+    TRAMO_INICIO(FASE_LECTURA);
+    struct EntradaPoly *entrada = esPoly ? leerArchivoPoly(nombre) : leerArchivoNode(nombre);
+    TRAMO_FIN(FASE_LECTURA);
+    if (!entrada) {
+        medicion->codigo = SALIDA_ENTRADA;
+        return;
+    }
+
+    struct OpcionesDelaunay opMalla;
+    delaunayOpcionesPorDefecto(&opMalla);
+    opMalla.anguloMinimo = op->anguloMinimo;
+    opMalla.algoritmo = op->algoritmo;
+    opMalla.nivelDetalle = NIVEL_ERROR;
+
+    struct Triangulacion *tr;
+    medicion->codigo = mallarEntrada(entrada, &opMalla, &tr);
+    medicion->operaciones = contadoresOperacion;
+    if (medicion->codigo == SALIDA_EXITO) {
+        // Igual que la línea de comandos: las salidas salen de los arreglos planos
+        TRAMO_INICIO(FASE_ESCRITURA);
+        struct MallaBinaria malla;
+        int correcto = mallaDesdeTriangulacion(tr, entrada, &malla);
+        if (correcto) {
+            snprintf(nombre, sizeof(nombre), "%s.1.node", base);
+            correcto = guardarArchivoNode(&malla, nombre);
+            if (!op->conservarArchivos) remove(nombre);
+            snprintf(nombre, sizeof(nombre), "%s.1.ele", base);
+            correcto = guardarArchivoEle(&malla, nombre) && correcto;
+            if (!op->conservarArchivos) remove(nombre);
+            liberarMallaBinaria(&malla);
+        }
+        TRAMO_FIN(FASE_ESCRITURA);
+        if (!correcto) medicion->codigo = SALIDA_ESCRITURA;
+
+        medicion->numPuntos = tr->numPuntos;
+        medicion->numTriangulos = tr->numTriangulos;
+        liberarTriangulacion(tr);
+    }
+    liberarEntradaPoly(entrada);
+
+    medicion->total = tiempoActual() - inicio;
+    for (int i = 0; i < NUM_FASES; i++) medicion->fases[i] = tiempoFases[i];
+}
+
+
+/* Salida de resultados                                                       */
+
+static void escribirEncabezado(FILE *salida, const struct OpcionesBanco *op) {
+    if (op->formato == FORMATO_JSON) {
+        fprintf(salida, "{\n  \"semilla\": %llu,\n  \"angulo_minimo\": %g,\n"
+                        "  \"algoritmo\": \"%s\",\n  \"resultados\": [",
+                (unsigned long long)op->semilla, op->anguloMinimo, opcionesAlgoritmo[op->algoritmo]);
+        return;
+    }
+    fprintf(salida, "generador,n,repeticion,codigo");
+    for (int i = 0; i < NUM_FASES; i++) fprintf(salida, ",%s", nombresFases[i]);
+    fprintf(salida, ",total,puntos,triangulos,puntos_por_segundo\n");
+}
+
+static void escribirMedicion(FILE *salida, const struct OpcionesBanco *op, bool primera,
+                             const char *generador, int n, int repeticion,
+                             const struct Medicion *m) {
+    double ritmo = m->total > 0.0 ? n / m->total : 0.0;
+    if (op->formato == FORMATO_JSON) {
+        fprintf(salida, "%s\n    {\"generador\": \"%s\", \"n\": %d, \"repeticion\": %d, "
+                        "\"codigo\": %d, \"fases\": {",
+                primera ? "" : ",", generador, n, repeticion, m->codigo);
+        for (int i = 0; i < NUM_FASES; i++) {
+            fprintf(salida, "%s\"%s\": %.9f", i ? ", " : "", nombresFases[i], m->fases[i]);
+        }
+        char operaciones[TAMANO_JSON_CONTADORES];
+        formatearContadoresJSON(&m->operaciones, operaciones, sizeof(operaciones));
+        fprintf(salida, "}, \"total\": %.9f, \"puntos\": %d, \"triangulos\": %d, "
+                        "\"puntos_por_segundo\": %.1f, \"operaciones\": %s}",
+                m->total, m->numPuntos, m->numTriangulos, ritmo, operaciones);
+        return;
+    }
+    fprintf(salida, "%s,%d,%d,%d", generador, n, repeticion, m->codigo);
+    for (int i = 0; i < NUM_FASES; i++) fprintf(salida, ",%.9f", m->fases[i]);
+    fprintf(salida, ",%.9f,%d,%d,%.1f\n", m->total, m->numPuntos, m->numTriangulos, ritmo);
+}
+
+static void escribirCierre(FILE *salida, const struct OpcionesBanco *op) {
+    if (op->formato == FORMATO_JSON) fprintf(salida, "\n  ]\n}\n");
+}
+
+
+// Tiempos por fase de cada generador y tamaño
+static void medirFases(const struct OpcionesBanco *op, FILE *salida) {
+    escribirEncabezado(salida, op);
+    bool primera = true;
+
+    for (int g = 0; g < NUM_GENERADORES; g++) {
+        if (!generadorElegido(op->generadores, generadores[g].nombre)) continue;
+        double ultimoTiempo = 0.0;
+        int ultimoN = 0;
+
+        for (int t = 0; t < op->numTamanos; t++) {
+            int n = op->tamanos[t];
+
+            // La triangulación actual puede crecer de forma cuadrática: se
+            // estima con ese orden y se omiten los tamaños que no caben
+            if (ultimoN > 0) {
+                double razon = (double)n / ultimoN;
+                if (ultimoTiempo * razon * razon > op->limite) {
+                    TRAZA_AVISO("%s: se omite n=%d (estimado %.0f s > %.0f s)\n",
+                                generadores[g].nombre, n, ultimoTiempo * razon * razon, op->limite);
+                    continue;
+                }
+            }
+
+            struct Aleatorio azar = { op->semilla ^ ((uint64_t)g << 32) ^ (uint64_t)n };
+            struct ConjuntoPuntos conjunto;
+            if (!generadores[g].generar(&azar, n, op, &conjunto)) {
+                TRAZA_ERROR("%s: no se pudo generar n=%d\n", generadores[g].nombre, n);
+                break;
+            }
+
+            char base[FILENAME_MAX], nombre[FILENAME_MAX + 16];
+            bool esPoly = conjunto.segmentos != NULL;
+            snprintf(base, sizeof(base), "%s/bench_%s_%d",
+                     op->directorioTemporal, generadores[g].nombre, n);
+            snprintf(nombre, sizeof(nombre), "%s%s", base, esPoly ? ".poly" : ".node");
+            int escrito = escribirConjunto(&conjunto, nombre);
+            liberarConjunto(&conjunto);
+            if (!escrito) {
+                TRAZA_ERROR("No se pudo escribir %s\n", nombre);
+                break;
+            }
+
+            double mejor = DBL_MAX;
+            for (int r = 0; r < op->repeticiones; r++) {
+                struct Medicion medicion;
+                medirEjecucion(base, esPoly, op, &medicion);
+                escribirMedicion(salida, op, primera, generadores[g].nombre, n, r, &medicion);
+                fflush(salida);
+                primera = false;
+                if (medicion.total < mejor) mejor = medicion.total;
+                if (medicion.total > op->limite) break;
+            }
+            if (!op->conservarArchivos) remove(nombre);
+
+            ultimoTiempo = mejor;
+            ultimoN = n;
+        }
+    }
+
+    escribirCierre(salida, op);
+}
+
+
+/* Comparación con triangle.c                                                 */
+
+# ifdef COMPARAR_TRIANGLE
+
+// Resultado de un motor sobre una entrada
+struct Comparacion {
+    int codigo;              // SALIDA_*, o 128 + señal si el proceso murió
+    double segundos;
+    long memoriaPicoKB;      // Pico del proceso que mallaba (-1 si no se sabe)
+    int numPuntos;
+    int numTriangulos;
+    int degenerados;         // Triángulos de área nula o índices inválidos
+    int noDelaunay;          // Aristas interiores no restringidas que violan
+                             // la circunferencia vacía
+    int aristasSobrantes;    // Aristas compartidas por más de dos triángulos
+    int segmentosFaltantes;  // Segmentos de entrada ausentes como aristas
+};
+
+enum Motor {
+    MOTOR_DELAUNAY,
+    MOTOR_TRIANGLE,
+    NUM_MOTORES
+};
+
+static const char *nombresMotores[NUM_MOTORES] = { "delaunay", "triangle" };
+
+// Arista de la malla: vértices ordenados, triángulo y vértice opuesto
+struct AristaMalla {
+    int a, b;
+    int triangulo;
+    int opuesto;
+};
+
+static int compararAristas(const void *x, const void *y) {
+    const struct AristaMalla *e = x, *f = y;
+    if (e->a != f->a) return e->a < f->a ? -1 : 1;
+    if (e->b != f->b) return e->b < f->b ? -1 : 1;
+    return 0;
+}
+
+static double orientacionPlana(const double *p, const double *q, const double *r) {
+    return (q[0] - p[0]) * (r[1] - p[1]) - (q[1] - p[1]) * (r[0] - p[0]);
+}
+
+// > 0 si d está dentro de la circunferencia de (a, b, c) en sentido
+// antihorario; los valores por debajo del error de redondeo cuentan como 0
+static double enCircunferencia(const double *a, const double *b, const double *c,
+                               const double *d) {
+    double adx = a[0] - d[0], ady = a[1] - d[1];
+    double bdx = b[0] - d[0], bdy = b[1] - d[1];
+    double cdx = c[0] - d[0], cdy = c[1] - d[1];
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy)
+               + clift * (adx * bdy - bdx * ady);
+    double permanente = alift * (fabs(bdx * cdy) + fabs(cdx * bdy))
+                      + blift * (fabs(cdx * ady) + fabs(adx * cdy))
+                      + clift * (fabs(adx * bdy) + fabs(bdx * ady));
+    return fabs(det) <= 1e-12 * permanente ? 0.0 : det;
+}
+
+// Revisa una malla en arreglos planos (base-0). Los segmentos de entrada se
+// buscan como aristas, por lo que con refinamiento (segmentos partidos por
+// puntos Steiner) la cuenta de faltantes es una cota superior.
+static void validarMalla(const double *puntos, int numPuntos, const int *triangulos,
+                         int numTriangulos, const int *segmentos, int numSegmentos,
+                         struct Comparacion *c) {
+    struct AristaMalla *aristas = malloc((size_t)numTriangulos * 3 * sizeof(struct AristaMalla) + 1);
+    struct AristaMalla *restricciones = malloc((size_t)numSegmentos * sizeof(struct AristaMalla) + 1);
+    if (!aristas || !restricciones) {
+        free(aristas);
+        free(restricciones);
+        c->codigo = SALIDA_MEMORIA;
+        return;
+    }
+
+    int numAristas = 0;
+    for (int t = 0; t < numTriangulos; t++) {
+        const int *v = &triangulos[3 * t];
+        bool validos = true;
+        for (int k = 0; k < 3; k++) {
+            if (v[k] < 0 || v[k] >= numPuntos) validos = false;
+        }
+        if (!validos || orientacionPlana(&puntos[2 * v[0]], &puntos[2 * v[1]], &puntos[2 * v[2]]) == 0.0) {
+            c->degenerados++;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            int a = v[(k + 1) % 3], b = v[(k + 2) % 3];
+            aristas[numAristas].a = a < b ? a : b;
+            aristas[numAristas].b = a < b ? b : a;
+            aristas[numAristas].triangulo = t;
+            aristas[numAristas].opuesto = v[k];
+            numAristas++;
+        }
+    }
+    qsort(aristas, numAristas, sizeof(struct AristaMalla), compararAristas);
+
+    for (int s = 0; s < numSegmentos; s++) {
+        int a = segmentos[2 * s], b = segmentos[2 * s + 1];
+        restricciones[s].a = a < b ? a : b;
+        restricciones[s].b = a < b ? b : a;
+    }
+    qsort(restricciones, numSegmentos, sizeof(struct AristaMalla), compararAristas);
+
+    for (int s = 0; s < numSegmentos; s++) {
+        if (!bsearch(&restricciones[s], aristas, numAristas, sizeof(struct AristaMalla),
+                     compararAristas)) {
+            c->segmentosFaltantes++;
+        }
+    }
+
+    // Aristas iguales quedan contiguas tras ordenar
+    for (int i = 0; i < numAristas; ) {
+        int j = i + 1;
+        while (j < numAristas && compararAristas(&aristas[i], &aristas[j]) == 0) j++;
+
+        if (j - i > 2) {
+            c->aristasSobrantes += j - i - 2;
+        } else if (j - i == 2 &&
+                   !bsearch(&aristas[i], restricciones, numSegmentos,
+                            sizeof(struct AristaMalla), compararAristas)) {
+            // Prueba en ambos sentidos: basta que un vértice opuesto viole
+            const int *t = &triangulos[3 * aristas[i].triangulo];
+            const double *p0 = &puntos[2 * t[0]], *p1 = &puntos[2 * t[1]], *p2 = &puntos[2 * t[2]];
+            const double *d = &puntos[2 * aristas[i + 1].opuesto];
+            double det = orientacionPlana(p0, p1, p2) > 0.0 ? enCircunferencia(p0, p1, p2, d)
+                                                       : enCircunferencia(p0, p2, p1, d);
+            if (det > 0.0) c->noDelaunay++;
+        }
+        i = j;
+    }
+
+    free(aristas);
+    free(restricciones);
+}
+
+static void mallarConDelaunay(const struct ConjuntoPuntos *conjunto, const struct OpcionesBanco *op,
+                              struct Comparacion *c) {
+    ContextoDelaunay *ctx = delaunayCrearContexto();
+    if (!ctx) {
+        c->codigo = SALIDA_MEMORIA;
+        return;
+    }
+
+    struct OpcionesDelaunay opMalla;
+    delaunayOpcionesPorDefecto(&opMalla);
+    opMalla.anguloMinimo = op->anguloMinimo;
+    opMalla.algoritmo = op->algoritmo;
+    opMalla.calcularVecinos = 0;
+
+    struct DelaunayES entrada, salida;
+    memset(&entrada, 0, sizeof(entrada));
+    entrada.listaPuntos = conjunto->puntos;
+    entrada.numPuntos = conjunto->numPuntos;
+    entrada.listaSegmentos = conjunto->segmentos;
+    entrada.numSegmentos = conjunto->numSegmentos;
+    entrada.listaAgujeros = conjunto->agujeros;
+    entrada.numAgujeros = conjunto->numAgujeros;
+
+    double inicio = tiempoActual();
+    c->codigo = delaunayTriangular(ctx, &opMalla, &entrada, &salida);
+    c->segundos = tiempoActual() - inicio;
+
+    if (c->codigo == SALIDA_EXITO) {
+        c->numPuntos = salida.numPuntos;
+        c->numTriangulos = salida.numTriangulos;
+        validarMalla(salida.listaPuntos, salida.numPuntos, salida.listaTriangulos,
+                     salida.numTriangulos, salida.listaSegmentos, salida.numSegmentos, c);
+    } else {
+        TRAZA_ERROR("delaunay: %s\n", delaunayUltimoError(ctx));
+    }
+    delaunayLiberarES(&salida);
+    delaunayDestruirContexto(ctx);
+}
+
+static void mallarConTriangle(const struct ConjuntoPuntos *conjunto, const struct OpcionesBanco *op,
+                              struct Comparacion *c) {
+    struct triangulateio entrada, salida;
+    memset(&entrada, 0, sizeof(entrada));
+    memset(&salida, 0, sizeof(salida));
+    entrada.pointlist = conjunto->puntos;
+    entrada.numberofpoints = conjunto->numPuntos;
+    entrada.segmentlist = conjunto->segmentos;
+    entrada.numberofsegments = conjunto->numSegmentos;
+    entrada.holelist = conjunto->agujeros;
+    entrada.numberofholes = conjunto->numAgujeros;
+
+    // z: base-0, Q: sin mensajes, p: con segmentos, q: calidad
+    char switches[64];
+    int longitud = snprintf(switches, sizeof(switches), "zQ%s", conjunto->segmentos ? "p" : "");
+    if (op->anguloMinimo > 0.0) {
+        snprintf(switches + longitud, sizeof(switches) - longitud, "q%g", op->anguloMinimo);
+    }
+
+    double inicio = tiempoActual();
+    int estado = triangulate(switches, &entrada, &salida, NULL);
+    c->segundos = tiempoActual() - inicio;
+
+    // Sin -p Triangle cuenta las aristas de la envolvente como segmentos
+    // pero no entrega la lista
+    if (estado == 0) {
+        c->codigo = SALIDA_EXITO;
+        c->numPuntos = salida.numberofpoints;
+        c->numTriangulos = salida.numberoftriangles;
+        validarMalla(salida.pointlist, salida.numberofpoints, salida.trianglelist,
+                     salida.numberoftriangles, salida.segmentlist,
+                     salida.segmentlist ? salida.numberofsegments : 0, c);
+    } else {
+        c->codigo = SALIDA_TRIANGULACION;
+        TRAZA_ERROR("triangle: triangulate() devolvió %d\n", estado);
+    }
+
+    trifree(salida.pointlist);
+    trifree(salida.pointmarkerlist);
+    trifree(salida.trianglelist);
+    trifree(salida.segmentlist);
+    trifree(salida.segmentmarkerlist);
+}
+
+// Cada motor corre en un proceso hijo: la memoria pico se mide por motor y
+// una caída o un bucle sin fin del motor no detiene la comparación
+static void ejecutarMotor(enum Motor motor, const struct ConjuntoPuntos *conjunto,
+                          const struct OpcionesBanco *op, struct Comparacion *c) {
+    memset(c, 0, sizeof(struct Comparacion));
+    c->memoriaPicoKB = -1;
+
+#ifndef _WIN32
+    int tubo[2];
+    if (pipe(tubo) == 0) {
+        fflush(NULL);
+        pid_t hijo = fork();
+        if (hijo == 0) {
+            close(tubo[0]);
+            alarm((unsigned)(4.0 * op->limite) + 1);
+            if (motor == MOTOR_DELAUNAY) mallarConDelaunay(conjunto, op, c);
+            else mallarConTriangle(conjunto, op, c);
+            ssize_t escrito = write(tubo[1], c, sizeof(struct Comparacion));
+            _exit(escrito == (ssize_t)sizeof(struct Comparacion) ? 0 : 1);
+        }
+        close(tubo[1]);
+        if (hijo > 0) {
+            ssize_t leido = read(tubo[0], c, sizeof(struct Comparacion));
+            int estado;
+            struct rusage uso;
+            wait4(hijo, &estado, 0, &uso);
+            if (WIFSIGNALED(estado)) {
+                memset(c, 0, sizeof(struct Comparacion));
+                c->codigo = 128 + WTERMSIG(estado);
+            } else if (leido != (ssize_t)sizeof(struct Comparacion)) {
+                c->codigo = SALIDA_TRIANGULACION;
+            }
+#  ifdef __APPLE__
+            c->memoriaPicoKB = uso.ru_maxrss / 1024;
+#  else
+            c->memoriaPicoKB = uso.ru_maxrss;
+#  endif
+            close(tubo[0]);
+            return;
+        }
+        close(tubo[0]);
+    }
+#endif
+
+    // Sin procesos hijos: en este mismo proceso y sin memoria pico
+    if (motor == MOTOR_DELAUNAY) mallarConDelaunay(conjunto, op, c);
+    else mallarConTriangle(conjunto, op, c);
+}
+
+static void escribirEncabezadoComparacion(FILE *salida, const struct OpcionesBanco *op) {
+    if (op->formato == FORMATO_JSON) {
+        fprintf(salida, "{\n  \"semilla\": %llu,\n  \"angulo_minimo\": %g,\n"
+                        "  \"comparacion\": [",
+                (unsigned long long)op->semilla, op->anguloMinimo);
+        return;
+    }
+    fprintf(salida, "generador,n,motor,repeticion,codigo,segundos,memoria_pico_kb,puntos,"
+                    "triangulos,degenerados,no_delaunay,aristas_sobrantes,segmentos_faltantes\n");
+}
+
+static void escribirComparacion(FILE *salida, const struct OpcionesBanco *op, bool primera,
+                                const char *generador, int n, enum Motor motor, int repeticion,
+                                const struct Comparacion *c) {
+    if (op->formato == FORMATO_JSON) {
+        fprintf(salida, "%s\n    {\"generador\": \"%s\", \"n\": %d, \"motor\": \"%s\", "
+                        "\"repeticion\": %d, \"codigo\": %d, \"segundos\": %.9f, "
+                        "\"memoria_pico_kb\": %ld, \"puntos\": %d, \"triangulos\": %d, "
+                        "\"degenerados\": %d, \"no_delaunay\": %d, \"aristas_sobrantes\": %d, "
+                        "\"segmentos_faltantes\": %d}",
+                primera ? "" : ",", generador, n, nombresMotores[motor], repeticion, c->codigo,
+                c->segundos, c->memoriaPicoKB, c->numPuntos, c->numTriangulos, c->degenerados,
+                c->noDelaunay, c->aristasSobrantes, c->segmentosFaltantes);
+        return;
+    }
+    fprintf(salida, "%s,%d,%s,%d,%d,%.9f,%ld,%d,%d,%d,%d,%d,%d\n",
+            generador, n, nombresMotores[motor], repeticion, c->codigo, c->segundos,
+            c->memoriaPicoKB, c->numPuntos, c->numTriangulos, c->degenerados, c->noDelaunay,
+            c->aristasSobrantes, c->segmentosFaltantes);
+}
+
+// Corre cada entrada en ambos motores. La omisión por tiempo estimado solo
+// afecta a Delaunay.c; triangle.c se mide en todos los tamaños.
+static void compararConTriangle(const struct OpcionesBanco *op, FILE *salida) {
+    escribirEncabezadoComparacion(salida, op);
+    bool primera = true;
+
+    for (int g = 0; g < NUM_GENERADORES; g++) {
+        if (!generadorElegido(op->generadores, generadores[g].nombre)) continue;
+        double ultimoTiempo = 0.0;
+        int ultimoN = 0;
+
+        for (int t = 0; t < op->numTamanos; t++) {
+            int n = op->tamanos[t];
+            bool omitirDelaunay = false;
+            if (ultimoN > 0) {
+                double razon = (double)n / ultimoN;
+                if (ultimoTiempo * razon * razon > op->limite) {
+                    TRAZA_AVISO("%s: se omite delaunay con n=%d (estimado %.0f s > %.0f s)\n",
+                                generadores[g].nombre, n, ultimoTiempo * razon * razon, op->limite);
+                    omitirDelaunay = true;
+                }
+            }
+
+            struct Aleatorio azar = { op->semilla ^ ((uint64_t)g << 32) ^ (uint64_t)n };
+            struct ConjuntoPuntos conjunto;
+            if (!generadores[g].generar(&azar, n, op, &conjunto)) {
+                TRAZA_ERROR("%s: no se pudo generar n=%d\n", generadores[g].nombre, n);
+                break;
+            }
+
+            double mejor = DBL_MAX;
+            for (int r = 0; r < op->repeticiones; r++) {
+                for (int m = 0; m < NUM_MOTORES; m++) {
+                    if (m == MOTOR_DELAUNAY && omitirDelaunay) continue;
+                    struct Comparacion c;
+                    ejecutarMotor((enum Motor)m, &conjunto, op, &c);
+                    escribirComparacion(salida, op, primera, generadores[g].nombre, n,
+                                        (enum Motor)m, r, &c);
+                    fflush(salida);
+                    primera = false;
+                    if (m == MOTOR_DELAUNAY && c.segundos < mejor) mejor = c.segundos;
+                }
+            }
+            liberarConjunto(&conjunto);
+
+            if (!omitirDelaunay) {
+                ultimoTiempo = mejor;
+                ultimoN = n;
+            }
+        }
+    }
+
+    if (op->formato == FORMATO_JSON) fprintf(salida, "\n  ]\n}\n");
+}
+
+# endif /* COMPARAR_TRIANGLE */
+
+
+/* Programa principal                                                         */
+
+static void usoBanco(void) {
+    fprintf(stderr,
+        "Uso: bench [-g generadores] [-n tamaños] [-r repeticiones] [-s semilla]\n"
+        "           [-l segundos] [-q ángulo] [-a motor] [-f csv|json] [-o archivo]\n"
+        "           [-d directorio de datos] [-t directorio temporal] [-k]\n"
+        "  -g  Lista separada por comas (defecto: todos)\n"
+        "  -n  Tamaños separados por comas (defecto: " TAMANOS_DEFECTO ")\n"
+        "  -l  Omite los tamaños cuya duración estimada supere este límite\n"
+        "  -q  Refinamiento de calidad con este ángulo mínimo\n"
+        "  -a  Triangulación inicial: dyv, incremental, barrido (defecto) o auto\n"
+        "  -k  Conserva los archivos generados\n"
+        "  -c  Compara con triangle.c (compilado con -DCOMPARAR_TRIANGLE)\n"
+        "Generadores:");
+    for (int i = 0; i < NUM_GENERADORES; i++) fprintf(stderr, " %s", generadores[i].nombre);
+    fprintf(stderr, "\n");
+}
+
+static int leerAlgoritmo(const char *nombre, struct OpcionesBanco *op) {
+    for (int i = 0; i < NUM_ALGORITMOS; i++) {
+        if (strcmp(nombre, opcionesAlgoritmo[i]) == 0) {
+            op->algoritmo = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int leerTamanos(const char *lista, struct OpcionesBanco *op) {
+    op->numTamanos = 0;
+    const char *p = lista;
+    while (*p) {
+        char *fin;
+        double valor = strtod(p, &fin);   // Acepta 1e6
+        if (fin == p || valor < 3 || valor > INT_MAX || op->numTamanos == MAX_TAMANOS) return 0;
+        op->tamanos[op->numTamanos++] = (int)valor;
+        p = (*fin == ',') ? fin + 1 : fin;
+        if (*fin != ',' && *fin != '\0') return 0;
+    }
+    return op->numTamanos > 0;
+}
+
+int main(int argc, char **argv) {
+    struct OpcionesBanco op;
+    memset(&op, 0, sizeof(op));
+    op.repeticiones = 3;
+    op.semilla = 1;
+    op.algoritmo = ALGORITMO_BARRIDO;
+    op.limite = LIMITE_DEFECTO;
+    op.formato = FORMATO_CSV;
+    op.directorioDatos = "..";
+    op.directorioTemporal = ".";
+    leerTamanos(TAMANOS_DEFECTO, &op);
+    nivelDetalle = NIVEL_AVISO;     // Errores y tamaños omitidos a stderr
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *valor = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool usaValor = true;
+
+        if (strcmp(arg, "-g") == 0 && valor) op.generadores = valor;
+        else if (strcmp(arg, "-n") == 0 && valor) {
+            if (!leerTamanos(valor, &op)) { usoBanco(); return SALIDA_USO; }
+        }
+        else if (strcmp(arg, "-r") == 0 && valor) op.repeticiones = atoi(valor);
+        else if (strcmp(arg, "-s") == 0 && valor) op.semilla = strtoull(valor, NULL, 10);
+        else if (strcmp(arg, "-l") == 0 && valor) op.limite = atof(valor);
+        else if (strcmp(arg, "-q") == 0 && valor) op.anguloMinimo = atof(valor);
+        else if (strcmp(arg, "-a") == 0 && valor) {
+            if (!leerAlgoritmo(valor, &op)) { usoBanco(); return SALIDA_USO; }
+        }
+        else if (strcmp(arg, "-f") == 0 && valor) {
+            if (strcmp(valor, "json") == 0) op.formato = FORMATO_JSON;
+            else if (strcmp(valor, "csv") == 0) op.formato = FORMATO_CSV;
+            else { usoBanco(); return SALIDA_USO; }
+        }
+        else if (strcmp(arg, "-o") == 0 && valor) op.archivoSalida = valor;
+        else if (strcmp(arg, "-d") == 0 && valor) op.directorioDatos = valor;
+        else if (strcmp(arg, "-t") == 0 && valor) op.directorioTemporal = valor;
+        else if (strcmp(arg, "-k") == 0) { op.conservarArchivos = true; usaValor = false; }
+        else if (strcmp(arg, "-c") == 0) { op.compararTriangle = true; usaValor = false; }
+        else { usoBanco(); return SALIDA_USO; }
+
+        if (usaValor) i++;
+    }
+    if (op.repeticiones < 1) op.repeticiones = 1;
+
+    FILE *salida = stdout;
+    if (op.archivoSalida) {
+        salida = fopen(op.archivoSalida, "w");
+        if (!salida) {
+            TRAZA_ERROR("No se pudo crear %s\n", op.archivoSalida);
+            return SALIDA_ESCRITURA;
+        }
+    }
+
+#ifdef COMPARAR_TRIANGLE
+    if (op.compararTriangle) compararConTriangle(&op, salida);
+    else medirFases(&op, salida);
+#else
+    if (op.compararTriangle) {
+        TRAZA_ERROR("-c requiere compilar con -DCOMPARAR_TRIANGLE y triangle.o\n");
+        if (salida != stdout) fclose(salida);
+        return SALIDA_NO_SOPORTADO;
+    }
+    medirFases(&op, salida);
+#endif
+    if (salida != stdout) fclose(salida);
+    return SALIDA_EXITO;
+}
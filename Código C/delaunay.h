@@ -0,0 +1,118 @@
+/******************************************************************************/
+/*                                                                            */
+/**********		      LIBRERIA DE TRIANGULACION DE DELAUNAY		         **********/
+/*                                                                            */
+/******************************************************************************/
+
+/* Interfaz de libdelaunay. Se obtiene compilando Delaunay.c con
+   -DDELAUNAY_LIBRERIA, que excluye main y el menú interactivo:
+
+       gcc -O2 -c -DDELAUNAY_LIBRERIA Delaunay.c -o delaunay.o
+       ar rcs libdelaunay.a delaunay.o
+
+   La entrada y la salida siguen el modelo de struct triangulateio de
+   triangle.c: arreglos planos, vértices numerados desde 0. Cada llamada
+   trabaja sobre su propio contexto y no escribe en stdout ni en archivos,
+   por lo que varios hilos pueden mallar a la vez usando un contexto cada uno. */
+
+#ifndef DELAUNAY_H
+#define DELAUNAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Códigos de resultado (también los códigos de salida del programa)          */
+# define SALIDA_EXITO 0
+# define SALIDA_USO 1              // Argumentos u opciones inválidos
+# define SALIDA_ENTRADA 2          // No se pudo leer o interpretar la entrada
+# define SALIDA_MEMORIA 3
+# define SALIDA_TRIANGULACION 4    // La triangulación falló o no pasó la verificación
+# define SALIDA_ESCRITURA 5
+# define SALIDA_NO_SOPORTADO 6     // Opción reconocida pero no implementada
+
+/* Niveles de detalle de los mensajes                                         */
+# define NIVEL_SILENCIOSO 0
+# define NIVEL_ERROR 1
+# define NIVEL_AVISO 2
+# define NIVEL_NORMAL 3
+# define NIVEL_DETALLADO 4
+# define NIVEL_DEPURACION 5
+
+/* Ubicación de los puntos Steiner del refinamiento (OpcionesDelaunay y -o)  */
+# define STEINER_CIRCUNCENTRO 0    // Circuncentro del triángulo malo
+# define STEINER_FUERA_CENTRO 1    // Fuera de centro de Üngör
+# define STEINER_TRIANGLE 2        // Fuera de centro con la constante de triangle.c
+
+/* Triangulación inicial (OpcionesDelaunay, -i, -F y -A)                   */
+# define ALGORITMO_DIVIDE_Y_VENCERAS 0   // Divide y vencerás; no pasa la verificación
+                                         // de la malla, solo para comparar
+# define ALGORITMO_INCREMENTAL 1         // Inserción incremental (Bowyer-Watson)
+# define ALGORITMO_BARRIDO 2             // Barrido con frente de avance (defecto)
+# define ALGORITMO_AUTOMATICO 3          // Elige el motor y los hilos según la entrada
+
+/* Entrada y salida de una triangulación. En la entrada se usan los puntos,
+   segmentos, agujeros y regiones; en la salida se llenan los puntos (con los
+   Steiner agregados), triángulos, vecinos y segmentos. Los arreglos de
+   salida los reserva la librería y se liberan con delaunayLiberarES.        */
+struct DelaunayES {
+    double *listaPuntos;              // x, y por punto
+    int *listaMarcadoresPuntos;       // Opcional, uno por punto
+    int numPuntos;
+
+    int *listaTriangulos;             // 3 vértices por triángulo
+    int *listaVecinos;                // 3 por triángulo, -1 en el borde
+    int numTriangulos;
+
+    int *listaSegmentos;              // 2 vértices por segmento
+    int *listaMarcadoresSegmentos;    // Opcional, uno por segmento
+    int numSegmentos;
+
+    double *listaAgujeros;            // x, y por agujero
+    int numAgujeros;
+
+    double *listaRegiones;            // x, y, atributo, área máxima por región
+    int numRegiones;
+};
+
+/* Opciones de mallado (equivalentes a los switches -q, -a, -D, -o, -j y -k)   */
+struct OpcionesDelaunay {
+    double anguloMinimo;     // Grados; 0 desactiva la restricción de calidad
+    double areaMaxima;       // Área máxima global; <= 0 sin restricción
+    int usarAreasRegion;     // Aplicar el área máxima de cada región
+    int conforme;            // Delaunay conforme
+    int hilos;               // 0 = valor por defecto
+    int calcularVecinos;     // Llenar listaVecinos
+    int nivelDetalle;        // NIVEL_SILENCIOSO por defecto
+    const char *directorioCache;  // Caché de resultados en disco; NULL la desactiva
+    double megabytesCache;        // Límite del directorio; <= 0 usa 1024 MB
+    int posicionSteiner;     // STEINER_*; STEINER_TRIANGLE por defecto
+    int eliminarRepetidos;   // Quitar vértices repetidos antes de triangular; la
+                             // salida numera solo los que quedan
+    double toleranciaRepetidos;  // Distancia para considerarlos repetidos (0 = idénticos)
+    int algoritmo;           // ALGORITMO_*; ALGORITMO_BARRIDO por defecto
+};
+
+typedef struct ContextoDelaunay ContextoDelaunay;
+
+ContextoDelaunay *delaunayCrearContexto(void);
+void delaunayDestruirContexto(ContextoDelaunay *ctx);
+void delaunayOpcionesPorDefecto(struct OpcionesDelaunay *op);
+
+// Devuelve SALIDA_EXITO o un código de error; el mensaje queda en el contexto
+int delaunayTriangular(ContextoDelaunay *ctx, const struct OpcionesDelaunay *op,
+                       const struct DelaunayES *entrada, struct DelaunayES *salida);
+
+const char *delaunayUltimoError(const ContextoDelaunay *ctx);
+
+// Contadores de operaciones de la última llamada (predicados, intercambios,
+// recorridos, cavidades, puntos Steiner rechazados y asignaciones) como un
+// objeto JSON; el texto pertenece al contexto
+const char *delaunayContadoresJSON(ContextoDelaunay *ctx);
+void delaunayLiberarES(struct DelaunayES *es);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELAUNAY_H */
@@ -0,0 +1,859 @@
+/******************************************************************************/
+/*                                                                            */
+/**********		     SERVIDOR DE TRABAJOS DE MALLADO		         **********/
+/*                                                                            */
+/******************************************************************************/
+
+/* Atiende trabajos de mallado por un socket Unix local. Cada trabajo trae un
+   PSLG (puntos, segmentos, agujeros y regiones) y sus opciones; la respuesta
+   es la malla en formato .bmesh. Los trabajos se reparten entre un número
+   fijo de hilos; cada hilo conserva sus búferes entre trabajos, de modo que
+   el arranque del proceso y el calentamiento del asignador de memoria se
+   pagan una sola vez.
+
+   Compilación (incluye Delaunay.c como librería; solo POSIX):
+
+       gcc -O2 -pthread -o servidor servidor.c -lm
+
+   Uso:
+
+       servidor [-j hilos] [-v] socket                  (atiende trabajos)
+       servidor -c socket archivo.poly [-n repeticiones] [-q ángulo] [-a área]
+                [-i | -F | -A] [-t posición] [-d]       (cliente de prueba)
+
+   El cliente envía el .poly, guarda la malla en archivo.1.bmesh y muestra
+   las latencias (mediana, p99 y máxima) de las repeticiones.
+
+   Protocolo (todos los campos en little-endian). Una conexión puede enviar
+   varios trabajos seguidos; cada uno recibe su respuesta en orden.
+
+   Solicitud:
+       char     magia[4]            "DLNJ"
+       uint32   version             2 (en la 1 el campo opciones era
+                                    reservado); otra versión se rechaza
+                                    con SALIDA_ENTRADA
+       uint32   numPuntos, numSegmentos, numAgujeros, numRegiones
+       uint32   banderas            bit 0: áreas por región
+                                    bit 1: Delaunay conforme
+                                    bit 2: trae marcadores de puntos
+                                    bit 3: trae marcadores de segmentos
+       uint32   opciones            bits 0-3: ALGORITMO_* + 1
+                                    bits 4-7: STEINER_* + 1
+                                    bit 8: elimina vértices repetidos
+                                    (idénticos); 0 deja los valores por
+                                    defecto de delaunayOpcionesPorDefecto
+       double   anguloMinimo        Grados; 0 sin restricción de calidad
+       double   areaMaxima          <= 0 sin restricción
+       uint64   longitudDatos       Bytes que siguen a la cabecera
+     seguida de:
+       double   puntos[2 * numPuntos]
+       int32    marcadoresPuntos[numPuntos]          (bit 2)
+       int32    segmentos[2 * numSegmentos]         (numeración desde 0)
+       int32    marcadoresSegmentos[numSegmentos]   (bit 3)
+       double   agujeros[2 * numAgujeros]
+       double   regiones[4 * numRegiones]           (x, y, atributo, área)
+
+   Respuesta:
+       char     magia[4]            "DLNR"
+       int32    codigo              SALIDA_EXITO o un código de error
+       uint64   longitud
+     seguida de la malla .bmesh (codigo 0) o del mensaje de error. */
+
+# define DELAUNAY_LIBRERIA
+# include "Delaunay.c"
+
+# ifdef _WIN32
+#  error "servidor.c requiere sockets Unix y pthreads (POSIX)"
+# endif
+
+# include <errno.h>
+# include <pthread.h>
+# include <signal.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <time.h>
+# include <unistd.h>
+
+/* Constantes                                                                 */
+# define PROTOCOLO_MAGIA_SOLICITUD "DLNJ"
+# define PROTOCOLO_MAGIA_RESPUESTA "DLNR"
+# define PROTOCOLO_VERSION 2
+
+# define BANDERA_AREAS_REGION        (1u << 0)
+# define BANDERA_CONFORME            (1u << 1)
+# define BANDERA_MARCADORES_PUNTOS   (1u << 2)
+# define BANDERA_MARCADORES_SEGMENTOS (1u << 3)
+
+// Campos de CabeceraSolicitud.opciones; un campo en 0 toma el valor por defecto
+# define OPCION_ALGORITMO(o)         ((int)((o) & 0xfu) - 1)
+# define OPCION_STEINER(o)           ((int)(((o) >> 4) & 0xfu) - 1)
+# define CAMPO_ALGORITMO(a)          ((uint32_t)((a) + 1) & 0xfu)
+# define CAMPO_STEINER(s)            (((uint32_t)((s) + 1) & 0xfu) << 4)
+# define OPCION_ELIMINAR_REPETIDOS   (1u << 8)
+# define OPCIONES_CONOCIDAS          0x1ffu
+
+# define MAX_ELEMENTOS_TRABAJO (1u << 28)       // Por arreglo
+# define MAX_DATOS_TRABAJO ((uint64_t)1 << 34)  // 16 GiB por solicitud
+# define TAMANO_BUFER_SALIDA (1 << 20)          // Búfer de stdio por hilo
+# define MAX_HILOS_SERVIDOR 256
+# define TAMANO_COLA_CONEXIONES 128
+# define REPETICIONES_DEFECTO 1
+
+struct CabeceraSolicitud {
+    char magia[4];
+    uint32_t version;
+    uint32_t numPuntos;
+    uint32_t numSegmentos;
+    uint32_t numAgujeros;
+    uint32_t numRegiones;
+    uint32_t banderas;
+    uint32_t opciones;
+    double anguloMinimo;
+    double areaMaxima;
+    uint64_t longitudDatos;
+};
+
+struct CabeceraRespuesta {
+    char magia[4];
+    int32_t codigo;
+    uint64_t longitud;
+};
+
+// Búferes propios de un hilo, reutilizados entre trabajos. Solo crecen.
+struct ArenaTrabajador {
+    unsigned char *datos;        // Carga útil de la solicitud
+    size_t capacidadDatos;
+    struct Punto *vertices;
+    size_t capacidadVertices;
+    int *marcadores;
+    size_t capacidadMarcadores;
+    struct Segmento *segmentos;
+    size_t capacidadSegmentos;
+    struct Punto *agujeros;
+    size_t capacidadAgujeros;
+    struct Region *regiones;
+    size_t capacidadRegiones;
+    char *buferSalida;           // Búfer de stdio hacia el socket
+    char error[TAMANO_MENSAJE_ERROR];
+};
+
+struct Trabajador {
+    pthread_t hilo;
+    int indice;
+    int conexion;                // -1 si está libre
+    long long trabajos;
+    struct ArenaTrabajador arena;
+};
+
+// Cola circular de conexiones aceptadas pendientes de atender
+struct ColaConexiones {
+    int conexiones[TAMANO_COLA_CONEXIONES];
+    int inicio;
+    int cantidad;
+    bool terminar;
+    pthread_mutex_t cerrojo;
+    pthread_cond_t hayConexion;
+    pthread_cond_t hayEspacio;
+};
+
+static struct ColaConexiones cola = {
+    .cerrojo = PTHREAD_MUTEX_INITIALIZER,
+    .hayConexion = PTHREAD_COND_INITIALIZER,
+    .hayEspacio = PTHREAD_COND_INITIALIZER,
+};
+static struct Trabajador *trabajadores;
+static int numTrabajadores;
+static bool servidorDetallado;
+static volatile sig_atomic_t senalTerminar = 0;
+
+
+/* Utilidades de E/S                                                          */
+
+static double relojSegundos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Lee exactamente n bytes; devuelve 0 si la conexión se cerró o falló
+static int leerExacto(int fd, void *destino, size_t n) {
+    char *p = destino;
+    while (n > 0) {
+        ssize_t leidos = read(fd, p, n);
+        if (leidos < 0 && errno == EINTR) continue;
+        if (leidos <= 0) return 0;
+        p += leidos;
+        n -= (size_t)leidos;
+    }
+    return 1;
+}
+
+static int escribirExacto(int fd, const void *origen, size_t n) {
+    const char *p = origen;
+    while (n > 0) {
+        ssize_t escritos = write(fd, p, n);
+        if (escritos < 0 && errno == EINTR) continue;
+        if (escritos <= 0) return 0;
+        p += escritos;
+        n -= (size_t)escritos;
+    }
+    return 1;
+}
+
+// Asegura que *bufer tenga al menos necesario bytes sin conservar su contenido
+static int reservarArena(void **bufer, size_t *capacidad, size_t necesario) {
+    if (necesario <= *capacidad) return 1;
+    size_t nueva = *capacidad > 0 ? *capacidad : 4096;
+    while (nueva < necesario) nueva *= 2;
+    void *p = malloc(nueva);
+    if (!p) return 0;
+    free(*bufer);
+    *bufer = p;
+    *capacidad = nueva;
+    return 1;
+}
+
+static void liberarArena(struct ArenaTrabajador *arena) {
+    free(arena->datos);
+    free(arena->vertices);
+    free(arena->marcadores);
+    free(arena->segmentos);
+    free(arena->agujeros);
+    free(arena->regiones);
+    free(arena->buferSalida);
+    memset(arena, 0, sizeof(struct ArenaTrabajador));
+}
+
+static void cabeceraSolicitudAHost(struct CabeceraSolicitud *c) {
+    if (esHostBigEndian()) {
+        intercambiarBytes(&c->version, 7, 4);
+        intercambiarBytes(&c->anguloMinimo, 3, 8);
+    }
+}
+
+static void cabeceraRespuestaAHost(struct CabeceraRespuesta *c) {
+    if (esHostBigEndian()) {
+        intercambiarBytes(&c->codigo, 1, 4);
+        intercambiarBytes(&c->longitud, 1, 8);
+    }
+}
+
+// Bytes de carga útil que corresponden a la cabecera
+static uint64_t longitudEsperada(const struct CabeceraSolicitud *c) {
+    uint64_t n = (uint64_t)c->numPuntos * 2 * sizeof(double);
+    if (c->banderas & BANDERA_MARCADORES_PUNTOS) n += (uint64_t)c->numPuntos * sizeof(int32_t);
+    n += (uint64_t)c->numSegmentos * 2 * sizeof(int32_t);
+    if (c->banderas & BANDERA_MARCADORES_SEGMENTOS) n += (uint64_t)c->numSegmentos * sizeof(int32_t);
+    n += (uint64_t)c->numAgujeros * 2 * sizeof(double);
+    n += (uint64_t)c->numRegiones * 4 * sizeof(double);
+    return n;
+}
+
+
+/* Funciones del servidor                                                     */
+
+// Convierte la carga útil a una EntradaPoly cuyos arreglos viven en la arena.
+// La entrada no se libera con liberarEntradaPoly.
+static int entradaDesdeSolicitud(struct ArenaTrabajador *arena, const struct CabeceraSolicitud *c,
+                                 struct EntradaPoly *entrada) {
+    memset(entrada, 0, sizeof(struct EntradaPoly));
+    size_t np = c->numPuntos, ns = c->numSegmentos, nh = c->numAgujeros, nr = c->numRegiones;
+    bool bigEndian = esHostBigEndian();
+
+    if (!reservarArena((void **)&arena->vertices, &arena->capacidadVertices, np * sizeof(struct Punto)) ||
+        !reservarArena((void **)&arena->marcadores, &arena->capacidadMarcadores, np * sizeof(int)) ||
+        !reservarArena((void **)&arena->segmentos, &arena->capacidadSegmentos, ns * sizeof(struct Segmento)) ||
+        !reservarArena((void **)&arena->agujeros, &arena->capacidadAgujeros, nh * sizeof(struct Punto)) ||
+        !reservarArena((void **)&arena->regiones, &arena->capacidadRegiones, nr * sizeof(struct Region))) {
+        TRAZA_ERROR("No se pudo asignar memoria para la entrada\n");
+        return SALIDA_MEMORIA;
+    }
+
+    // Los arreglos de la carga útil no están necesariamente alineados
+    unsigned char *p = arena->datos;
+#define LEER_CAMPO(destino, tam) do {                       \
+        memcpy(&(destino), p, (tam));                       \
+        if (bigEndian) intercambiarBytes(&(destino), 1, (tam)); \
+        p += (tam);                                         \
+    } while (0)
+
+    entrada->numVertices = (int)np;
+    entrada->vertices = arena->vertices;
+    for (size_t i = 0; i < np; i++) {
+        LEER_CAMPO(entrada->vertices[i].x, 8);
+        LEER_CAMPO(entrada->vertices[i].y, 8);
+        entrada->vertices[i].indice = (int)i;
+        if (!isfinite(entrada->vertices[i].x) || !isfinite(entrada->vertices[i].y)) {
+            TRAZA_ERROR("El punto %zu tiene coordenadas no finitas\n", i);
+            return SALIDA_ENTRADA;
+        }
+    }
+    if (c->banderas & BANDERA_MARCADORES_PUNTOS) {
+        entrada->numMarcadores = 1;
+        entrada->marcadores = arena->marcadores;
+        for (size_t i = 0; i < np; i++) {
+            int32_t m;
+            LEER_CAMPO(m, 4);
+            entrada->marcadores[i] = m;
+        }
+    }
+
+    entrada->numSegmentos = (int)ns;
+    entrada->segmentos = arena->segmentos;
+    for (size_t i = 0; i < ns; i++) {
+        int32_t v1, v2;
+        LEER_CAMPO(v1, 4);
+        LEER_CAMPO(v2, 4);
+        if (v1 < 0 || (size_t)v1 >= np || v2 < 0 || (size_t)v2 >= np) {
+            TRAZA_ERROR("El segmento %zu referencia un vértice inexistente\n", i);
+            return SALIDA_ENTRADA;
+        }
+        entrada->segmentos[i].v1 = v1;
+        entrada->segmentos[i].v2 = v2;
+        entrada->segmentos[i].marcador = 0;
+    }
+    if (c->banderas & BANDERA_MARCADORES_SEGMENTOS) {
+        for (size_t i = 0; i < ns; i++) {
+            int32_t m;
+            LEER_CAMPO(m, 4);
+            entrada->segmentos[i].marcador = m;
+        }
+    }
+
+    entrada->numAgujeros = (int)nh;
+    entrada->agujeros = arena->agujeros;
+    for (size_t i = 0; i < nh; i++) {
+        LEER_CAMPO(entrada->agujeros[i].x, 8);
+        LEER_CAMPO(entrada->agujeros[i].y, 8);
+        entrada->agujeros[i].indice = (int)i;
+    }
+
+    entrada->numRegiones = (int)nr;
+    entrada->regiones = arena->regiones;
+    for (size_t i = 0; i < nr; i++) {
+        double atributo;
+        LEER_CAMPO(entrada->regiones[i].x, 8);
+        LEER_CAMPO(entrada->regiones[i].y, 8);
+        LEER_CAMPO(atributo, 8);
+        LEER_CAMPO(entrada->regiones[i].areaMaxima, 8);
+        entrada->regiones[i].atributo = (int)atributo;
+    }
+#undef LEER_CAMPO
+
+    if (entrada->numVertices < 3) {
+        TRAZA_ERROR("Se necesitan al menos 3 puntos (hay %d)\n", entrada->numVertices);
+        return SALIDA_ENTRADA;
+    }
+    return SALIDA_EXITO;
+}
+
+static int enviarError(FILE *salida, int codigo, const char *mensaje) {
+    struct CabeceraRespuesta r;
+    memcpy(r.magia, PROTOCOLO_MAGIA_RESPUESTA, 4);
+    r.codigo = codigo;
+    r.longitud = strlen(mensaje);
+    cabeceraRespuestaAHost(&r);
+    return fwrite(&r, sizeof(r), 1, salida) == 1 &&
+           fwrite(mensaje, 1, strlen(mensaje), salida) == strlen(mensaje) &&
+           fflush(salida) == 0;
+}
+
+// Ejecuta un trabajo ya leído y envía su respuesta. Devuelve 0 si la
+// conexión dejó de servir.
+static int atenderTrabajo(struct Trabajador *t, const struct CabeceraSolicitud *c, FILE *salida) {
+    struct ArenaTrabajador *arena = &t->arena;
+    double inicio = relojSegundos();
+    arena->error[0] = '\0';
+
+    struct OpcionesDelaunay op;
+    delaunayOpcionesPorDefecto(&op);
+    op.anguloMinimo = c->anguloMinimo;
+    op.areaMaxima = c->areaMaxima;
+    op.usarAreasRegion = (c->banderas & BANDERA_AREAS_REGION) != 0;
+    op.conforme = (c->banderas & BANDERA_CONFORME) != 0;
+    op.eliminarRepetidos = (c->opciones & OPCION_ELIMINAR_REPETIDOS) != 0;
+    if (OPCION_ALGORITMO(c->opciones) >= 0) op.algoritmo = OPCION_ALGORITMO(c->opciones);
+    if (OPCION_STEINER(c->opciones) >= 0) op.posicionSteiner = OPCION_STEINER(c->opciones);
+    op.hilos = 1;   // El paralelismo lo da el número de trabajadores
+
+    struct EntradaPoly entrada;
+    struct Triangulacion *tr = NULL;
+    struct MallaBinaria malla;
+    int codigo = SALIDA_EXITO;
+    if ((c->opciones & ~OPCIONES_CONOCIDAS) != 0 || op.algoritmo > ALGORITMO_AUTOMATICO ||
+        op.posicionSteiner > STEINER_TRIANGLE) {
+        snprintf(arena->error, sizeof(arena->error), "Opciones de la solicitud inválidas: 0x%x",
+                 (unsigned)c->opciones);
+        codigo = SALIDA_USO;
+    }
+    if (codigo == SALIDA_EXITO) {
+        codigo = entradaDesdeSolicitud(arena, c, &entrada);
+    }
+    if (codigo == SALIDA_EXITO) {
+        codigo = mallarEntrada(&entrada, &op, &tr);
+        // Con -D, -q o -a la entrada pasa a tener los subsegmentos de la
+        // malla en un arreglo nuevo, que libera al anterior de la arena
+        if (entrada.segmentos != arena->segmentos) {
+            arena->segmentos = entrada.segmentos;
+            arena->capacidadSegmentos = (size_t)entrada.numSegmentos * sizeof(struct Segmento);
+        }
+    }
+    if (codigo == SALIDA_EXITO) {
+        if (!mallaDesdeTriangulacion(tr, &entrada, &malla)) {
+            TRAZA_ERROR("No se pudo asignar memoria para la salida\n");
+            codigo = SALIDA_MEMORIA;
+        }
+        liberarTriangulacion(tr);
+    }
+
+    int correcto;
+    if (codigo != SALIDA_EXITO) {
+        if (arena->error[0] == '\0') {
+            snprintf(arena->error, sizeof(arena->error), "Error %d", codigo);
+        }
+        correcto = enviarError(salida, codigo, arena->error);
+    } else {
+        struct CabeceraRespuesta r;
+        memcpy(r.magia, PROTOCOLO_MAGIA_RESPUESTA, 4);
+        r.codigo = SALIDA_EXITO;
+        r.longitud = tamanoBMesh(&malla);
+        cabeceraRespuestaAHost(&r);
+        correcto = fwrite(&r, sizeof(r), 1, salida) == 1 &&
+                   escribirBMesh(&malla, salida) &&
+                   fflush(salida) == 0;
+        liberarMallaBinaria(&malla);
+    }
+
+    t->trabajos++;
+    if (servidorDetallado) {
+        fprintf(stderr, "[hilo %d] trabajo %lld: %u puntos, código %d, %.3f ms\n",
+                t->indice, t->trabajos, c->numPuntos, codigo, (relojSegundos() - inicio) * 1e3);
+    }
+    return correcto;
+}
+
+// Atiende los trabajos de una conexión hasta que el cliente la cierre
+static void atenderConexion(struct Trabajador *t, int conexion) {
+    struct ArenaTrabajador *arena = &t->arena;
+    FILE *salida = fdopen(dup(conexion), "wb");
+    if (!salida) return;
+    setvbuf(salida, arena->buferSalida, _IOFBF, TAMANO_BUFER_SALIDA);
+
+    struct CabeceraSolicitud c;
+    while (leerExacto(conexion, &c, sizeof(c))) {
+        cabeceraSolicitudAHost(&c);
+        if (memcmp(c.magia, PROTOCOLO_MAGIA_SOLICITUD, 4) != 0) {
+            enviarError(salida, SALIDA_ENTRADA, "Cabecera de solicitud inválida");
+            break;
+        }
+        if (c.version != PROTOCOLO_VERSION) {
+            // La cabecera de otra versión puede tener otra longitud o campos
+            // con otro significado: no se sigue leyendo la conexión
+            char mensaje[64];
+            snprintf(mensaje, sizeof(mensaje), "Versión de protocolo %u no soportada (se espera %d)",
+                     (unsigned)c.version, PROTOCOLO_VERSION);
+            enviarError(salida, SALIDA_ENTRADA, mensaje);
+            break;
+        }
+        if (c.numPuntos > MAX_ELEMENTOS_TRABAJO || c.numSegmentos > MAX_ELEMENTOS_TRABAJO ||
+            c.numAgujeros > MAX_ELEMENTOS_TRABAJO || c.numRegiones > MAX_ELEMENTOS_TRABAJO ||
+            c.longitudDatos > MAX_DATOS_TRABAJO || c.longitudDatos != longitudEsperada(&c)) {
+            // Sin una longitud confiable no se puede seguir leyendo la conexión
+            enviarError(salida, SALIDA_ENTRADA, "Longitud de datos inconsistente con la cabecera");
+            break;
+        }
+        if (!reservarArena((void **)&arena->datos, &arena->capacidadDatos, (size_t)c.longitudDatos)) {
+            enviarError(salida, SALIDA_MEMORIA, "Memoria insuficiente");
+            break;
+        }
+        if (!leerExacto(conexion, arena->datos, (size_t)c.longitudDatos)) break;
+        if (!atenderTrabajo(t, &c, salida)) break;
+    }
+    fclose(salida);
+}
+
+static void *bucleTrabajador(void *arg) {
+    struct Trabajador *t = arg;
+
+    // El estado de trazas es local al hilo: silencioso y con errores a la arena
+    nivelDetalle = NIVEL_SILENCIOSO;
+    mensajeError = t->arena.error;
+
+    for (;;) {
+        pthread_mutex_lock(&cola.cerrojo);
+        while (cola.cantidad == 0 && !cola.terminar) {
+            pthread_cond_wait(&cola.hayConexion, &cola.cerrojo);
+        }
+        if (cola.cantidad == 0) {
+            pthread_mutex_unlock(&cola.cerrojo);
+            break;
+        }
+        int conexion = cola.conexiones[cola.inicio];
+        cola.inicio = (cola.inicio + 1) % TAMANO_COLA_CONEXIONES;
+        cola.cantidad--;
+        t->conexion = conexion;
+        pthread_cond_signal(&cola.hayEspacio);
+        pthread_mutex_unlock(&cola.cerrojo);
+
+        atenderConexion(t, conexion);
+
+        pthread_mutex_lock(&cola.cerrojo);
+        t->conexion = -1;
+        pthread_mutex_unlock(&cola.cerrojo);
+        close(conexion);
+    }
+    return NULL;
+}
+
+static void manejarSenal(int senal) {
+    (void)senal;
+    senalTerminar = 1;
+}
+
+static int crearSocketServidor(const char *ruta) {
+    struct sockaddr_un direccion;
+    if (strlen(ruta) >= sizeof(direccion.sun_path)) {
+        TRAZA_ERROR("La ruta del socket es demasiado larga: %s\n", ruta);
+        return -1;
+    }
+    memset(&direccion, 0, sizeof(direccion));
+    direccion.sun_family = AF_UNIX;
+    strcpy(direccion.sun_path, ruta);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        TRAZA_ERROR("No se pudo crear el socket: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(ruta);
+    if (bind(fd, (struct sockaddr *)&direccion, sizeof(direccion)) != 0 ||
+        listen(fd, TAMANO_COLA_CONEXIONES) != 0) {
+        TRAZA_ERROR("No se pudo escuchar en %s: %s\n", ruta, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int ejecutarServidor(const char *ruta, int hilos) {
+    int servidor = crearSocketServidor(ruta);
+    if (servidor < 0) return SALIDA_ESCRITURA;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    // Solo el hilo principal recibe SIGINT/SIGTERM; accept() vuelve con EINTR
+    struct sigaction accion;
+    memset(&accion, 0, sizeof(accion));
+    accion.sa_handler = manejarSenal;
+    sigaction(SIGINT, &accion, NULL);
+    sigaction(SIGTERM, &accion, NULL);
+    sigset_t senales, anteriores;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &senales, &anteriores);
+
+    numTrabajadores = hilos;
+    trabajadores = calloc((size_t)hilos, sizeof(struct Trabajador));
+    if (!trabajadores) {
+        close(servidor);
+        unlink(ruta);
+        return SALIDA_MEMORIA;
+    }
+    int creados = 0;
+    for (int i = 0; i < hilos; i++) {
+        trabajadores[i].indice = i;
+        trabajadores[i].conexion = -1;
+        trabajadores[i].arena.buferSalida = malloc(TAMANO_BUFER_SALIDA);
+        if (!trabajadores[i].arena.buferSalida ||
+            pthread_create(&trabajadores[i].hilo, NULL, bucleTrabajador, &trabajadores[i]) != 0) {
+            free(trabajadores[i].arena.buferSalida);
+            break;
+        }
+        creados++;
+    }
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    if (creados == 0) {
+        TRAZA_ERROR("No se pudo crear ningún hilo de trabajo\n");
+        free(trabajadores);
+        close(servidor);
+        unlink(ruta);
+        return SALIDA_MEMORIA;
+    }
+    TRAZA_INFO("Escuchando en %s con %d hilos\n", ruta, creados);
+
+    while (!senalTerminar) {
+        int conexion = accept(servidor, NULL, NULL);
+        if (conexion < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            TRAZA_ERROR("Error en accept: %s\n", strerror(errno));
+            break;
+        }
+
+        pthread_mutex_lock(&cola.cerrojo);
+        while (cola.cantidad == TAMANO_COLA_CONEXIONES && !senalTerminar) {
+            pthread_cond_wait(&cola.hayEspacio, &cola.cerrojo);
+        }
+        cola.conexiones[(cola.inicio + cola.cantidad) % TAMANO_COLA_CONEXIONES] = conexion;
+        cola.cantidad++;
+        pthread_cond_signal(&cola.hayConexion);
+        pthread_mutex_unlock(&cola.cerrojo);
+    }
+
+    // Cerrar: no aceptar más, despertar a los hilos ociosos y cortar las
+    // conexiones en curso para que los hilos ocupados terminen su lectura
+    close(servidor);
+    unlink(ruta);
+    pthread_mutex_lock(&cola.cerrojo);
+    cola.terminar = true;
+    for (int i = 0; i < cola.cantidad; i++) {
+        close(cola.conexiones[(cola.inicio + i) % TAMANO_COLA_CONEXIONES]);
+    }
+    cola.cantidad = 0;
+    for (int i = 0; i < creados; i++) {
+        if (trabajadores[i].conexion >= 0) shutdown(trabajadores[i].conexion, SHUT_RD);
+    }
+    pthread_cond_broadcast(&cola.hayConexion);
+    pthread_mutex_unlock(&cola.cerrojo);
+
+    long long total = 0;
+    for (int i = 0; i < creados; i++) {
+        pthread_join(trabajadores[i].hilo, NULL);
+        total += trabajadores[i].trabajos;
+        liberarArena(&trabajadores[i].arena);
+    }
+    free(trabajadores);
+    TRAZA_INFO("Servidor detenido tras %lld trabajos\n", total);
+    return SALIDA_EXITO;
+}
+
+
+/* Cliente de prueba                                                          */
+
+// Serializa una EntradaPoly como solicitud (cabecera más carga útil)
+static unsigned char *serializarSolicitud(const struct EntradaPoly *e, double anguloMinimo,
+                                          double areaMaxima, uint32_t opciones, size_t *longitud) {
+    struct CabeceraSolicitud c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magia, PROTOCOLO_MAGIA_SOLICITUD, 4);
+    c.version = PROTOCOLO_VERSION;
+    c.numPuntos = (uint32_t)e->numVertices;
+    c.numSegmentos = (uint32_t)e->numSegmentos;
+    c.numAgujeros = (uint32_t)e->numAgujeros;
+    c.numRegiones = (uint32_t)e->numRegiones;
+    c.banderas = BANDERA_MARCADORES_SEGMENTOS;
+    if (e->marcadores) c.banderas |= BANDERA_MARCADORES_PUNTOS;
+    if (e->numRegiones > 0) c.banderas |= BANDERA_AREAS_REGION;
+    c.anguloMinimo = anguloMinimo;
+    c.areaMaxima = areaMaxima;
+    c.opciones = opciones;
+    c.longitudDatos = longitudEsperada(&c);
+
+    *longitud = sizeof(c) + (size_t)c.longitudDatos;
+    unsigned char *bufer = malloc(*longitud);
+    if (!bufer) return NULL;
+    unsigned char *p = bufer + sizeof(c);
+    bool bigEndian = esHostBigEndian();
+#define ESCRIBIR_CAMPO(valor, tipo) do {                    \
+        tipo v_ = (tipo)(valor);                            \
+        if (bigEndian) intercambiarBytes(&v_, 1, sizeof(tipo)); \
+        memcpy(p, &v_, sizeof(tipo));                       \
+        p += sizeof(tipo);                                  \
+    } while (0)
+
+    for (int i = 0; i < e->numVertices; i++) {
+        ESCRIBIR_CAMPO(e->vertices[i].x, double);
+        ESCRIBIR_CAMPO(e->vertices[i].y, double);
+    }
+    if (e->marcadores) {
+        for (int i = 0; i < e->numVertices; i++) ESCRIBIR_CAMPO(e->marcadores[i], int32_t);
+    }
+    for (int i = 0; i < e->numSegmentos; i++) {
+        ESCRIBIR_CAMPO(e->segmentos[i].v1, int32_t);
+        ESCRIBIR_CAMPO(e->segmentos[i].v2, int32_t);
+    }
+    for (int i = 0; i < e->numSegmentos; i++) ESCRIBIR_CAMPO(e->segmentos[i].marcador, int32_t);
+    for (int i = 0; i < e->numAgujeros; i++) {
+        ESCRIBIR_CAMPO(e->agujeros[i].x, double);
+        ESCRIBIR_CAMPO(e->agujeros[i].y, double);
+    }
+    for (int i = 0; i < e->numRegiones; i++) {
+        ESCRIBIR_CAMPO(e->regiones[i].x, double);
+        ESCRIBIR_CAMPO(e->regiones[i].y, double);
+        ESCRIBIR_CAMPO(e->regiones[i].atributo, double);
+        ESCRIBIR_CAMPO(e->regiones[i].areaMaxima, double);
+    }
+#undef ESCRIBIR_CAMPO
+
+    cabeceraSolicitudAHost(&c);
+    memcpy(bufer, &c, sizeof(c));
+    return bufer;
+}
+
+static int conectarServidor(const char *ruta) {
+    struct sockaddr_un direccion;
+    if (strlen(ruta) >= sizeof(direccion.sun_path)) return -1;
+    memset(&direccion, 0, sizeof(direccion));
+    direccion.sun_family = AF_UNIX;
+    strcpy(direccion.sun_path, ruta);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&direccion, sizeof(direccion)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int compararDobles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int ejecutarCliente(const char *ruta, const char *archivoPoly, int repeticiones,
+                           double anguloMinimo, double areaMaxima, uint32_t opciones) {
+    struct EntradaPoly *entrada = leerArchivoPoly(archivoPoly);
+    if (!entrada) return SALIDA_ENTRADA;
+
+    size_t longitudSolicitud;
+    unsigned char *solicitud = serializarSolicitud(entrada, anguloMinimo, areaMaxima, opciones,
+                                                   &longitudSolicitud);
+    liberarEntradaPoly(entrada);
+    double *latencias = malloc((size_t)repeticiones * sizeof(double));
+    if (!solicitud || !latencias) {
+        free(solicitud);
+        free(latencias);
+        return SALIDA_MEMORIA;
+    }
+
+    int fd = conectarServidor(ruta);
+    if (fd < 0) {
+        TRAZA_ERROR("No se pudo conectar a %s: %s\n", ruta, strerror(errno));
+        free(solicitud);
+        free(latencias);
+        return SALIDA_ESCRITURA;
+    }
+
+    int codigo = SALIDA_EXITO;
+    unsigned char *respuesta = NULL;
+    uint64_t longitudRespuesta = 0;
+    for (int i = 0; i < repeticiones && codigo == SALIDA_EXITO; i++) {
+        double inicio = relojSegundos();
+        struct CabeceraRespuesta r;
+        if (!escribirExacto(fd, solicitud, longitudSolicitud) || !leerExacto(fd, &r, sizeof(r))) {
+            TRAZA_ERROR("Se perdió la conexión con el servidor\n");
+            codigo = SALIDA_ESCRITURA;
+            break;
+        }
+        cabeceraRespuestaAHost(&r);
+        if (memcmp(r.magia, PROTOCOLO_MAGIA_RESPUESTA, 4) != 0) {
+            TRAZA_ERROR("Respuesta inválida del servidor\n");
+            codigo = SALIDA_ESCRITURA;
+            break;
+        }
+        free(respuesta);
+        respuesta = malloc((size_t)r.longitud + 1);
+        if (!respuesta) {
+            codigo = SALIDA_MEMORIA;
+            break;
+        }
+        if (!leerExacto(fd, respuesta, (size_t)r.longitud)) {
+            TRAZA_ERROR("Se perdió la conexión con el servidor\n");
+            codigo = SALIDA_ESCRITURA;
+            break;
+        }
+        latencias[i] = relojSegundos() - inicio;
+        longitudRespuesta = r.longitud;
+        if (r.codigo != SALIDA_EXITO) {
+            respuesta[r.longitud] = '\0';
+            TRAZA_ERROR("El servidor respondió %d: %s\n", r.codigo, (char *)respuesta);
+            codigo = r.codigo;
+        }
+    }
+    close(fd);
+    free(solicitud);
+
+    if (codigo == SALIDA_EXITO) {
+        // foo.poly -> foo.1.bmesh, como la línea de comandos
+        char nombre[1024];
+        const char *punto = strrchr(archivoPoly, '.');
+        int base = punto ? (int)(punto - archivoPoly) : (int)strlen(archivoPoly);
+        snprintf(nombre, sizeof(nombre), "%.*s.1.bmesh", base, archivoPoly);
+        FILE *archivo = fopen(nombre, "wb");
+        if (!archivo || fwrite(respuesta, 1, (size_t)longitudRespuesta, archivo) != longitudRespuesta) {
+            TRAZA_ERROR("No se pudo escribir %s\n", nombre);
+            codigo = SALIDA_ESCRITURA;
+        }
+        if (archivo) fclose(archivo);
+
+        qsort(latencias, (size_t)repeticiones, sizeof(double), compararDobles);
+        int p99 = (int)ceil(0.99 * repeticiones) - 1;
+        TRAZA_INFO("%s: %llu bytes, %d repeticiones, mediana %.3f ms, p99 %.3f ms, máx %.3f ms\n",
+                   nombre, (unsigned long long)longitudRespuesta, repeticiones,
+                   latencias[repeticiones / 2] * 1e3, latencias[p99 < 0 ? 0 : p99] * 1e3,
+                   latencias[repeticiones - 1] * 1e3);
+    }
+    free(respuesta);
+    free(latencias);
+    return codigo;
+}
+
+
+/* Programa principal                                                         */
+
+static void usoServidor(void) {
+    printf("Uso: servidor [-j hilos] [-v] socket\n");
+    printf("     servidor -c socket archivo.poly [-n repeticiones] [-q ángulo] [-a área]\n");
+    printf("                [-i | -F | -A] [-t posición] [-d]\n");
+    printf("  -i -F -A  Triangulación inicial incremental / por barrido / automática\n");
+    printf("  -t        Puntos Steiner: 0 circuncentro, 1 fuera de centro, 2 triangle.c\n");
+    printf("  -d        Elimina los vértices repetidos\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *ruta = NULL, *archivoPoly = NULL;
+    bool cliente = false;
+    int hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int repeticiones = REPETICIONES_DEFECTO;
+    double anguloMinimo = 0.0, areaMaxima = -1.0;
+    int algoritmo = -1, posicionSteiner = -1;   // -1: el defecto del servidor
+    uint32_t opciones = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        bool conValor = i + 1 < argc;
+        if (strcmp(a, "-j") == 0 && conValor) hilos = atoi(argv[++i]);
+        else if (strcmp(a, "-n") == 0 && conValor) repeticiones = atoi(argv[++i]);
+        else if (strcmp(a, "-q") == 0 && conValor) anguloMinimo = atof(argv[++i]);
+        else if (strcmp(a, "-a") == 0 && conValor) areaMaxima = atof(argv[++i]);
+        else if (strcmp(a, "-t") == 0 && conValor) posicionSteiner = atoi(argv[++i]);
+        else if (strcmp(a, "-i") == 0) algoritmo = ALGORITMO_INCREMENTAL;
+        else if (strcmp(a, "-F") == 0) algoritmo = ALGORITMO_BARRIDO;
+        else if (strcmp(a, "-A") == 0) algoritmo = ALGORITMO_AUTOMATICO;
+        else if (strcmp(a, "-d") == 0) opciones |= OPCION_ELIMINAR_REPETIDOS;
+        else if (strcmp(a, "-c") == 0) cliente = true;
+        else if (strcmp(a, "-v") == 0) servidorDetallado = true;
+        else if (strcmp(a, "-h") == 0) {
+            usoServidor();
+            return SALIDA_EXITO;
+        } else if (a[0] != '-' && !ruta) ruta = a;
+        else if (a[0] != '-' && !archivoPoly) archivoPoly = a;
+        else {
+            usoServidor();
+            return SALIDA_USO;
+        }
+    }
+    if (!ruta || (cliente && !archivoPoly) || (!cliente && archivoPoly) || repeticiones < 1) {
+        usoServidor();
+        return SALIDA_USO;
+    }
+    if (hilos < 1) hilos = 1;
+    if (hilos > MAX_HILOS_SERVIDOR) hilos = MAX_HILOS_SERVIDOR;
+
+    if (cliente) {
+        opciones |= CAMPO_ALGORITMO(algoritmo) | CAMPO_STEINER(posicionSteiner);
+        return ejecutarCliente(ruta, archivoPoly, repeticiones, anguloMinimo, areaMaxima, opciones);
+    }
+    return ejecutarServidor(ruta, hilos);
+}
@@ -269,6 +269,32 @@
 /* #define CPU86 */
 /* #define LINUX */
 
+/* When the compiler reports a fast fused multiply-add (<math.h> defines     */
+/*   FP_FAST_FMA, or FP_FAST_FMAF for single precision, when gcc or clang is */
+/*   given -mfma or a -march that has it), the roundoff error of a product   */
+/*   in the exact arithmetic is found with one fma() instead of by Dekker's  */
+/*   splitting.  Define the NO_FMA symbol to always split.  If you do, and   */
+/*   the target has FMA, also compile with -ffp-contract=off:  a compiler    */
+/*   that fuses the multiply and subtract in Split() breaks the splitting.   */
+/*   The predicates return the same signs either way, but the meshes are     */
+/*   byte-identical to a build without FMA only with -ffp-contract=off,      */
+/*   since otherwise the compiler also fuses arithmetic outside the          */
+/*   predicates, such as the coordinates of new vertices.                    */
+
+/* #define NO_FMA */
+
+/* On Linux, large blocks of the memory pools are aligned to 2 MB and        */
+/*   marked with madvise() as candidates for transparent huge pages, which   */
+/*   cuts the TLB misses of traversals and mesh walks on very large meshes.  */
+/*   Define the NO_HUGEPAGES symbol to allocate every block with malloc()    */
+/*   instead.  If Triangle is compiled with OpenMP, also define the          */
+/*   FIRSTTOUCH symbol to have the threads touch the pages of each large     */
+/*   block in parallel, so that on a NUMA machine the block is spread over   */
+/*   the memory of the nodes that will work on it.                           */
+
+/* #define NO_HUGEPAGES */
+/* #define FIRSTTOUCH */
+
 #define INEXACT /* Nothing */
 /* #define INEXACT volatile */
 
@@ -298,6 +324,31 @@
 /* Number of splay tree nodes allocated at once. */
 #define SPLAYNODEPERBLOCK 508
 
+/* With the -G switch, point location keeps a grid with about this many     */
+/*   input vertices per cell.                                                */
+
+#define GRIDVERTICES 2
+
+/* The numbers above are minimums.  When a pool is created with an estimate  */
+/*   of the number of items it will hold, every block after the first holds */
+/*   at least 1/POOLGROWTH of the estimate, so that a mesh refined far past  */
+/*   its input grows in a few large blocks rather than many small ones.      */
+/*   Blocks of at least HUGEPAGEBYTES bytes are rounded up to a multiple of  */
+/*   that size.  Both can be changed with -D compiler switches.              */
+
+#ifndef POOLGROWTH
+#define POOLGROWTH 8
+#endif /* not POOLGROWTH */
+#ifndef HUGEPAGEBYTES
+#define HUGEPAGEBYTES 2097152
+#endif /* not HUGEPAGEBYTES */
+
+/* When Triangle is compiled with OpenMP, the divide-and-conquer algorithm   */
+/*   triangulates the two halves of any subset of at least this many        */
+/*   vertices in parallel.                                                   */
+
+#define DIVCONQTASKSIZE 8192
+
 /* The vertex types.   A DEADVERTEX has been deleted entirely.  An           */
 /*   UNDEADVERTEX is not part of the mesh, but is written to the output      */
 /*   .node file and affects the node indexing in the other output files.     */
@@ -344,16 +395,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 #ifndef NO_TIMER
 #include <sys/timeb.h>
 #endif /* not NO_TIMER */
-#ifdef CPU86
-#include <float.h>
-#endif /* CPU86 */
 #ifdef LINUX
 #include <fpu_control.h>
 #endif /* LINUX */
+#if defined(__linux__) && !defined(NO_HUGEPAGES)
+#include <sys/mman.h>
+#ifdef MADV_HUGEPAGE
+#define HUGEPAGES
+#endif /* MADV_HUGEPAGE */
+#endif /* __linux__ and not NO_HUGEPAGES */
 #ifdef TRILIBRARY
+#include <setjmp.h>
 #include "triangle.h"
 #endif /* TRILIBRARY */
 
@@ -618,10 +674,10 @@ struct splaynode {
 /*   itembytes is the length of a record in bytes (after rounding up).       */
 /*   itemsperblock is the number of items allocated at once in a single      */
 /*   block.  itemsfirstblock is the number of items in the first block,      */
-/*   which can vary from the others.  items is the number of currently       */
-/*   allocated items.  maxitems is the maximum number of items that have     */
-/*   been allocated at once; it is the current number of items plus the      */
-/*   number of records kept on deaditemstack.                                */
+/*   which can vary from the others; poolinit() chooses both.  items is the  */
+/*   number of currently allocated items.  maxitems is the maximum number of */
+/*   items that have been allocated at once; it is the current number of    */
+/*   items plus the number of records kept on deaditemstack.                 */
 
 struct memorypool {
   VOID **firstblock, **nowblock;
@@ -639,18 +695,57 @@ struct memorypool {
 };
 
 
-/* Global constants.                                                         */
+/* Global constants.  They depend only on the floating-point format, so      */
+/*   they are fixed at compile time instead of being computed by every call  */
+/*   to exactinit(); concurrent calls to triangulate() share them safely.    */
+/*   EPSILON is the largest power of two such that 1.0 + EPSILON = 1.0,      */
+/*   that is, half of FLT_EPSILON or DBL_EPSILON; it only enters the error   */
+/*   bounds below, so it has no variable of its own.  SPLITTER is            */
+/*   2^ceiling(p / 2) + 1 for a p-bit significand (24 or 53 bits); it is     */
+/*   used only by Split(), which a fused multiply-add makes unnecessary.     */
+
+#ifdef SINGLE
+#define EPSILON (FLT_EPSILON * 0.5)
+#define SPLITTER 4097.0                                          /* 2^12 + 1 */
+#else /* not SINGLE */
+#define EPSILON (DBL_EPSILON * 0.5)
+#define SPLITTER 134217729.0                                     /* 2^27 + 1 */
+#endif /* not SINGLE */
+
+static const REAL resulterrbound = (3.0 + 8.0 * EPSILON) * EPSILON;
+static const REAL ccwerrboundA = (3.0 + 16.0 * EPSILON) * EPSILON;
+static const REAL ccwerrboundB = (2.0 + 12.0 * EPSILON) * EPSILON;
+static const REAL ccwerrboundC = (9.0 + 64.0 * EPSILON) * EPSILON * EPSILON;
+static const REAL iccerrboundA = (10.0 + 96.0 * EPSILON) * EPSILON;
+static const REAL iccerrboundB = (4.0 + 48.0 * EPSILON) * EPSILON;
+static const REAL iccerrboundC = (44.0 + 576.0 * EPSILON) * EPSILON * EPSILON;
+static const REAL o3derrboundA = (7.0 + 56.0 * EPSILON) * EPSILON;
+static const REAL o3derrboundB = (3.0 + 28.0 * EPSILON) * EPSILON;
+static const REAL o3derrboundC = (26.0 + 288.0 * EPSILON) * EPSILON * EPSILON;
+
+#ifdef TRILIBRARY
 
-REAL splitter;       /* Used to split REAL factors for exact multiplication. */
-REAL epsilon;                             /* Floating-point machine epsilon. */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
+/* In the library, triexit() does not end the program:  it jumps back to the */
+/*   triangulate() call running on the same thread, which frees the mesh     */
+/*   and returns the exit status.  Each thread keeps its own return point,   */
+/*   so independent meshes can be built concurrently on worker threads.      */
+
+#if defined(_MSC_VER)
+#define THREADLOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREADLOCAL __thread
+#else /* not _MSC_VER and not __GNUC__ */
+#define THREADLOCAL _Thread_local
+#endif /* not _MSC_VER and not __GNUC__ */
+
+struct exitpoint {
+  jmp_buf jump;
+  int status;
+};
 
-/* Random number seed is not constant, but I've made it global anyway.       */
+static THREADLOCAL struct exitpoint *triexitpoint = (struct exitpoint *) NULL;
 
-unsigned long randomseed;                     /* Current random number seed. */
+#endif /* TRILIBRARY */
 
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
@@ -708,6 +803,7 @@ struct mesh {
   int checkquality;                  /* Has quality triangulation begun yet? */
   int readnodefile;                           /* Has a .node file been read? */
   long samples;              /* Number of random samples for point location. */
+  unsigned long randomseed;                   /* Current random number seed. */
 
   long incirclecount;                 /* Number of incircle tests performed. */
   long counterclockcount;     /* Number of counterclockwise tests performed. */
@@ -737,6 +833,14 @@ struct mesh {
 
   struct otri recenttri;
 
+/* Point location grid (-G switch).  Each cell holds an encoded handle on a  */
+/*   triangle whose origin lies in the cell, or NULL.  `gridxscale' and      */
+/*   `gridyscale' convert a distance from (xmin, ymin) to a cell count.      */
+
+  triangle *locategrid;
+  int gridcols, gridrows;
+  REAL gridxscale, gridyscale;
+
 };                                                  /* End of `struct mesh'. */
 
 
@@ -769,7 +873,7 @@ struct behavior {
 /*   nobisect: count of how often -Y switch is selected.                     */
 /*   steiner: maximum number of Steiner points, specified after -S switch.   */
 /*   incremental: -i switch.  sweepline: -F switch.                          */
-/*   dwyer: inverse of -l switch.                                            */
+/*   dwyer: inverse of -l switch.  gridlocate: -G switch.                    */
 /*   splitseg: -s switch.                                                    */
 /*   conformdel: -D switch.  docheck: -C switch.                             */
 /*   quiet: -Q switch.  verbose: count of how often -V switch is selected.   */
@@ -785,6 +889,7 @@ struct behavior {
   int nobound, nopolywritten, nonodewritten, noelewritten, noiterationnum;
   int noholes, noexact, conformdel;
   int incremental, sweepline, dwyer;
+  int gridlocate;
   int splitseg;
   int docheck;
   int quiet, verbose;
@@ -1415,6 +1520,12 @@ int status;
 #endif /* not ANSI_DECLARATORS */
 
 {
+#ifdef TRILIBRARY
+  if (triexitpoint != (struct exitpoint *) NULL) {
+    triexitpoint->status = status;
+    longjmp(triexitpoint->jump, 1);
+  }
+#endif /* TRILIBRARY */
   exit(status);
 }
 
@@ -1467,15 +1578,15 @@ void syntax()
 {
 #ifdef CDT_ONLY
 #ifdef REDUCED
-  printf("triangle [-pAcjevngBPNEIOXzo_lQVh] input_file\n");
+  printf("triangle [-pAcjevngBPNEIOXzo_lGQVh] input_file\n");
 #else /* not REDUCED */
-  printf("triangle [-pAcjevngBPNEIOXzo_iFlCQVh] input_file\n");
+  printf("triangle [-pAcjevngBPNEIOXzo_iFlGCQVh] input_file\n");
 #endif /* not REDUCED */
 #else /* not CDT_ONLY */
 #ifdef REDUCED
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__lQVh] input_file\n");
+  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__lGQVh] input_file\n");
 #else /* not REDUCED */
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlsCQVh] input_file\n");
+  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlGsCQVh] input_file\n");
 #endif /* not REDUCED */
 #endif /* not CDT_ONLY */
 
@@ -1520,6 +1631,8 @@ void syntax()
   printf("    -F  Uses Fortune's sweepline algorithm, rather than d-and-c.\n");
 #endif /* not REDUCED */
   printf("    -l  Uses vertical cuts only, rather than alternating cuts.\n");
+  printf(
+    "    -G  Uses a grid, rather than random sampling, to locate points.\n");
 #ifndef REDUCED
 #ifndef CDT_ONLY
   printf(
@@ -1578,7 +1691,8 @@ void info()
   printf(
 "Delaunay triangulation is returned in .node and .ele output files.  The\n");
   printf("command syntax is:\n\n");
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlsCQVh] input_file\n\n");
+  printf(
+    "triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlGsCQVh] input_file\n\n");
   printf(
 "Underscores indicate that numbers may optionally follow certain switches.\n");
   printf(
@@ -1914,6 +2028,18 @@ void info()
 "        small or short and wide.  This switch is primarily of theoretical\n");
   printf("        interest.\n");
   printf(
+"    -G  Starts each point location from the triangle recorded for the\n");
+  printf(
+"        point's cell in a uniform grid, instead of from the best of a\n");
+  printf(
+"        random sample of triangles.  The grid is updated as vertices are\n");
+  printf(
+"        inserted.  Speeds up the insertion of segments and the incremental\n"
+);
+  printf(
+"        algorithm on large inputs, and makes their walks independent of\n");
+  printf("        the random number generator.\n");
+  printf(
 "    -s  Specifies that segments should be forced into the triangulation by\n"
 );
   printf(
@@ -3309,6 +3435,7 @@ struct behavior *b;
   b->noholes = b->noexact = 0;
   b->incremental = b->sweepline = 0;
   b->dwyer = 1;
+  b->gridlocate = 0;
   b->splitseg = 0;
   b->docheck = 0;
   b->nobisect = 0;
@@ -3460,6 +3587,9 @@ struct behavior *b;
         if (argv[i][j] == 'l') {
           b->dwyer = 0;
         }
+        if (argv[i][j] == 'G') {
+          b->gridlocate = 1;
+        }
 #ifndef REDUCED
 #ifndef CDT_ONLY
         if (argv[i][j] == 's') {
@@ -3910,13 +4040,111 @@ struct memorypool *pool;
   pool->deaditemstack = (VOID *) NULL;
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  poolblockitems()   Choose how many items go in a block that should hold  */
+/*                     at least `itemcount' items.                           */
+/*                                                                           */
+/*  A block that will be backed by huge pages is rounded up to a whole       */
+/*  number of them, and the slack is handed out as extra items.              */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int poolblockitems(struct memorypool *pool, int itemcount)
+#else /* not ANSI_DECLARATORS */
+int poolblockitems(pool, itemcount)
+struct memorypool *pool;
+int itemcount;
+#endif /* not ANSI_DECLARATORS */
+
+{
+#ifdef HUGEPAGES
+  size_t blockbytes;
+
+  blockbytes = (size_t) itemcount * (size_t) pool->itembytes +
+               sizeof(VOID *) + (size_t) pool->alignbytes;
+  if (blockbytes >= HUGEPAGEBYTES) {
+    blockbytes = (blockbytes + HUGEPAGEBYTES - 1) / HUGEPAGEBYTES *
+                 HUGEPAGEBYTES;
+    itemcount = (int) ((blockbytes - sizeof(VOID *) -
+                        (size_t) pool->alignbytes) / (size_t) pool->itembytes);
+  }
+#endif /* HUGEPAGES */
+  return itemcount;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolblockalloc()   Allocate a block of `itemcount' items for a pool.     */
+/*                                                                           */
+/*  Space for `itemcount' items and one pointer (to point to the next block) */
+/*  are allocated, as well as space to ensure alignment of the items.  The   */
+/*  next block pointer is set to NULL.                                       */
+/*                                                                           */
+/*  Large blocks are aligned to HUGEPAGEBYTES and offered to the kernel for  */
+/*  transparent huge pages.  They are still released with trifree().  With  */
+/*  FIRSTTOUCH, the OpenMP threads fault the block's pages in, each one      */
+/*  taking a contiguous share, so the pages are placed on the NUMA nodes of  */
+/*  the threads.                                                             */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+VOID **poolblockalloc(struct memorypool *pool, int itemcount)
+#else /* not ANSI_DECLARATORS */
+VOID **poolblockalloc(pool, itemcount)
+struct memorypool *pool;
+int itemcount;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID **newblock;
+  size_t blockbytes;
+#if defined(HUGEPAGES) && defined(FIRSTTOUCH) && defined(_OPENMP)
+  long page;
+#endif /* HUGEPAGES and FIRSTTOUCH and _OPENMP */
+
+  blockbytes = (size_t) itemcount * (size_t) pool->itembytes +
+               sizeof(VOID *) + (size_t) pool->alignbytes;
+#ifdef HUGEPAGES
+  if (blockbytes >= HUGEPAGEBYTES) {
+    blockbytes = (blockbytes + HUGEPAGEBYTES - 1) / HUGEPAGEBYTES *
+                 HUGEPAGEBYTES;
+    if (posix_memalign((void **) &newblock, HUGEPAGEBYTES, blockbytes) != 0) {
+      newblock = (VOID **) NULL;
+    } else {
+      /* Only advice; the block works the same if the kernel ignores it. */
+      madvise((void *) newblock, blockbytes, MADV_HUGEPAGE);
+#if defined(FIRSTTOUCH) && defined(_OPENMP)
+      /* The block is aligned to and a multiple of HUGEPAGEBYTES, so one */
+      /*   write faults in each huge page.                                */
+#pragma omp parallel for schedule(static)
+      for (page = 0; page < (long) (blockbytes / HUGEPAGEBYTES); page++) {
+        ((char *) newblock)[(size_t) page * HUGEPAGEBYTES] = 0;
+      }
+#endif /* FIRSTTOUCH and _OPENMP */
+    }
+  } else
+#endif /* HUGEPAGES */
+  newblock = (VOID **) malloc(blockbytes);
+  if (newblock == (VOID **) NULL) {
+    printf("Error:  Out of memory.\n");
+    triexit(1);
+  }
+  *newblock = (VOID *) NULL;
+  return newblock;
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  poolinit()   Initialize a pool of memory for allocation of items.        */
 /*                                                                           */
 /*  This routine initializes the machinery for allocating items.  A `pool'   */
 /*  is created whose records have size at least `bytecount'.  Items will be  */
-/*  allocated in `itemcount'-item blocks.  Each item is assumed to be a      */
+/*  allocated in blocks of at least `itemcount' items, or 1/POOLGROWTH of    */
+/*  `firstitemcount' if that is more, and the first block holds at least     */
+/*  `firstitemcount' items (if it's nonzero).  Each item is assumed to be a  */
 /*  collection of words, and either pointers or floating-point values are    */
 /*  assumed to be the "primary" word type.  (The "primary" word type is used */
 /*  to determine alignment of items.)  If `alignment' isn't zero, all items  */
@@ -3953,21 +4181,19 @@ int alignment;
   }
   pool->itembytes = ((bytecount - 1) / pool->alignbytes + 1) *
                     pool->alignbytes;
-  pool->itemsperblock = itemcount;
+  /* Later blocks grow with the estimate of the pool's size. */
+  if (firstitemcount / POOLGROWTH > itemcount) {
+    itemcount = firstitemcount / POOLGROWTH;
+  }
+  pool->itemsperblock = poolblockitems(pool, itemcount);
   if (firstitemcount == 0) {
-    pool->itemsfirstblock = itemcount;
+    pool->itemsfirstblock = pool->itemsperblock;
   } else {
-    pool->itemsfirstblock = firstitemcount;
+    pool->itemsfirstblock = poolblockitems(pool, firstitemcount);
   }
 
-  /* Allocate a block of items.  Space for `itemsfirstblock' items and one  */
-  /*   pointer (to point to the next block) are allocated, as well as space */
-  /*   to ensure alignment of the items.                                    */
-  pool->firstblock = (VOID **)
-    trimalloc(pool->itemsfirstblock * pool->itembytes + (int) sizeof(VOID *) +
-              pool->alignbytes);
-  /* Set the next block pointer to NULL. */
-  *(pool->firstblock) = (VOID *) NULL;
+  /* Allocate the first block of items. */
+  pool->firstblock = poolblockalloc(pool, pool->itemsfirstblock);
   poolrestart(pool);
 }
 
@@ -4021,12 +4247,8 @@ struct memorypool *pool;
       /* Check if another block must be allocated. */
       if (*(pool->nowblock) == (VOID *) NULL) {
         /* Allocate a new block of items, pointed to by the previous block. */
-        newblock = (VOID **) trimalloc(pool->itemsperblock * pool->itembytes +
-                                       (int) sizeof(VOID *) +
-                                       pool->alignbytes);
+        newblock = poolblockalloc(pool, pool->itemsperblock);
         *(pool->nowblock) = (VOID *) newblock;
-        /* The next block pointer is NULL. */
-        *newblock = (VOID *) NULL;
       }
 
       /* Move to the new block. */
@@ -4157,6 +4379,84 @@ struct memorypool *pool;
   return newitem;
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  poolreserve()   Make sure that the next `count' fresh items fit in       */
+/*                  blocks that have already been allocated.                 */
+/*                                                                           */
+/*  Once the blocks are in place, poolskip() can hand a stretch of fresh     */
+/*  items to a copy of the pool, and several copies can allocate from their  */
+/*  own stretches at the same time without calling trimalloc().              */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void poolreserve(struct memorypool *pool, long count)
+#else /* not ANSI_DECLARATORS */
+void poolreserve(pool, count)
+struct memorypool *pool;
+long count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID **block;
+  VOID **newblock;
+  long room;
+
+  block = pool->nowblock;
+  room = (long) pool->unallocateditems;
+  while (room < count) {
+    if (*block == (VOID *) NULL) {
+      /* Allocate a new block of items, pointed to by the previous block. */
+      newblock = poolblockalloc(pool, pool->itemsperblock);
+      *block = (VOID *) newblock;
+    }
+    block = (VOID **) *block;
+    room += (long) pool->itemsperblock;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolskip()   Advance past `count' fresh items, leaving the pool exactly  */
+/*               as if poolalloc() had been called `count' times.            */
+/*                                                                           */
+/*  The stack of dead items must be empty, and the items must have been      */
+/*  reserved with poolreserve().                                             */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void poolskip(struct memorypool *pool, long count)
+#else /* not ANSI_DECLARATORS */
+void poolskip(pool, count)
+struct memorypool *pool;
+long count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  unsigned long alignptr;
+
+  pool->items += count;
+  pool->maxitems += count;
+  while (count > (long) pool->unallocateditems) {
+    count -= (long) pool->unallocateditems;
+    /* Move to the next block. */
+    pool->nowblock = (VOID **) *(pool->nowblock);
+    /* Find the first item in the block.    */
+    /*   Increment by the size of (VOID *). */
+    alignptr = (unsigned long) (pool->nowblock + 1);
+    /* Align the item on an `alignbytes'-byte boundary. */
+    pool->nextitem = (VOID *)
+      (alignptr + (unsigned long) pool->alignbytes -
+       (alignptr % (unsigned long) pool->alignbytes));
+    pool->unallocateditems = pool->itemsperblock;
+  }
+  pool->nextitem = (VOID *) ((char *) pool->nextitem +
+                             count * pool->itembytes);
+  pool->unallocateditems -= (int) count;
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  dummyinit()   Initialize the triangle that fills "outer space" and the   */
@@ -4631,6 +4931,9 @@ struct behavior *b;
     trifree((VOID *) m->dummysubbase);
   }
   pooldeinit(&m->vertices);
+  if (m->locategrid != (triangle *) NULL) {
+    trifree((VOID *) m->locategrid);
+  }
 #ifndef CDT_ONLY
   if (b->quality) {
     pooldeinit(&m->badsubsegs);
@@ -4642,6 +4945,41 @@ struct behavior *b;
 #endif /* not CDT_ONLY */
 }
 
+#ifdef TRILIBRARY
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triangleabort()   Free the memory of a mesh abandoned by an error.       */
+/*                                                                           */
+/*  Unlike triangledeinit(), does not rely on the switches:  the error may   */
+/*  have come before they were parsed.  Every pool was zeroed by             */
+/*  triangleinit(), so freeing one that was never initialized is harmless.   */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void triangleabort(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+void triangleabort(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  pooldeinit(&m->triangles);
+  pooldeinit(&m->subsegs);
+  pooldeinit(&m->vertices);
+  pooldeinit(&m->viri);
+  pooldeinit(&m->badsubsegs);
+  pooldeinit(&m->badtriangles);
+  pooldeinit(&m->flipstackers);
+  pooldeinit(&m->splaynodes);
+  trifree((VOID *) m->dummytribase);
+  trifree((VOID *) m->dummysubbase);
+  trifree((VOID *) m->locategrid);
+}
+
+#endif /* TRILIBRARY */
+
 /**                                                                         **/
 /**                                                                         **/
 /********* Memory management routines end here                       *********/
@@ -4796,11 +5134,54 @@ struct osub *newsubseg;
   Two_Diff_Tail(a, b, x, y)
 
 #define Split(a, ahi, alo) \
-  c = (REAL) (splitter * a); \
+  c = (REAL) ((REAL) SPLITTER * a); \
   abig = (REAL) (c - a); \
   ahi = c - abig; \
   alo = a - ahi
 
+/* With a fused multiply-add, a * b - x is computed with a single rounding,  */
+/*   and it is exact because x is a * b rounded; so the tail of a product    */
+/*   (or a square) is one instruction and nothing is split; the functions   */
+/*   declare the temporaries of Split() only when it is used.  Every product */
+/*   is still represented exactly, so the error bounds of the predicates do  */
+/*   not change.                                                             */
+
+#ifndef NO_FMA
+#ifdef SINGLE
+#ifdef FP_FAST_FMAF
+#define Fused_Multiply_Add(a, b, c)  fmaf(a, b, c)
+#endif /* FP_FAST_FMAF */
+#else /* not SINGLE */
+#ifdef FP_FAST_FMA
+#define Fused_Multiply_Add(a, b, c)  fma(a, b, c)
+#endif /* FP_FAST_FMA */
+#endif /* not SINGLE */
+#endif /* not NO_FMA */
+
+#ifdef Fused_Multiply_Add
+
+#define Two_Product_Tail(a, b, x, y) \
+  y = Fused_Multiply_Add(a, b, -x)
+
+#define Two_Product(a, b, x, y) \
+  x = (REAL) (a * b); \
+  Two_Product_Tail(a, b, x, y)
+
+#define Presplit(a, ahi, alo)
+
+#define Two_Product_Presplit(a, b, bhi, blo, x, y) \
+  x = (REAL) (a * b); \
+  Two_Product_Tail(a, b, x, y)
+
+#define Square_Tail(a, x, y) \
+  y = Fused_Multiply_Add(a, a, -x)
+
+#define Square(a, x, y) \
+  x = (REAL) (a * a); \
+  Square_Tail(a, x, y)
+
+#else /* not Fused_Multiply_Add */
+
 #define Two_Product_Tail(a, b, x, y) \
   Split(a, ahi, alo); \
   Split(b, bhi, blo); \
@@ -4814,7 +5195,10 @@ struct osub *newsubseg;
   Two_Product_Tail(a, b, x, y)
 
 /* Two_Product_Presplit() is Two_Product() where one of the inputs has       */
-/*   already been split.  Avoids redundant splitting.                        */
+/*   already been split by Presplit().  Avoids redundant splitting.          */
+
+#define Presplit(a, ahi, alo) \
+  Split(a, ahi, alo)
 
 #define Two_Product_Presplit(a, b, bhi, blo, x, y) \
   x = (REAL) (a * b); \
@@ -4836,6 +5220,8 @@ struct osub *newsubseg;
   x = (REAL) (a * a); \
   Square_Tail(a, x, y)
 
+#endif /* not Fused_Multiply_Add */
+
 /* Macros for summing expansions of various fixed lengths.  These are all    */
 /*   unrolled versions of Expansion_Sum().                                   */
 
@@ -4858,7 +5244,7 @@ struct osub *newsubseg;
 /* Macro for multiplying a two-component expansion by a single component.    */
 
 #define Two_One_Product(a1, a0, b, x3, x2, x1, x0) \
-  Split(b, bhi, blo); \
+  Presplit(b, bhi, blo); \
   Two_Product_Presplit(a0, b, bhi, blo, _i, x0); \
   Two_Product_Presplit(a1, b, bhi, blo, _j, _0); \
   Two_Sum(_i, _0, _k, x1); \
@@ -4866,28 +5252,18 @@ struct osub *newsubseg;
 
 /*****************************************************************************/
 /*                                                                           */
-/*  exactinit()   Initialize the variables used for exact arithmetic.        */
-/*                                                                           */
-/*  `epsilon' is the largest power of two such that 1.0 + epsilon = 1.0 in   */
-/*  floating-point arithmetic.  `epsilon' bounds the relative roundoff       */
-/*  error.  It is used for floating-point error analysis.                    */
+/*  exactinit()   Prepare the FPU for exact arithmetic.                      */
 /*                                                                           */
-/*  `splitter' is used to split floating-point numbers into two half-        */
-/*  length significands for exact multiplication.                            */
-/*                                                                           */
-/*  I imagine that a highly optimizing compiler might be too smart for its   */
-/*  own good, and somehow cause this routine to fail, if it pretends that    */
-/*  floating-point arithmetic is too much like real arithmetic.              */
-/*                                                                           */
-/*  Don't change this routine unless you fully understand it.                */
+/*  `epsilon' and `splitter' used to be measured here; they are now the      */
+/*  compile-time constants EPSILON and SPLITTER (see the global constants    */
+/*  above).  What remains is setting the x87 FPU to round to the precision   */
+/*  of REAL.  The control word belongs to the calling thread, so this is     */
+/*  still done on every call to triangulate().                               */
 /*                                                                           */
 /*****************************************************************************/
 
 void exactinit()
 {
-  REAL half;
-  REAL check, lastcheck;
-  int every_other;
 #ifdef LINUX
   int cword;
 #endif /* LINUX */
@@ -4909,37 +5285,6 @@ void exactinit()
 #endif /* not SINGLE */
   _FPU_SETCW(cword);
 #endif /* LINUX */
-
-  every_other = 1;
-  half = 0.5;
-  epsilon = 1.0;
-  splitter = 1.0;
-  check = 1.0;
-  /* Repeatedly divide `epsilon' by two until it is too small to add to      */
-  /*   one without causing roundoff.  (Also check if the sum is equal to     */
-  /*   the previous sum, for machines that round up instead of using exact   */
-  /*   rounding.  Not that these routines will work on such machines.)       */
-  do {
-    lastcheck = check;
-    epsilon *= half;
-    if (every_other) {
-      splitter *= 2.0;
-    }
-    every_other = !every_other;
-    check = 1.0 + epsilon;
-  } while ((check != 1.0) && (check != lastcheck));
-  splitter += 1.0;
-  /* Error bounds for orientation and incircle tests. */
-  resulterrbound = (3.0 + 8.0 * epsilon) * epsilon;
-  ccwerrboundA = (3.0 + 16.0 * epsilon) * epsilon;
-  ccwerrboundB = (2.0 + 12.0 * epsilon) * epsilon;
-  ccwerrboundC = (9.0 + 64.0 * epsilon) * epsilon * epsilon;
-  iccerrboundA = (10.0 + 96.0 * epsilon) * epsilon;
-  iccerrboundB = (4.0 + 48.0 * epsilon) * epsilon;
-  iccerrboundC = (44.0 + 576.0 * epsilon) * epsilon * epsilon;
-  o3derrboundA = (7.0 + 56.0 * epsilon) * epsilon;
-  o3derrboundB = (3.0 + 28.0 * epsilon) * epsilon;
-  o3derrboundC = (26.0 + 288.0 * epsilon) * epsilon * epsilon;
 }
 
 /*****************************************************************************/
@@ -5069,12 +5414,14 @@ REAL *h;
   REAL enow;
   INEXACT REAL bvirt;
   REAL avirt, bround, around;
+#ifndef Fused_Multiply_Add
   INEXACT REAL c;
   INEXACT REAL abig;
   REAL ahi, alo, bhi, blo;
   REAL err1, err2, err3;
+#endif /* not Fused_Multiply_Add */
 
-  Split(b, bhi, blo);
+  Presplit(b, bhi, blo);
   Two_Product_Presplit(e[0], b, bhi, blo, Q, hh);
   hindex = 0;
   if (hh != 0) {
@@ -5171,10 +5518,12 @@ REAL detsum;
 
   INEXACT REAL bvirt;
   REAL avirt, bround, around;
+#ifndef Fused_Multiply_Add
   INEXACT REAL c;
   INEXACT REAL abig;
   REAL ahi, alo, bhi, blo;
   REAL err1, err2, err3;
+#endif /* not Fused_Multiply_Add */
   INEXACT REAL _i, _j;
   REAL _0;
 
@@ -5369,10 +5718,12 @@ REAL permanent;
 
   INEXACT REAL bvirt;
   REAL avirt, bround, around;
+#ifndef Fused_Multiply_Add
   INEXACT REAL c;
   INEXACT REAL abig;
   REAL ahi, alo, bhi, blo;
   REAL err1, err2, err3;
+#endif /* not Fused_Multiply_Add */
   INEXACT REAL _i, _j;
   REAL _0;
 
@@ -6027,10 +6378,12 @@ REAL permanent;
 
   INEXACT REAL bvirt;
   REAL avirt, bround, around;
+#ifndef Fused_Multiply_Add
   INEXACT REAL c;
   INEXACT REAL abig;
   REAL ahi, alo, bhi, blo;
   REAL err1, err2, err3;
+#endif /* not Fused_Multiply_Add */
   INEXACT REAL _i, _j, _k;
   REAL _0;
 
@@ -6651,9 +7004,12 @@ struct mesh *m;
   m->checkquality = 0;     /* The quality triangulation stage has not begun. */
   m->incirclecount = m->counterclockcount = m->orient3dcount = 0;
   m->hyperbolacount = m->circletopcount = m->circumcentercount = 0;
-  randomseed = 1;
+  m->randomseed = 1;
+  m->dummytribase = (triangle *) NULL;    /* Nothing to free if we bail out. */
+  m->locategrid = (triangle *) NULL;          /* No point location grid yet. */
+  m->dummysubbase = (subseg *) NULL;
 
-  exactinit();                     /* Initialize exact arithmetic constants. */
+  exactinit();                          /* Prepare FPU for exact arithmetic. */
 }
 
 /*****************************************************************************/
@@ -6667,15 +7023,16 @@ struct mesh *m;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-unsigned long randomnation(unsigned int choices)
+unsigned long randomnation(struct mesh *m, unsigned int choices)
 #else /* not ANSI_DECLARATORS */
-unsigned long randomnation(choices)
+unsigned long randomnation(m, choices)
+struct mesh *m;
 unsigned int choices;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  randomseed = (randomseed * 1366l + 150889l) % 714025l;
-  return randomseed / (714025l / choices + 1);
+  m->randomseed = (m->randomseed * 1366l + 150889l) % 714025l;
+  return m->randomseed / (714025l / choices + 1);
 }
 
 /********* Mesh quality testing routines begin here                  *********/
@@ -7422,6 +7779,141 @@ struct behavior *b;
   }
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  gridinit()   Create an empty point location grid over the bounding box   */
+/*               of the input vertices.                                      */
+/*                                                                           */
+/*  The grid has about one cell per GRIDVERTICES input vertices, and the     */
+/*  cells are shaped to follow the proportions of the bounding box.          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void gridinit(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void gridinit(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  REAL width, height;
+  int cells;
+  int i;
+
+  width = m->xmax - m->xmin;
+  height = m->ymax - m->ymin;
+  cells = m->invertices / GRIDVERTICES;
+  if (cells < 1) {
+    cells = 1;
+  }
+  if ((width > 0.0) && (height > 0.0)) {
+    m->gridcols = (int) sqrt((REAL) cells * width / height);
+  } else if (width > 0.0) {
+    m->gridcols = cells;
+  } else {
+    m->gridcols = 1;
+  }
+  if (m->gridcols < 1) {
+    m->gridcols = 1;
+  } else if (m->gridcols > cells) {
+    m->gridcols = cells;
+  }
+  m->gridrows = cells / m->gridcols;
+  m->gridxscale = (width > 0.0) ? (REAL) m->gridcols / width : 0.0;
+  m->gridyscale = (height > 0.0) ? (REAL) m->gridrows / height : 0.0;
+  if (b->verbose) {
+    printf("  Creating a %d by %d point location grid.\n", m->gridcols,
+           m->gridrows);
+  }
+
+  m->locategrid = (triangle *)
+    trimalloc(m->gridcols * m->gridrows * (int) sizeof(triangle));
+  for (i = 0; i < m->gridcols * m->gridrows; i++) {
+    m->locategrid[i] = (triangle) NULL;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  gridcell()   Find the index of the point location grid cell that         */
+/*               contains a point.                                           */
+/*                                                                           */
+/*  Points outside the bounding box (such as the vertices of the triangular  */
+/*  bounding box of the incremental algorithm) go to the nearest cell.       */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int gridcell(struct mesh *m, vertex point)
+#else /* not ANSI_DECLARATORS */
+int gridcell(m, point)
+struct mesh *m;
+vertex point;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  REAL x, y;
+  int col, row;
+
+  x = (point[0] - m->xmin) * m->gridxscale;
+  y = (point[1] - m->ymin) * m->gridyscale;
+  if (x <= 0.0) {
+    col = 0;
+  } else if (x >= (REAL) (m->gridcols - 1)) {
+    col = m->gridcols - 1;
+  } else {
+    col = (int) x;
+  }
+  if (y <= 0.0) {
+    row = 0;
+  } else if (y >= (REAL) (m->gridrows - 1)) {
+    row = m->gridrows - 1;
+  } else {
+    row = (int) y;
+  }
+  return row * m->gridcols + col;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  gridfill()   Record a triangle in every grid cell that holds a vertex of */
+/*               the triangulation.                                          */
+/*                                                                           */
+/*  Used after a whole triangulation has been built (or read) at once.       */
+/*  Afterward, insertvertex() keeps the grid current by recording a triangle */
+/*  in the cell of each vertex it inserts.                                   */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void gridfill(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void gridfill(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri triangleloop;
+  vertex triorg;
+
+  if (b->verbose) {
+    printf("  Filling the point location grid.\n");
+  }
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  while (triangleloop.tri != (triangle *) NULL) {
+    for (triangleloop.orient = 0; triangleloop.orient < 3;
+         triangleloop.orient++) {
+      org(triangleloop, triorg);
+      m->locategrid[gridcell(m, triorg)] = encode(triangleloop);
+    }
+    triangleloop.tri = triangletraverse(m);
+  }
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  preciselocate()   Find a triangle or edge containing a given point.      */
@@ -7607,6 +8099,10 @@ int stopatsubsegment;
 /*  origin is closest to the point we are searching for.  Normally,          */
 /*  `searchtri' should be a handle on the convex hull of the triangulation.  */
 /*                                                                           */
+/*  If a point location grid is kept (-G switch) and the triangle recorded   */
+/*  in the point's cell still has its origin in that cell, that triangle is  */
+/*  a candidate too, and the random sample is skipped.                       */
+/*                                                                           */
 /*  Details on the random sampling method can be found in the Mucke, Saias,  */
 /*  and Zhu paper cited in the header of this code.                          */
 /*                                                                           */
@@ -7648,12 +8144,15 @@ struct otri *searchtri;
   VOID **sampleblock;
   char *firsttri;
   struct otri sampletri;
+  struct otri gridtri;
   vertex torg, tdest;
   unsigned long alignptr;
   REAL searchdist, dist;
   REAL ahead;
   long samplesperblock, totalsamplesleft, samplesleft;
   long population, totalpopulation;
+  int cell;
+  int gridhit;
   triangle ptr;                         /* Temporary variable used by sym(). */
 
   if (b->verbose > 2) {
@@ -7692,6 +8191,34 @@ struct otri *searchtri;
     }
   }
 
+  /* If the grid cell of the point has a live triangle whose origin is */
+  /*   still in the cell, test it and skip the random sampling.        */
+  gridhit = 0;
+  if (m->locategrid != (triangle *) NULL) {
+    cell = gridcell(m, searchpoint);
+    decode(m->locategrid[cell], gridtri);
+    if ((gridtri.tri != (triangle *) NULL) && !deadtri(gridtri.tri)) {
+      org(gridtri, torg);
+      if ((torg != (vertex) NULL) && (gridcell(m, torg) == cell)) {
+        if ((torg[0] == searchpoint[0]) && (torg[1] == searchpoint[1])) {
+          otricopy(gridtri, *searchtri);
+          return ONVERTEX;
+        }
+        gridhit = 1;
+        dist = (searchpoint[0] - torg[0]) * (searchpoint[0] - torg[0]) +
+               (searchpoint[1] - torg[1]) * (searchpoint[1] - torg[1]);
+        if (dist < searchdist) {
+          otricopy(gridtri, *searchtri);
+          searchdist = dist;
+          if (b->verbose > 2) {
+            printf("    Choosing grid triangle with origin (%.12g, %.12g).\n",
+                   torg[0], torg[1]);
+          }
+        }
+      }
+    }
+  }
+
   /* The number of random samples taken is proportional to the cube root of */
   /*   the number of triangles in the mesh.  The next bit of code assumes   */
   /*   that the number of triangles increases monotonically (or at least    */
@@ -7701,16 +8228,17 @@ struct otri *searchtri;
     m->samples++;
   }
 
-  /* We'll draw ceiling(samples * TRIPERBLOCK / maxitems) random samples  */
-  /*   from each block of triangles (except the first)--until we meet the */
-  /*   sample quota.  The ceiling means that blocks at the end might be   */
-  /*   neglected, but I don't care.                                       */
-  samplesperblock = (m->samples * TRIPERBLOCK - 1) / m->triangles.maxitems + 1;
+  /* We'll draw ceiling(samples * itemsperblock / maxitems) random samples */
+  /*   from each block of triangles (except the first)--until we meet the  */
+  /*   sample quota.  The ceiling means that blocks at the end might be    */
+  /*   neglected, but I don't care.                                        */
+  samplesperblock = (m->samples * (long) m->triangles.itemsperblock - 1) /
+                    m->triangles.maxitems + 1;
   /* We'll draw ceiling(samples * itemsfirstblock / maxitems) random samples */
   /*   from the first block of triangles.                                    */
   samplesleft = (m->samples * m->triangles.itemsfirstblock - 1) /
                 m->triangles.maxitems + 1;
-  totalsamplesleft = m->samples;
+  totalsamplesleft = gridhit ? 0 : m->samples;
   population = m->triangles.itemsfirstblock;
   totalpopulation = m->triangles.maxitems;
   sampleblock = m->triangles.firstblock;
@@ -7730,7 +8258,7 @@ struct otri *searchtri;
     /* Choose `samplesleft' randomly sampled triangles in this block. */
     do {
       sampletri.tri = (triangle *) (firsttri +
-                                    (randomnation((unsigned int) population) *
+                                    (randomnation(m, (unsigned int) population) *
                                      m->triangles.itembytes));
       if (!deadtri(sampletri.tri)) {
         org(sampletri, torg);
@@ -7754,7 +8282,7 @@ struct otri *searchtri;
       sampleblock = (VOID **) *sampleblock;
       samplesleft = samplesperblock;
       totalpopulation -= population;
-      population = TRIPERBLOCK;
+      population = m->triangles.itemsperblock;
     }
   }
 
@@ -8775,6 +9303,9 @@ int triflaws;
         /* We're done.  Return a triangle whose origin is the new vertex. */
         lnext(horiz, *searchtri);
         lnext(horiz, m->recenttri);
+        if (m->locategrid != (triangle *) NULL) {
+          m->locategrid[gridcell(m, newvertex)] = encode(m->recenttri);
+        }
         return success;
       }
       /* Finish finding the next edge around the newly inserted vertex. */
@@ -9199,9 +9730,10 @@ struct behavior *b;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void vertexsort(vertex *sortarray, int arraysize)
+void vertexsort(struct mesh *m, vertex *sortarray, int arraysize)
 #else /* not ANSI_DECLARATORS */
-void vertexsort(sortarray, arraysize)
+void vertexsort(m, sortarray, arraysize)
+struct mesh *m;
 vertex *sortarray;
 int arraysize;
 #endif /* not ANSI_DECLARATORS */
@@ -9224,7 +9756,7 @@ int arraysize;
     return;
   }
   /* Choose a random pivot to split the array. */
-  pivot = (int) randomnation((unsigned int) arraysize);
+  pivot = (int) randomnation(m, (unsigned int) arraysize);
   pivotx = sortarray[pivot][0];
   pivoty = sortarray[pivot][1];
   /* Split the array. */
@@ -9252,11 +9784,11 @@ int arraysize;
   }
   if (left > 1) {
     /* Recursively sort the left subset. */
-    vertexsort(sortarray, left);
+    vertexsort(m, sortarray, left);
   }
   if (right < arraysize - 2) {
     /* Recursively sort the right subset. */
-    vertexsort(&sortarray[right + 1], arraysize - right - 1);
+    vertexsort(m, &sortarray[right + 1], arraysize - right - 1);
   }
 }
 
@@ -9273,9 +9805,11 @@ int arraysize;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void vertexmedian(vertex *sortarray, int arraysize, int median, int axis)
+void vertexmedian(struct mesh *m, vertex *sortarray, int arraysize, int median,
+                  int axis)
 #else /* not ANSI_DECLARATORS */
-void vertexmedian(sortarray, arraysize, median, axis)
+void vertexmedian(m, sortarray, arraysize, median, axis)
+struct mesh *m;
 vertex *sortarray;
 int arraysize;
 int median;
@@ -9300,7 +9834,7 @@ int axis;
     return;
   }
   /* Choose a random pivot to split the array. */
-  pivot = (int) randomnation((unsigned int) arraysize);
+  pivot = (int) randomnation(m, (unsigned int) arraysize);
   pivot1 = sortarray[pivot][axis];
   pivot2 = sortarray[pivot][1 - axis];
   /* Split the array. */
@@ -9330,11 +9864,11 @@ int axis;
   /*   conditionals is true.                             */
   if (left > median) {
     /* Recursively shuffle the left subset. */
-    vertexmedian(sortarray, left, median, axis);
+    vertexmedian(m, sortarray, left, median, axis);
   }
   if (right < median - 1) {
     /* Recursively shuffle the right subset. */
-    vertexmedian(&sortarray[right + 1], arraysize - right - 1,
+    vertexmedian(m, &sortarray[right + 1], arraysize - right - 1,
                  median - right - 1, axis);
   }
 }
@@ -9351,9 +9885,10 @@ int axis;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void alternateaxes(vertex *sortarray, int arraysize, int axis)
+void alternateaxes(struct mesh *m, vertex *sortarray, int arraysize, int axis)
 #else /* not ANSI_DECLARATORS */
-void alternateaxes(sortarray, arraysize, axis)
+void alternateaxes(m, sortarray, arraysize, axis)
+struct mesh *m;
 vertex *sortarray;
 int arraysize;
 int axis;
@@ -9369,13 +9904,13 @@ int axis;
     axis = 0;
   }
   /* Partition with a horizontal or vertical cut. */
-  vertexmedian(sortarray, arraysize, divider, axis);
+  vertexmedian(m, sortarray, arraysize, divider, axis);
   /* Recursively partition the subsets with a cross cut. */
   if (arraysize - divider >= 2) {
     if (divider >= 2) {
-      alternateaxes(sortarray, divider, 1 - axis);
+      alternateaxes(m, sortarray, divider, 1 - axis);
     }
-    alternateaxes(&sortarray[divider], arraysize - divider, 1 - axis);
+    alternateaxes(m, &sortarray[divider], arraysize - divider, 1 - axis);
   }
 }
 
@@ -9733,6 +10268,15 @@ int axis;
 /*  knitted together by mergehulls().  The base cases (problems of two or    */
 /*  three vertices) are handled specially here.                              */
 /*                                                                           */
+/*  A triangulation of n vertices always allocates 2n - 2 triangles, and     */
+/*  nothing is freed until the ghosts are removed, so the stretch of the     */
+/*  triangle pool each subproblem fills is known in advance.  With OpenMP,   */
+/*  the left half of a large subproblem is triangulated by a separate task   */
+/*  on a copy of the mesh whose pool starts at the left half's stretch,      */
+/*  while the right half is placed after it with poolskip().  Every triangle */
+/*  lands where the serial recursion would have put it, so the output does   */
+/*  not depend on the number of threads.                                     */
+/*                                                                           */
 /*  On completion, `farleft' and `farright' are bounding triangles such that */
 /*  the origin of `farleft' is the leftmost vertex (breaking ties by         */
 /*  choosing the highest leftmost vertex), and the destination of            */
@@ -9759,6 +10303,9 @@ struct otri *farright;
 {
   struct otri midtri, tri1, tri2, tri3;
   struct otri innerleft, innerright;
+#ifdef _OPENMP
+  struct mesh leftmesh;
+#endif /* _OPENMP */
   REAL area;
   int divider;
 
@@ -9892,10 +10439,33 @@ struct otri *farright;
   } else {
     /* Split the vertices in half. */
     divider = vertices >> 1;
-    /* Recursively triangulate each half. */
-    divconqrecurse(m, b, sortarray, divider, 1 - axis, farleft, &innerleft);
-    divconqrecurse(m, b, &sortarray[divider], vertices - divider, 1 - axis,
-                   &innerright, farright);
+#ifdef _OPENMP
+    if ((vertices >= DIVCONQTASKSIZE) && (b->verbose < 2)) {
+      /* The left half gets its own copy of the mesh, so the pool cursor */
+      /*   and the operation counters are not shared with the right.    */
+      leftmesh = *m;
+      leftmesh.incirclecount = leftmesh.counterclockcount = 0;
+      leftmesh.orient3dcount = 0;
+#pragma omp task shared(leftmesh, innerleft)
+      divconqrecurse(&leftmesh, b, sortarray, divider, 1 - axis, farleft,
+                     &innerleft);
+      /* The right half starts where the left half's 2 * divider - 2 */
+      /*   triangles end.                                            */
+      poolskip(&m->triangles, 2 * (long) divider - 2);
+      divconqrecurse(m, b, &sortarray[divider], vertices - divider, 1 - axis,
+                     &innerright, farright);
+#pragma omp taskwait
+      m->incirclecount += leftmesh.incirclecount;
+      m->counterclockcount += leftmesh.counterclockcount;
+      m->orient3dcount += leftmesh.orient3dcount;
+    } else
+#endif /* _OPENMP */
+    {
+      /* Recursively triangulate each half. */
+      divconqrecurse(m, b, sortarray, divider, 1 - axis, farleft, &innerleft);
+      divconqrecurse(m, b, &sortarray[divider], vertices - divider, 1 - axis,
+                     &innerright, farright);
+    }
     if (b->verbose > 1) {
       printf("  Joining triangulations with %d and %d vertices.\n", divider,
              vertices - divider);
@@ -9993,7 +10563,7 @@ struct behavior *b;
     sortarray[i] = vertextraverse(m);
   }
   /* Sort the vertices. */
-  vertexsort(sortarray, m->invertices);
+  vertexsort(m, sortarray, m->invertices);
   /* Discard duplicate vertices, which can really mess up the algorithm. */
   i = 0;
   for (j = 1; j < m->invertices; j++) {
@@ -10017,9 +10587,9 @@ struct behavior *b;
     divider = i >> 1;
     if (i - divider >= 2) {
       if (divider >= 2) {
-        alternateaxes(sortarray, divider, 1);
+        alternateaxes(m, sortarray, divider, 1);
       }
-      alternateaxes(&sortarray[divider], i - divider, 1);
+      alternateaxes(m, &sortarray[divider], i - divider, 1);
     }
   }
 
@@ -10028,6 +10598,20 @@ struct behavior *b;
   }
 
   /* Form the Delaunay triangulation. */
+#ifdef _OPENMP
+  if ((i >= DIVCONQTASKSIZE) && (b->verbose < 2)) {
+    /* Allocate the blocks for all 2i - 2 triangles up front, so the */
+    /*   tasks never grow the pool.                                  */
+    poolreserve(&m->triangles, 2 * (long) i - 2);
+#pragma omp parallel
+    {
+      /* Each thread needs the floating-point settings of exactinit(). */
+      exactinit();
+#pragma omp single
+      divconqrecurse(m, b, sortarray, i, 0, &hullleft, &hullright);
+    }
+  } else
+#endif /* _OPENMP */
   divconqrecurse(m, b, sortarray, i, 0, &hullleft, &hullright);
   trifree((VOID *) sortarray);
 
@@ -10889,7 +11473,7 @@ struct behavior *b;
       lnext(fliptri, righttri);
       sym(lefttri, farlefttri);
 
-      if (randomnation(SAMPLERATE) == 0) {
+      if (randomnation(m, SAMPLERATE) == 0) {
         symself(fliptri);
         dest(fliptri, leftvertex);
         apex(fliptri, midvertex);
@@ -10946,9 +11530,9 @@ struct behavior *b;
           otricopy(lefttri, bottommost);
         }
 
-        if (randomnation(SAMPLERATE) == 0) {
+        if (randomnation(m, SAMPLERATE) == 0) {
           splayroot = splayinsert(m, splayroot, &lefttri, nextvertex);
-        } else if (randomnation(SAMPLERATE) == 0) {
+        } else if (randomnation(m, SAMPLERATE) == 0) {
           lnext(righttri, inserttri);
           splayroot = splayinsert(m, splayroot, &inserttri, nextvertex);
         }
@@ -10992,6 +11576,8 @@ struct behavior *b;
   }
 
   pooldeinit(&m->splaynodes);
+  trifree((VOID *) eventheap);
+  trifree((VOID *) events);
   lprevself(bottommost);
   return removeghosts(m, b, &bottommost);
 }
@@ -15666,10 +16252,10 @@ struct behavior *b;
 #ifdef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-void triangulate(char *triswitches, struct triangulateio *in,
-                 struct triangulateio *out, struct triangulateio *vorout)
+int triangulate(char *triswitches, struct triangulateio *in,
+                struct triangulateio *out, struct triangulateio *vorout)
 #else /* not ANSI_DECLARATORS */
-void triangulate(triswitches, in, out, vorout)
+int triangulate(triswitches, in, out, vorout)
 char *triswitches;
 struct triangulateio *in;
 struct triangulateio *out;
@@ -15693,7 +16279,10 @@ char **argv;
   struct behavior b;
   REAL *holearray;                                        /* Array of holes. */
   REAL *regionarray;   /* Array of regional attributes and area constraints. */
-#ifndef TRILIBRARY
+#ifdef TRILIBRARY
+  struct exitpoint exitpoint;              /* Where triexit() comes back to. */
+  struct exitpoint *callerexitpoint;
+#else /* not TRILIBRARY */
   FILE *polyfile;
 #endif /* not TRILIBRARY */
 #ifndef NO_TIMER
@@ -15709,6 +16298,15 @@ char **argv;
 
   triangleinit(&m);
 #ifdef TRILIBRARY
+  /* An error anywhere below lands here through triexit().  The mesh is */
+  /*   freed and the status that would have ended the program returned. */
+  callerexitpoint = triexitpoint;
+  triexitpoint = &exitpoint;
+  if (setjmp(exitpoint.jump)) {
+    triexitpoint = callerexitpoint;
+    triangleabort(&m);
+    return exitpoint.status != 0 ? exitpoint.status : 1;
+  }
   parsecommandline(1, &triswitches, &b);
 #else /* not TRILIBRARY */
   parsecommandline(argc, argv, &b);
@@ -15729,6 +16327,9 @@ char **argv;
   }
 #endif /* not NO_TIMER */
 
+  if (b.gridlocate) {
+    gridinit(&m, &b);
+  }
 #ifdef CDT_ONLY
   m.hullsize = delaunay(&m, &b);                /* Triangulate the vertices. */
 #else /* not CDT_ONLY */
@@ -15749,6 +16350,9 @@ char **argv;
     m.hullsize = delaunay(&m, &b);              /* Triangulate the vertices. */
   }
 #endif /* not CDT_ONLY */
+  if (b.gridlocate) {
+    gridfill(&m, &b);
+  }
 
 #ifndef NO_TIMER
   if (!b.quiet) {
@@ -16000,7 +16604,8 @@ char **argv;
 #endif /* not REDUCED */
 
   triangledeinit(&m, &b);
-#ifndef TRILIBRARY
+#ifdef TRILIBRARY
+  triexitpoint = callerexitpoint;
+#endif /* TRILIBRARY */
   return 0;
-#endif /* not TRILIBRARY */
 }
@@ -0,0 +1,89 @@
+/*****************************************************************************/
+/*                                                                           */
+/*  (triangle.h)                                                             */
+/*                                                                           */
+/*  Include file for programs that call Triangle.                            */
+/*                                                                           */
+/*  Accompanies Triangle Version 1.6                                         */
+/*  July 28, 2005                                                            */
+/*                                                                           */
+/*  Copyright 1996, 2005                                                     */
+/*  Jonathan Richard Shewchuk                                                */
+/*                                                                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  To use Triangle as a library, compile triangle.c with -DTRILIBRARY and   */
+/*  link it with your program.  Before including this file, define REAL     */
+/*  (float or double, matching the SINGLE setting used for triangle.c) and   */
+/*  VOID (int or void), e.g.:                                                */
+/*                                                                           */
+/*      #define REAL double                                                  */
+/*      #define VOID void                                                    */
+/*      #include "triangle.h"                                                */
+/*                                                                           */
+/*  Define ANSI_DECLARATORS both here and when compiling triangle.c to get   */
+/*  prototypes.                                                              */
+/*                                                                           */
+/*  All input and output goes through `struct triangulateio'.  Lists are     */
+/*  flat arrays; a point uses two REALs, a triangle `numberofcorners' ints,  */
+/*  a segment or edge two ints, a hole two REALs and a region four REALs     */
+/*  (x, y, regional attribute, maximum area).  Output lists that are NULL on */
+/*  entry are allocated by Triangle and must be released with trifree().    */
+/*  Which lists are read and written depends on the switches passed to      */
+/*  triangulate(); see the usage text in triangle.c (`triangle -h').        */
+/*                                                                           */
+/*  triangulate() returns 0 on success.  On an error (out of memory, bad     */
+/*  input, internal error) it frees its working memory and returns the       */
+/*  nonzero status the standalone program would have exited with; output     */
+/*  lists allocated before the error are left in `out' for trifree().        */
+/*  Calls share no mutable state, so independent meshes may be built         */
+/*  concurrently from several threads.                                       */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef TRIANGLE_H
+#define TRIANGLE_H
+
+struct triangulateio {
+  REAL *pointlist;                                               /* In / out */
+  REAL *pointattributelist;                                      /* In / out */
+  int *pointmarkerlist;                                          /* In / out */
+  int numberofpoints;                                            /* In / out */
+  int numberofpointattributes;                                   /* In / out */
+
+  int *trianglelist;                                             /* In / out */
+  REAL *triangleattributelist;                                   /* In / out */
+  REAL *trianglearealist;                                         /* In only */
+  int *neighborlist;                                             /* Out only */
+  int numberoftriangles;                                         /* In / out */
+  int numberofcorners;                                           /* In / out */
+  int numberoftriangleattributes;                                /* In / out */
+
+  int *segmentlist;                                              /* In / out */
+  int *segmentmarkerlist;                                        /* In / out */
+  int numberofsegments;                                          /* In / out */
+
+  REAL *holelist;                        /* In / pointer to array copied out */
+  int numberofholes;                                      /* In / copied out */
+
+  REAL *regionlist;                      /* In / pointer to array copied out */
+  int numberofregions;                                    /* In / copied out */
+
+  int *edgelist;                                                 /* Out only */
+  int *edgemarkerlist;            /* Not used with Voronoi diagram; out only */
+  REAL *normlist;                /* Used only with Voronoi diagram; out only */
+  int numberofedges;                                             /* Out only */
+};
+
+#ifdef ANSI_DECLARATORS
+int triangulate(char *, struct triangulateio *, struct triangulateio *,
+                struct triangulateio *);
+void trifree(VOID *memptr);
+#else /* not ANSI_DECLARATORS */
+int triangulate();
+void trifree();
+#endif /* not ANSI_DECLARATORS */
+
+#endif /* TRIANGLE_H */